@@ -12,56 +12,126 @@ Created on: {DATE}                 /:/\:\  \     /:/\:\  \     /:/\:\  \
                                      \/__/         \/__/         \/__/
  _________________________________________________________________________________________*/
 #include "EEPROM_24C32.h"
+#include "uart_trace.h"
 
 // Global variables
 
 // Local Variables
-static uint8_t eepromReadWaitingFlag;
  void* eppromCallbackDataPointer;
-static uint8_t eepromDataReadyFlag;
-
-static uint16_t CurrentAdr;
-static uint8_t  CurrentLength;
-static void*    CurrentDataPtr;
-
-// Arrays to hold the read request details
-static uint16_t eepromReadAddressQueue[EEPROM_READ_QUEUE_SIZE];     // Array to hold EEPROM addresses
-static void*    eepromReadDataPtrQueue[EEPROM_READ_QUEUE_SIZE];     // Array to hold pointers to data buffers
-static uint8_t  eepromReadLengthQueue[EEPROM_READ_QUEUE_SIZE];      // Array to hold the lengths of data to be read
-
-// Pointers to the head and tail of the FIFO queue
-static uint8_t queueHead = 0;
-static uint8_t queueTail = 0;
-static uint8_t eepromReadQueueSize;
-static uint8_t eepromQueueADD(uint16_t adr , uint8_t length,void* DataPtr){
-    if (eepromReadQueueSize<EEPROM_READ_QUEUE_SIZE){
-        eepromReadAddressQueue[queueHead] =adr;
-        eepromReadDataPtrQueue[queueHead] =DataPtr;
-        eepromReadLengthQueue [queueHead]  =length;
-        queueHead=(queueHead+1)%EEPROM_READ_QUEUE_SIZE;
-        eepromReadQueueSize++;
-        return 1;
-    } else{
-    return 0;
-    }
+
+#if EEPROM_PAGE_SIZE % EEPROM_WRITE_PIECE
+#error "EEPROM_WRITE_PIECE must divide the page"
+#endif
+
+static const eeprom_Part_t eeprom_Part = { EEPROM_PART };
+
+// FIFO of pending read requests, one per chip
+I2C_REQUEST_QUEUE_ARRAY_DEFINE(eeprom_Queues, EEPROM_CHIPS, EEPROM_READ_QUEUE_SIZE);
+
+static void eeprom_blockService();
+
+// Bus descriptors, filled by eeprom_init(); chip n answers at EEPROM_24C32_ADDR + n
+static i2c_Device_t eeprom_Devices[EEPROM_CHIPS];
+
+// Block transfer states
+#define EEPROM_BLOCK_IDLE   0
+#define EEPROM_BLOCK_WRITE  1   // Next page piece waits for space in the I2C write buffer
+#define EEPROM_BLOCK_POLL   2   // ACK polling while the EEPROM writes a page piece
+#define EEPROM_BLOCK_READ   3   // Read requests queued, waiting for the last delivery
+
+static uint8_t  eeprom_BlockState;
+static uint8_t  eeprom_BlockProbing;                    // ACK poll on its way
+static uint8_t  eeprom_BlockPollChip;                   // Chip being ACK polled
+static uint8_t  eeprom_BlockProbeTicket;                // Probe ticket of the ACK poll
+static uint8_t  eeprom_ProbeTicket;                     // Probe ticket of the last eeprom_probe()
+static uint8_t  eeprom_ChipBusy;                        // Chips written since their last ACK poll, one bit each
+static eeprom_addr_t eeprom_BlockAddr;                  // Next EEPROM address to queue
+static uint16_t eeprom_BlockRemaining;                  // Bytes not queued yet
+static const uint8_t* eeprom_BlockSource;               // Next byte of a write, in caller memory
+static uint8_t* eeprom_BlockTarget;                     // Next byte of a read, in caller memory
+
+
+/**
+ * @brief Finds the chip holding a linear address.
+ *
+ * Without striping the chips follow each other, chip n holding the addresses
+ * from n * EEPROM_CHIP_SIZE on. With EEPROM_STRIPE_ENABLE page p lies on chip
+ * p % EEPROM_CHIPS, so a sequential write moves to the next chip with every page.
+ *
+ * @param addr  Linear address.
+ * @param local Returns the address inside the chip.
+ * @param run   Returns the number of bytes from addr on that follow on the same chip.
+ *
+ * @return uint8_t The chip number.
+ */
+static uint8_t eeprom_Locate(eeprom_addr_t addr, uint16_t* local, eeprom_addr_t* run) {
+#if defined(EEPROM_STRIPE_ENABLE) && EEPROM_CHIPS > 1
+    eeprom_addr_t page = addr / EEPROM_PAGE_SIZE;
+    *local = (uint16_t)((page / EEPROM_CHIPS) * EEPROM_PAGE_SIZE + (addr % EEPROM_PAGE_SIZE));
+    *run   = EEPROM_PAGE_SIZE - (addr % EEPROM_PAGE_SIZE);
+    return (uint8_t)(page % EEPROM_CHIPS);
+#else
+    *local = (uint16_t)(addr % EEPROM_CHIP_SIZE);
+    *run   = EEPROM_CHIP_SIZE - (addr % EEPROM_CHIP_SIZE);
+    return (uint8_t)(addr / EEPROM_CHIP_SIZE);
+#endif
 }
-static uint8_t eepromQueueGet(){
-    if(eepromReadQueueSize>0){
-        CurrentAdr     = eepromReadAddressQueue[queueTail];
-        CurrentDataPtr = eepromReadDataPtrQueue[queueTail];
-        CurrentLength  = eepromReadLengthQueue[queueTail];
-        return 1;
-    } else {
+
+/**
+ * @brief Queues a read, split where the range moves to another chip.
+ *
+ * @return uint8_t Returns 1 if every piece was queued. On 0 some pieces may
+ *         be queued already; reading the range again is harmless.
+ */
+static uint8_t eeprom_Read(eeprom_addr_t addr, uint8_t length, uint8_t* data) {
+    while (length) {
+        uint16_t local;
+        eeprom_addr_t run;
+        uint8_t chip = eeprom_Locate(addr, &local, &run);
+        uint8_t piece = (run < length) ? (uint8_t) run : length;
+
+        if (chip >= EEPROM_CHIPS || !i2c_DeviceRead(&eeprom_Devices[chip], local, piece, data)) {
             return 0;
         }
+        addr   += piece;
+        data   += piece;
+        length -= piece;
+    }
+    return 1;
 }
 
+/**
+ * @brief Queues a write within one page of one chip.
+ *
+ * The chip-local address and the caller's data go out as two segments of one
+ * frame, nothing is copied to the stack.
+ *
+ * A chip does not acknowledge its address during the write cycle after a
+ * write, so a second frame right behind the first would be dropped. Every
+ * write therefore marks its chip busy, and the chip takes no further write
+ * until the block service has seen it ACK a poll (see eeprom_blockService()).
+ *
+ * @return uint8_t Returns 1 if queued, 0 if addr is out of range, the chip
+ *         is still busy with an earlier write or the I2C write buffer is full.
+ */
+static uint8_t eeprom_Write(eeprom_addr_t addr, uint8_t length, const uint8_t* data) {
+    uint16_t local;
+    eeprom_addr_t run;
+    uint8_t chip = eeprom_Locate(addr, &local, &run);
 
-uint8_t eeprom_readByte(uint16_t addr ,uint8_t* CallBackData ) {
-    return eepromQueueADD(addr ,1,CallBackData);
+    if (chip >= EEPROM_CHIPS || (eeprom_ChipBusy & (1 << chip)) ||
+            !i2c_DeviceWriteRegister(&eeprom_Devices[chip], local, length, data)) {
+        return 0;
+    }
+    eeprom_ChipBusy |= (1 << chip);
+    return 1;
+}
+
+uint8_t eeprom_readByte(eeprom_addr_t addr ,uint8_t* CallBackData ) {
+    return eeprom_Read(addr, 1, CallBackData);
 }
-uint8_t eeprom_readArray(uint16_t addr, uint8_t length, uint8_t * CallBackData) {
-    return eepromQueueADD(addr  ,length,CallBackData);
+uint8_t eeprom_readArray(eeprom_addr_t addr, uint8_t length, uint8_t * CallBackData) {
+    return eeprom_Read(addr, length, CallBackData);
 }
 /**
  * @brief Writes a single byte to the EEPROM at the specified address.
@@ -76,14 +146,15 @@ uint8_t eeprom_readArray(uint16_t addr, uint8_t length, uint8_t * CallBackData)
  * 
  * @return uint8_t
  *         Returns the result of the I2C operation (1 for success, 0 for failure).
+ *         It fails while the chip is still writing an earlier write, try again later.
  */
-uint8_t eeprom_write_uint16_t(uint16_t addr, uint16_t data) {
+uint8_t eeprom_write_uint16_t(eeprom_addr_t addr, uint16_t data) {
     uint8_t result;
-    uint8_t addr_high = (addr >> 8);  // Extract high byte of the 16-bit address
-    uint8_t addr_low  = addr;         // Extract low byte of the 16-bit address
+    uint8_t bytes[2] = { (uint8_t) data, (uint8_t) (data >> 8) };
 
-    // Send the high byte, low byte, and data to the EEPROM using I2C
-    result = i2c_SendArray(EEPROM_24C32_ADDR, 4, (uint8_t[]){addr_high, addr_low,(uint8_t) (data),(uint8_t) (data >> 8)});
+    // Send the address and data to the EEPROM using I2C
+    result = eeprom_Write(addr, 2, bytes);
+    TRACE(if (result) { trace_Event(TRACE_EVT_EEPROM_WRITE, (uint8_t[]){(uint8_t) addr, addr >> 8, 2}, 3); });
     
     return result; // Return the status of the write operation
 }
@@ -101,14 +172,14 @@ uint8_t eeprom_write_uint16_t(uint16_t addr, uint16_t data) {
  * 
  * @return uint8_t
  *         Returns the result of the I2C operation (1 for success, 0 for failure).
+ *         It fails while the chip is still writing an earlier write, try again later.
  */
-uint8_t eeprom_writeByte(uint16_t addr, uint8_t data) {
+uint8_t eeprom_writeByte(eeprom_addr_t addr, uint8_t data) {
     uint8_t result;
-    uint8_t addr_high = (addr >> 8);  // Extract high byte of the 16-bit address
-    uint8_t addr_low  = addr;         // Extract low byte of the 16-bit address
 
-    // Send the high byte, low byte, and data to the EEPROM using I2C
-    result = i2c_SendArray(EEPROM_24C32_ADDR, 3, (uint8_t[]){addr_high, addr_low, data});
+    // Send the address and data to the EEPROM using I2C
+    result = eeprom_Write(addr, 1, &data);
+    TRACE(if (result) { trace_Event(TRACE_EVT_EEPROM_WRITE, (uint8_t[]){(uint8_t) addr, addr >> 8, 1}, 3); });
     
     return result; // Return the status of the write operation
 }
@@ -131,8 +202,8 @@ uint8_t eeprom_writeByte(uint16_t addr, uint8_t data) {
  *         Returns 1 if the read operation was successful and data is in queue,
  *         or 0 if the read operation failed.
  */
-uint8_t eeprom_read_uint16_t(uint16_t addr ,uint16_t* CallBackData ) { 
-    return eepromQueueADD(addr ,2,CallBackData);
+uint8_t eeprom_read_uint16_t(eeprom_addr_t addr ,uint16_t* CallBackData ) { 
+    return eeprom_Read(addr, 2, (uint8_t*) CallBackData);
 }
 
 /**
@@ -140,7 +211,8 @@ uint8_t eeprom_read_uint16_t(uint16_t addr ,uint16_t* CallBackData ) {
  * 
  * This function writes a sequence of bytes to the EEPROM (24C32) starting at a given 
  * 16-bit address. The function first sends the 16-bit address (high and low bytes), 
- * followed by the array of data bytes to be written into the EEPROM.
+ * followed by the array of data bytes to be written into the EEPROM. Both are
+ * copied straight into the I2C write buffer, any length uses the same stack.
  * 
  * @param addr   The 16-bit starting address in the EEPROM where data will be written.
  * @param data   Pointer to the array of bytes to be written into the EEPROM.
@@ -148,26 +220,14 @@ uint8_t eeprom_read_uint16_t(uint16_t addr ,uint16_t* CallBackData ) {
  * 
  * @return uint8_t
  *         Returns 1 if the write operation was successful, or 0 if the operation failed.
+ *         It fails while the chip is still writing an earlier write, try again later.
  */
-uint8_t eeprom_writeArray(uint16_t addr, uint8_t length, uint8_t *data) {
+uint8_t eeprom_writeArray(eeprom_addr_t addr, uint8_t length, uint8_t *data) {
     uint8_t result;
-    uint8_t addr_high = (addr >> 8); // Extract high byte of the 16-bit address
-    uint8_t addr_low = addr;         // Extract low byte of the 16-bit address
     
-    // Create a buffer to hold the address and data together
-    uint8_t buffer[length + 2];
-    
-    // Add the high and low address bytes to the buffer
-    buffer[0] = addr_high;
-    buffer[1] = addr_low;
-    
-    // Copy the data to be written into the buffer, starting after the address
-    for (uint8_t i = 0; i < length; i++) {
-        buffer[i + 2] = data[i];
-    }
-    
-    // Send the buffer (address + data) to the EEPROM
-    result = i2c_SendArray(EEPROM_24C32_ADDR, length + 2, buffer);
+    // Send the address and the data, streamed from the caller's array, to the EEPROM
+    result = eeprom_Write(addr, length, data);
+    TRACE(if (result) { trace_Event(TRACE_EVT_EEPROM_WRITE, (uint8_t[]){(uint8_t) addr, addr >> 8, length}, 3); });
     
     return result; // Return status of the operation (1 for success, 0 for failure)
 }
@@ -176,45 +236,298 @@ uint8_t eeprom_writeArray(uint16_t addr, uint8_t length, uint8_t *data) {
 
 
 /**
- * @brief Periodically checks if the EEPROM data is ready to be read.
- * 
- * This function is meant to be called in a periodic task or main loop. It checks the 
- * I2C read buffer and sets a flag when data from the EEPROM is ready to be fetched.
- * The flag indicates that the EEPROM data has been successfully read and can now be
- * processed or stored in the appropriate variable.
- * 
- * @return uint8_t
- *         Returns 1 if data is ready to be fetched, 0 if data is not ready yet.
- */
-void eeprom_Update() {
-
-    // Check if data in the I2C read buffer is ready to be processed
-    if(eepromReadWaitingFlag){
-        if (i2cReadDataReadyFlag ) {
-            // Data is ready, set the flag (you can define a flag variable in your program)
-            eepromDataReadyFlag = 1;
-            eepromReadWaitingFlag = 0;
-            i2c_ReadFromRxBuffer(CurrentDataPtr, CurrentLength);
-            eepromDataReadyFlag = 0;
+ * @brief Returns 1 while any EEPROM read has not been delivered yet.
+ */
+uint8_t eeprom_readPending() {
+    for (uint8_t chip = 0; chip < EEPROM_CHIPS; chip++) {
+        if (i2c_DeviceReadPending(&eeprom_Devices[chip])) {
+            return 1;
         }
-    } else{
-        // make sure there is enough size for the request in the write buffer , also if the i2c has another read request then wait 
-        // and for the first condition is that , make sure that there is a request for data
-        if(eepromReadQueueSize>0 && i2cReadBusyFlag == 0 &&((i2c_WriteBufferCurrentSize + 6) < I2C_WRITE_BUFFER_SIZE) ){  
-
-        eepromQueueGet();
-        i2c_SendArray(EEPROM_24C32_ADDR, 2, (uint8_t[]){(CurrentAdr >> 8), (uint8_t) CurrentAdr});
-        if(i2c_GetData(EEPROM_24C32_ADDR, CurrentLength)){
-            queueTail=(queueTail+1)%EEPROM_READ_QUEUE_SIZE;
-            eepromReadQueueSize--;
-            eepromReadWaitingFlag = 1;
-        } 
+    }
+    return 0;
+}
+
+/**
+ * @brief Returns the number of read requests queued for all chips.
+ */
+static uint8_t eeprom_readQueued() {
+    uint8_t count = 0;
+    for (uint8_t chip = 0; chip < EEPROM_CHIPS; chip++) {
+        count += i2c_QueueCount(&eeprom_Queues[chip]);
+    }
+    return count;
+}
+
+/**
+ * @brief Returns the bytes waiting in the write buffer of the EEPROM bus.
+ */
+uint8_t eeprom_writeQueued() {
+    return i2c_DeviceWritesQueued(&eeprom_Devices[0]);
+}
+
+/**
+ * @brief Starts an ACK poll of the EEPROM.
+ *
+ * After a write the 24C32 ignores its address until the internal write
+ * cycle (up to 10 ms) is over. Poll until eeprom_probeStatus() reads
+ * I2C_PROBE_ACK before the next write instead of waiting the worst case.
+ * With several chips this polls chip 0, block writes poll the chip they wrote.
+ *
+ * @return uint8_t Returns 1 if the poll was queued.
+ */
+uint8_t eeprom_probe() {
+    if (!i2c_DeviceProbe(&eeprom_Devices[0])) {
+        return 0;
+    }
+    eeprom_ProbeTicket = i2c_DeviceProbeTicket(&eeprom_Devices[0]);
+    return 1;
+}
+
+/**
+ * @brief Returns the I2C_PROBE_* result of the last eeprom_probe(), probes of
+ * other drivers in between do not change it.
+ */
+uint8_t eeprom_probeStatus() {
+    return i2c_DeviceProbeResult(&eeprom_Devices[0], eeprom_ProbeTicket);
+}
+
+/**
+ * @brief Writes within one page at once, polled, for the power-fail save.
+ *
+ * Call it after i2c_Preempt() with interrupts off. The chip is ACK polled for
+ * up to one write cycle in case it is still programming an earlier page; the
+ * attempts are counted from the SCL period set in TWBR. Returns after the
+ * STOP, the chip then needs EEPROM_WRITE_CYCLE_MS of supply to program it.
+ *
+ * @return uint8_t Returns 1 if the chip took the write, 0 if addr is out of
+ *         range, the chips are not on the TWI or the chip did not answer.
+ */
+uint8_t eeprom_writeNow(eeprom_addr_t addr, uint8_t length, const uint8_t* data) {
+    uint16_t local;
+    eeprom_addr_t run;
+    uint8_t chip = eeprom_Locate(addr, &local, &run);
+    uint8_t header[2] = { local >> 8, (uint8_t) local };
+    // SCL period = (16 + 2 * TWBR) CPU cycles with prescaler 1, one attempt = START + address = 10 periods
+    uint16_t attempts = (uint16_t)((EEPROM_WRITE_CYCLE_MS * (F_CPU / 1000UL)) / (10UL * (16 + 2 * TWBR))) + 1;
+
+    if (chip >= EEPROM_CHIPS || (eeprom_Devices[chip].bus && eeprom_Devices[chip].bus != &i2c_TwiBus)) {
+        return 0;
+    }
+    return i2c_PolledWrite(eeprom_Devices[chip].address, EEPROM_ADDRESS_WIDTH, &header[2 - EEPROM_ADDRESS_WIDTH],
+                           length, data, attempts);
+}
+
+/**
+ * @brief Returns the descriptor of the fitted part (see EEPROM_PART).
+ */
+const eeprom_Part_t* eeprom_part() {
+    return &eeprom_Part;
+}
+
+/**
+ * @brief Queues the next piece of a block write, up to the end of its page.
+ *
+ * A chip still in the write cycle of an earlier piece is ACK polled first.
+ * With striping the next page lies on another chip, so it goes out at once
+ * and the write cycles of the chips overlap.
+ *
+ * @return uint8_t Returns 1 if it went to the I2C write buffer.
+ */
+static uint8_t eeprom_blockWritePiece() {
+    uint16_t local;
+    eeprom_addr_t run;
+    uint8_t chip = eeprom_Locate(eeprom_BlockAddr, &local, &run);
+    uint8_t length = EEPROM_WRITE_PIECE - (eeprom_BlockAddr % EEPROM_WRITE_PIECE);
+    if (length > eeprom_BlockRemaining) {
+        length = (uint8_t) eeprom_BlockRemaining;
+    }
+    if (eeprom_ChipBusy & (1 << chip)) {
+        eeprom_BlockPollChip = chip;
+        eeprom_BlockProbing = 0;
+        eeprom_BlockState = EEPROM_BLOCK_POLL;
+        return 0;
+    }
+    if (!eeprom_Write(eeprom_BlockAddr, length, eeprom_BlockSource)) {
+        eeprom_BlockState = EEPROM_BLOCK_WRITE;
+        return 0;
+    }
+    TRACE(trace_Event(TRACE_EVT_EEPROM_WRITE, (uint8_t[]){(uint8_t) eeprom_BlockAddr, eeprom_BlockAddr >> 8, length}, 3));
+    eeprom_BlockAddr += length;
+    eeprom_BlockSource += length;
+    eeprom_BlockRemaining -= length;
+    eeprom_BlockState = EEPROM_BLOCK_WRITE;
+    return 1;
+}
+
+/**
+ * @brief Keeps EEPROM_BLOCK_READ_AHEAD pieces of a block read queued.
+ */
+static void eeprom_blockReadPieces() {
+    while (eeprom_BlockRemaining && eeprom_readQueued() < EEPROM_BLOCK_READ_AHEAD) {
+        uint16_t local;
+        eeprom_addr_t run;
+        uint8_t chip = eeprom_Locate(eeprom_BlockAddr, &local, &run);
+        uint8_t length = (eeprom_BlockRemaining > EEPROM_BLOCK_READ_CHUNK) ? EEPROM_BLOCK_READ_CHUNK : (uint8_t) eeprom_BlockRemaining;
+        if (run < length) {
+            length = (uint8_t) run;     // Ends where the next chip takes over
+        }
+        if (!i2c_DeviceRead(&eeprom_Devices[chip], local, length, eeprom_BlockTarget)) {
+            return;
         }
+        eeprom_BlockAddr += length;
+        eeprom_BlockTarget += length;
+        eeprom_BlockRemaining -= length;
+    }
+}
+
+/**
+ * @brief Advances the block transfer, run by the arbiter on every pass.
+ *
+ * A write ACK polls a chip before its next piece, so the piece goes out as
+ * soon as the write cycle is over; the write ends once every chip it used
+ * answers again. A read keeps the device queues filled, so the arbiter starts
+ * the next piece right after delivering the previous one.
+ *
+ * Without a block transfer the chips marked busy by plain writes are polled
+ * the same way, which frees them for the next write.
+ */
+static void eeprom_blockService() {
+    uint8_t probe;
+
+    switch (eeprom_BlockState) {
+        case EEPROM_BLOCK_IDLE:
+            if (!eeprom_ChipBusy) {
+                break;
+            }
+            // fall through, polls the chips of the plain writes (nothing remains to write)
+        case EEPROM_BLOCK_WRITE:
+            if (eeprom_BlockRemaining) {
+                eeprom_blockWritePiece();
+            } else if (eeprom_ChipBusy) {
+                // Wait for the chips still writing, lowest first
+                for (eeprom_BlockPollChip = 0; !(eeprom_ChipBusy & (1 << eeprom_BlockPollChip)); eeprom_BlockPollChip++);
+                eeprom_BlockProbing = 0;
+                eeprom_BlockState = EEPROM_BLOCK_POLL;
+            } else {
+                eeprom_BlockState = EEPROM_BLOCK_IDLE;
+            }
+            break;
+
+        case EEPROM_BLOCK_POLL:
+            if (!eeprom_BlockProbing) {
+                eeprom_BlockProbing = i2c_DeviceProbe(&eeprom_Devices[eeprom_BlockPollChip]);
+                eeprom_BlockProbeTicket = i2c_DeviceProbeTicket(&eeprom_Devices[eeprom_BlockPollChip]);
+                break;
+            }
+            probe = i2c_DeviceProbeResult(&eeprom_Devices[eeprom_BlockPollChip], eeprom_BlockProbeTicket);
+            if (probe == I2C_PROBE_PENDING) {
+                break;
+            }
+            eeprom_BlockProbing = 0;                // NACK or LOST, probed again
+            if (probe == I2C_PROBE_ACK) {
+                eeprom_ChipBusy &= ~(1 << eeprom_BlockPollChip);
+                eeprom_BlockState = EEPROM_BLOCK_WRITE;
+            }
+            break;
+
+        case EEPROM_BLOCK_READ:
+            eeprom_blockReadPieces();
+            if (!eeprom_BlockRemaining && !eeprom_readPending()) {
+                eeprom_BlockState = EEPROM_BLOCK_IDLE;
+            }
+            break;
+
+        default:
+            break;
     }
- i2c_Update();
 }
 
+/**
+ * @brief Starts writing a block of any length.
+ *
+ * The block is split at the page boundaries and streamed from caller memory
+ * one page piece per write cycle. The first piece is copied before this
+ * returns, so a block within one page needs no buffer afterwards; a longer
+ * one must stay valid until eeprom_blockBusy() returns 0.
+ *
+ * A chip written by anything else since its last ACK poll may still be in
+ * its write cycle. The block does not start on it then; the block service
+ * polls it meanwhile and the call succeeds once the chip answered.
+ *
+ * @return uint8_t Returns 1 if the write was started, 0 if a block transfer
+ *         or poll is running, the chip is still writing or the I2C write
+ *         buffer is full.
+ */
+uint8_t eeprom_writeBlock(eeprom_addr_t addr, uint16_t length, const uint8_t* data) {
+    uint16_t local;
+    eeprom_addr_t run;
+
+    if (eeprom_BlockState != EEPROM_BLOCK_IDLE || length == 0 || (uint32_t) addr + length > EEPROM_SIZE ||
+            (eeprom_ChipBusy & (1 << eeprom_Locate(addr, &local, &run)))) {
+        return 0;
+    }
+    eeprom_BlockAddr = addr;
+    eeprom_BlockRemaining = length;
+    eeprom_BlockSource = data;
+    if (!eeprom_blockWritePiece()) {
+        eeprom_BlockRemaining = 0;
+        eeprom_BlockState = EEPROM_BLOCK_IDLE;
+        return 0;
+    }
+    return 1;
+}
 
+/**
+ * @brief Starts reading a block of any length into caller memory.
+ *
+ * The data is complete once eeprom_blockBusy() returns 0.
+ *
+ * @return uint8_t Returns 1 if the read was started, 0 if a block transfer
+ *         or poll is running.
+ */
+uint8_t eeprom_readBlock(eeprom_addr_t addr, uint16_t length, uint8_t* data) {
+    if (eeprom_BlockState != EEPROM_BLOCK_IDLE || length == 0 || (uint32_t) addr + length > EEPROM_SIZE) {
+        return 0;
+    }
+    eeprom_BlockAddr = addr;
+    eeprom_BlockRemaining = length;
+    eeprom_BlockTarget = data;
+    eeprom_BlockState = EEPROM_BLOCK_READ;
+    eeprom_blockReadPieces();
+    return 1;
+}
+
+/**
+ * @brief Returns 1 while a block transfer, or the poll of a chip after a write, is running.
+ */
+uint8_t eeprom_blockBusy() {
+    return eeprom_BlockState != EEPROM_BLOCK_IDLE;
+}
+
+/**
+ * @brief Registers the EEPROM chips with the I2C arbiter.
+ *
+ * The arbiter initializes the bus with the first device registered on it,
+ * so the bus is set up once however many devices join.
+ *
+ * Every chip is a device of its own with its own read queue, so reads of
+ * different chips never merge and one chip in its write cycle does not hold
+ * up the others. Read requests are served by i2c_DeviceUpdate() from then on.
+ *
+ * @param frequency The highest SCL frequency the EEPROM is allowed to run at.
+ */
 void eeprom_init(uint32_t frequency){
-    i2c_Init( frequency);
+    for (uint8_t chip = 0; chip < EEPROM_CHIPS; chip++) {
+        I2C_REQUEST_QUEUE_ARRAY_INIT(eeprom_Queues, chip);
+
+        i2c_Device_t* device  = &eeprom_Devices[chip];
+        device->address       = EEPROM_24C32_ADDR + chip;
+        device->speed         = frequency;
+        device->registerWidth = EEPROM_ADDRESS_WIDTH;
+        device->readQueue     = &eeprom_Queues[chip];
+        device->service       = (chip == 0) ? eeprom_blockService : 0;
+        device->flags         = I2C_DEVICE_COALESCE;
+        device->bus           = EEPROM_I2C_BUS;
+        i2c_DeviceRegister(device);
+    }
 }
\ No newline at end of file
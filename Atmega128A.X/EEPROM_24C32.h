@@ -5,20 +5,109 @@
 #ifndef EEPROM_24C32_H
 #define EEPROM_24C32_H
 
-#include "I2C_Driver.h"
+#include "i2c_driver.h"
+#include "i2c_device.h"
+#include "i2c_soft.h"
 
-// Define the I2C address for 24C32 (A2, A1, A0 = 0)
-#define EEPROM_24C32_ADDR 0x50  // 7-bit address (0x50 << 1) for write, (0x51 << 1) for read
-#define EEPROM_READ_QUEUE_SIZE 30
-// Function prototypes
+// Supported parts: page size, address bytes, capacity, write cycle time (ms)
+#define EEPROM_PART_24C32       32,  2, 4096UL,  10
+#define EEPROM_PART_24C64       32,  2, 8192UL,  10
+#define EEPROM_PART_24C128      64,  2, 16384UL, 5
+#define EEPROM_PART_24C256      64,  2, 32768UL, 5
+#define EEPROM_PART_24LC512     128, 2, 65536UL, 5
+
+// Fitted parts, all chips are the same part with A2..A0 = 0, 1, 2 ...
+#ifndef EEPROM_PART
+#define EEPROM_PART             EEPROM_PART_24C32
+#endif
+#ifndef EEPROM_CHIPS
+#define EEPROM_CHIPS            1           // 1 to 8
+#endif
+
+// Bus the chips are wired to, 0 for the TWI or &i2c_SoftBus (i2c_soft.h)
+#ifndef EEPROM_I2C_BUS
+#define EEPROM_I2C_BUS          0
+#endif
+
+// Spread consecutive pages over the chips (page 0 on chip 0, page 1 on chip 1 ...)
+// so a block write goes on while the previous chip is in its write cycle.
+// Changes the layout of the stored data, uncomment or pass -DEEPROM_STRIPE_ENABLE.
+//#define EEPROM_STRIPE_ENABLE
+
+typedef struct {
+    uint8_t  pageSize;          // A write must not cross a page boundary
+    uint8_t  addressWidth;      // Memory address bytes after the device address
+    uint32_t capacity;          // Bytes per chip
+    uint8_t  writeCycleMs;      // Worst case internal write time (tWR)
+} eeprom_Part_t;
+
+#define EEPROM_PART_PAGE_(page, width, capacity, twr)       page
+#define EEPROM_PART_WIDTH_(page, width, capacity, twr)      width
+#define EEPROM_PART_CAPACITY_(page, width, capacity, twr)   capacity
+#define EEPROM_PART_TWR_(page, width, capacity, twr)        twr
+#define EEPROM_PART_FIELD(field, part)  field(part)
+
+#define EEPROM_24C32_ADDR      0x50         // 7-bit address of chip 0 (A2, A1, A0 = 0)
+#define EEPROM_PAGE_SIZE       EEPROM_PART_FIELD(EEPROM_PART_PAGE_, EEPROM_PART)
+#define EEPROM_ADDRESS_WIDTH   EEPROM_PART_FIELD(EEPROM_PART_WIDTH_, EEPROM_PART)
+#define EEPROM_CHIP_SIZE       EEPROM_PART_FIELD(EEPROM_PART_CAPACITY_, EEPROM_PART)
+#define EEPROM_WRITE_CYCLE_MS  EEPROM_PART_FIELD(EEPROM_PART_TWR_, EEPROM_PART)
+#define EEPROM_SIZE            (EEPROM_CHIP_SIZE * EEPROM_CHIPS)   // Linear address space of all chips
+
+// Read requests queued per chip, a power of two, 5 bytes a slot.
+// i2c_DeviceQueueHighWater peaked at 15 while a profile of PROFILE_MAX_SEGMENTS
+// was read at once, so one chip gets 16 slots (80 B). Several chips share
+// those 16, at least 4 each: a read the queue refuses is issued again by its
+// caller, and with EEPROM_STRIPE_ENABLE a burst spreads over the chips anyway.
+// The queues stay per chip because the arbiter serves each chip as a device of
+// its own, a chip in its write cycle would hold up the reads of the others in
+// a shared FIFO.
+#if EEPROM_CHIPS == 1
+#define EEPROM_READ_QUEUE_SIZE 16
+#elif EEPROM_CHIPS == 2
+#define EEPROM_READ_QUEUE_SIZE 8
+#else
+#define EEPROM_READ_QUEUE_SIZE 4
+#endif
+
+#if EEPROM_CHIPS < 1 || EEPROM_CHIPS > 8
+#error "EEPROM_CHIPS must be 1 to 8 (A2..A0)"
+#endif
+#if EEPROM_CHIPS >= I2C_MAX_DEVICES
+#error "raise I2C_MAX_DEVICES, every chip is a device of the arbiter"
+#endif
+
+// Addresses of the linear space, 16 bits as long as they are enough
+#if EEPROM_SIZE > 0xFFFFUL
+typedef uint32_t eeprom_addr_t;
+#else
+typedef uint16_t eeprom_addr_t;
+#endif
+
+// Function prototypes. A write fails (returns 0) while its chip may still be
+// in the write cycle of the previous one; the chip is ACK polled meanwhile.
 void    eeprom_init(uint32_t frequency);
-uint8_t eeprom_writeByte(uint16_t addr, uint8_t data);                              // Write a byte to the EEPROM
-uint8_t eeprom_readByte(uint16_t addr, uint8_t* CallBackData );                     // Read a byte from the EEPROM
-uint8_t eeprom_writeArray(uint16_t addr, uint8_t length, uint8_t *data);            // Write an array of bytes to the EEPROM
-uint8_t eeprom_readArray(uint16_t addr, uint8_t length,uint8_t* CallBackData  );    // Read an array of bytes from the EEPROM
-uint8_t eeprom_read_uint16_t(uint16_t addr ,uint16_t* CallBackData ) ;
-uint8_t eeprom_write_uint16_t(uint16_t addr, uint16_t data);
-void eeprom_Update() ;                                                              //called periodically to Update i2c and update if eeprom data is ready !
+const eeprom_Part_t* eeprom_part();                                                 // Descriptor of the fitted part
+uint8_t eeprom_writeByte(eeprom_addr_t addr, uint8_t data);                         // Write a byte to the EEPROM
+uint8_t eeprom_readByte(eeprom_addr_t addr, uint8_t* CallBackData );                // Read a byte from the EEPROM
+uint8_t eeprom_writeArray(eeprom_addr_t addr, uint8_t length, uint8_t *data);       // Write an array of bytes, within one page
+uint8_t eeprom_readArray(eeprom_addr_t addr, uint8_t length,uint8_t* CallBackData  ); // Read an array of bytes from the EEPROM
+uint8_t eeprom_read_uint16_t(eeprom_addr_t addr ,uint16_t* CallBackData ) ;
+uint8_t eeprom_write_uint16_t(eeprom_addr_t addr, uint16_t data);
+uint8_t eeprom_readPending();                                                       // Reads not delivered yet
+uint8_t eeprom_writeQueued();                                                       // Bytes waiting in the write buffer of the bus
+uint8_t eeprom_probe();                                                             // ACK poll of chip 0
+uint8_t eeprom_probeStatus();                                                       // I2C_PROBE_* result of eeprom_probe()
+uint8_t eeprom_writeNow(eeprom_addr_t addr, uint8_t length, const uint8_t* data);   // Polled write after i2c_Preempt(), within one page
+
+// Block transfers of up to the whole EEPROM, streamed from or into caller
+// memory by the arbiter (i2c_DeviceUpdate()); one block transfer at a time
+#define EEPROM_BLOCK_READ_CHUNK 96  // Bytes per read request, must fit the I2C read buffer
+#define EEPROM_BLOCK_READ_AHEAD 2   // Read requests kept queued, leaves the queue to the other users
+#define EEPROM_WRITE_PIECE      ((EEPROM_PAGE_SIZE < 64) ? EEPROM_PAGE_SIZE : 64)  // Longest write frame, must fit the I2C write buffer
+uint8_t eeprom_writeBlock(eeprom_addr_t addr, uint16_t length, const uint8_t* data); // Page by page with ACK polling
+uint8_t eeprom_readBlock(eeprom_addr_t addr, uint16_t length, uint8_t* data);      // In EEPROM_BLOCK_READ_CHUNK pieces
+uint8_t eeprom_blockBusy();                                                         // 1 until the last byte is written or delivered, or a chip polled
 
 #endif // EEPROM_24C32_H
 /* for the read request it returns 1 on success on putting a request
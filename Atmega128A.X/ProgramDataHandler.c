@@ -12,6 +12,7 @@ Created on: {DATE}                 /:/\:\  \     /:/\:\  \     /:/\:\  \
                                      \/__/         \/__/         \/__/
  _________________________________________________________________________________________*/
 
+#include <avr/interrupt.h>
 #include "ProgramDataHandler.h"
 // Global variables for the current program's parameters
 uint16_t StandbyTemp;
@@ -25,116 +26,585 @@ uint16_t VaccumStopTemp;
 uint8_t  RateOfHeatRise;
 uint8_t  VaccumPercent;
 
-// Function to load a program's parameters from EEPROM into global variables
-void EEPROM_loadProgram(uint8_t groupIndex, uint8_t programIndex) {
-    
+// Double buffer: the control loop reads program_Active while the shadow is loaded
+static Program_t  program_Buffers[2];
+static Program_t* volatile program_Active = &program_Buffers[0];
+static uint8_t    program_ShadowState = PROGRAM_SHADOW_EMPTY;
+
+#define PROGRAM_NONE            0xFF
+
+// Differential save, one program at a time
+#define PROGRAM_SAVE_READBACK   0   // Stored record on its way into program_SaveOld
+#define PROGRAM_SAVE_WRITE      1   // Changed spans of program_SaveNew on their way
+#define PROGRAM_SAVE_SPANS      2   // A record crosses at most one page boundary
+
+static Program_t program_SaveOld;                       // Read-back of the stored record
+static Program_t program_SaveNew;                       // Record being stored, the block writer reads it
+static uint8_t   program_SaveIndex = PROGRAM_NONE;      // Program being saved
+static uint8_t   program_SaveState;                     // PROGRAM_SAVE_*
+static uint8_t   program_SaveField = PROGRAM_NONE;      // Offset of a single field write, applied to the read-back
+static uint16_t  program_SaveValue;                     // Its value
+static uint8_t   program_SpanFirst[PROGRAM_SAVE_SPANS]; // Record offset of each changed span
+static uint8_t   program_SpanLength[PROGRAM_SAVE_SPANS];
+static uint8_t   program_SpanCount;
+static uint8_t   program_SpanNext;                      // Next span to hand to the block writer
+static EEPROM_SaveStats_t program_SaveStats;
+static EEPROM_SaveStats_t program_SavePending;          // Counts of the save on its way
+
+// Sum of the bytes before the checksum field
+static uint16_t program_Checksum(const Program_t* program) {
+    const uint8_t* bytes = (const uint8_t*) program;
+    uint16_t sum = 0;
+    for (uint8_t i = 0; i < CHECKSUM_OFFSET; i++) {
+        sum += bytes[i];
+    }
+    return sum;
+}
+
+// Bytes of the field at a *_OFFSET, 0 for an offset that is not a field
+static uint8_t program_FieldWidth(uint8_t offset) {
+    if (offset == RATE_OF_HEAT_RISE_OFFSET || offset == VACCUM_PERCENT_OFFSET) {
+        return 1;
+    }
+    return (offset < RATE_OF_HEAT_RISE_OFFSET && !(offset & 1)) ? 2 : 0;
+}
+
+// Stores one field, little endian as the whole record, and renews the checksum
+static void program_SetField(Program_t* program, uint8_t offset, uint16_t value) {
+    uint8_t* bytes = (uint8_t*) program;
+    bytes[offset] = (uint8_t) value;
+    if (program_FieldWidth(offset) == 2) {
+        bytes[offset + 1] = (uint8_t)(value >> 8);
+    }
+    program->Checksum = program_Checksum(program);
+}
+
+// Reads one field, the offset is a field (program_FieldWidth() != 0)
+static uint16_t program_GetField(const Program_t* program, uint8_t offset) {
+    const uint8_t* bytes = (const uint8_t*) program;
+    if (program_FieldWidth(offset) == 2) {
+        return bytes[offset] | ((uint16_t) bytes[offset + 1] << 8);
+    }
+    return bytes[offset];
+}
+
+static Program_t* program_Shadow() {
+    return (program_Active == &program_Buffers[0]) ? &program_Buffers[1] : &program_Buffers[0];
+}
+
+/**
+ * @brief Starts reading a program into the shadow buffer.
+ *
+ * The whole program arrives with one 20-byte read, the running program is
+ * not touched. Meant to be called during the current segment so the next
+ * program is ready when the switch comes.
+ *
+ * @return uint8_t Returns 1 if the read was queued, 0 if a load is still
+ *         running or the read queue is full.
+ */
+uint8_t EEPROM_prefetchProgram(uint8_t groupIndex, uint8_t programIndex) {
     uint16_t CurrentMemoryAdress = (EEPROM_BASE_ADDR + ( groupIndex * PROGRAM_GROUP_SIZE ) +( programIndex * PROGRAM_DATA_SIZE ));
-    
-    eeprom_read_uint16_t((CurrentMemoryAdress + STANDBY_TEMP_OFFSET     ),&StandbyTemp      );
-    eeprom_read_uint16_t((CurrentMemoryAdress + HOLD_TIME_STANDBY_OFFSET),&HoldTimeStandby  );
-    eeprom_read_uint16_t((CurrentMemoryAdress + BURNING_TEMP_OFFSET     ),&BurningTemp      );
-    eeprom_read_uint16_t((CurrentMemoryAdress + BURNING_TIME_OFFSET     ),&BurningTime      );
-    eeprom_read_uint16_t((CurrentMemoryAdress + COOLING_TEMP_OFFSET     ),&CoolingTemp      );
-    eeprom_read_uint16_t((CurrentMemoryAdress + COOLING_TIME_OFFSET     ),&CoolingTime      );
-    eeprom_read_uint16_t((CurrentMemoryAdress + VACCUM_START_TEMP_OFFSET),&VaccumStartTemp  );
-    eeprom_read_uint16_t((CurrentMemoryAdress + VACCUM_STOP_TEMP_OFFSET ),&VaccumStopTemp   );
-    eeprom_readByte     ((CurrentMemoryAdress + RATE_OF_HEAT_RISE_OFFSET),&RateOfHeatRise   );
-    eeprom_readByte     ((CurrentMemoryAdress + VACCUM_PERCENT_OFFSET   ),&VaccumPercent    );
+
+    if (program_ShadowState == PROGRAM_SHADOW_LOADING || groupIndex >= PROGRAM_GROUP_COUNT || programIndex >= PROGRAMS_PER_GROUP
+            || program_SaveIndex != PROGRAM_NONE) {
+        return 0;
+    }
+    if (!eeprom_readArray(CurrentMemoryAdress, PROGRAM_DATA_SIZE, (uint8_t*) program_Shadow())) {
+        return 0;
+    }
+    program_ShadowState = PROGRAM_SHADOW_LOADING;
+    return 1;
+}
+
+/**
+ * @brief Checks a program read from the EEPROM.
+ *
+ * A blank program (0xFF everywhere) fails the range checks. The checksum is
+ * only checked when one was written, programs saved before it existed still load.
+ */
+static uint8_t program_IsValid(const Program_t* program) {
+    return program->StandbyTemp <= PROGRAM_MAX_TEMP && program->BurningTemp <= PROGRAM_MAX_TEMP &&
+           program->CoolingTemp <= PROGRAM_MAX_TEMP && program->VaccumStartTemp <= PROGRAM_MAX_TEMP &&
+           program->VaccumStopTemp <= PROGRAM_MAX_TEMP && program->VaccumPercent <= PROGRAM_MAX_VACCUM &&
+           (program->Checksum == PROGRAM_NO_CHECKSUM || program->Checksum == program_Checksum(program));
+}
+
+/**
+ * @brief Returns the state of the shadow buffer, validating it once the read arrived.
+ */
+uint8_t EEPROM_shadowStatus() {
+    if (program_ShadowState == PROGRAM_SHADOW_LOADING && !eeprom_readPending()) {
+        program_ShadowState = program_IsValid(program_Shadow()) ? PROGRAM_SHADOW_READY : PROGRAM_SHADOW_INVALID;
+    }
+    return program_ShadowState;
+}
+
+/**
+ * @brief Puts a program held in RAM (e.g. the setpoints of a power-fail page)
+ * into the shadow buffer, validated as if it had been read.
+ *
+ * @return uint8_t PROGRAM_SHADOW_READY or PROGRAM_SHADOW_INVALID, or
+ *         PROGRAM_SHADOW_LOADING if a read into the shadow is still on its
+ *         way and nothing was copied; call it again then.
+ */
+uint8_t EEPROM_shadowProgram(const Program_t* program) {
+    if (EEPROM_shadowStatus() == PROGRAM_SHADOW_LOADING) {
+        return PROGRAM_SHADOW_LOADING;
+    }
+    *program_Shadow() = *program;
+    program_ShadowState = program_IsValid(program) ? PROGRAM_SHADOW_READY : PROGRAM_SHADOW_INVALID;
+    return program_ShadowState;
+}
+
+/**
+ * @brief Makes the shadow program the active one.
+ *
+ * Call it at a control cycle boundary: the switch is a single pointer store
+ * with interrupts off, so the control loop sees either the whole old or the
+ * whole new program. The global variables follow for the settings code.
+ *
+ * @return uint8_t Returns 1 if a validated program was published.
+ */
+uint8_t EEPROM_publishProgram() {
+    if (EEPROM_shadowStatus() != PROGRAM_SHADOW_READY) {
+        return 0;
+    }
+    Program_t* shadow = program_Shadow();
+    uint8_t sreg = SREG;
+    cli();
+    program_Active = shadow;
+    SREG = sreg;
+    program_ShadowState = PROGRAM_SHADOW_EMPTY;
+
+    StandbyTemp     = shadow->StandbyTemp;
+    HoldTimeStandby = shadow->HoldTimeStandby;
+    BurningTemp     = shadow->BurningTemp;
+    BurningTime     = shadow->BurningTime;
+    CoolingTemp     = shadow->CoolingTemp;
+    CoolingTime     = shadow->CoolingTime;
+    VaccumStartTemp = shadow->VaccumStartTemp;
+    VaccumStopTemp  = shadow->VaccumStopTemp;
+    RateOfHeatRise  = shadow->RateOfHeatRise;
+    VaccumPercent   = shadow->VaccumPercent;
+    return 1;
+}
+
+/**
+ * @brief Returns the program the control loop runs, all zero before the first publish.
+ */
+const Program_t* EEPROM_activeProgram() {
+    return program_Active;
+}
+
+// Record cache of the selection UI
+#define PROGRAM_CACHE_FREE      0
+#define PROGRAM_CACHE_LOADING   1
+#define PROGRAM_CACHE_VALID     2
+#define PROGRAM_CACHE_INVALID   3
+
+typedef struct {
+    Program_t program;
+    uint8_t   index;    // group * PROGRAMS_PER_GROUP + program
+    uint8_t   state;    // PROGRAM_CACHE_*
+} program_CacheEntry_t;
+
+static program_CacheEntry_t program_Cache[PROGRAM_CACHE_SIZE];
+static uint8_t  program_Wanted[PROGRAM_CACHE_SIZE];     // Indexes to keep cached, most wanted first
+static uint8_t  program_WantedCount;
+static program_CacheEntry_t* program_CacheLoad;         // Entry whose read is on its way
+static uint8_t  program_CacheLoadStale;                 // Its record was written meanwhile, drop the data
+static uint16_t program_CacheHitCount;
+static uint16_t program_CacheMissCount;
+
+static void program_WriteChanges(const Program_t* stored);
+static void program_SaveUpdate();
+
+static program_CacheEntry_t* program_CacheFind(uint8_t index) {
+    for (uint8_t i = 0; i < PROGRAM_CACHE_SIZE; i++) {
+        if (program_Cache[i].state != PROGRAM_CACHE_FREE && program_Cache[i].index == index) {
+            return &program_Cache[i];
+        }
+    }
+    return 0;
+}
+
+static uint8_t program_IsWanted(uint8_t index) {
+    for (uint8_t i = 0; i < program_WantedCount; i++) {
+        if (program_Wanted[i] == index) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void program_Want(uint8_t index) {
+    if (program_WantedCount < PROGRAM_CACHE_SIZE && !program_IsWanted(index)) {
+        program_Wanted[program_WantedCount++] = index;
+    }
+}
+
+/**
+ * @brief Drops a cached program, e.g. after it was written.
+ */
+static void program_CacheInvalidate(uint8_t groupIndex, uint8_t programIndex) {
+    program_CacheEntry_t* entry = program_CacheFind(groupIndex * PROGRAMS_PER_GROUP + programIndex);
+    if (entry && entry == program_CacheLoad) {
+        program_CacheLoadStale = 1;    // The read may have passed the bus before the write
+    } else if (entry) {
+        entry->state = PROGRAM_CACHE_FREE;
+    }
+}
+
+/**
+ * @brief Moves the selection cursor of the UI.
+ *
+ * The prefetcher then keeps the selected program, the programs before and
+ * after it (across the group boundary) and the rest of its group cached,
+ * nearest first.
+ *
+ * @return uint8_t Returns 1 if the program was already cached (a hit).
+ */
+uint8_t EEPROM_selectProgram(uint8_t groupIndex, uint8_t programIndex) {
+    uint8_t index = groupIndex * PROGRAMS_PER_GROUP + programIndex;
+
+    if (groupIndex >= PROGRAM_GROUP_COUNT || programIndex >= PROGRAMS_PER_GROUP) {
+        return 0;
+    }
+    program_WantedCount = 0;
+    program_Want(index);
+    program_Want((index + 1) % PROGRAM_COUNT);
+    program_Want((index + PROGRAM_COUNT - 1) % PROGRAM_COUNT);
+    for (uint8_t d = 2; d < PROGRAMS_PER_GROUP; d++) {
+        if (programIndex + d < PROGRAMS_PER_GROUP) {
+            program_Want(index + d);
+        }
+        if (programIndex >= d) {
+            program_Want(index - d);
+        }
+    }
+
+    program_CacheEntry_t* entry = program_CacheFind(index);
+    if (entry && entry->state >= PROGRAM_CACHE_VALID) {
+        program_CacheHitCount++;
+        return 1;
+    }
+    program_CacheMissCount++;
+    return 0;
+}
+
+/**
+ * @brief Returns a cached program for display.
+ *
+ * @return const Program_t* The program, 0 while it is not loaded yet or if
+ *         it failed the validation (blank or corrupt).
+ */
+const Program_t* EEPROM_cachedProgram(uint8_t groupIndex, uint8_t programIndex) {
+    program_CacheEntry_t* entry = program_CacheFind(groupIndex * PROGRAMS_PER_GROUP + programIndex);
+    return (entry && entry->state == PROGRAM_CACHE_VALID) ? &entry->program : 0;
+}
+
+/**
+ * @brief Runs the prefetcher, call it from the main loop.
+ *
+ * Finishes the read on its way, then starts the next one only while no
+ * other EEPROM read is queued and the write buffer is empty, so the
+ * speculative reads take idle bus time only. One read is on the bus at a
+ * time and the selected program always goes first.
+ */
+void EEPROM_prefetchUpdate() {
+    if (program_CacheLoad) {
+        if (eeprom_readPending()) {
+            return;
+        }
+        if (program_CacheLoadStale) {
+            program_CacheLoad->state = PROGRAM_CACHE_FREE;
+        } else {
+            program_CacheLoad->state = program_IsValid(&program_CacheLoad->program) ? PROGRAM_CACHE_VALID : PROGRAM_CACHE_INVALID;
+        }
+        program_CacheLoad = 0;
+        program_CacheLoadStale = 0;
+    }
+    if (program_SaveIndex != PROGRAM_NONE) {
+        program_SaveUpdate();
+        if (program_SaveIndex != PROGRAM_NONE) {
+            return;                     // A read now could return the record half written
+        }
+    }
+    if (eeprom_readPending() || eeprom_writeQueued() != 0) {
+        return;
+    }
+
+    for (uint8_t w = 0; w < program_WantedCount; w++) {
+        uint8_t index = program_Wanted[w];
+        if (program_CacheFind(index)) {
+            continue;
+        }
+        // Reuse a free entry or one that is no longer wanted
+        for (uint8_t i = 0; i < PROGRAM_CACHE_SIZE; i++) {
+            program_CacheEntry_t* entry = &program_Cache[i];
+            if (entry->state == PROGRAM_CACHE_FREE || !program_IsWanted(entry->index)) {
+                uint16_t CurrentMemoryAdress = EEPROM_BASE_ADDR + ((uint16_t) index * PROGRAM_DATA_SIZE);
+                if (eeprom_readArray(CurrentMemoryAdress, PROGRAM_DATA_SIZE, (uint8_t*) &entry->program)) {
+                    entry->index = index;
+                    entry->state = PROGRAM_CACHE_LOADING;
+                    program_CacheLoad = entry;
+                }
+                return;
+            }
+        }
+        return;
+    }
+}
+
+uint16_t EEPROM_cacheHits() {
+    return program_CacheHitCount;
+}
+
+uint16_t EEPROM_cacheMisses() {
+    return program_CacheMissCount;
+}
+
+// Function to load a program's parameters from EEPROM, they reach the global
+// variables with EEPROM_publishProgram() instead of one by one
+void EEPROM_loadProgram(uint8_t groupIndex, uint8_t programIndex) {
+    EEPROM_prefetchProgram(groupIndex, programIndex);
+}
+
+/**
+ * @brief Plans the writes of a program record, the bytes that differ from the stored ones.
+ *
+ * The record is handled page by page (a 20 byte record may cross a 32 byte
+ * page boundary): a page whose bytes are all equal is not written at all,
+ * otherwise one span covers its first to its last changed byte. A field change
+ * thus costs one write cycle, together with the checksum if both share the page.
+ *
+ * The spans of program_SaveNew are written by program_SaveUpdate().
+ */
+static void program_WriteChanges(const Program_t* stored) {
+    const uint8_t* oldBytes = (const uint8_t*) stored;
+    const uint8_t* newBytes = (const uint8_t*) &program_SaveNew;
+    uint16_t address = EEPROM_BASE_ADDR + ((uint16_t) program_SaveIndex * PROGRAM_DATA_SIZE);
+    uint8_t  i = 0;
+
+    program_SpanCount = 0;
+    program_SpanNext  = 0;
+    program_SavePending = (EEPROM_SaveStats_t) { 0 };
+    while (i < PROGRAM_DATA_SIZE) {
+        // End of the part of the record inside the current page
+        uint8_t pageEnd = i + (EEPROM_PAGE_SIZE - ((address + i) % EEPROM_PAGE_SIZE));
+        if (pageEnd > PROGRAM_DATA_SIZE) {
+            pageEnd = PROGRAM_DATA_SIZE;
+        }
+        uint8_t first = pageEnd;
+        uint8_t last  = i;
+        for (uint8_t b = i; b < pageEnd; b++) {
+            if (oldBytes[b] != newBytes[b]) {
+                if (first == pageEnd) {
+                    first = b;
+                }
+                last = b;
+            }
+        }
+        if (first == pageEnd) {
+            program_SavePending.pagesElided++;
+            program_SavePending.bytesElided += pageEnd - i;
+        } else {
+            program_SpanFirst[program_SpanCount]  = first;
+            program_SpanLength[program_SpanCount] = last - first + 1;
+            program_SpanCount++;
+            program_SavePending.pagesWritten++;
+            program_SavePending.bytesWritten += last - first + 1;
+            program_SavePending.bytesElided  += (pageEnd - i) - (last - first + 1);
+        }
+        i = pageEnd;
+    }
+
+    // Not shown while it is written, the prefetcher waits for the save
+    program_CacheEntry_t* entry = program_CacheFind(program_SaveIndex);
+    if (entry && entry == program_CacheLoad) {
+        program_CacheLoadStale = 1;
+    } else if (entry) {
+        entry->state = PROGRAM_CACHE_LOADING;
+    }
+    program_SaveState = PROGRAM_SAVE_WRITE;
+}
+
+/**
+ * @brief Runs the save on its way, from EEPROM_prefetchUpdate().
+ *
+ * Once the read-back arrived the changed spans are planned, then each goes
+ * out as a block write, which ACK polls the chip between the two pages. The
+ * cache takes the new record and the statistics count the save only after
+ * the block writer reports the last write cycle over.
+ */
+static void program_SaveUpdate() {
+    if (program_SaveState == PROGRAM_SAVE_READBACK) {
+        if (eeprom_readPending()) {
+            return;
+        }
+        if (program_SaveField != PROGRAM_NONE) {
+            program_SaveNew = program_SaveOld;
+            program_SetField(&program_SaveNew, program_SaveField, program_SaveValue);
+        }
+        program_WriteChanges(&program_SaveOld);
+    }
+
+    uint16_t address = EEPROM_BASE_ADDR + ((uint16_t) program_SaveIndex * PROGRAM_DATA_SIZE);
+    while (program_SpanNext < program_SpanCount) {
+        uint8_t first = program_SpanFirst[program_SpanNext];
+        if (!eeprom_writeBlock(address + first, program_SpanLength[program_SpanNext], (const uint8_t*) &program_SaveNew + first)) {
+            return;                     // The block writer or the chip is busy, next pass
+        }
+        program_SpanNext++;
+    }
+    if (eeprom_blockBusy()) {
+        return;
+    }
+
+    program_CacheEntry_t* entry = program_CacheFind(program_SaveIndex);
+    if (entry && entry != program_CacheLoad) {
+        entry->program = program_SaveNew;
+        entry->state   = PROGRAM_CACHE_VALID;
+    }
+    program_SaveStats.bytesWritten += program_SavePending.bytesWritten;
+    program_SaveStats.bytesElided  += program_SavePending.bytesElided;
+    program_SaveStats.pagesWritten += program_SavePending.pagesWritten;
+    program_SaveStats.pagesElided  += program_SavePending.pagesElided;
+    program_SaveIndex = PROGRAM_NONE;
+}
+
+/**
+ * @brief Starts storing a program record, writing only what changed.
+ *
+ * The stored contents are taken from the record cache when it holds the
+ * program (the selection UI keeps the edited program cached). Otherwise the
+ * record is read back with one sequential read; if the read queue is full the
+ * whole record is written. The writes follow from EEPROM_prefetchUpdate(),
+ * program loads and prefetches wait until the last one is done.
+ *
+ * Without a program only the field at fieldOffset changes: it is set in the
+ * stored record, which is then saved with a new checksum like any other.
+ *
+ * @return uint8_t Returns 1 if the save was started, 0 while an earlier save
+ *         is still running, for an invalid index, or for a field write whose
+ *         read-back the read queue refused.
+ */
+static uint8_t program_Save(uint8_t groupIndex, uint8_t programIndex, const Program_t* program,
+                            uint8_t fieldOffset, uint16_t value) {
+    uint8_t index = groupIndex * PROGRAMS_PER_GROUP + programIndex;
+    program_CacheEntry_t* entry = program_CacheFind(index);
+
+    if (groupIndex >= PROGRAM_GROUP_COUNT || programIndex >= PROGRAMS_PER_GROUP || program_SaveIndex != PROGRAM_NONE) {
+        return 0;
+    }
+    program_SaveIndex = index;
+    program_SaveField = PROGRAM_NONE;
+    if (program) {
+        program_SaveNew = *program;
+        program_SaveNew.Checksum = program_Checksum(&program_SaveNew);
+    }
+
+    if (entry && entry->state == PROGRAM_CACHE_VALID && entry != program_CacheLoad) {
+        if (!program) {
+            program_SaveNew = entry->program;
+            program_SetField(&program_SaveNew, fieldOffset, value);
+        }
+        program_WriteChanges(&entry->program);
+    } else if (eeprom_readArray(EEPROM_BASE_ADDR + ((uint16_t) index * PROGRAM_DATA_SIZE), PROGRAM_DATA_SIZE, (uint8_t*) &program_SaveOld)) {
+        if (!program) {
+            program_SaveField = fieldOffset;
+            program_SaveValue = value;
+        }
+        program_SaveState = PROGRAM_SAVE_READBACK;
+        program_CacheInvalidate(groupIndex, programIndex);
+    } else if (!program) {
+        program_SaveIndex = PROGRAM_NONE;
+        return 0;
+    } else {
+        // Nothing known about the stored record, compare against the complement
+        // so the whole record is written
+        uint8_t* bytes = (uint8_t*) &program_SaveOld;
+        for (uint8_t i = 0; i < PROGRAM_DATA_SIZE; i++) {
+            bytes[i] = ~((uint8_t*) &program_SaveNew)[i];
+        }
+        program_WriteChanges(&program_SaveOld);
+    }
+    program_SaveUpdate();
+    return 1;
 }
 
 // Function to save a program's parameters into EEPROM
-void EEPROM_saveProgramData(uint8_t groupIndex, uint8_t programIndex, 
+uint8_t EEPROM_saveProgramData(uint8_t groupIndex, uint8_t programIndex, 
                         uint16_t standbyTemp    , uint16_t holdTimeStandby  , uint8_t rateOfHeatRise, 
                         uint16_t burningTemp    , uint16_t burningTime      , uint16_t coolingTemp, 
                         uint16_t coolingTime    , uint8_t vaccumPercent     , uint16_t vaccumStartTemp, 
                         uint16_t vaccumStopTemp) {
-    
-    
-    uint16_t CurrentMemoryAdress = (EEPROM_BASE_ADDR + ( groupIndex * PROGRAM_GROUP_SIZE ) +( programIndex * PROGRAM_DATA_SIZE ));
-    eeprom_write_uint16_t((CurrentMemoryAdress + STANDBY_TEMP_OFFSET     ),standbyTemp      );
-    eeprom_write_uint16_t((CurrentMemoryAdress + HOLD_TIME_STANDBY_OFFSET),holdTimeStandby  );
-    eeprom_write_uint16_t((CurrentMemoryAdress + BURNING_TEMP_OFFSET     ),burningTemp      );
-    eeprom_write_uint16_t((CurrentMemoryAdress + BURNING_TIME_OFFSET     ),burningTime      );
-    eeprom_write_uint16_t((CurrentMemoryAdress + COOLING_TEMP_OFFSET     ),coolingTemp      );
-    eeprom_write_uint16_t((CurrentMemoryAdress + COOLING_TIME_OFFSET     ),coolingTime      );
-    eeprom_write_uint16_t((CurrentMemoryAdress + VACCUM_START_TEMP_OFFSET),vaccumStartTemp  );
-    eeprom_write_uint16_t((CurrentMemoryAdress + VACCUM_STOP_TEMP_OFFSET ),vaccumStopTemp   );
-    eeprom_writeByte     ((CurrentMemoryAdress + RATE_OF_HEAT_RISE_OFFSET),rateOfHeatRise   );
-    eeprom_writeByte     ((CurrentMemoryAdress + VACCUM_PERCENT_OFFSET   ),vaccumPercent    );
-}
-void EEPROM_saveCurrentSettings(uint8_t groupIndex, uint8_t programIndex){
-        
-    uint16_t CurrentMemoryAdress = (EEPROM_BASE_ADDR + ( groupIndex * PROGRAM_GROUP_SIZE ) +( programIndex * PROGRAM_DATA_SIZE ));
-    
-    eeprom_write_uint16_t((CurrentMemoryAdress + STANDBY_TEMP_OFFSET     ),StandbyTemp      );
-    eeprom_write_uint16_t((CurrentMemoryAdress + HOLD_TIME_STANDBY_OFFSET),HoldTimeStandby  );
-    eeprom_write_uint16_t((CurrentMemoryAdress + BURNING_TEMP_OFFSET     ),BurningTemp      );
-    eeprom_write_uint16_t((CurrentMemoryAdress + BURNING_TIME_OFFSET     ),BurningTime      );
-    eeprom_write_uint16_t((CurrentMemoryAdress + COOLING_TEMP_OFFSET     ),CoolingTemp      );
-    eeprom_write_uint16_t((CurrentMemoryAdress + COOLING_TIME_OFFSET     ),CoolingTime      );
-    eeprom_write_uint16_t((CurrentMemoryAdress + VACCUM_START_TEMP_OFFSET),VaccumStartTemp  );
-    eeprom_write_uint16_t((CurrentMemoryAdress + VACCUM_STOP_TEMP_OFFSET ),VaccumStopTemp   );
-    eeprom_writeByte     ((CurrentMemoryAdress + RATE_OF_HEAT_RISE_OFFSET),RateOfHeatRise   );
-    eeprom_writeByte     ((CurrentMemoryAdress + VACCUM_PERCENT_OFFSET   ),VaccumPercent    );
-}
-
-// Function to read/write program variables (helper)
-uint16_t EEPROM_readProgramVariable(uint8_t groupIndex, uint8_t programIndex, uint8_t variableOffset) {
-    void *variablePtr = 0x00;
-    uint8_t byte_flag = 0x00;
-    uint16_t CurrentMemoryAdress = (EEPROM_BASE_ADDR + ( groupIndex * PROGRAM_GROUP_SIZE ) +( programIndex * PROGRAM_DATA_SIZE ));
+    Program_t program = { standbyTemp, holdTimeStandby, burningTemp, burningTime, coolingTemp, coolingTime,
+                          vaccumStartTemp, vaccumStopTemp, rateOfHeatRise, vaccumPercent, 0 };
+    return program_Save(groupIndex, programIndex, &program, 0, 0);
+}
+uint8_t EEPROM_saveCurrentSettings(uint8_t groupIndex, uint8_t programIndex){
+    Program_t program = { StandbyTemp, HoldTimeStandby, BurningTemp, BurningTime, CoolingTemp, CoolingTime,
+                          VaccumStartTemp, VaccumStopTemp, RateOfHeatRise, VaccumPercent, 0 };
+    return program_Save(groupIndex, programIndex, &program, 0, 0);
+}
+
+/**
+ * @brief Returns 1 while a save is read back or written, EEPROM_prefetchUpdate() runs it.
+ */
+uint8_t EEPROM_saveBusy() {
+    return program_SaveIndex != PROGRAM_NONE;
+}
+
+/**
+ * @brief Returns the byte and page counts of the differential saves, each
+ * counted once its last write cycle is over.
+ */
+const EEPROM_SaveStats_t* EEPROM_saveStats() {
+    return &program_SaveStats;
+}
 
-    // Determine the memory address for the selected variable based on its offset
-    switch (variableOffset) {
-        case STANDBY_TEMP_OFFSET:
-            variablePtr = &StandbyTemp;
-            break;
-        case HOLD_TIME_STANDBY_OFFSET:
-            variablePtr = &HoldTimeStandby;
-            break;
-        case BURNING_TEMP_OFFSET:
-            variablePtr = &BurningTemp;
-            break;
-        case BURNING_TIME_OFFSET:
-            variablePtr = &BurningTime;
-            break;
-        case COOLING_TEMP_OFFSET:
-            variablePtr = &CoolingTemp;
-            break;
-        case COOLING_TIME_OFFSET:
-            variablePtr = &CoolingTime;
-            break;
-        case VACCUM_START_TEMP_OFFSET:
-            variablePtr = &VaccumStartTemp;
-            break;
-        case VACCUM_STOP_TEMP_OFFSET:
-            variablePtr = &VaccumStopTemp;
-            break;
-        case RATE_OF_HEAT_RISE_OFFSET:
-            variablePtr = &RateOfHeatRise;
-            byte_flag = 1;
-            break;
-        case VACCUM_PERCENT_OFFSET:
-            variablePtr = &VaccumPercent;
-            byte_flag = 1;
-            break;
-        default:
-            // Invalid offset, return failure
-            return 0;
-    }
-    if(byte_flag){
-            eeprom_readByte     ((CurrentMemoryAdress + variableOffset   ),variablePtr    );
-    } else{
-            eeprom_read_uint16_t((CurrentMemoryAdress + variableOffset   ),variablePtr    );
+/**
+ * @brief Reads one field of a stored program, variableOffset is one of the
+ * *_OFFSET field offsets.
+ *
+ * The field comes from the record cache. Nothing is read into the globals of
+ * the running program, only EEPROM_publishProgram() changes those, as a whole
+ * program. A program that is not cached yet is selected, so the prefetcher
+ * loads it with its neighbours; call again until the field is there.
+ *
+ * @return uint8_t Returns 1 with *value set, 0 while the record is loading,
+ *         if it is blank or corrupt or for an offset that is not a field.
+ */
+uint8_t EEPROM_readProgramVariable(uint8_t groupIndex, uint8_t programIndex, uint8_t variableOffset, uint16_t* value) {
+    if (!program_FieldWidth(variableOffset) || groupIndex >= PROGRAM_GROUP_COUNT || programIndex >= PROGRAMS_PER_GROUP) {
+        return 0;
+    }
+    program_CacheEntry_t* entry = program_CacheFind(groupIndex * PROGRAMS_PER_GROUP + programIndex);
+    if (!entry) {
+        EEPROM_selectProgram(groupIndex, programIndex);
+        return 0;
     }
+    if (entry->state != PROGRAM_CACHE_VALID) {
+        return 0;
+    }
+    *value = program_GetField(&entry->program, variableOffset);
     return 1;
 }
 
-void EEPROM_writeProgramVariable(uint8_t groupIndex, uint8_t programIndex, uint8_t variableOffset, uint16_t value) {
-    uint16_t CurrentMemoryAdress = (EEPROM_BASE_ADDR + ( groupIndex * PROGRAM_GROUP_SIZE ) +( programIndex * PROGRAM_DATA_SIZE ));
-    if((variableOffset == VACCUM_PERCENT_OFFSET)||(variableOffset == RATE_OF_HEAT_RISE_OFFSET)){
-            eeprom_writeByte     ((CurrentMemoryAdress + variableOffset   ),value    );
-    } else{
-            eeprom_write_uint16_t((CurrentMemoryAdress + variableOffset   ),value    );
-    } 
+/**
+ * @brief Changes one field of a stored program, variableOffset is one of the
+ * *_OFFSET field offsets.
+ *
+ * The field is set in the stored record (from the cache or read back) and the
+ * record is saved with a new checksum, the same way as EEPROM_saveProgramData().
+ *
+ * @return uint8_t Returns 1 if the save was started, 0 for an offset that is
+ *         not a field or while an earlier save is still running.
+ */
+uint8_t EEPROM_writeProgramVariable(uint8_t groupIndex, uint8_t programIndex, uint8_t variableOffset, uint16_t value) {
+    if (!program_FieldWidth(variableOffset)) {
+        return 0;
+    }
+    return program_Save(groupIndex, programIndex, 0, variableOffset, value);
 }
@@ -42,29 +42,84 @@ extern uint8_t  VaccumPercent;
 #define VACCUM_STOP_TEMP_OFFSET   14
 #define RATE_OF_HEAT_RISE_OFFSET  16
 #define VACCUM_PERCENT_OFFSET     17
-// two bytes remain
+#define CHECKSUM_OFFSET           18    // sum of bytes 0..17, 0xFFFF if not written (older programs)
+
+// One program as stored in the EEPROM, little endian
+typedef struct {
+    uint16_t StandbyTemp;
+    uint16_t HoldTimeStandby;
+    uint16_t BurningTemp;
+    uint16_t BurningTime;
+    uint16_t CoolingTemp;
+    uint16_t CoolingTime;
+    uint16_t VaccumStartTemp;
+    uint16_t VaccumStopTemp;
+    uint8_t  RateOfHeatRise;
+    uint8_t  VaccumPercent;
+    uint16_t Checksum;
+} Program_t;
+
+#define PROGRAM_NO_CHECKSUM     0xFFFF
+#define PROGRAM_MAX_TEMP        1600    // Plausibility limit of the validation
+#define PROGRAM_MAX_VACCUM      100
+
+// EEPROM_shadowStatus() results
+#define PROGRAM_SHADOW_EMPTY    0   // Nothing loaded since the last publish
+#define PROGRAM_SHADOW_LOADING  1   // Read on its way
+#define PROGRAM_SHADOW_READY    2   // Validated, EEPROM_publishProgram() will take it
+#define PROGRAM_SHADOW_INVALID  3   // Blank, out of range or checksum mismatch
 // Function prototypes
 #define EEPROM_BASE_ADDR    0x0000  // the base adress 0x0000 for the default settings   5A
-#define EEPROM_MAX_ADDR     0x0FFF  // the 24c32 is 32 kilo byte
+#define EEPROM_MAX_ADDR     (EEPROM_SIZE - 1)  // last linear address of all chips, 0x0FFF for one 24C32
 #define PROGRAM_GROUP_SIZE  200     //each group consists of 10 Programs 
+#define PROGRAM_GROUP_COUNT 10      //groups 0 to 9
+#define PROGRAM_TABLE_END   (EEPROM_BASE_ADDR + (PROGRAM_GROUP_COUNT * PROGRAM_GROUP_SIZE)) // first address past the program table, 0x07D0
 #define PROGRAM_DATA_SIZE   20      //each program is 20 bytes
+#define PROGRAMS_PER_GROUP  (PROGRAM_GROUP_SIZE / PROGRAM_DATA_SIZE)
+#define PROGRAM_COUNT       (PROGRAM_GROUP_COUNT * PROGRAMS_PER_GROUP)
+#define PROGRAM_CACHE_SIZE  12      // selected program, its two neighbours and the rest of its group
 #define DEFULT_PROGRAM      0x0000  // the memory adress of the default settings
 /* group range from   0 to 9
  * Program range from 0 to 9
  */
 // Base address of the EEPROM
-// Load a program's parameters from EEPROM into global variables
+// Load a program's parameters from EEPROM, published to the global variables by EEPROM_publishProgram()
 void EEPROM_loadProgram(uint8_t groupIndex, uint8_t programIndex);
 
-// Save a program's parameters into EEPROM
-void EEPROM_saveProgramData(uint8_t groupIndex, uint8_t programIndex, 
+// Double buffered program switch for the control loop
+uint8_t EEPROM_prefetchProgram(uint8_t groupIndex, uint8_t programIndex);  // Read into the shadow buffer
+uint8_t EEPROM_shadowStatus();                                            // PROGRAM_SHADOW_*
+uint8_t EEPROM_shadowProgram(const Program_t* program);                   // Copy into the shadow buffer instead
+uint8_t EEPROM_publishProgram();                                          // Swap at a control cycle boundary
+const Program_t* EEPROM_activeProgram();                                  // Program the control loop runs
+
+// Record cache for the selection UI, filled around the selected program in idle bus time
+uint8_t  EEPROM_selectProgram(uint8_t groupIndex, uint8_t programIndex);  // Move the cursor, 1 on a cache hit
+const Program_t* EEPROM_cachedProgram(uint8_t groupIndex, uint8_t programIndex); // 0 until loaded or if invalid
+void     EEPROM_prefetchUpdate();                                         // Issue the next speculative read, call periodically
+uint16_t EEPROM_cacheHits();
+uint16_t EEPROM_cacheMisses();
+
+// Save a program's parameters into EEPROM, only the changed bytes are written.
+// One save runs at a time from EEPROM_prefetchUpdate(); a save returns 0 while
+// the previous one is still running, call it again.
+typedef struct {
+    uint16_t bytesWritten;
+    uint16_t bytesElided;   // Unchanged bytes not written
+    uint16_t pagesWritten;  // EEPROM write cycles, one per touched page
+    uint16_t pagesElided;   // Pages of saved records left untouched
+} EEPROM_SaveStats_t;
+
+uint8_t EEPROM_saveProgramData(uint8_t groupIndex, uint8_t programIndex, 
                         uint16_t standbyTemp, uint16_t holdTimeStandby, uint8_t rateOfHeatRise, 
                         uint16_t burningTemp, uint16_t burningTime, uint16_t coolingTemp, 
                         uint16_t coolingTime, uint8_t vaccumPercent, uint16_t vaccumStartTemp, 
                         uint16_t vaccumStopTemp);
 
 // Helper functions to read/write program variables
-uint16_t EEPROM_readProgramVariable(uint8_t groupIndex, uint8_t programIndex, uint8_t variableOffset);
-void EEPROM_writeProgramVariable(uint8_t groupIndex, uint8_t programIndex, uint8_t variableOffset, uint16_t value);
-void EEPROM_saveCurrentSettings(uint8_t groupIndex, uint8_t programIndex);
+uint8_t EEPROM_readProgramVariable(uint8_t groupIndex, uint8_t programIndex, uint8_t variableOffset, uint16_t* value);
+uint8_t EEPROM_writeProgramVariable(uint8_t groupIndex, uint8_t programIndex, uint8_t variableOffset, uint16_t value);
+uint8_t EEPROM_saveCurrentSettings(uint8_t groupIndex, uint8_t programIndex);
+uint8_t EEPROM_saveBusy();                                                // 1 until the last save is written
+const EEPROM_SaveStats_t* EEPROM_saveStats();
 #endif // PROGRAM_DATA_HANDLER_H
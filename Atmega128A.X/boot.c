@@ -0,0 +1,167 @@
+/*_____________________________{FILE_NAME}_____________________________________________________
+                                      ___           ___           ___
+ Author: Abdelrahman Selim           /\  \         /\  \         /\  \
+                                    /::\  \       /::\  \       /::\  \
+Created on: {DATE}                 /:/\:\  \     /:/\:\  \     /:/\:\  \
+                                  /::\ \:\  \   _\:\ \:\  \   /::\ \:\  \
+ Version: 01                     /:/\:\ \:\__\ /\ \:\ \:\__\ /:/\:\ \:\__\
+                                 \/__\:\/:/  / \:\ \:\ \/__/ \/__\:\/:/  /
+                                      \::/  /   \:\ \:\__\        \::/  /
+                                      /:/  /     \:\/:/  /        /:/  /
+ Brief : Boot Sequencer              /:/  /       \::/  /        /:/  /
+                                     \/__/         \/__/         \/__/
+ _________________________________________________________________________________________*/
+#include "boot.h"
+#include "EEPROM_24C32.h"
+#include <util/delay.h>
+#include "ProgramDataHandler.h"
+#include "rtc_ds1307.h"
+#include "data_log.h"
+#include "profile_store.h"
+#include "power_fail.h"
+#include "uart_trace.h"
+
+// Local Variables
+static boot_Report_t boot_Status;
+#ifdef POWERFAIL_ENABLE
+static powerfail_Progress_t boot_Progress;      // Restored from the power-fail page
+static uint8_t boot_Resumed;
+#endif
+
+
+/**
+ * @brief Starts the boot of every device without waiting for any of them.
+ *
+ * The EEPROM chips and the DS1307 register with the arbiter, which sets up
+ * each bus once. Then the RTC status read, the data log and profile
+ * recovery, the read of the default program and, with POWERFAIL_ENABLE, of
+ * the power-fail page are all queued together, so they share the bus
+ * instead of running one after the other. The main loop
+ * runs them with boot_Update() until boot_Ready().
+ *
+ * @param defaultTime Time set if the DS1307 was never initialized, 7 hex bytes
+ *                    as for DS1307_set(TIME); must stay valid until boot_Ready().
+ */
+void boot_Start(uint8_t* defaultTime) {
+    TCCR1A = 0;
+    TCNT1  = 0;
+    TCCR1B = BOOT_TIMER_CS;
+    if (BOOT_SETTLE_MS) {
+        _delay_ms(BOOT_SETTLE_MS);
+    }
+
+    eeprom_init(I2C_STANDARD_MODE);
+    DS1307_init_start(defaultTime, CLOCK_RUN, NO_FORCE_RESET);
+    datalog_Init();
+    profile_Init();
+    EEPROM_prefetchProgram(BOOT_GROUP, BOOT_PROGRAM);   // Refused only by a full queue, boot_Update() asks again
+#ifdef POWERFAIL_ENABLE
+    powerfail_Init();
+#endif
+}
+
+// Records the time a task finished
+static void boot_Done(uint8_t task, uint16_t* ms) {
+    if (!(boot_Status.done & task)) {
+        boot_Status.done |= task;
+        *ms = BOOT_TICKS_TO_MS(TCNT1);
+    }
+}
+
+// Gives up the tasks still running at the deadline. The DS1307 init is
+// stopped; the EEPROM tasks are left to finish in the background, as their
+// state machines still own their buffers: the built-in program stays active,
+// and the log and the profiles report ready late or not at all.
+static void boot_Fail(uint8_t tasks) {
+    boot_Status.failed |= tasks;
+    if (tasks & BOOT_TASK_RTC) {
+        DS1307_init_abort();
+        boot_Status.rtcState = DS1307_init_state();
+    }
+    if (tasks & BOOT_TASK_PROGRAM) {
+        boot_Status.programStatus = EEPROM_shadowStatus();
+    }
+}
+
+/**
+ * @brief Checks the boot tasks, run from the main loop next to i2c_DeviceUpdate().
+ *
+ * The default program is published as soon as it is read and valid; a blank
+ * or corrupt one leaves the built-in defaults in place. A page saved at a
+ * power failure is restored after it, so its setpoints replace the default
+ * program, and staged again right away for the resumed run. Once every task
+ * is done, or failed at BOOT_TASK_TIMEOUT_MS on the Timer1 tick, the time to
+ * ready is kept and, with tracing, sent as TRACE_EVT_BOOT.
+ */
+void boot_Update() {
+    if (boot_Ready()) {
+        return;
+    }
+    if (DS1307_init_state() == DS1307_INIT_KEPT || DS1307_init_state() == DS1307_INIT_RESET) {
+        boot_Status.rtcState = DS1307_init_state();
+        boot_Done(BOOT_TASK_RTC, &boot_Status.rtcMs);
+    }
+    if (!(boot_Status.done & BOOT_TASK_PROGRAM)) {
+        uint8_t status = EEPROM_shadowStatus();
+        if (status == PROGRAM_SHADOW_EMPTY) {
+            EEPROM_prefetchProgram(BOOT_GROUP, BOOT_PROGRAM);
+        } else if (status == PROGRAM_SHADOW_READY || status == PROGRAM_SHADOW_INVALID) {
+            if (status == PROGRAM_SHADOW_READY) {
+                EEPROM_publishProgram();
+            }
+            boot_Status.programStatus = status;
+            boot_Done(BOOT_TASK_PROGRAM, &boot_Status.programMs);
+            EEPROM_selectProgram(BOOT_GROUP, BOOT_PROGRAM);   // Fill the selection cache around it in idle bus time
+        }
+    }
+    if (datalog_Ready()) {
+        boot_Done(BOOT_TASK_LOG, &boot_Status.logMs);
+    }
+    if (profile_Ready()) {
+        boot_Done(BOOT_TASK_PROFILE, &boot_Status.profileMs);
+    }
+#ifdef POWERFAIL_ENABLE
+    if ((boot_Status.done & BOOT_TASK_PROGRAM) && !(boot_Status.done & BOOT_TASK_POWERFAIL)) {
+        uint8_t status = powerfail_Status();
+        if (status == POWERFAIL_SAVED && powerfail_Restore(&boot_Progress)) {
+            powerfail_Stage(&boot_Progress);
+            boot_Resumed = 1;
+            boot_Status.done |= BOOT_TASK_POWERFAIL;
+        } else if (status == POWERFAIL_NONE) {
+            boot_Status.done |= BOOT_TASK_POWERFAIL;
+        }
+    }
+#endif
+    if (TCNT1 >= BOOT_MS_TO_TICKS(BOOT_TASK_TIMEOUT_MS)) {
+        boot_Fail(BOOT_TASK_ALL & ~(boot_Status.done | boot_Status.failed));
+    }
+    if (boot_Ready()) {
+        boot_Status.readyMs = BOOT_TICKS_TO_MS(TCNT1);
+        TRACE(trace_Event(TRACE_EVT_BOOT, &boot_Status, sizeof(boot_Status)));
+    }
+}
+
+/**
+ * @brief Returns 1 once the controller is ready: every task done, or failed
+ * at the deadline (see boot_Report()->failed).
+ */
+uint8_t boot_Ready() {
+    return (boot_Status.done | boot_Status.failed) == BOOT_TASK_ALL;
+}
+
+/**
+ * @brief Returns the boot times, readyMs is 0 until boot_Ready().
+ */
+const boot_Report_t* boot_Report() {
+    return &boot_Status;
+}
+
+#ifdef POWERFAIL_ENABLE
+/**
+ * @brief Returns where the program interrupted by a power failure stopped,
+ * 0 if the last run was not interrupted. The control loop resumes from it.
+ */
+const powerfail_Progress_t* boot_ResumePoint() {
+    return boot_Resumed ? &boot_Progress : 0;
+}
+#endif
@@ -0,0 +1,68 @@
+#ifndef BOOT_H
+#define BOOT_H
+
+#include <avr/io.h>
+#include "power_fail.h"
+
+// Supply settling before the first bus access. The devices that are not up
+// yet simply do not acknowledge and their reads are retried, so no delay is
+// needed unless the board's power-good signal asks for one.
+#ifndef BOOT_SETTLE_MS
+#define BOOT_SETTLE_MS      0
+#endif
+
+// Time base of the boot measurement: Timer1 free running at clk/1024
+#define BOOT_TIMER_CS       ((1 << CS12) | (1 << CS10))
+#define BOOT_TIMER_DIV      1024UL
+#define BOOT_TICKS_TO_MS(t) ((uint16_t)(((uint32_t)(t) * BOOT_TIMER_DIV) / (F_CPU / 1000UL)))
+#define BOOT_MS_TO_TICKS(m) ((uint16_t)(((uint32_t)(m) * (F_CPU / 1000UL)) / BOOT_TIMER_DIV))
+
+// Deadline of every task, counted from boot_Start(). A task not done by then
+// (a device missing or NACKing for good) is marked failed and the controller
+// starts without it. Well above the <100 ms a healthy boot takes.
+#ifndef BOOT_TASK_TIMEOUT_MS
+#define BOOT_TASK_TIMEOUT_MS    250
+#endif
+#if (BOOT_TASK_TIMEOUT_MS * (F_CPU / 1000UL)) / BOOT_TIMER_DIV > 0xFFFFUL
+#error "boot deadline must come before Timer1 wraps"
+#endif
+
+// Default program, validated and published before the controller reports ready
+#define BOOT_GROUP          0
+#define BOOT_PROGRAM        0
+
+// Parts of the boot, one bit each in boot_Report_t.done and .failed
+#define BOOT_TASK_RTC       0x01    // DS1307 status read and, if needed, reset
+#define BOOT_TASK_PROGRAM   0x02    // Default program read, checked and published
+#define BOOT_TASK_LOG       0x04    // Data log write head recovered
+#define BOOT_TASK_PROFILE   0x08    // Profile heap map built
+#define BOOT_TASK_POWERFAIL 0x10    // Page of the last power failure read back and restored (power_fail.h)
+#ifdef POWERFAIL_ENABLE
+#define BOOT_TASK_ALL       0x1F
+#else
+#define BOOT_TASK_ALL       0x0F
+#endif
+
+typedef struct {
+    uint16_t readyMs;           // main() to the last task done
+    uint16_t rtcMs;             // main() to each task done
+    uint16_t programMs;
+    uint16_t logMs;
+    uint16_t profileMs;
+    uint8_t  done;              // BOOT_TASK_* finished
+    uint8_t  rtcState;          // DS1307_INIT_KEPT, DS1307_INIT_RESET or DS1307_INIT_FAILED
+    uint8_t  programStatus;     // PROGRAM_SHADOW_READY or PROGRAM_SHADOW_INVALID (defaults kept),
+                                // the state it was left in if the task failed
+    uint8_t  failed;            // BOOT_TASK_* given up at BOOT_TASK_TIMEOUT_MS
+} boot_Report_t;
+
+// Function prototypes
+void    boot_Start(uint8_t* defaultTime);   // Start every device at once, returns without waiting
+void    boot_Update();                      // Advance the boot, call from the main loop until boot_Ready()
+uint8_t boot_Ready();                       // 1 once every task is done or failed
+const boot_Report_t* boot_Report();         // Time to ready, per task, and the tasks that failed
+#ifdef POWERFAIL_ENABLE
+const powerfail_Progress_t* boot_ResumePoint(); // Progress of the interrupted program, 0 if none
+#endif
+
+#endif // BOOT_H
@@ -0,0 +1,272 @@
+/*_____________________________{FILE_NAME}_____________________________________________________
+                                      ___           ___           ___
+ Author: Abdelrahman Selim           /\  \         /\  \         /\  \
+                                    /::\  \       /::\  \       /::\  \
+Created on: {DATE}                 /:/\:\  \     /:/\:\  \     /:/\:\  \
+                                  /::\ \:\  \   _\:\ \:\  \   /::\ \:\  \
+ Version: 01                     /:/\:\ \:\__\ /\ \:\ \:\__\ /:/\:\ \:\__\
+                                 \/__\:\/:/  / \:\ \:\ \/__/ \/__\:\/:/  /
+                                      \::/  /   \:\ \:\__\        \::/  /
+                                      /:/  /     \:\/:/  /        /:/  /
+ Brief : EEPROM Data Logger          /:/  /       \::/  /        /:/  /
+                                     \/__/         \/__/         \/__/
+ _________________________________________________________________________________________*/
+#include "data_log.h"
+#include "rtc_ds1307.h"
+
+// Logger states, in the order they are passed through after datalog_Init()
+#define DATALOG_STATE_OFF           0   // datalog_Init() not called
+#define DATALOG_STATE_RECOVER_FIRST 1   // Reading the header of the first page
+#define DATALOG_STATE_RECOVER       2   // Binary search for the write head
+#define DATALOG_STATE_TIME_BASE     3   // Reading the DS1307 for the time base
+#define DATALOG_STATE_IDLE          4   // Accepting samples
+#define DATALOG_STATE_WRITE         5   // A full page waits for the block writer
+#define DATALOG_STATE_POLL          6   // The EEPROM writes the page
+
+static uint8_t  datalog_State;
+static uint8_t  datalog_Busy;                       // A read of the current state is on its way
+static uint8_t  datalog_Header[2];                  // Mark and sequence of the page being probed
+static uint8_t  datalog_FirstSequence;              // Sequence of page 0
+static uint16_t datalog_Low;                        // Binary search range [low, high)
+static uint16_t datalog_High;
+static uint16_t datalog_Probe;                      // Page being probed
+static uint16_t datalog_Head;                       // Next page to write
+static uint8_t  datalog_Sequence;                   // Sequence of the next page
+static uint8_t  datalog_TimeRaw[7];                 // DS1307 timekeeper registers
+static uint32_t datalog_TimeBase;                   // Ticks since 2000-01-01 at datalog_Init()
+static uint8_t  datalog_Page[DATALOG_PAGE_SIZE];    // Page being filled
+static uint8_t  datalog_Open;                       // datalog_Page holds samples
+static codec_Encoder_t datalog_Encoder;             // Writes the samples after the first into datalog_Page
+static uint32_t datalog_LastTime;                   // Elapsed ticks of the last sample
+static uint16_t datalog_DropCount;
+
+/**
+ * @brief Starts the logger.
+ *
+ * Nothing is read here; datalog_Update() first finds the write head with a
+ * binary search over the page headers (6 two-byte reads for the 32 pages of a 24C32), then
+ * reads the DS1307 once for the time base. Samples are accepted from then on.
+ */
+void datalog_Init() {
+    datalog_State = DATALOG_STATE_RECOVER_FIRST;
+    datalog_Busy = 0;
+    datalog_Open = 0;
+}
+
+/**
+ * @brief Returns 1 once the write head and time base are known.
+ */
+uint8_t datalog_Ready() {
+    return datalog_State >= DATALOG_STATE_IDLE;
+}
+
+/**
+ * @brief Returns the number of samples refused since reset.
+ */
+uint16_t datalog_Dropped() {
+    return datalog_DropCount;
+}
+
+/**
+ * @brief Hands the page in RAM to the block writer, which ACK polls after it.
+ *
+ * A block within one page is copied right away, so the RAM page is free
+ * again as soon as this succeeds.
+ */
+static uint8_t datalog_WritePage() {
+    uint16_t addr = DATALOG_REGION_START + (datalog_Head * DATALOG_PAGE_SIZE);
+    codec_EncodeFinish(&datalog_Encoder);
+    if (!eeprom_writeBlock(addr, DATALOG_PAGE_SIZE, datalog_Page)) {
+        datalog_State = DATALOG_STATE_WRITE;
+        return 0;
+    }
+    datalog_Head = (datalog_Head + 1) % DATALOG_PAGES;
+    datalog_Sequence++;
+    datalog_Open = 0;
+    datalog_State = DATALOG_STATE_POLL;
+    return 1;
+}
+
+/**
+ * @brief Starts a new page with one sample.
+ */
+static void datalog_OpenPage(uint32_t elapsed, int16_t value) {
+    uint32_t time = datalog_TimeBase + elapsed;
+    for (uint8_t i = 0; i < DATALOG_PAGE_SIZE; i++) {
+        datalog_Page[i] = 0xFF;
+    }
+    datalog_Page[DATALOG_HDR_MARK]         = DATALOG_PAGE_MARK;
+    datalog_Page[DATALOG_HDR_SEQUENCE]     = datalog_Sequence;
+    datalog_Page[DATALOG_HDR_TIME]         = (uint8_t) time;
+    datalog_Page[DATALOG_HDR_TIME + 1]     = (uint8_t)(time >> 8);
+    datalog_Page[DATALOG_HDR_TIME + 2]     = (uint8_t)(time >> 16);
+    datalog_Page[DATALOG_HDR_TIME + 3]     = (uint8_t)(time >> 24);
+    datalog_Page[DATALOG_HDR_PERIOD]       = 0;     // Set by the second sample
+    datalog_Page[DATALOG_HDR_VALUE]        = (uint8_t) value;
+    datalog_Page[DATALOG_HDR_VALUE + 1]    = (uint8_t)((uint16_t) value >> 8);
+    datalog_Page[DATALOG_HDR_COUNT]        = 1;
+    codec_EncodeInit(&datalog_Encoder, &datalog_Page[DATALOG_HEADER_SIZE], DATALOG_PAGE_SIZE - DATALOG_HEADER_SIZE, value);
+    datalog_Open = 1;
+    datalog_LastTime = elapsed;
+}
+
+/**
+ * @brief Adds one sample to the log.
+ *
+ * The samples of a page share one period, so only their values are stored,
+ * as delta_codec tokens: a ramp takes about a byte per sample and a soak a
+ * byte per 63 samples. A sample that does not fit or is off the period,
+ * also one at the time of the last sample (the period is never 0), closes
+ * the page and starts the next one with a full timestamp. Nothing
+ * touches the bus until a page is complete.
+ *
+ * @param elapsed Sample time in 1/DATALOG_TICKS_PER_SECOND s since datalog_Init().
+ * @param value   Sample value, e.g. temperature in degrees.
+ *
+ * @return uint8_t Returns 1 if the sample was stored, 0 if it was dropped
+ *         (logger not ready or the previous page still being written).
+ */
+uint8_t datalog_Append(uint32_t elapsed, int16_t value) {
+    if (datalog_State < DATALOG_STATE_IDLE) {
+        datalog_DropCount++;
+        return 0;
+    }
+    if (datalog_Open) {
+        uint32_t dt = elapsed - datalog_LastTime;
+        if (datalog_Page[DATALOG_HDR_PERIOD] == 0 && dt > 0 && dt <= 0xFF) {
+            datalog_Page[DATALOG_HDR_PERIOD] = (uint8_t) dt;
+        }
+        if (dt != 0 && dt == datalog_Page[DATALOG_HDR_PERIOD] && datalog_Page[DATALOG_HDR_COUNT] < DATALOG_PAGE_MAX_SAMPLES &&
+            codec_EncodePut(&datalog_Encoder, value)) {
+            datalog_Page[DATALOG_HDR_COUNT]++;
+            datalog_LastTime = elapsed;
+            return 1;
+        }
+        // Page full or off the period, the page has to go first
+        if (datalog_State != DATALOG_STATE_IDLE || !datalog_WritePage()) {
+            datalog_DropCount++;
+            return 0;
+        }
+    }
+    datalog_OpenPage(elapsed, value);
+    return 1;
+}
+
+/**
+ * @brief Writes the partly filled page, e.g. at the end of a firing.
+ *
+ * The unused bytes stay 0xFF; the next sample opens a new page.
+ *
+ * @return uint8_t Returns 1 if the page was queued or nothing was open.
+ */
+uint8_t datalog_Flush() {
+    if (!datalog_Open) {
+        return 1;
+    }
+    if (datalog_State != DATALOG_STATE_IDLE) {
+        return 0;
+    }
+    return datalog_WritePage();
+}
+
+/**
+ * @brief Checks the header read for the binary search.
+ *
+ * Page p of the current lap carries sequence (first + p); a page of the
+ * previous lap is DATALOG_PAGES behind and a blank or torn page has no mark,
+ * so the test is true for every page before the head and false after it.
+ */
+static uint8_t datalog_PageIsCurrent(uint16_t page) {
+    return datalog_Header[0] == DATALOG_PAGE_MARK &&
+           datalog_Header[1] == (uint8_t)(datalog_FirstSequence + page);
+}
+
+/**
+ * @brief Issues the header read of a page once and reports when it arrived.
+ *
+ * @return uint8_t Returns 1 when datalog_Header holds the header of the page.
+ */
+static uint8_t datalog_ReadHeader(uint16_t page) {
+    if (!datalog_Busy) {
+        datalog_Busy = eeprom_readArray(DATALOG_REGION_START + (page * DATALOG_PAGE_SIZE), 2, datalog_Header);
+        return 0;
+    }
+    if (eeprom_readPending()) {
+        return 0;
+    }
+    datalog_Busy = 0;
+    return 1;
+}
+
+/**
+ * @brief Runs the logger state machine, call it from the main loop.
+ *
+ * Each call does at most one step and never waits on the bus.
+ */
+void datalog_Update() {
+    switch (datalog_State) {
+        case DATALOG_STATE_RECOVER_FIRST:
+            if (!datalog_ReadHeader(0)) {
+                break;
+            }
+            if (datalog_Header[0] != DATALOG_PAGE_MARK) {
+                // Empty log
+                datalog_Head = 0;
+                datalog_Sequence = 0;
+                datalog_State = DATALOG_STATE_TIME_BASE;
+                break;
+            }
+            datalog_FirstSequence = datalog_Header[1];
+            datalog_Low = 1;
+            datalog_High = DATALOG_PAGES;
+            datalog_Probe = (datalog_Low + datalog_High) / 2;
+            datalog_State = DATALOG_STATE_RECOVER;
+            break;
+
+        case DATALOG_STATE_RECOVER:
+            if (datalog_Low < datalog_High) {
+                if (!datalog_ReadHeader(datalog_Probe)) {
+                    break;
+                }
+                if (datalog_PageIsCurrent(datalog_Probe)) {
+                    datalog_Low = datalog_Probe + 1;
+                } else {
+                    datalog_High = datalog_Probe;
+                }
+                datalog_Probe = (datalog_Low + datalog_High) / 2;
+                break;
+            }
+            // datalog_Low is the first page that is not part of the current lap
+            datalog_Head = datalog_Low % DATALOG_PAGES;
+            datalog_Sequence = (uint8_t)(datalog_FirstSequence + datalog_Low);
+            datalog_State = DATALOG_STATE_TIME_BASE;
+            break;
+
+        case DATALOG_STATE_TIME_BASE:
+            if (!datalog_Busy) {
+                // A full DS1307 queue is tried again on the next pass
+                datalog_Busy = time_i2c_read_multi(DS1307_I2C_ADDRESS, DS1307_REGISTER_SECONDS, datalog_TimeRaw, sizeof(datalog_TimeRaw));
+                break;
+            }
+            if (DS1307_read_pending()) {
+                break;
+            }
+            datalog_Busy = 0;
+            datalog_TimeBase = DS1307_raw_to_seconds(datalog_TimeRaw) * DATALOG_TICKS_PER_SECOND;
+            datalog_State = DATALOG_STATE_IDLE;
+            break;
+
+        case DATALOG_STATE_WRITE:
+            datalog_WritePage();
+            break;
+
+        case DATALOG_STATE_POLL:
+            if (!eeprom_blockBusy()) {
+                datalog_State = DATALOG_STATE_IDLE;  // Write cycle over
+            }
+            break;
+
+        default:
+            break;
+    }
+}
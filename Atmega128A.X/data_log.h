@@ -0,0 +1,51 @@
+#ifndef DATA_LOG_H
+#define DATA_LOG_H
+
+#include <stdint.h>
+#include "EEPROM_24C32.h"
+#include "ProgramDataHandler.h"
+#include "delta_codec.h"
+
+// Circular log of timestamped samples (e.g. kiln temperature) in the 24C32,
+// written one whole page at a time behind the profile store (profile_store.h)
+#define DATALOG_REGION_START        0x0C00                      // 0x0800 - 0x0BFF hold the profiles
+#define DATALOG_PAGE_SIZE           32                          // Fixed by tools/datalog_decode.py, inside one EEPROM page
+#define DATALOG_PAGES_FIT           ((EEPROM_SIZE - DATALOG_REGION_START) / DATALOG_PAGE_SIZE)
+// The rest of the EEPROM, 32 pages on a 24C32. One page less if that is a multiple
+// of 256: the previous lap would carry the same one-byte sequence as the current one.
+#define DATALOG_PAGES               (DATALOG_PAGES_FIT - ((DATALOG_PAGES_FIT % 256) == 0))
+#define DATALOG_TICKS_PER_SECOND    4                           // Time resolution of the samples
+#define DATALOG_PAGE_MARK           0x4D                        // First byte of every written page
+
+// Page layout, multi-byte fields little endian:
+//   [0] DATALOG_PAGE_MARK  [1] sequence  [2..5] time of the first sample in ticks since 2000-01-01
+//   [6] sample period in ticks  [7..8] first value  [9] sample count  [10..] delta_codec tokens
+// Samples of a page are evenly spaced; a sample off the period starts a new page.
+#define DATALOG_HDR_MARK            0
+#define DATALOG_HDR_SEQUENCE        1
+#define DATALOG_HDR_TIME            2
+#define DATALOG_HDR_PERIOD          6
+#define DATALOG_HDR_VALUE           7
+#define DATALOG_HDR_COUNT           9
+#define DATALOG_HEADER_SIZE         10
+#define DATALOG_PAGE_MAX_SAMPLES    0xFF
+
+#if EEPROM_PAGE_SIZE % DATALOG_PAGE_SIZE
+#error "a log page must not cross an EEPROM page"
+#endif
+#if (DATALOG_REGION_START < PROGRAM_TABLE_END) || (DATALOG_REGION_START % DATALOG_PAGE_SIZE)
+#error "log region must start on a page boundary past the program table"
+#endif
+#if EEPROM_SIZE < DATALOG_REGION_START + (2 * DATALOG_PAGE_SIZE)
+#error "log region does not fit in the EEPROM"
+#endif
+
+// Function prototypes
+void     datalog_Init();                                    // Recover the write head and the RTC time base
+void     datalog_Update();                                  // Advance recovery and page writes, call periodically
+uint8_t  datalog_Ready();                                   // 1 once samples are accepted
+uint8_t  datalog_Append(uint32_t elapsed, int16_t value);   // Add a sample, elapsed in ticks since datalog_Init()
+uint8_t  datalog_Flush();                                   // Write the partly filled page now
+uint16_t datalog_Dropped();                                 // Samples refused because a page write was still running
+
+#endif // DATA_LOG_H
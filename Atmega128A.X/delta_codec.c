@@ -0,0 +1,237 @@
+/*_____________________________{FILE_NAME}_____________________________________________________
+                                      ___           ___           ___
+ Author: Abdelrahman Selim           /\  \         /\  \         /\  \
+                                    /::\  \       /::\  \       /::\  \
+Created on: {DATE}                 /:/\:\  \     /:/\:\  \     /:/\:\  \
+                                  /::\ \:\  \   _\:\ \:\  \   /::\ \:\  \
+ Version: 01                     /:/\:\ \:\__\ /\ \:\ \:\__\ /:/\:\ \:\__\
+                                 \/__\:\/:/  / \:\ \:\ \/__/ \/__\:\/:/  /
+                                      \::/  /   \:\ \:\__\        \::/  /
+                                      /:/  /     \:\/:/  /        /:/  /
+ Brief : Delta / Varint Codec        /:/  /       \::/  /        /:/  /
+                                     \/__/         \/__/         \/__/
+ _________________________________________________________________________________________*/
+#include "delta_codec.h"
+
+// Bytes needed for a token
+static uint8_t codec_TokenSize(uint32_t token) {
+    if (token < 0x80) {
+        return 1;
+    }
+    return (token < 0x4000) ? 2 : 3;
+}
+
+// Bytes needed for the run token of run repeats, 0 if there is no run
+static uint8_t codec_RunSize(uint8_t run) {
+    return run ? codec_TokenSize(((uint32_t) run << 1) | 1) : 0;
+}
+
+// Appends a token, the caller checked that it fits
+static void codec_PutToken(codec_Encoder_t* enc, uint32_t token) {
+    while (token >= 0x80) {
+        enc->out[enc->length++] = (uint8_t) token | 0x80;
+        token >>= 7;
+    }
+    enc->out[enc->length++] = (uint8_t) token;
+}
+
+/**
+ * @brief Starts encoding into a window.
+ *
+ * The first value is the reference of the deltas and is not written to the
+ * window; the caller keeps it, e.g. in a page header.
+ *
+ * @param enc   Encoder state.
+ * @param out   Window the tokens are written to.
+ * @param size  Window size in bytes.
+ * @param first First value of the series.
+ */
+void codec_EncodeInit(codec_Encoder_t* enc, uint8_t* out, uint8_t size, int16_t first) {
+    enc->out = out;
+    enc->size = size;
+    enc->length = 0;
+    enc->run = 0;
+    enc->last = first;
+}
+
+/**
+ * @brief Adds the next value of the series.
+ *
+ * A repeat of the last value only extends the pending run; space for the run
+ * token is always kept, so codec_EncodeFinish() cannot fail. Nothing is
+ * changed when the value is refused, the caller can finish the window and
+ * start the next one with it.
+ *
+ * @return uint8_t Returns 1 if the value was added, 0 if the window is full.
+ */
+uint8_t codec_EncodePut(codec_Encoder_t* enc, int16_t value) {
+    int32_t delta = (int32_t) value - enc->last;
+
+    if (delta == 0) {
+        if (enc->run == 0xFF) {
+            codec_PutToken(enc, ((uint32_t) enc->run << 1) | 1);
+            enc->run = 0;
+        }
+        if (enc->length + codec_RunSize(enc->run + 1) > enc->size) {
+            return 0;
+        }
+        enc->run++;
+        return 1;
+    }
+
+    uint32_t token = (((uint32_t) delta << 1) ^ (uint32_t)(delta >> 31)) << 1;  // zigzag(delta) << 1
+    if (enc->length + codec_RunSize(enc->run) + codec_TokenSize(token) > enc->size) {
+        return 0;
+    }
+    if (enc->run) {
+        codec_PutToken(enc, ((uint32_t) enc->run << 1) | 1);
+        enc->run = 0;
+    }
+    codec_PutToken(enc, token);
+    enc->last = value;
+    return 1;
+}
+
+/**
+ * @brief Writes the pending run.
+ *
+ * @return uint8_t The number of bytes used in the window.
+ */
+uint8_t codec_EncodeFinish(codec_Encoder_t* enc) {
+    if (enc->run) {
+        codec_PutToken(enc, ((uint32_t) enc->run << 1) | 1);
+        enc->run = 0;
+    }
+    return enc->length;
+}
+
+/**
+ * @brief Starts decoding a window written by the encoder.
+ *
+ * @param dec   Decoder state.
+ * @param in    Encoded tokens.
+ * @param size  Number of encoded bytes.
+ * @param first First value of the series, as passed to codec_EncodeInit().
+ */
+void codec_DecodeInit(codec_Decoder_t* dec, const uint8_t* in, uint8_t size, int16_t first) {
+    dec->in = in;
+    dec->size = size;
+    dec->position = 0;
+    dec->run = 0;
+    dec->last = first;
+}
+
+/**
+ * @brief Returns the next value after the first one.
+ *
+ * @return uint8_t Returns 1 if value was set, 0 at the end of the data or on
+ *         a malformed token.
+ */
+uint8_t codec_DecodeNext(codec_Decoder_t* dec, int16_t* value) {
+    if (dec->run) {
+        dec->run--;
+        *value = dec->last;
+        return 1;
+    }
+
+    uint32_t token = 0;
+    uint8_t shift = 0;
+    uint8_t byte;
+    do {
+        if (dec->position >= dec->size || shift >= 7 * CODEC_TOKEN_MAX_SIZE) {
+            return 0;
+        }
+        byte = dec->in[dec->position++];
+        token |= (uint32_t)(byte & 0x7F) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+
+    if (token & 1) {
+        if ((token >> 1) == 0 || (token >> 1) > 0xFF) {
+            return 0;
+        }
+        dec->run = (uint8_t)(token >> 1) - 1;
+    } else {
+        uint32_t zigzag = token >> 1;
+        dec->last += (int16_t)((zigzag >> 1) ^ -(int32_t)(zigzag & 1));
+    }
+    *value = dec->last;
+    return 1;
+}
+
+
+#ifdef CODEC_BENCH_ENABLE
+#include "i2c_driver.h"
+
+#define CODEC_BENCH_SAMPLES     1024
+#define CODEC_BENCH_WINDOW      128
+
+/* Synthetic firing at a few samples per second: ramp at 3 degrees per sample
+ * with a degree of overshoot every 8 samples, soak at 925 with a one degree
+ * ripple, then cooling at 2 degrees per sample. */
+static int16_t codec_BenchSample(uint16_t i) {
+    if (i < 300) {
+        return 25 + (int16_t)(i * 3) + ((i & 7) == 0);
+    }
+    if (i < 600) {
+        return 925 + ((i & 15) == 0);
+    }
+    return 925 - (int16_t)((i - 600) * 2);
+}
+
+/**
+ * @brief Measures the codec on a synthetic firing profile.
+ *
+ * The profile is encoded into CODEC_BENCH_WINDOW byte windows, each decoded
+ * again right away. Times come from Timer3 at clk/I2C_STATS_TIMER_DIV, with
+ * the cost of generating the samples subtracted.
+ *
+ * @param result Compression and cycles per sample.
+ */
+void codec_Benchmark(codec_Bench_t* result) {
+    static uint8_t window[CODEC_BENCH_WINDOW];
+    codec_Encoder_t enc;
+    codec_Decoder_t dec;
+    volatile int16_t sink;
+    int16_t value;
+    uint32_t encodeTicks = 0, decodeTicks = 0, generateTicks = 0;
+    uint16_t bytes = 0;
+    uint16_t i = 0;
+    uint16_t start;
+
+    TCCR3A = 0;
+    TCCR3B = I2C_STATS_TIMER_CS;
+    while (i < CODEC_BENCH_SAMPLES) {
+        int16_t first = codec_BenchSample(i++);
+        start = i;
+
+        uint16_t t0 = TCNT3;
+        codec_EncodeInit(&enc, window, sizeof(window), first);
+        while (i < CODEC_BENCH_SAMPLES && codec_EncodePut(&enc, codec_BenchSample(i))) {
+            i++;
+        }
+        codec_EncodeFinish(&enc);
+        encodeTicks += (uint16_t)(TCNT3 - t0);
+        bytes += sizeof(first) + enc.length;
+
+        t0 = TCNT3;
+        for (uint16_t j = start; j <= i && j < CODEC_BENCH_SAMPLES; j++) {
+            sink = codec_BenchSample(j);
+        }
+        generateTicks += (uint16_t)(TCNT3 - t0);
+
+        t0 = TCNT3;
+        codec_DecodeInit(&dec, window, enc.length, first);
+        while (codec_DecodeNext(&dec, &value)) {
+            sink = value;
+        }
+        decodeTicks += (uint16_t)(TCNT3 - t0);
+    }
+    (void) sink;
+
+    result->samples = CODEC_BENCH_SAMPLES;
+    result->encodedBytes = bytes;
+    result->encodeCycles = ((encodeTicks - generateTicks) * I2C_STATS_TIMER_DIV) / CODEC_BENCH_SAMPLES;
+    result->decodeCycles = (decodeTicks * I2C_STATS_TIMER_DIV) / CODEC_BENCH_SAMPLES;
+}
+#endif
@@ -0,0 +1,53 @@
+#ifndef DELTA_CODEC_H
+#define DELTA_CODEC_H
+
+#include <stdint.h>
+
+// Delta codec for slowly changing series (temperatures, profile fields).
+// Every token is an unsigned LEB128 varint (7 bits per byte, bit 7 = more):
+//   (zigzag(delta) << 1)      the next value differs from the last one by delta
+//   (run << 1) | 1            the last value repeats run more times
+// so deltas up to +-31 and runs up to 63 take one byte.
+#define CODEC_TOKEN_MAX_SIZE  3     // An int16_t delta needs at most 18 bits
+
+// Uncomment or pass -DCODEC_BENCH_ENABLE to build codec_Benchmark()
+//#define CODEC_BENCH_ENABLE
+
+// Encoder writing into a caller supplied window, e.g. the free part of an EEPROM page
+typedef struct {
+    uint8_t* out;       // Window
+    uint8_t  size;      // Window size
+    uint8_t  length;    // Bytes written, excluding the pending run
+    uint8_t  run;       // Repeats of last not written yet
+    int16_t  last;      // Last value put
+} codec_Encoder_t;
+
+// Decoder reading tokens from a buffer
+typedef struct {
+    const uint8_t* in;
+    uint8_t  size;
+    uint8_t  position;
+    uint8_t  run;       // Repeats of last still to be returned
+    int16_t  last;
+} codec_Decoder_t;
+
+#ifdef CODEC_BENCH_ENABLE
+typedef struct {
+    uint16_t samples;           // Samples in the benchmark profile
+    uint16_t encodedBytes;      // Size after encoding
+    uint16_t encodeCycles;      // CPU cycles per sample, encoder
+    uint16_t decodeCycles;      // CPU cycles per sample, decoder
+} codec_Bench_t;
+#endif
+
+// Function prototypes
+void    codec_EncodeInit(codec_Encoder_t* enc, uint8_t* out, uint8_t size, int16_t first); // first is stored by the caller
+uint8_t codec_EncodePut(codec_Encoder_t* enc, int16_t value);       // 0 if the value does not fit any more
+uint8_t codec_EncodeFinish(codec_Encoder_t* enc);                   // Write the pending run, returns the length
+void    codec_DecodeInit(codec_Decoder_t* dec, const uint8_t* in, uint8_t size, int16_t first);
+uint8_t codec_DecodeNext(codec_Decoder_t* dec, int16_t* value);     // 0 at the end of the data
+#ifdef CODEC_BENCH_ENABLE
+void    codec_Benchmark(codec_Bench_t* result);                     // Encode and decode a firing profile, timed with Timer3
+#endif
+
+#endif // DELTA_CODEC_H
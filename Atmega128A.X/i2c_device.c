@@ -0,0 +1,429 @@
+/*_____________________________{FILE_NAME}_____________________________________________________
+                                      ___           ___           ___
+ Author: Abdelrahman Selim           /\  \         /\  \         /\  \
+                                    /::\  \       /::\  \       /::\  \
+Created on: {DATE}                 /:/\:\  \     /:/\:\  \     /:/\:\  \
+                                  /::\ \:\  \   _\:\ \:\  \   /::\ \:\  \
+ Version: 01                     /:/\:\ \:\__\ /\ \:\ \:\__\ /:/\:\ \:\__\
+                                 \/__\:\/:/  / \:\ \:\ \/__/ \/__\:\/:/  /
+                                      \::/  /   \:\ \:\__\        \::/  /
+                                      /:/  /     \:\/:/  /        /:/  /
+ Brief : I2C Device Registry         /:/  /       \::/  /        /:/  /
+                                     \/__/         \/__/         \/__/
+ _________________________________________________________________________________________*/
+#include "i2c_device.h"
+#include "uart_trace.h"
+
+// Arbiter state of one bus
+typedef struct {
+    const i2c_Bus_t* bus;
+    i2c_Device_t*    active;            // Device whose read is on the bus, 0 if none
+    uint32_t         speed;             // Current SCL frequency of the bus
+    uint16_t         spanAddress;       // First address of the read on the bus
+    uint8_t          spanLength;        // Bytes of the read on the bus
+    uint8_t          spanRequests;      // Oldest requests merged into it
+    uint8_t          spanQueued;        // Requests queued when it started
+    uint8_t          next;              // Round robin position among the devices
+} i2c_Arbiter_t;
+
+// Local Variables
+static i2c_Device_t* i2c_Devices[I2C_MAX_DEVICES];   // Registered devices
+static uint8_t       i2c_DeviceCount;                // Number of registered devices
+static i2c_Arbiter_t i2c_Arbiters[I2C_MAX_BUSES];    // One per bus in use
+static uint8_t       i2c_ArbiterCount;
+
+static uint8_t i2c_TwiReadBusy() {
+    return i2cReadBusyFlag;
+}
+
+const i2c_Bus_t i2c_TwiBus = {
+    i2c_Init, i2c_SendArray, i2c_SendHeaderArray, i2c_GetData, i2c_CopyFromRxBuffer, i2c_ReleaseRxBuffer,
+    i2c_TwiReadBusy, i2c_WriteBufferUsed, i2c_Probe, i2c_ProbeTicket, i2c_ProbeResult, i2c_Update,
+    I2C_WRITE_BUFFER_SIZE, I2C_READ_BUFFER_SIZE - 1
+};
+
+static inline const i2c_Bus_t* i2c_DeviceBus(i2c_Device_t* device) {
+    return device->bus ? device->bus : &i2c_TwiBus;
+}
+
+
+/**
+ * @brief Adds a device to the bus arbiter.
+ *
+ * Each bus always runs at the speed of its slowest registered device, so the
+ * bus is re-initialized whenever a slower device joins. Registering the same
+ * descriptor twice has no effect.
+ *
+ * @param device The device descriptor, must stay valid for the program lifetime.
+ *
+ * @return uint8_t Returns 1 if the device is registered, 0 if the registry is full.
+ */
+uint8_t i2c_DeviceRegister(i2c_Device_t* device) {
+    const i2c_Bus_t* bus = i2c_DeviceBus(device);
+    i2c_Arbiter_t* arbiter = 0;
+
+    for (uint8_t i = 0; i < i2c_DeviceCount; i++) {
+        if (i2c_Devices[i] == device) {
+            return 1;  // Already registered
+        }
+    }
+    for (uint8_t i = 0; i < i2c_ArbiterCount; i++) {
+        if (i2c_Arbiters[i].bus == bus) {
+            arbiter = &i2c_Arbiters[i];
+        }
+    }
+    if (i2c_DeviceCount >= I2C_MAX_DEVICES || (!arbiter && i2c_ArbiterCount >= I2C_MAX_BUSES)) {
+        return 0;  // Registry is full
+    }
+    if (!arbiter) {
+        arbiter = &i2c_Arbiters[i2c_ArbiterCount++];
+        arbiter->bus = bus;
+    }
+    i2c_Devices[i2c_DeviceCount++] = device;
+
+    if (arbiter->speed == 0 || device->speed < arbiter->speed) {
+        arbiter->speed = device->speed;
+        bus->init(arbiter->speed);
+    }
+    return 1;
+}
+
+/**
+ * @brief Changes the highest SCL frequency of a registered device.
+ *
+ * The bus is set to the slowest of its devices again, so raising the speed of
+ * one device only speeds the bus up if no slower device shares it. Like
+ * i2c_DeviceRegister() it re-initializes the bus, call it while no transfer runs.
+ *
+ * @param device The registered device descriptor.
+ * @param speed  The new SCL frequency in Hz.
+ */
+void i2c_DeviceSetSpeed(i2c_Device_t* device, uint32_t speed) {
+    const i2c_Bus_t* bus = i2c_DeviceBus(device);
+    uint32_t slowest = speed;
+
+    device->speed = speed;
+    for (uint8_t i = 0; i < i2c_DeviceCount; i++) {
+        if (i2c_DeviceBus(i2c_Devices[i]) == bus && i2c_Devices[i]->speed < slowest) {
+            slowest = i2c_Devices[i]->speed;
+        }
+    }
+    for (uint8_t i = 0; i < i2c_ArbiterCount; i++) {
+        if (i2c_Arbiters[i].bus == bus && i2c_Arbiters[i].speed != slowest) {
+            i2c_Arbiters[i].speed = slowest;
+            bus->init(slowest);
+        }
+    }
+}
+
+/**
+ * @brief Queues a read of a device register / memory range.
+ *
+ * A range longer than the receive buffer of the bus (bus->maxRead) is queued as
+ * several requests, which are read back to back; either all of them or none
+ * are queued.
+ *
+ * @param device   The device to read from.
+ * @param reg      Register or memory address, sent with device->registerWidth bytes.
+ * @param length   Number of bytes to read.
+ * @param dataPtr  Where the data will be stored once it arrives.
+ *
+ * @return uint8_t Returns 1 if the request was queued, 0 if the device queue is full.
+ */
+uint8_t i2c_DeviceRead(i2c_Device_t* device, uint16_t reg, uint8_t length, void* dataPtr) {
+    uint8_t maxRead = i2c_DeviceBus(device)->maxRead;
+    uint8_t* data = dataPtr;
+    uint8_t pieces = (length + maxRead - 1) / maxRead;
+
+    if (i2c_QueueCount(device->readQueue) + pieces > device->readQueue->mask + 1) {
+        return 0;
+    }
+    while (length > maxRead) {
+        i2c_QueueAdd(device->readQueue, reg, maxRead, data);
+        reg    += maxRead;
+        data   += maxRead;
+        length -= maxRead;
+    }
+    return i2c_QueueAdd(device->readQueue, reg, length, data);
+}
+
+/**
+ * @brief Returns 1 while any read of the device has not been delivered yet.
+ *
+ * Requests stay in the device queue until their data is delivered, so the queue
+ * count covers both the waiting requests and the one on the bus.
+ */
+uint8_t i2c_DeviceReadPending(i2c_Device_t* device) {
+    return i2c_QueueCount(device->readQueue) > 0;
+}
+
+/**
+ * @brief Returns a ticket for the reads queued so far, for i2c_DeviceReadDone().
+ *
+ * The ticket is the free running head of the device queue: requests complete
+ * in order, so the reads queued before the call are delivered once the tail
+ * has caught up with it.
+ */
+uint8_t i2c_DeviceReadTicket(i2c_Device_t* device) {
+    return device->readQueue->head;
+}
+
+/**
+ * @brief Returns 1 once every read queued before the ticket was taken has been
+ * delivered, whatever was queued after it.
+ */
+uint8_t i2c_DeviceReadDone(i2c_Device_t* device, uint8_t ticket) {
+    return (int8_t)(device->readQueue->tail - ticket) >= 0;
+}
+
+/**
+ * @brief Drops every read of the device that has not been delivered yet.
+ *
+ * The requests are marked as served (length 0), so the arbiter removes them
+ * without bus traffic, and a read already on the bus is finished but not
+ * copied. The destinations are not written any more once this returns.
+ */
+void i2c_DeviceReadCancel(i2c_Device_t* device) {
+    for (uint8_t i = 0; i < i2c_QueueCount(device->readQueue); i++) {
+        i2c_QueueAt(device->readQueue, i)->length = 0;
+    }
+}
+
+/**
+ * @brief Queues a write transaction to the device on the bus it is wired to.
+ *
+ * @return uint8_t Returns 1 if queued, 0 if the write buffer of the bus is full.
+ */
+uint8_t i2c_DeviceWrite(i2c_Device_t* device, uint8_t length, uint8_t* data) {
+    return i2c_DeviceBus(device)->sendArray(device->address, length, data);
+}
+
+/**
+ * @brief Queues a write of data to a device register / memory address.
+ *
+ * The register address (device->registerWidth bytes, most significant first)
+ * and the data go to the write buffer as two segments of one frame, so no
+ * frame is assembled on the stack whatever the length.
+ *
+ * @return uint8_t Returns 1 if queued, 0 if the write buffer of the bus is full.
+ */
+uint8_t i2c_DeviceWriteRegister(i2c_Device_t* device, uint16_t reg, uint8_t length, const uint8_t* data) {
+    uint8_t header[2];
+
+    if (device->registerWidth == 2) {
+        header[0] = reg >> 8;
+        header[1] = (uint8_t) reg;
+    } else {
+        header[0] = (uint8_t) reg;
+    }
+    return i2c_DeviceBus(device)->sendHeaderArray(device->address, device->registerWidth, header, length, data);
+}
+
+/**
+ * @brief Returns the bytes waiting in the write buffer of the device's bus.
+ */
+uint8_t i2c_DeviceWritesQueued(i2c_Device_t* device) {
+    return i2c_DeviceBus(device)->writeBufferUsed();
+}
+
+/**
+ * @brief Queues an address-only write, e.g. for ACK polling. Take
+ * i2c_DeviceProbeTicket() right after it succeeded.
+ */
+uint8_t i2c_DeviceProbe(i2c_Device_t* device) {
+    return i2c_DeviceBus(device)->probe(device->address);
+}
+
+/**
+ * @brief Returns the ticket of the last probe queued on the device's bus.
+ */
+uint8_t i2c_DeviceProbeTicket(i2c_Device_t* device) {
+    return i2c_DeviceBus(device)->probeTicket();
+}
+
+/**
+ * @brief Returns the I2C_PROBE_* outcome of the probe with the ticket, not
+ * that of a probe another driver queued on the same bus meanwhile.
+ */
+uint8_t i2c_DeviceProbeResult(i2c_Device_t* device, uint8_t ticket) {
+    return i2c_DeviceBus(device)->probeResult(ticket);
+}
+
+/**
+ * @brief Starts the oldest read request of a device on its bus.
+ *
+ * Sends the register address (most significant byte first, nothing for a
+ * registerWidth of 0) followed by the read request. The read buffer of a bus is
+ * shared, so only one read can be on each bus at a time.
+ *
+ * For devices flagged I2C_DEVICE_COALESCE the read is extended over the
+ * following requests as long as each one continues or overlaps the span read so
+ * far, so a burst of field reads becomes one sequential read. Requests already
+ * served by an earlier read (see i2c_DeviceDeliver()) are dropped here without
+ * any bus traffic.
+ *
+ * @return uint8_t Returns 1 if the read was started.
+ */
+static uint8_t i2c_DeviceStartRead(i2c_Arbiter_t* arbiter, i2c_Device_t* device) {
+    const i2c_Bus_t* bus = arbiter->bus;
+    i2c_Request_t* request;
+    uint8_t reg[2];
+
+    while ((request = i2c_QueuePeek(device->readQueue)) && request->length == 0) {
+        i2c_QueueRemove(device->readQueue);
+    }
+    // Enough space for the register write and the read request (address + length each)
+    if (!request || (bus->writeBufferUsed() + device->registerWidth + 4) >= (bus->writeBufferSize - 1)) {
+        return 0;
+    }
+
+    arbiter->spanAddress  = request->address;
+    arbiter->spanLength   = request->length;
+    arbiter->spanRequests = 1;
+    arbiter->spanQueued   = i2c_QueueCount(device->readQueue);
+    if (device->flags & I2C_DEVICE_COALESCE) {
+        while (arbiter->spanRequests < arbiter->spanQueued) {
+            i2c_Request_t* next = i2c_QueueAt(device->readQueue, arbiter->spanRequests);
+            uint16_t end = arbiter->spanAddress + arbiter->spanLength;
+
+            if (next->length == 0) {
+                arbiter->spanRequests++;    // Already served, removed with the others
+                continue;
+            }
+            if (next->address < arbiter->spanAddress || next->address > end) {
+                break;  // Gap or behind the span, keep the FIFO order
+            }
+            if (next->address + next->length > end) {
+                if (next->address + next->length - arbiter->spanAddress > bus->maxRead) {
+                    break;
+                }
+                arbiter->spanLength = next->address + next->length - arbiter->spanAddress;
+            }
+            arbiter->spanRequests++;
+        }
+    }
+
+    if (device->registerWidth == 2) {
+        reg[0] = arbiter->spanAddress >> 8;
+        reg[1] = (uint8_t) arbiter->spanAddress;
+    } else {
+        reg[0] = (uint8_t) arbiter->spanAddress;
+    }
+    if (device->registerWidth) {
+        bus->sendArray(device->address, device->registerWidth, reg);
+    }
+    return bus->getData(device->address, arbiter->spanLength);
+}
+
+/**
+ * @brief Hands a finished read to every request it covers.
+ *
+ * The requests merged at start are removed in order. Later requests that were
+ * already queued when the read started and lie entirely inside the span (in
+ * practice duplicates of an address) get their data as well and are marked
+ * done with a length of 0; requests queued after the start are left alone, a
+ * write queued in between may have changed the memory.
+ *
+ * @return uint8_t Returns 1 once the whole read arrived and was delivered.
+ */
+static uint8_t i2c_DeviceDeliver(i2c_Arbiter_t* arbiter) {
+    const i2c_Bus_t* bus = arbiter->bus;
+    i2c_Device_t* device = arbiter->active;
+    i2c_Request_t* request;
+    uint8_t last;
+
+    // Bytes arrive one by one, wait until the whole read is in
+    if (!bus->copyFromRx(arbiter->spanLength - 1, &last, 1)) {
+        return 0;
+    }
+    for (uint8_t i = 0; i < arbiter->spanQueued; i++) {
+        request = i2c_QueueAt(device->readQueue, i);
+        if (request->length == 0) {
+            continue;   // Served by an earlier read, only removed here
+        }
+        if (i < arbiter->spanRequests || (request->address >= arbiter->spanAddress
+                && request->address + request->length <= arbiter->spanAddress + arbiter->spanLength)) {
+            bus->copyFromRx(request->address - arbiter->spanAddress, request->dataPtr, request->length);
+            I2C_STATS(if (i != 0) { i2c_Stats.readsMerged++; });
+            if (i >= arbiter->spanRequests) {
+                request->length = 0;
+            }
+        }
+    }
+    bus->releaseRx(arbiter->spanLength);
+    TRACE(trace_Event(TRACE_EVT_I2C_READ, (uint8_t[]){device->address, (uint8_t) arbiter->spanAddress,
+                                                     arbiter->spanAddress >> 8, arbiter->spanLength}, 4));
+    for (uint8_t i = 0; i < arbiter->spanRequests; i++) {
+        i2c_QueueRemove(device->readQueue);
+    }
+    return 1;
+}
+
+/**
+ * @brief Single bus arbiter for all registered devices.
+ *
+ * This function is meant to be called periodically from the main loop instead of
+ * one update function per device. On every pass it, for each bus:
+ * - delivers a finished read to its requesters and frees their device queue slots,
+ * - starts the next read, visiting the devices of the bus round robin so a busy
+ *   device cannot starve the others,
+ * and then runs the service hook of every device and updates the bus drivers.
+ *
+ * Every bus has its own read in flight, so a device on the software bus never
+ * waits behind the TWI traffic. A read that finishes is followed by the next one
+ * in the same pass.
+ */
+void i2c_DeviceUpdate() {
+    for (uint8_t b = 0; b < i2c_ArbiterCount; b++) {
+        i2c_Arbiter_t* arbiter = &i2c_Arbiters[b];
+
+        if (arbiter->active && i2c_DeviceDeliver(arbiter)) {
+            arbiter->active = 0;
+        }
+
+        if (arbiter->active && arbiter->bus->readBusy() == 0) {
+            // The device did not acknowledge the read (e.g. EEPROM write cycle), the
+            // request is still queued and starts again on its turn
+            arbiter->active = 0;
+        }
+
+        if (!arbiter->active && arbiter->bus->readBusy() == 0) {
+            for (uint8_t i = 0; i < i2c_DeviceCount; i++) {
+                i2c_Device_t* device = i2c_Devices[arbiter->next];
+                arbiter->next = (arbiter->next + 1) % i2c_DeviceCount;
+                if (i2c_DeviceBus(device) == arbiter->bus && i2c_DeviceStartRead(arbiter, device)) {
+                    arbiter->active = device;
+                    break;
+                }
+            }
+        }
+    }
+
+    for (uint8_t i = 0; i < i2c_DeviceCount; i++) {
+        if (i2c_Devices[i]->service) {
+            i2c_Devices[i]->service();
+        }
+    }
+    for (uint8_t b = 0; b < i2c_ArbiterCount; b++) {
+        i2c_Arbiters[b].bus->update();
+    }
+}
+
+#ifdef I2C_STATS_ENABLE
+/**
+ * @brief Returns the most read requests ever queued at once for a device,
+ * e.g. to size EEPROM_READ_QUEUE_SIZE and DS1307_READ_QUEUE_SIZE.
+ *
+ * @param address The 7-bit I2C address of a registered device.
+ *
+ * @return uint8_t The high-water mark, 0 if no such device is registered.
+ */
+uint8_t i2c_DeviceQueueHighWater(uint8_t address) {
+    for (uint8_t i = 0; i < i2c_DeviceCount; i++) {
+        if (i2c_Devices[i]->address == address) {
+            return i2c_Devices[i]->readQueue->highWater;
+        }
+    }
+    return 0;
+}
+#endif
@@ -0,0 +1,72 @@
+#ifndef I2C_DEVICE_H
+#define I2C_DEVICE_H
+
+#include "i2c_driver.h"
+#include "i2c_request_queue.h"
+
+// Maximum number of devices that can be registered on the bus, each EEPROM chip counts
+#ifndef I2C_MAX_DEVICES
+#define I2C_MAX_DEVICES 4
+#endif
+
+// Maximum number of buses, the TWI plus the software master (i2c_soft.h)
+#ifndef I2C_MAX_BUSES
+#define I2C_MAX_BUSES   2
+#endif
+
+// Device flags
+// Reads of neighbouring addresses return plain memory (no FIFO or clear-on-read
+// registers), so queued reads may be merged into one transaction
+#define I2C_DEVICE_COALESCE     0x01
+
+// Transaction API of one I2C master, same semantics as the TWI driver (i2c_driver.h)
+typedef struct {
+    void    (*init)(uint32_t frequency);
+    uint8_t (*sendArray)(uint8_t adr, uint8_t length, uint8_t* data);
+    uint8_t (*sendHeaderArray)(uint8_t adr, uint8_t headerLength, const uint8_t* header, uint8_t length, const uint8_t* data);
+    uint8_t (*getData)(uint8_t adr, uint8_t length);
+    uint8_t (*copyFromRx)(uint8_t offset, uint8_t* data, uint8_t length);
+    void    (*releaseRx)(uint8_t length);
+    uint8_t (*readBusy)(void);          // 1 from getData() until releaseRx() or a refused read
+    uint8_t (*writeBufferUsed)(void);
+    uint8_t (*probe)(uint8_t adr);
+    uint8_t (*probeTicket)(void);       // Ticket of the last probe queued
+    uint8_t (*probeResult)(uint8_t ticket); // I2C_PROBE_* of the probe with the ticket
+    void    (*update)(void);
+    uint8_t writeBufferSize;
+    uint8_t maxRead;                    // Longest read the receive buffer holds
+} i2c_Bus_t;
+
+extern const i2c_Bus_t i2c_TwiBus;      // The TWI peripheral
+
+// Descriptor of one I2C slave device, owned by its driver
+typedef struct {
+    uint8_t             address;        // 7-bit I2C address
+    uint32_t            speed;          // Highest SCL frequency the device supports
+    uint8_t             registerWidth;  // Register address bytes sent before a read (1 or 2, 0 for none)
+    i2c_RequestQueue_t* readQueue;      // Pending read requests of this device
+    void              (*service)(void); // Optional driver hook, called on every arbiter pass
+    uint8_t             flags;          // I2C_DEVICE_* options, 0 if left out of the initializer
+    const i2c_Bus_t*    bus;            // Bus the device is wired to, 0 (left out) for the TWI
+} i2c_Device_t;
+
+// Function prototypes
+uint8_t i2c_DeviceRegister(i2c_Device_t* device);                                              // Add a device to the bus
+void    i2c_DeviceSetSpeed(i2c_Device_t* device, uint32_t speed);                             // New highest SCL frequency of a device
+uint8_t i2c_DeviceRead(i2c_Device_t* device, uint16_t reg, uint8_t length, void* dataPtr);     // Queue a read request
+uint8_t i2c_DeviceReadPending(i2c_Device_t* device);                                          // Reads not delivered yet
+uint8_t i2c_DeviceReadTicket(i2c_Device_t* device);                                           // Ticket for the reads queued so far
+uint8_t i2c_DeviceReadDone(i2c_Device_t* device, uint8_t ticket);                             // Reads before the ticket delivered
+void    i2c_DeviceReadCancel(i2c_Device_t* device);                                           // Drop the reads not delivered yet
+uint8_t i2c_DeviceWrite(i2c_Device_t* device, uint8_t length, uint8_t* data);                 // Queue a write on the device's bus
+uint8_t i2c_DeviceWriteRegister(i2c_Device_t* device, uint16_t reg, uint8_t length, const uint8_t* data); // Register address, then data
+uint8_t i2c_DeviceWritesQueued(i2c_Device_t* device);                                         // Bytes queued on the device's bus
+uint8_t i2c_DeviceProbe(i2c_Device_t* device);                                                // Address-only write
+uint8_t i2c_DeviceProbeTicket(i2c_Device_t* device);                                          // Ticket of the last probe on its bus
+uint8_t i2c_DeviceProbeResult(i2c_Device_t* device, uint8_t ticket);                          // I2C_PROBE_* of the probe with the ticket
+void    i2c_DeviceUpdate();                                                                    // Bus arbiter, call periodically
+#ifdef I2C_STATS_ENABLE
+uint8_t i2c_DeviceQueueHighWater(uint8_t address);                                            // Most reads queued at once
+#endif
+
+#endif // I2C_DEVICE_H
@@ -12,33 +12,149 @@ Created on: 16/10/2024             /:/\:\  \     /:/\:\  \     /:/\:\  \
                                      \/__/         \/__/         \/__/
  _________________________________________________________________________________________*/
 #include "i2c_driver.h"
+#include "uart_trace.h"
+
+/* ISR / main loop interface
+ *
+ * Both buffers are single-producer/single-consumer rings: each index is
+ * written by one side only (write ring: head by the main loop, tail by the
+ * TWI interrupt; read ring the other way round) and the fill level is
+ * computed from the two, so nothing is read-modify-written from both sides
+ * and no interrupts are disabled on the request path. One slot of each ring
+ * stays empty to tell full from empty. A producer fills the bytes first and
+ * publishes them with a single store of its index after I2C_BARRIER(); a
+ * whole frame [address][length][data] is published at once, so the
+ * interrupt never sees half of one.
+ *
+ * The flags are handed over the same way: the main loop only sets a flag
+ * the interrupt has cleared and the other way round.
+ */
+#define I2C_BARRIER()   __asm__ __volatile__ ("" ::: "memory")  // Keeps buffer accesses on their side of an index store
+
+// Fast data byte entry, see I2C_FAST_ISR_DISABLE (host builds always use the C handler)
+#if defined(__AVR__) && !defined(I2C_FAST_ISR_DISABLE) && !defined(I2C_STATS_ENABLE) && !defined(I2C_BUSTRACE_ENABLE)
+#define I2C_FAST_ISR
+#endif
 
 // Global Variables
-uint8_t i2cErorrFlag;         // Error flag for I2C operations
+volatile uint8_t i2cErorrFlag;      // Error flag for I2C operations, set by the interrupt
 uint8_t i2cReadDataReadyFlag;
-uint8_t i2cReadBusyFlag;
-uint8_t i2c_WriteBufferCurrentSize;           // Tracks the number of bytes currently in the write buffer
+volatile uint8_t i2cReadBusyFlag;   // Set by i2c_GetData(), cleared on delivery or by a NACK in the interrupt
 
 // Static Variables for Read Buffer Management
-static uint8_t i2c_ReadDataLength;                          // Length of data to be read
-static uint8_t i2c_ReadBuffer[I2C_READ_BUFFER_SIZE];    // 30-byte circular buffer for I2C read data
-static uint8_t i2c_ReadBufferHead = 0;                  // Points to where the next byte will be written in the read buffer
-static uint8_t i2c_ReadBufferTail = 0;                  // Points to where the next byte will be read from the read buffer
-static uint8_t i2c_ReadBufferCurrentSize = 0;           // Tracks the number of bytes currently in the read buffer
+static volatile uint8_t i2c_ReadDataLength;             // Bytes still to receive, set by i2c_GetData() only while 0
+static uint8_t i2c_ReadBuffer[I2C_READ_BUFFER_SIZE];    // Circular buffer for I2C read data
+static volatile uint8_t i2c_ReadBufferHead = 0;         // Next byte written, owned by the interrupt
+static volatile uint8_t i2c_ReadBufferTail = 0;         // Next byte read, owned by the main loop
 
 // Static Variables for Write Buffer Management
 static uint8_t WriteDataLength;                          // Length of data to be sent 
-static uint8_t i2c_WriteBuffer[I2C_WRITE_BUFFER_SIZE];   // 30-byte circular buffer for I2C write data
-static uint8_t i2c_WriteBufferHead = 0;                  // Points to where the next byte will be written in the write buffer
-static uint8_t i2c_WriteBufferTail = 0;                  // Points to where the next byte will be read from the write buffer
+static uint8_t i2c_WriteBuffer[I2C_WRITE_BUFFER_SIZE];   // Circular buffer for I2C write data
+static volatile uint8_t i2c_WriteBufferHead = 0;         // Next byte written, owned by the main loop
+static volatile uint8_t i2c_WriteBufferTail = 0;         // Next byte sent, owned by the interrupt
 
 // Static Variables for I2C State Management
-static uint8_t RepeatStartFlag;               // Flag indicating if a repeated start is requested
-static uint8_t RepeatStartPlace;              // Store the current place for repeated start
+static volatile uint8_t RepeatStartFlag;      // Set by i2c_SendArraySr(), cleared by the interrupt
+static uint8_t RepeatStartPlace;              // Write tail at which the repeated start is due
+static volatile uint8_t i2c_BusIdle = 1;      // Token: cleared by i2c_Update() to send START, set by the interrupt with STOP
+
+// Static Variables for Probe Results, see i2c_ProbeResult()
+static uint8_t i2c_ProbeHead;                 // Free running, probes queued, owned by the main loop
+static volatile uint8_t i2c_ProbeTail;        // Free running, probes answered, owned by the interrupt
+static volatile uint8_t i2c_ProbeAcks;        // Bit (ticket % 8) set if that probe was acknowledged
 
 static uint8_t currentAddress;                 // Current I2C slave address
 static uint8_t CurrentData;                    // Holder for the data to be transmitted currently
 
+#ifdef I2C_STATS_ENABLE
+// Bus statistics, see i2c_StatsGet()
+i2c_Stats_t i2c_Stats;
+static uint8_t  i2c_StatsBusActive;            // Set from START until STOP
+static uint16_t i2c_StatsLastEvent;            // Timer3 value of the last bus event
+static uint16_t i2c_StatsLastUpdate;           // Timer3 value of the last i2c_Update()
+
+// Adds the time since the last bus event to the busy time while a transaction runs
+#define I2C_STATS_BUS_EVENT(now)  do { if (i2c_StatsBusActive) { i2c_Stats.busBusyTicks += (uint16_t)((now) - i2c_StatsLastEvent); } \
+                                       i2c_StatsLastEvent = (now); } while (0)
+#define I2C_STATS_BUS_STOP()      do { i2c_StatsBusActive = 0; } while (0)
+#else
+#define I2C_STATS_BUS_STOP()      do { } while (0)
+#endif
+
+#ifdef I2C_BUSTRACE_ENABLE
+// Bus tracer ring, written by the TWI interrupt only
+#define I2C_BUSTRACE_RUNNING    0   // Recording, waiting for the trigger
+#define I2C_BUSTRACE_TRIGGERED  1   // Trigger seen, taking the post trigger entries
+#define I2C_BUSTRACE_FROZEN     2   // Stopped, the ring can be read out
+
+static i2c_BusTraceEntry_t i2c_BusTraceBuffer[I2C_BUSTRACE_SIZE];
+static uint8_t          i2c_BusTraceHead;           // Free running index of the next entry
+static uint8_t          i2c_BusTraceFill;           // Entries recorded, saturates at I2C_BUSTRACE_SIZE
+static volatile uint8_t i2c_BusTraceState;          // I2C_BUSTRACE_RUNNING / TRIGGERED / FROZEN
+static uint8_t          i2c_BusTraceTrigger;        // Status that fires the trigger, 0 = none
+static uint8_t          i2c_BusTracePost;           // Entries taken after the trigger
+static uint8_t          i2c_BusTraceRemaining;      // Entries left before freezing
+#endif
+
+
+// Bytes between tail and head of a ring
+static inline uint8_t i2c_RingCount(uint8_t head, uint8_t tail, uint8_t size) {
+    return (head >= tail) ? (head - tail) : (uint8_t)(head + size - tail);
+}
+
+// Index after i, without a division
+static inline uint8_t i2c_RingNext(uint8_t i, uint8_t size) {
+    return (++i == size) ? 0 : i;
+}
+
+/**
+ * @brief Returns the bytes queued in the write buffer.
+ *
+ * Called from the main loop the value can only be too high, never too low:
+ * the interrupt may have sent more since.
+ */
+uint8_t i2c_WriteBufferUsed() {
+    return i2c_RingCount(i2c_WriteBufferHead, i2c_WriteBufferTail, I2C_WRITE_BUFFER_SIZE);
+}
+
+// Received bytes not yet taken by i2c_ReadFromRxBuffer()
+static uint8_t i2c_ReadBufferUsed() {
+    return i2c_RingCount(i2c_ReadBufferHead, i2c_ReadBufferTail, I2C_READ_BUFFER_SIZE);
+}
+
+// Takes one byte from the write ring, interrupt side
+static inline uint8_t i2c_WriteBufferPop() {
+    uint8_t tail = i2c_WriteBufferTail;
+    uint8_t data = i2c_WriteBuffer[tail];
+    i2c_WriteBufferTail = i2c_RingNext(tail, I2C_WRITE_BUFFER_SIZE);
+    return data;
+}
+
+// Drops count bytes of the write ring, interrupt side
+static inline void i2c_WriteBufferSkip(uint8_t count) {
+    uint16_t tail = i2c_WriteBufferTail + count;
+    i2c_WriteBufferTail = (tail >= I2C_WRITE_BUFFER_SIZE) ? (uint8_t)(tail - I2C_WRITE_BUFFER_SIZE) : (uint8_t) tail;
+}
+
+// Appends one received byte to the read ring, interrupt side
+static inline void i2c_ReadBufferPush(uint8_t data) {
+    uint8_t head = i2c_ReadBufferHead;
+    i2c_ReadBuffer[head] = data;
+    I2C_BARRIER();
+    i2c_ReadBufferHead = i2c_RingNext(head, I2C_READ_BUFFER_SIZE);
+}
+
+// Records the answer to the oldest probe not answered yet, interrupt side
+static inline void i2c_ProbeAnswered(uint8_t ack) {
+    uint8_t ticket = i2c_ProbeTail + 1;
+    uint8_t bit = 1 << (ticket % I2C_PROBE_RESULTS);
+    i2c_ProbeAcks = ack ? (i2c_ProbeAcks | bit) : (i2c_ProbeAcks & ~bit);
+    I2C_BARRIER();
+    i2c_ProbeTail = ticket;
+}
+
+// Hands the bus back to i2c_Update(), interrupt side, with every STOP
+#define I2C_BUS_RELEASE()   do { i2c_BusIdle = 1; } while (0)
 
 /**
  * @brief Adds data to the I2C write buffer.
@@ -48,37 +164,49 @@ static uint8_t CurrentData;                    // Holder for the data to be tran
  * the new data. The function maintains the circular nature of the buffer by wrapping around 
  * the buffer indices as needed.
  *
- * @param address  The I2C address to be sent, indicating the target slave device.
- * @param length   The length of the data to be sent (number of bytes).
- * @param data     A pointer to the data array that needs to be added to the write buffer.
+ * The frame data is taken from two segments, a header (e.g. the register
+ * address) and the payload, so callers never assemble a frame on the stack.
+ *
+ * @param address      The I2C address to be sent, indicating the target slave device.
+ * @param headerLength The number of header bytes, sent first (0 for none).
+ * @param header       A pointer to the header bytes.
+ * @param length       The length of the data to be sent (number of bytes).
+ * @param data         A pointer to the data array that needs to be added to the write buffer.
  * 
  * @return uint8_t Returns 1 on success if the data was successfully added to the buffer, 
  *                 or 0 if there is not enough space in the buffer to accommodate the new data.
  */
-static uint8_t i2c_AddToWriteBuffer(uint8_t address, uint8_t length, uint8_t *data) {
-    // Ensure that the total size of the message does not exceed i2c_WriteBuffer space
-    if (length > (I2C_WRITE_BUFFER_SIZE - i2c_WriteBufferCurrentSize - 2)) {  
-        // Check for available space (2 bytes for address and length)
+static uint8_t i2c_AddToWriteBuffer(uint8_t address, uint8_t headerLength, const uint8_t* header,
+                                    uint8_t length, const uint8_t* data) {
+    uint8_t head = i2c_WriteBufferHead;
+    uint8_t space = (I2C_WRITE_BUFFER_SIZE - 1) - i2c_WriteBufferUsed();
+    uint16_t total = (uint16_t) headerLength + length;
+
+    // Ensure that the whole frame fits (2 bytes for address and length)
+    if (space < 2 || total > space - 2) {
+        I2C_STATS(i2c_Stats.retries++);
         return 0;  // Not enough space in i2c_WriteBuffer
     }
 
-    // Add address to i2c_WriteBuffer
-    i2c_WriteBuffer[i2c_WriteBufferHead] = address;
-    i2c_WriteBufferHead = (i2c_WriteBufferHead + 1) % I2C_WRITE_BUFFER_SIZE;
-    i2c_WriteBufferCurrentSize++;
-
-    // Add length to i2c_WriteBuffer
-    i2c_WriteBuffer[i2c_WriteBufferHead] = length;
-    i2c_WriteBufferHead = (i2c_WriteBufferHead + 1) % I2C_WRITE_BUFFER_SIZE;
-    i2c_WriteBufferCurrentSize++;
-
-    // Add data to i2c_WriteBuffer
+    // Fill the frame behind the published head
+    i2c_WriteBuffer[head] = address;
+    head = i2c_RingNext(head, I2C_WRITE_BUFFER_SIZE);
+    i2c_WriteBuffer[head] = (uint8_t) total;
+    head = i2c_RingNext(head, I2C_WRITE_BUFFER_SIZE);
+    for (uint8_t i = 0; i < headerLength; i++) {
+        i2c_WriteBuffer[head] = header[i];
+        head = i2c_RingNext(head, I2C_WRITE_BUFFER_SIZE);
+    }
     for (uint8_t i = 0; i < length; i++) {
-        i2c_WriteBuffer[i2c_WriteBufferHead] = data[i];
-        i2c_WriteBufferHead = (i2c_WriteBufferHead + 1) % I2C_WRITE_BUFFER_SIZE;
-        i2c_WriteBufferCurrentSize++;
+        i2c_WriteBuffer[head] = data[i];
+        head = i2c_RingNext(head, I2C_WRITE_BUFFER_SIZE);
     }
 
+    // Publish it with one store
+    I2C_BARRIER();
+    i2c_WriteBufferHead = head;
+    I2C_STATS(if (i2c_WriteBufferUsed() > i2c_Stats.writeBufferHighWater) { i2c_Stats.writeBufferHighWater = i2c_WriteBufferUsed(); });
+
     return 1;  // Success
 }
 
@@ -86,13 +214,10 @@ static uint8_t i2c_AddToWriteBuffer(uint8_t address, uint8_t length, uint8_t *da
  * @brief Retrieves the next address and length from the I2C write buffer.
  * 
  * This function reads the next I2C address and the length of the data to be transmitted 
- * from the I2C write buffer. It ensures that there is sufficient data available in the buffer 
- * before reading the values. The function also updates the tail index and the current size 
- * of the buffer accordingly. 
+ * from the I2C write buffer. Frames are published whole, so once the header is
+ * there the data is too. Called from the TWI interrupt only, which owns the tail.
  * 
- * **Note:** The buffer size is reduced by the amount of data taken, two bytes 
- * one for the address and one for the length n the data byte is freed after 
- * reading from it in the TWI interrupt 
+ * **Note:** The data bytes are freed one by one as the interrupt sends them.
  * 
  * @param address Pointer to a variable where the retrieved I2C address will be stored.
  * @param length  Pointer to a variable where the retrieved length of the data will be stored.
@@ -102,25 +227,13 @@ static uint8_t i2c_AddToWriteBuffer(uint8_t address, uint8_t length, uint8_t *da
  */
 static uint8_t i2c_getFromWriteBuffer(uint8_t *address, uint8_t *length) {
     // Ensure i2c_WriteBuffer is not empty
-    if (i2c_WriteBufferCurrentSize < 2) {
+    if (i2c_WriteBufferUsed() < 2) {
         return 0;  // Not enough data to read (at least address + length needed)
     }
+    I2C_BARRIER();
 
-    // Read address
-    *address = i2c_WriteBuffer[i2c_WriteBufferTail];
-    i2c_WriteBufferTail = (i2c_WriteBufferTail + 1) % I2C_WRITE_BUFFER_SIZE;
-    i2c_WriteBufferCurrentSize--;
-
-    // Read length
-    *length = i2c_WriteBuffer[i2c_WriteBufferTail];
-    i2c_WriteBufferTail = (i2c_WriteBufferTail + 1) % I2C_WRITE_BUFFER_SIZE;
-    i2c_WriteBufferCurrentSize--;
-
-    // Ensure we have enough data for the length field
-    if (i2c_WriteBufferCurrentSize < *length) {
-        return 0;  // Not enough data in the i2c_WriteBuffer
-    }
-
+    *address = i2c_WriteBufferPop();
+    *length  = i2c_WriteBufferPop();
     return 1;  // Success
 }
 
@@ -150,68 +263,111 @@ static uint8_t i2c_getFromWriteBuffer(uint8_t *address, uint8_t *length) {
  * 
  * **Note:** Proper handling of data lengths and buffer management 
  * is crucial to ensure accurate communication over the I2C bus.
+ *
+ * With I2C_FAST_ISR this is entered from the fast entry below for the rare
+ * states only, with the registers of the interrupted code untouched.
  */
+#ifdef I2C_FAST_ISR
+// Full C handler under a vector-like name (avr-gcc expects signal handlers to start with __vector)
+void __vector_TWI_slow(void) __attribute__((signal, used, externally_visible));
+void __vector_TWI_slow(void) {
+#else
 ISR(TWI_vect) {
-    switch (TWSR & 0xF8) { // TWI Status Register (TWSR) status codes
+#endif
+    uint8_t status = TWSR & 0xF8;
+#if defined(I2C_STATS_ENABLE) || defined(I2C_BUSTRACE_ENABLE)
+    uint16_t statsEntry = TCNT3;  // Timestamp of this bus event
+#endif
+#ifdef I2C_STATS_ENABLE
+    I2C_STATS_BUS_EVENT(statsEntry);
+#endif
+#ifdef I2C_BUSTRACE_ENABLE
+    uint8_t busTraceData = TWDR;
+    uint8_t busTraceAction = I2C_BUSTRACE_ACT_NONE;
+#endif
+    switch (status) { // TWI Status Register (TWSR) status codes
         case TWI_START:
-            // Handle the start condition
-            if (i2c_getFromWriteBuffer(&currentAddress, &WriteDataLength)) {
-                TWDR = currentAddress; // Load slave address into data register
-                TWCR = (TWCR & ~((1 << TWSTA) | (1 << TWSTO))) | (1 << TWINT); // Clear STA and ensure TWINT is set
-            }
-            break;
-
         case TWI_REP_START:
-            // Handle the repeated start condition
+            // Handle the start and repeated start condition
             if (i2c_getFromWriteBuffer(&currentAddress, &WriteDataLength)) {
+                I2C_STATS(i2c_Stats.transactions++);
                 TWDR = currentAddress; // Load slave address into data register
+                I2C_BUSTRACE_ACTION(I2C_BUSTRACE_ACT_ADDRESS);
                 TWCR = (TWCR & ~((1 << TWSTA) | (1 << TWSTO))) | (1 << TWINT); // Clear STA and ensure TWINT is set
             } else {
-                TWCR |= (1 << TWINT) | (1 << TWSTO); // Send stop condition if no data available
+                TWCR = (TWCR & ~(1 << TWSTA)) | (1 << TWINT) | (1 << TWSTO); // Send stop condition if no data available
+                I2C_BUSTRACE_ACTION(I2C_BUSTRACE_ACT_STOP);
+                I2C_STATS_BUS_STOP();
+                I2C_BUS_RELEASE();
             }
             break;
 
         case TWI_MT_SLA_NACK:
             // Master transmit, slave address not acknowledged
-            i2c_WriteBufferTail += WriteDataLength; // Adjust the write buffer tail
-            i2c_WriteBufferCurrentSize -= WriteDataLength; // Update the current size
+            i2c_WriteBufferSkip(WriteDataLength); // Drop the rest of the frame
             TWCR |= (1 << TWINT) | (1 << TWSTO); // Stop condition
+            I2C_BUSTRACE_ACTION(I2C_BUSTRACE_ACT_STOP);
+            I2C_STATS_BUS_STOP();
+            I2C_BUS_RELEASE();
+            I2C_STATS(i2c_Stats.nacks++);
+            if (WriteDataLength == 0) {
+                i2c_ProbeAnswered(0);           // A probe, not an error
+                break;
+            }
             i2cErorrFlag = I2C_ERROR_ADRESS_WRITE; // Set error flag
+            TRACE(trace_Event(TRACE_EVT_I2C_ERROR, (uint8_t[]){i2cErorrFlag}, 1));
             break;
 
         case TWI_MT_SLA_ACK:
             // Master transmit, slave address acknowledged
-            CurrentData = i2c_WriteBuffer[i2c_WriteBufferTail++]; // Get the next byte to send
+            if (WriteDataLength == 0) {
+                // Address-only probe, the device is ready
+                i2c_ProbeAnswered(1);
+                TWCR |= (1 << TWINT) | (1 << TWSTO); // Stop condition
+                I2C_BUSTRACE_ACTION(I2C_BUSTRACE_ACT_STOP);
+                I2C_STATS_BUS_STOP();
+                I2C_BUS_RELEASE();
+                break;
+            }
+            CurrentData = i2c_WriteBufferPop(); // Get the next byte to send
             TWDR = CurrentData; // Load the byte into the data register
-            i2c_WriteBufferTail %= I2C_WRITE_BUFFER_SIZE; // Wrap around the buffer size
-            i2c_WriteBufferCurrentSize--; // Decrease current size of the buffer
+            I2C_BUSTRACE_ACTION(I2C_BUSTRACE_ACT_DATA);
+            I2C_STATS(i2c_Stats.bytesWritten++);
             WriteDataLength--; // Decrease data length to send
             TWCR |= (1 << TWINT); // Start transmission
             break;
 
         case TWI_MT_DATA_NACK:
             // Data not acknowledged by the slave
-            i2c_WriteBufferTail += WriteDataLength; // Adjust the write buffer tail
-            i2c_WriteBufferCurrentSize -= WriteDataLength; // Update the current size
+            i2c_WriteBufferSkip(WriteDataLength); // Drop the rest of the frame
             TWCR |= (1 << TWINT) | (1 << TWSTO); // Stop condition
+            I2C_BUSTRACE_ACTION(I2C_BUSTRACE_ACT_STOP);
+            I2C_STATS_BUS_STOP();
+            I2C_BUS_RELEASE();
+            I2C_STATS(i2c_Stats.nacks++);
             i2cErorrFlag = I2C_ERROR_DATA_WRITE; // Set error flag
+            TRACE(trace_Event(TRACE_EVT_I2C_ERROR, (uint8_t[]){i2cErorrFlag}, 1));
             break;
 
         case TWI_MT_DATA_ACK:
             // Data acknowledged by the slave
             if (WriteDataLength > 0) {
-                TWDR = i2c_WriteBuffer[i2c_WriteBufferTail++]; // Get the next byte to send
-                i2c_WriteBufferTail %= I2C_WRITE_BUFFER_SIZE; // Wrap around the buffer size
-                i2c_WriteBufferCurrentSize--; // Decrease current size of the buffer
+                TWDR = i2c_WriteBufferPop(); // Get the next byte to send
+                I2C_BUSTRACE_ACTION(I2C_BUSTRACE_ACT_DATA);
+                I2C_STATS(i2c_Stats.bytesWritten++);
                 WriteDataLength--; // Decrease data length to send
                 TWCR |= (1 << TWINT); // Start transmission
             } else {
                 // Check if repeat start condition is needed
                 if (RepeatStartFlag && (RepeatStartPlace == i2c_WriteBufferTail)) {
                     TWCR |= (1 << TWINT) | (1 << TWSTA); // Initiate repeat start
+                    I2C_BUSTRACE_ACTION(I2C_BUSTRACE_ACT_REP_START);
                     RepeatStartFlag = 0; // Reset repeat start flag
                 } else {
                     TWCR |= (1 << TWINT) | (1 << TWSTO); // Send stop condition
+                    I2C_BUSTRACE_ACTION(I2C_BUSTRACE_ACT_STOP);
+                    I2C_STATS_BUS_STOP();
+                    I2C_BUS_RELEASE();
                 }
             }
             break;
@@ -221,48 +377,216 @@ ISR(TWI_vect) {
             if (i2c_ReadDataLength > 1) {
                 // Expecting more than one byte, send ACK after receiving each byte
                 TWCR |= (1 << TWINT) | (1 << TWEA); // Enable ACK
+                I2C_BUSTRACE_ACTION(I2C_BUSTRACE_ACT_ACK);
             } else {
                 // Only one byte to read, do not send ACK after receiving it
                 TWCR |= (1 << TWINT); // Do not send ACK after the last byte
+                I2C_BUSTRACE_ACTION(I2C_BUSTRACE_ACT_NACK);
             }
             break;
 
         case TWI_MR_SLA_NACK: // SLA+R transmitted, NACK received
             TWCR |= (1 << TWINT) | (1 << TWSTO); // Stop condition
+            I2C_BUSTRACE_ACTION(I2C_BUSTRACE_ACT_STOP);
+            I2C_STATS_BUS_STOP();
+            I2C_STATS(i2c_Stats.nacks++);
+            I2C_BUS_RELEASE();
+            i2c_ReadDataLength = 0; // Abandon the read, the requester starts it again
+            i2cReadBusyFlag = 0;
             i2cErorrFlag = I2C_ERROR_ADRESS_READ; // Set error flag
+            TRACE(trace_Event(TRACE_EVT_I2C_ERROR, (uint8_t[]){i2cErorrFlag}, 1));
             break;
 
         case TWI_MR_DATA_ACK: // Data byte received, ACK returned
             // Store received data in the read buffer
-            i2c_ReadBuffer[i2c_ReadBufferHead] = TWDR; // Save the received byte
-            i2c_ReadBufferHead = (i2c_ReadBufferHead + 1) % I2C_READ_BUFFER_SIZE; // Move head index
-            i2c_ReadBufferCurrentSize++; // Increase current size
+            i2c_ReadBufferPush(TWDR); // Save the received byte
             i2c_ReadDataLength--; // Decrease remaining data length
+            I2C_STATS(i2c_Stats.bytesRead++);
+            I2C_STATS(if (i2c_ReadBufferUsed() > i2c_Stats.readBufferHighWater) { i2c_Stats.readBufferHighWater = i2c_ReadBufferUsed(); });
 
             // Check if more bytes are expected
             if (i2c_ReadDataLength > 1) {
                 TWCR |= (1 << TWINT) | (1 << TWEN) | (1 << TWEA); // Send ACK to receive the next byte
+                I2C_BUSTRACE_ACTION(I2C_BUSTRACE_ACT_ACK);
             } else {
                 // Prepare to receive the last byte without sending ACK
                 TWCR = (TWCR & ~(1 << TWEA)) | (1 << TWINT) | (1 << TWEN);
+                I2C_BUSTRACE_ACTION(I2C_BUSTRACE_ACT_NACK);
             }
             break;
 
         case TWI_MR_DATA_NACK: // Data byte received, NACK returned
             // Store received data in the read buffer
-            i2c_ReadBuffer[i2c_ReadBufferHead] = TWDR; // Save the received byte
-            i2c_ReadBufferHead = (i2c_ReadBufferHead + 1) % I2C_READ_BUFFER_SIZE; // Move head index
-            i2c_ReadBufferCurrentSize++; // Increase current size
+            i2c_ReadBufferPush(TWDR); // Save the received byte
             i2c_ReadDataLength--; // Decrease remaining data length
+            I2C_STATS(i2c_Stats.bytesRead++);
+            I2C_STATS(if (i2c_ReadBufferUsed() > i2c_Stats.readBufferHighWater) { i2c_Stats.readBufferHighWater = i2c_ReadBufferUsed(); });
             TWCR |= (1 << TWINT) | (1 << TWSTO); // Stop condition
+            I2C_BUSTRACE_ACTION(I2C_BUSTRACE_ACT_STOP);
+            I2C_STATS_BUS_STOP();
+            I2C_BUS_RELEASE();
             break;
 
         default:
-            // Handle other statuses as needed
-            //TWCR |= (1 << TWINT) | (1 << TWSTO); // Send stop condition on error
+            // Bus error or a status this master does not expect, free the bus
+            TWCR = (TWCR & ~(1 << TWSTA)) | (1 << TWINT) | (1 << TWSTO); // Send stop condition on error
+            I2C_BUSTRACE_ACTION(I2C_BUSTRACE_ACT_STOP);
+            I2C_STATS_BUS_STOP();
+            I2C_BUS_RELEASE();
             break;
     }
+#ifdef I2C_BUSTRACE_ENABLE
+    // Same work for every status, the trigger check is a compare and a countdown
+    if (i2c_BusTraceState != I2C_BUSTRACE_FROZEN) {
+        i2c_BusTraceEntry_t* entry = &i2c_BusTraceBuffer[i2c_BusTraceHead++ & (I2C_BUSTRACE_SIZE - 1)];
+        entry->timestamp = statsEntry;
+        entry->status    = status;
+        entry->data      = busTraceData;
+        entry->action    = busTraceAction;
+        if (i2c_BusTraceFill < I2C_BUSTRACE_SIZE) {
+            i2c_BusTraceFill++;
+        }
+        if (i2c_BusTraceState == I2C_BUSTRACE_TRIGGERED) {
+            if (--i2c_BusTraceRemaining == 0) {
+                i2c_BusTraceState = I2C_BUSTRACE_FROZEN;
+            }
+        } else if (status == i2c_BusTraceTrigger) {
+            i2c_BusTraceRemaining = i2c_BusTracePost;
+            i2c_BusTraceState = i2c_BusTracePost ? I2C_BUSTRACE_TRIGGERED : I2C_BUSTRACE_FROZEN;
+        }
+    }
+#endif
+#ifdef I2C_STATS_ENABLE
+    uint16_t statsTicks = TCNT3 - statsEntry;
+    i2c_Stats.isrCount++;
+    i2c_Stats.isrTotalTicks += statsTicks;
+    if (statsTicks > i2c_Stats.isrMaxTicks) { i2c_Stats.isrMaxTicks = statsTicks; }
+    if (statsTicks < i2c_Stats.isrMinTicks || i2c_Stats.isrCount == 1) { i2c_Stats.isrMinTicks = statsTicks; }
+#endif
+}
+
+#ifdef I2C_FAST_ISR
+/**
+ * @brief Fast entry of the TWI interrupt for the data byte states.
+ *
+ * Sends the next byte of a write frame (TWI_MT_DATA_ACK) or stores a received
+ * byte (TWI_MR_DATA_ACK) with r24, r30, r31 and SREG only, the same steps as
+ * the C handler. Anything else, including the end of a write frame, restores
+ * r24 and SREG and jumps to __vector_TWI_slow(), which then runs as if it were
+ * the vector itself.
+ *
+ * CPU cycles from the interrupt to reti, including the 4 cycle response and
+ * the jmp of the vector table:
+ *   TWI_MT_DATA_ACK, byte sent     66
+ *   TWI_MR_DATA_ACK, byte stored   66
+ *   other states                   the C handler + 21 (+ 25 at the end of a write frame)
+ *
+ * The C handler alone on the two data paths has not been counted yet, so the
+ * gain and the cost on the other states are still open. Count it from
+ * avr-gcc -Os -S with I2C_FAST_ISR_DISABLE (prologue and epilogue included)
+ * before relying on this entry.
+ */
+ISR(TWI_vect, ISR_NAKED) {
+    __asm__ __volatile__ (
+        "push r24                       \n\t"
+        "in   r24, %[sreg]              \n\t"
+        "push r24                       \n\t"
+        "lds  r24, %[twsr]              \n\t"
+        "andi r24, 0xF8                 \n\t"
+        "cpi  r24, %[mrData]            \n\t"
+        "breq 2f                        \n\t"
+        "cpi  r24, %[mtData]            \n\t"
+        "brne 9f                        \n\t"
+
+        // TWI_MT_DATA_ACK: TWDR = i2c_WriteBufferPop() while the frame has bytes left
+        "lds  r24, %[wlen]              \n\t"
+        "subi r24, 1                    \n\t"
+        "brcs 9f                        \n\t"   // Frame done, STOP or repeated START in C
+        "sts  %[wlen], r24              \n\t"
+        "push r30                       \n\t"
+        "push r31                       \n\t"
+        "lds  r30, %[wtail]             \n\t"
+        "ldi  r31, 0                    \n\t"
+        "subi r30, lo8(-(%[wbuf]))      \n\t"
+        "sbci r31, hi8(-(%[wbuf]))      \n\t"
+        "ld   r24, Z                    \n\t"
+        "sts  %[twdr], r24              \n\t"
+        "lds  r24, %[wtail]             \n\t"
+        "inc  r24                       \n\t"
+        "cpi  r24, %[wsize]             \n\t"
+        "brne 1f                        \n\t"
+        "clr  r24                       \n\t"
+        "1:                             \n\t"
+        "sts  %[wtail], r24             \n\t"
+        "lds  r24, %[twcr]              \n\t"
+        "ori  r24, %[twint]             \n\t"
+        "rjmp 5f                        \n\t"
+
+        // TWI_MR_DATA_ACK: i2c_ReadBufferPush(TWDR), ACK unless the next byte is the last
+        "2:                             \n\t"
+        "push r30                       \n\t"
+        "push r31                       \n\t"
+        "lds  r30, %[rhead]             \n\t"
+        "ldi  r31, 0                    \n\t"
+        "subi r30, lo8(-(%[rbuf]))      \n\t"
+        "sbci r31, hi8(-(%[rbuf]))      \n\t"
+        "lds  r24, %[twdr]              \n\t"
+        "st   Z, r24                    \n\t"   // Data first, then the head publishes it
+        "lds  r24, %[rhead]             \n\t"
+        "inc  r24                       \n\t"
+        "cpi  r24, %[rsize]             \n\t"
+        "brne 3f                        \n\t"
+        "clr  r24                       \n\t"
+        "3:                             \n\t"
+        "sts  %[rhead], r24             \n\t"
+        "lds  r24, %[rlen]              \n\t"
+        "dec  r24                       \n\t"
+        "sts  %[rlen], r24              \n\t"
+        "cpi  r24, 2                    \n\t"
+        "lds  r24, %[twcr]              \n\t"
+        "brlo 4f                        \n\t"
+        "ori  r24, %[twAck]             \n\t"
+        "rjmp 5f                        \n\t"
+        "4:                             \n\t"
+        "andi r24, %[twNoAck]           \n\t"
+        "ori  r24, %[twNack]            \n\t"
+        "5:                             \n\t"
+        "sts  %[twcr], r24              \n\t"
+        "pop  r31                       \n\t"
+        "pop  r30                       \n\t"
+        "pop  r24                       \n\t"
+        "out  %[sreg], r24              \n\t"
+        "pop  r24                       \n\t"
+        "reti                           \n\t"
+
+        // Rare states
+        "9:                             \n\t"
+        "pop  r24                       \n\t"
+        "out  %[sreg], r24              \n\t"
+        "pop  r24                       \n\t"
+        "jmp  __vector_TWI_slow         \n\t"
+        :
+        : [sreg]    "I" (_SFR_IO_ADDR(SREG)),
+          [twsr]    "n" (_SFR_MEM_ADDR(TWSR)),
+          [twdr]    "n" (_SFR_MEM_ADDR(TWDR)),
+          [twcr]    "n" (_SFR_MEM_ADDR(TWCR)),
+          [mtData]  "M" (TWI_MT_DATA_ACK),
+          [mrData]  "M" (TWI_MR_DATA_ACK),
+          [twint]   "M" (1 << TWINT),
+          [twAck]   "M" ((1 << TWINT) | (1 << TWEN) | (1 << TWEA)),
+          [twNack]  "M" ((1 << TWINT) | (1 << TWEN)),
+          [twNoAck] "M" ((uint8_t) ~(1 << TWEA)),
+          [wlen]    "i" (&WriteDataLength),
+          [wtail]   "i" (&i2c_WriteBufferTail),
+          [wbuf]    "i" (i2c_WriteBuffer),
+          [wsize]   "M" (I2C_WRITE_BUFFER_SIZE),
+          [rhead]   "i" (&i2c_ReadBufferHead),
+          [rlen]    "i" (&i2c_ReadDataLength),
+          [rbuf]    "i" (i2c_ReadBuffer),
+          [rsize]   "M" (I2C_READ_BUFFER_SIZE)
+    );
 }
+#endif
 
 /**
  * @brief Sends a single byte of data to a specified I2C address.
@@ -281,7 +605,7 @@ ISR(TWI_vect) {
 uint8_t i2c_SendByte(uint8_t adr, uint8_t data) {
     // Shift the address left by one bit to include the write bit
     // and add the data to the write buffer
-    uint8_t result = i2c_AddToWriteBuffer((adr << 1), 1, &data);
+    uint8_t result = i2c_AddToWriteBuffer((adr << 1), 0, 0, 1, &data);
     return result;
 }
 
@@ -320,6 +644,19 @@ void i2c_Init(uint32_t frequency) {
 
     // Enable TWI and TWI interrupt
     TWCR = (1 << TWEN) | (1 << TWIE); // Enable TWI and TWI Interrupt
+    i2c_BusIdle = 1;
+
+#if defined(I2C_STATS_ENABLE) || defined(I2C_BUSTRACE_ENABLE)
+    // Free running Timer3, normal mode, time base of the statistics and the tracer
+    TCCR3A = 0;
+    TCCR3B = I2C_STATS_TIMER_CS;
+#endif
+#ifdef I2C_STATS_ENABLE
+    i2c_StatsReset();
+#endif
+#ifdef I2C_BUSTRACE_ENABLE
+    i2c_BusTraceArm(I2C_BUSTRACE_TRIGGER, I2C_BUSTRACE_POST);
+#endif
 
     // Enable global interrupts
     sei(); 
@@ -341,11 +678,29 @@ void i2c_Init(uint32_t frequency) {
  */
 uint8_t i2c_SendArray(uint8_t adr, uint8_t length, uint8_t* data) {
     // Add the address and data length to the I2C write buffer
-    uint8_t result = i2c_AddToWriteBuffer((adr << 1), length, data);
+    uint8_t result = i2c_AddToWriteBuffer((adr << 1), 0, 0, length, data);
     return result;
 }
 
 
+/**
+ * @brief Sends a header followed by an array of bytes as one write transaction.
+ *
+ * Same as i2c_SendArray() with the data in two pieces, e.g. a register
+ * address and the caller's payload, both copied into the write buffer.
+ *
+ * @param adr          The I2C slave address (7-bit).
+ * @param headerLength The number of header bytes.
+ * @param header       A pointer to the header bytes, sent first.
+ * @param length       The number of bytes to send from the data array.
+ * @param data         A pointer to the array of data to be sent.
+ *
+ * @return 1 if the frame was added to the write buffer, 0 otherwise.
+ */
+uint8_t i2c_SendHeaderArray(uint8_t adr, uint8_t headerLength, const uint8_t* header, uint8_t length, const uint8_t* data) {
+    return i2c_AddToWriteBuffer((adr << 1), headerLength, header, length, data);
+}
+
 /**
  * @brief Sends an array of bytes to the specified I2C address with a repeat start condition.
  * 
@@ -362,17 +717,74 @@ uint8_t i2c_SendArray(uint8_t adr, uint8_t length, uint8_t* data) {
  * @return 1 if the data was successfully added to the write buffer, 0 otherwise.
  */
 uint8_t i2c_SendArraySr(uint8_t adr, uint8_t length, uint8_t* data) {
-    // Set the repeat start flag for the next transmission
+    // Position in the write buffer after this frame (address and length included),
+    // set before the frame is published so the interrupt never sees it without
+    uint16_t place = i2c_WriteBufferHead + length + 2;
+    RepeatStartPlace = (uint8_t)(place % I2C_WRITE_BUFFER_SIZE);
     RepeatStartFlag = 1;
-    
-    // Calculate the position in the write buffer for the repeat start condition
-    RepeatStartPlace = i2c_WriteBufferHead + (length + 2); // Include address and length
-    uint8_t result = i2c_AddToWriteBuffer((adr << 1), length, data);
+
     // Add the address and data length to the I2C write buffer
+    uint8_t result = i2c_AddToWriteBuffer((adr << 1), 0, 0, length, data);
+    if (!result) {
+        RepeatStartFlag = 0;
+    }
     return result;
 }
 
 
+/**
+ * @brief Queues an address-only write to check whether a device answers.
+ *
+ * Used for ACK polling: an EEPROM does not acknowledge its address while an
+ * internal write cycle is running. No data byte is sent, so the probe does
+ * not disturb the device. Take i2c_ProbeTicket() right after a successful
+ * call and pass it to i2c_ProbeResult() for the outcome.
+ *
+ * @param adr The I2C slave address (7-bit).
+ *
+ * @return 1 if the probe was queued, 0 if the write buffer is full.
+ */
+uint8_t i2c_Probe(uint8_t adr) {
+    if (!i2c_AddToWriteBuffer((adr << 1), 0, 0, 0, 0)) {
+        return 0;
+    }
+    i2c_ProbeHead++;
+    return 1;
+}
+
+/**
+ * @brief Returns the ticket of the last probe queued, for i2c_ProbeResult().
+ */
+uint8_t i2c_ProbeTicket() {
+    return i2c_ProbeHead;
+}
+
+/**
+ * @brief Returns the outcome of the probe with the given ticket.
+ *
+ * Probes are answered in the order they were queued, so each caller (EEPROM
+ * ACK polling, a bus scan) gets the answer to its own probe even when probes
+ * of other drivers run in between. The answers of the last I2C_PROBE_RESULTS
+ * probes are kept; an older one reads I2C_PROBE_LOST and is probed again.
+ *
+ * @param ticket i2c_ProbeTicket() taken after the probe was queued.
+ *
+ * @return uint8_t I2C_PROBE_PENDING, I2C_PROBE_ACK, I2C_PROBE_NACK or
+ *         I2C_PROBE_LOST.
+ */
+uint8_t i2c_ProbeResult(uint8_t ticket) {
+    if ((int8_t)(i2c_ProbeTail - ticket) < 0) {
+        return I2C_PROBE_PENDING;
+    }
+    uint8_t ack = i2c_ProbeAcks & (1 << (ticket % I2C_PROBE_RESULTS));
+    I2C_BARRIER();
+    if ((uint8_t)(i2c_ProbeTail - ticket) >= I2C_PROBE_RESULTS) {
+        return I2C_PROBE_LOST;              // Its bit may belong to a later probe by now
+    }
+    return ack ? I2C_PROBE_ACK : I2C_PROBE_NACK;
+}
+
+
 /**
  * @brief Initiates a start condition for I2C communication if data is available.
  * 
@@ -384,11 +796,23 @@ uint8_t i2c_SendArraySr(uint8_t adr, uint8_t length, uint8_t* data) {
  *  transmitted when the write buffer is not empty.
  */
 void i2c_Update() {
-    if (i2c_WriteBufferCurrentSize) {    // Check if there is data in the write buffer
-    // Set the start condition for I2C communication
-    TWCR |= (1 << TWSTA);
+#ifdef I2C_STATS_ENABLE
+    uint16_t statsNow = TCNT3;
+    i2c_Stats.windowTicks += (uint16_t)(statsNow - i2c_StatsLastUpdate);
+    i2c_StatsLastUpdate = statsNow;
+#endif
+    // Start only on an idle bus: the interrupt is quiet then, so the TWCR
+    // read-modify-write cannot clear a pending TWINT of a running transfer
+    if (i2c_BusIdle && i2c_WriteBufferUsed()) {
+        i2c_BusIdle = 0;
+#ifdef I2C_STATS_ENABLE
+        i2c_StatsBusActive = 1;
+        i2c_StatsLastEvent = TCNT3;
+#endif
+        // Set the start condition for I2C communication
+        TWCR |= (1 << TWSTA);
     }
-    if(i2c_ReadBufferCurrentSize){
+    if(i2c_ReadBufferUsed()){
         i2cReadDataReadyFlag = 1;
     } else {
         i2cReadDataReadyFlag = 0;
@@ -416,13 +840,18 @@ void i2c_Update() {
 
 uint8_t i2c_GetData(uint8_t adr, uint8_t length) {
     // Ensure the read buffer is empty and no read operation is already pending
-    if(i2c_ReadBufferCurrentSize == 0 && i2c_ReadDataLength == 0) { 
-        // Set the length of the data to be read
+    if(i2c_ReadBufferUsed() == 0 && i2c_ReadDataLength == 0 && length > 0 && length < I2C_READ_BUFFER_SIZE) { 
+        // Set the length of the data to be read, the interrupt only
+        // looks at it once the read request below is published
         i2c_ReadDataLength = length;
+        i2cReadBusyFlag = 1;
         // Prepare the address with the read bit (LSB = 1) and add to write buffer
         // with zero length and zero data
-        uint8_t result = i2c_AddToWriteBuffer(((adr << 1) + 1), 0, 0);
-        if(result){i2cReadBusyFlag = 1;} // if the write in buffer process succeded
+        uint8_t result = i2c_AddToWriteBuffer(((adr << 1) + 1), 0, 0, 0, 0);
+        if(!result){
+            i2c_ReadDataLength = 0;
+            i2cReadBusyFlag = 0;
+        }
         return result;
     } else {
         // Return 0 if a read operation is already in progress or buffer is not ready
@@ -431,6 +860,47 @@ uint8_t i2c_GetData(uint8_t adr, uint8_t length) {
 }
 
 
+/**
+ * @brief Copies received bytes without freeing them.
+ *
+ * Lets a coalesced read hand out parts of the same data to several requests
+ * (see i2c_DeviceUpdate()), i2c_ReleaseRxBuffer() frees the data afterwards.
+ *
+ * @param offset Position of the first byte, counted from the oldest byte.
+ * @param data   Where the bytes are copied to.
+ * @param length Number of bytes to copy.
+ * @return       Returns length, or 0 if the bytes have not all arrived yet.
+ */
+uint8_t i2c_CopyFromRxBuffer(uint8_t offset, uint8_t* data, uint8_t length) {
+    uint8_t tail = i2c_ReadBufferTail;
+
+    if ((uint16_t) offset + length > i2c_ReadBufferUsed()) {
+        return 0; // Not enough data to read
+    }
+    I2C_BARRIER();
+
+    tail = (uint8_t)(((uint16_t) tail + offset) % I2C_READ_BUFFER_SIZE);
+    for (uint8_t i = 0; i < length; i++) {
+        data[i] = i2c_ReadBuffer[tail];
+        tail = i2c_RingNext(tail, I2C_READ_BUFFER_SIZE);
+    }
+    return length;
+}
+
+/**
+ * @brief Frees the oldest received bytes and ends the read.
+ *
+ * @param length Number of bytes to free, at most the number received.
+ */
+void i2c_ReleaseRxBuffer(uint8_t length) {
+    uint8_t tail = (uint8_t)(((uint16_t) i2c_ReadBufferTail + length) % I2C_READ_BUFFER_SIZE);
+
+    // Free the bytes with one store
+    I2C_BARRIER();
+    i2c_ReadBufferTail = tail;
+    i2cReadBusyFlag = 0;
+}
+
 /**
  * @brief Reads data from the I2C read buffer.
  * 
@@ -446,17 +916,228 @@ uint8_t i2c_GetData(uint8_t adr, uint8_t length) {
  *               current available data in the read buffer.
  */
 uint8_t i2c_ReadFromRxBuffer(uint8_t* data, uint8_t length) {
-    // Ensure there is enough data in the read buffer
-    if (length > i2c_ReadBufferCurrentSize) {
+    if (!i2c_CopyFromRxBuffer(0, data, length)) {
         return 0; // Not enough data to read
     }
+    i2c_ReleaseRxBuffer(length);
+    return length; // Return the number of bytes read
+}
 
-    // Read the requested number of bytes from the read buffer
-    for (uint8_t i = 0; i < length; i++) {
-        data[i] = i2c_ReadBuffer[i2c_ReadBufferTail]; // Retrieve byte
-        i2c_ReadBufferTail = (i2c_ReadBufferTail + 1) % I2C_READ_BUFFER_SIZE; // Update tail pointer
-        i2c_ReadBufferCurrentSize--; // Decrease the size of the read buffer
+
+/**
+ * @brief Issues a TWI command and busy-waits for its end, polled mode.
+ *
+ * @return uint8_t The TWI status after the command.
+ */
+static uint8_t i2c_PolledCommand(uint8_t command) {
+    TWCR = command;
+    while (!(TWCR & (1 << TWINT))) {
+    }
+    return TWSR & 0xF8;
+}
+
+/**
+ * @brief Takes the TWI away from the interrupt driven queue, for good.
+ *
+ * Meant for an emergency write from an interrupt of higher priority (the
+ * power-fail save), with interrupts off. The TWI interrupt is disabled, the
+ * byte on the wire is let finish and a read in progress gets one more byte
+ * without ACK so the slave releases SDA. The frame that was being sent never
+ * gets its STOP: the next i2c_PolledWrite() starts with a repeated START,
+ * which an EEPROM takes as the end of the page write without programming it,
+ * so the page keeps its old contents instead of being torn.
+ *
+ * Everything queued is dropped; the driver stays unusable until i2c_Init().
+ * Takes at most two byte times (18 SCL periods).
+ */
+void i2c_Preempt() {
+    TWCR = TWCR & ~((1 << TWIE) | (1 << TWINT));   // Writing TWINT as 1 would continue the transfer
+    if (!i2c_BusIdle) {
+        uint8_t status;
+
+        while (!(TWCR & (1 << TWINT))) {           // START or byte on the wire
+        }
+        status = TWSR & 0xF8;
+        if (status == TWI_MR_SLA_ACK || status == TWI_MR_DATA_ACK) {
+            i2c_PolledCommand((1 << TWINT) | (1 << TWEN));  // Last byte, not acknowledged
+        }
+    } else {
+        while (TWCR & (1 << TWSTO)) {              // STOP of the last frame
+        }
     }
+    i2c_WriteBufferTail = i2c_WriteBufferHead;
+    i2c_ProbeTail = i2c_ProbeHead;                 // Dropped probes read I2C_PROBE_NACK
+    i2c_ProbeAcks = 0;
+    i2c_ReadBufferTail = i2c_ReadBufferHead;
+    i2c_ReadDataLength = 0;
     i2cReadBusyFlag = 0;
-    return length; // Return the number of bytes read
+    i2c_BusIdle = 0;                               // Keeps i2c_Update() off the bus
+}
+
+/**
+ * @brief Writes one frame in polled mode after i2c_Preempt().
+ *
+ * A device that does not acknowledge its address, e.g. an EEPROM still in the
+ * write cycle of an earlier page, is addressed again with a repeated START up
+ * to attempts times (ACK polling); each attempt takes 10 SCL periods.
+ *
+ * @param adr          7-bit slave address.
+ * @param headerLength Header bytes (register / memory address), sent first.
+ * @param header       The header bytes.
+ * @param length       Data bytes.
+ * @param data         The data bytes.
+ * @param attempts     Addressing attempts, at least 1.
+ *
+ * @return uint8_t Returns 1 once the frame was acknowledged and the STOP sent,
+ *         0 if the device never answered or refused a byte.
+ */
+uint8_t i2c_PolledWrite(uint8_t adr, uint8_t headerLength, const uint8_t* header,
+                        uint8_t length, const uint8_t* data, uint16_t attempts) {
+    uint8_t status;
+    uint8_t result = 0;
+
+    do {
+        status = i2c_PolledCommand((1 << TWINT) | (1 << TWSTA) | (1 << TWEN));    // START or repeated START
+        if (status != TWI_START && status != TWI_REP_START) {
+            break;
+        }
+        TWDR = adr << 1;
+        status = i2c_PolledCommand((1 << TWINT) | (1 << TWEN));
+    } while (status == TWI_MT_SLA_NACK && --attempts);
+
+    if (status == TWI_MT_SLA_ACK) {
+        result = 1;
+        for (uint8_t i = 0; result && i < headerLength + length; i++) {
+            TWDR = (i < headerLength) ? header[i] : data[i - headerLength];
+            result = i2c_PolledCommand((1 << TWINT) | (1 << TWEN)) == TWI_MT_DATA_ACK;
+        }
+    }
+    TWCR = (1 << TWINT) | (1 << TWSTO) | (1 << TWEN);
+    while (TWCR & (1 << TWSTO)) {
+    }
+    return result;
+}
+
+
+#ifdef I2C_STATS_ENABLE
+/**
+ * @brief Clears the bus statistics and restarts the measurement window.
+ *
+ * Buffer high-water marks restart from the current fill level.
+ */
+void i2c_StatsReset() {
+    uint8_t sreg = SREG;
+    cli();
+    uint8_t* bytes = (uint8_t*)&i2c_Stats;
+    for (uint8_t i = 0; i < sizeof(i2c_Stats); i++) {
+        bytes[i] = 0;
+    }
+    i2c_Stats.writeBufferHighWater = i2c_WriteBufferUsed();
+    i2c_Stats.readBufferHighWater  = i2c_ReadBufferUsed();
+    i2c_StatsLastUpdate = TCNT3;
+    i2c_StatsLastEvent  = i2c_StatsLastUpdate;
+    SREG = sreg;
+}
+
+/**
+ * @brief Copies the bus statistics with interrupts held off, so the counters
+ * updated by the TWI interrupt are consistent with each other.
+ *
+ * Durations are in Timer3 ticks of I2C_STATS_TIMER_DIV CPU cycles. The window
+ * only advances in i2c_Update(), so it must be called at least every
+ * 65536 ticks (65 ms at 8 MHz) for the busy percentage to stay accurate.
+ *
+ * @param stats Destination of the copy.
+ */
+void i2c_StatsGet(i2c_Stats_t* stats) {
+    uint8_t sreg = SREG;
+    cli();
+    *stats = i2c_Stats;
+    SREG = sreg;
+}
+
+/**
+ * @brief Returns the share of the measurement window the bus was busy, 0-100.
+ */
+uint8_t i2c_StatsBusyPercent() {
+    i2c_Stats_t stats;
+    i2c_StatsGet(&stats);
+    if (stats.windowTicks == 0) {
+        return 0;
+    }
+    if (stats.busBusyTicks >= stats.windowTicks) {
+        return 100;
+    }
+    return (uint8_t)((stats.busBusyTicks * 100) / stats.windowTicks);
+}
+#endif
+
+
+#ifdef I2C_BUSTRACE_ENABLE
+/**
+ * @brief Clears the bus trace and starts recording.
+ *
+ * The ring keeps the last I2C_BUSTRACE_SIZE interrupts. When the status
+ * triggerStatus is seen, postTrigger more interrupts are recorded and the
+ * ring freezes, so it holds the events leading up to the fault and the
+ * recovery right after it.
+ *
+ * @param triggerStatus TWSR status that fires the trigger (e.g. TWI_MT_SLA_NACK), 0 to record forever.
+ * @param postTrigger   Entries recorded after the trigger, less than I2C_BUSTRACE_SIZE.
+ */
+void i2c_BusTraceArm(uint8_t triggerStatus, uint8_t postTrigger) {
+    uint8_t sreg = SREG;
+    cli();
+    i2c_BusTraceTrigger = triggerStatus;
+    i2c_BusTracePost = postTrigger;
+    i2c_BusTraceHead = 0;
+    i2c_BusTraceFill = 0;
+    i2c_BusTraceState = I2C_BUSTRACE_RUNNING;
+    SREG = sreg;
+}
+
+/**
+ * @brief Clears the bus trace and re-arms the current trigger.
+ */
+void i2c_BusTraceRestart() {
+    i2c_BusTraceArm(i2c_BusTraceTrigger, i2c_BusTracePost);
+}
+
+/**
+ * @brief Returns 1 once the trigger fired and the ring stopped recording.
+ */
+uint8_t i2c_BusTraceFrozen() {
+    return i2c_BusTraceState == I2C_BUSTRACE_FROZEN;
+}
+
+/**
+ * @brief Returns the number of entries in the ring.
+ */
+uint8_t i2c_BusTraceCount() {
+    return i2c_BusTraceFill;
+}
+
+/**
+ * @brief Copies one entry of the bus trace, oldest first.
+ *
+ * The ring is only stable once frozen; while recording, later entries may
+ * already have been overwritten by the time they are read.
+ *
+ * @param index Age of the entry, 0 is the oldest.
+ * @param entry Destination of the copy.
+ *
+ * @return uint8_t Returns 1 if the entry exists, 0 if index is past the end.
+ */
+uint8_t i2c_BusTraceGet(uint8_t index, i2c_BusTraceEntry_t* entry) {
+    uint8_t sreg = SREG;
+    cli();
+    uint8_t count = i2c_BusTraceFill;
+    if (index >= count) {
+        SREG = sreg;
+        return 0;
+    }
+    *entry = i2c_BusTraceBuffer[(uint8_t)(i2c_BusTraceHead - count + index) & (I2C_BUSTRACE_SIZE - 1)];
+    SREG = sreg;
+    return 1;
 }
+#endif
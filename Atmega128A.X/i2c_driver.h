@@ -4,8 +4,10 @@
 #include <avr/io.h>
 #include <avr/interrupt.h>
 
-// Define CPU frequency
+// Define CPU frequency, can be overridden from the build (-DF_CPU=...)
+#ifndef F_CPU
 #define F_CPU 8000000UL  // Define CPU frequency as 8 MHz
+#endif
 
 // Macros for setting I2C speed (Standard or Fast mode)
 #define I2C_STANDARD_MODE 100000UL  // Standard I2C speed of 100 kHz
@@ -32,11 +34,98 @@
 #define I2C_ERROR_DATA_WRITE    0x02 // Data write error
 #define I2C_ERROR_ADRESS_READ   0x03 // Address read error
 
+// Bus statistics, uncomment or pass -DI2C_STATS_ENABLE to the compiler.
+// When disabled the instrumentation compiles to nothing.
+//#define I2C_STATS_ENABLE
+
+// Bus tracer, uncomment or pass -DI2C_BUSTRACE_ENABLE to the compiler.
+// Records every TWI interrupt in a small ring until a trigger freezes it.
+//#define I2C_BUSTRACE_ENABLE
+
+// The data byte states (TWI_MT_DATA_ACK with bytes left, TWI_MR_DATA_ACK) are
+// handled by a hand-written interrupt entry that saves 3 registers instead of
+// the full C prologue; every other status goes on to the C handler. The
+// statistics and the bus tracer need to see every event, so they use the C
+// handler alone. Uncomment or pass -DI2C_FAST_ISR_DISABLE to always use C.
+//#define I2C_FAST_ISR_DISABLE
+
+// Timer3 runs free as the time base of the statistics and the bus tracer,
+// 1 tick = I2C_STATS_TIMER_DIV CPU cycles
+#define I2C_STATS_TIMER_DIV     8
+#define I2C_STATS_TIMER_CS      (1 << CS31)   // clk/8
+
+#ifdef I2C_STATS_ENABLE
+typedef struct {
+    uint32_t bytesWritten;          // Data bytes transmitted (address bytes excluded)
+    uint32_t bytesRead;             // Data bytes received
+    uint16_t transactions;          // START / repeated START that carried a transaction
+    uint16_t nacks;                 // Address or data bytes not acknowledged
+    uint16_t retries;               // Requests refused because a buffer was full, the caller retries
+    uint8_t  writeBufferHighWater;  // Highest i2c_WriteBufferUsed() seen
+    uint8_t  readBufferHighWater;   // Highest read buffer fill seen
+    uint16_t isrCount;              // TWI interrupts measured
+    uint16_t isrMinTicks;           // Shortest ISR, in timer ticks
+    uint16_t isrMaxTicks;           // Longest ISR, in timer ticks
+    uint32_t isrTotalTicks;         // Sum of all ISR durations, for the average
+    uint32_t busBusyTicks;          // Time between START and STOP
+    uint32_t windowTicks;           // Time covered by the statistics
+    uint16_t readsMerged;           // Device reads served by another read (i2c_device.c coalescing)
+} i2c_Stats_t;
+
+extern i2c_Stats_t i2c_Stats;
+
+void    i2c_StatsReset();                   // Clear the statistics and restart the window
+void    i2c_StatsGet(i2c_Stats_t* stats);   // Consistent copy of the statistics
+uint8_t i2c_StatsBusyPercent();             // Bus utilization over the window, 0-100
+#define I2C_STATS(statement)    do { statement; } while (0)
+#else
+#define I2C_STATS(statement)    do { } while (0)
+#endif
+
+#ifdef I2C_BUSTRACE_ENABLE
+#define I2C_BUSTRACE_SIZE       32                  // Entries, must be a power of two
+#define I2C_BUSTRACE_TRIGGER    TWI_MT_SLA_NACK     // Default trigger armed by i2c_Init(), 0 = none
+#define I2C_BUSTRACE_POST       4                   // Entries kept after the trigger
+
+// What the interrupt did in response to the status
+#define I2C_BUSTRACE_ACT_NONE       0   // Nothing, bus left waiting
+#define I2C_BUSTRACE_ACT_ADDRESS    1   // SLA+R/W loaded into TWDR
+#define I2C_BUSTRACE_ACT_DATA       2   // Data byte loaded into TWDR
+#define I2C_BUSTRACE_ACT_ACK        3   // Next byte will be acknowledged
+#define I2C_BUSTRACE_ACT_NACK       4   // Next byte is the last, not acknowledged
+#define I2C_BUSTRACE_ACT_STOP       5   // STOP requested
+#define I2C_BUSTRACE_ACT_REP_START  6   // Repeated START requested
+
+// One TWI interrupt. TWDR is sampled on entry, so it holds the byte that was
+// just transmitted or received.
+typedef struct {
+    uint16_t timestamp;     // Timer3 at interrupt entry
+    uint8_t  status;        // TWSR & 0xF8
+    uint8_t  data;          // TWDR
+    uint8_t  action;        // I2C_BUSTRACE_ACT_*
+} i2c_BusTraceEntry_t;
+
+void    i2c_BusTraceArm(uint8_t triggerStatus, uint8_t postTrigger);   // Clear and start recording, trigger 0 records forever
+void    i2c_BusTraceRestart();                                        // Clear and re-arm with the current trigger
+uint8_t i2c_BusTraceFrozen();                                         // 1 once the trigger fired and the post entries were taken
+uint8_t i2c_BusTraceCount();                                          // Entries recorded, at most I2C_BUSTRACE_SIZE
+uint8_t i2c_BusTraceGet(uint8_t index, i2c_BusTraceEntry_t* entry);   // Entry by age, 0 = oldest
+#define I2C_BUSTRACE_ACTION(a)  do { busTraceAction = (a); } while (0)
+#else
+#define I2C_BUSTRACE_ACTION(a)  do { } while (0)
+#endif
+
+// Outcome of i2c_Probe(), from i2c_ProbeResult()
+#define I2C_PROBE_PENDING       0x00 // Probe queued or on the bus
+#define I2C_PROBE_ACK           0x01 // Device acknowledged its address
+#define I2C_PROBE_NACK          0x02 // Device did not answer (absent or busy)
+#define I2C_PROBE_LOST          0x03 // Answer overwritten by later probes, probe again
+#define I2C_PROBE_RESULTS       8    // Answers kept, probes of other drivers in between
+
 // External variable to indicate I2C errors
-extern uint8_t i2cErorrFlag;             
+extern volatile uint8_t i2cErorrFlag;             
 extern uint8_t i2cReadDataReadyFlag;
-extern uint8_t i2cReadBusyFlag;
-extern uint8_t i2c_WriteBufferCurrentSize;           // Tracks the number of bytes currently in the write buffer
+extern volatile uint8_t i2cReadBusyFlag;
 
 // Function prototypes
 void       i2c_Update();                                                // Update the I2C state
@@ -44,7 +133,19 @@ void       i2c_Init(uint32_t frequency);                                // Initi
 uint8_t    i2c_SendByte(uint8_t adr, uint8_t data);                     // Send a single byte to an I2C device
 uint8_t    i2c_SendArray(uint8_t adr, uint8_t length, uint8_t* data);   // Send an array of bytes to an I2C device
 uint8_t    i2c_GetData(uint8_t adr, uint8_t length);                    // Prepare to read data from an I2C device
+uint8_t    i2c_SendHeaderArray(uint8_t adr, uint8_t headerLength, const uint8_t* header, uint8_t length, const uint8_t* data); // Header, then data, one frame
 uint8_t    i2c_SendArraySr(uint8_t adr, uint8_t length, uint8_t* data); // Send an array with a repeated start condition
 uint8_t    i2c_ReadFromRxBuffer(uint8_t* data, uint8_t length);         // Read data from the RX buffer
+uint8_t    i2c_CopyFromRxBuffer(uint8_t offset, uint8_t* data, uint8_t length); // Copy without freeing
+void       i2c_ReleaseRxBuffer(uint8_t length);                         // Free received bytes, ends the read
+uint8_t    i2c_Probe(uint8_t adr);                                      // Address-only write
+uint8_t    i2c_ProbeTicket();                                           // Ticket of the last probe queued
+uint8_t    i2c_ProbeResult(uint8_t ticket);                             // I2C_PROBE_* of the probe with the ticket
+uint8_t    i2c_WriteBufferUsed();                                       // Bytes queued in the write buffer
+
+// Polled access for an emergency write (power-fail save), the queue is abandoned
+void       i2c_Preempt();                                               // Take the TWI from the interrupt, interrupts off
+uint8_t    i2c_PolledWrite(uint8_t adr, uint8_t headerLength, const uint8_t* header,
+                           uint8_t length, const uint8_t* data, uint16_t attempts); // One frame, ACK polls the address
 
 #endif // I2C_DRIVER_H
@@ -0,0 +1,75 @@
+#ifndef I2C_PT_H
+#define I2C_PT_H
+
+#include <stdint.h>
+#include "i2c_device.h"
+
+// Stackless coroutines (protothreads) for driver operations that take several
+// transactions. The operation is written as one sequential function that is
+// called again on every pass of the bus arbiter (from the driver's service
+// hook); each wait returns to the arbiter and the next call resumes right
+// after it. The whole state is an i2c_Pt_t (3 bytes).
+//
+//     static i2c_Pt_t pt;
+//     static uint8_t  value;
+//     static uint8_t  my_op() {
+//         I2C_PT_BEGIN(&pt);
+//         I2C_PT_READ(&pt, &device, REG, 1, &value);     // Yields until the byte arrived
+//         value |= 0x80;
+//         I2C_PT_WRITE(&pt, &device, REG, 1, &value);    // Yields while the write buffer is full
+//         I2C_PT_END(&pt);
+//     }
+//
+// The resume points are case labels of one switch, so:
+// - locals do not survive a wait, keep the state in statics or a struct,
+// - a switch statement must not contain a wait, use if / else around it,
+// - at most one wait per source line, and sources below 32768 lines.
+
+// Coroutine results
+#define I2C_PT_WAITING  0       // Waiting, call again on the next pass
+#define I2C_PT_ENDED    1       // Ran to the end (or I2C_PT_EXIT), restarts on the next call
+
+typedef struct {
+    uint16_t line;              // Resume point, 0 to start from the top
+    uint8_t  ticket;            // Read ticket of the last I2C_PT_READ
+} i2c_Pt_t;
+
+#define I2C_PT_INIT(pt)         do { (pt)->line = 0; } while (0)
+
+#define I2C_PT_BEGIN(pt)        switch ((pt)->line) { case 0:
+
+#define I2C_PT_END(pt)          } (pt)->line = 0; return I2C_PT_ENDED
+
+// Leaves the operation, the next call starts it again
+#define I2C_PT_EXIT(pt)         do { (pt)->line = 0; return I2C_PT_ENDED; } while (0)
+
+// Returns until condition holds, it is evaluated again on every call
+#define I2C_PT_WAIT_UNTIL(pt, condition)    I2C_PT_WAIT_AT(pt, __LINE__, condition)
+
+// Wait with an explicit resume point, for macros holding two waits on one line
+#define I2C_PT_WAIT_AT(pt, point, condition)                                    \
+    do { (pt)->line = (point); case (point):                                    \
+         if (!(condition)) return I2C_PT_WAITING; } while (0)
+
+// Returns once unconditionally
+#define I2C_PT_YIELD(pt)                                                        \
+    do { (pt)->line = __LINE__; return I2C_PT_WAITING; case __LINE__:; } while (0)
+
+// Queues a read (waiting for a free queue slot) and waits until its data is
+// in dataPtr. Reads are started by the arbiter, so one queued after a write on
+// the same bus sees the written value.
+#define I2C_PT_READ(pt, device, reg, length, dataPtr)                           \
+    do { I2C_PT_WAIT_AT(pt, __LINE__, i2c_DeviceRead(device, reg, length, dataPtr)); \
+         (pt)->ticket = i2c_DeviceReadTicket(device);                           \
+         I2C_PT_WAIT_AT(pt, __LINE__ | 0x8000, i2c_DeviceReadDone(device, (pt)->ticket)); } while (0)
+
+// Queues a register write, waiting while the write buffer of the bus is full.
+// The data is copied, so it may change once this returns.
+#define I2C_PT_WRITE(pt, device, reg, length, data)                             \
+    I2C_PT_WAIT_UNTIL(pt, i2c_DeviceWriteRegister(device, reg, length, data))
+
+// Waits until every write queued on the device's bus has left the buffer
+#define I2C_PT_FLUSH(pt, device)                                                \
+    I2C_PT_WAIT_UNTIL(pt, i2c_DeviceWritesQueued(device) == 0)
+
+#endif // I2C_PT_H
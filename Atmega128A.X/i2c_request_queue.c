@@ -0,0 +1,93 @@
+/*_____________________________{FILE_NAME}_____________________________________________________
+                                      ___           ___           ___
+ Author: Abdelrahman Selim           /\  \         /\  \         /\  \
+                                    /::\  \       /::\  \       /::\  \
+Created on: {DATE}                 /:/\:\  \     /:/\:\  \     /:/\:\  \
+                                  /::\ \:\  \   _\:\ \:\  \   /::\ \:\  \
+ Version: 01                     /:/\:\ \:\__\ /\ \:\ \:\__\ /:/\:\ \:\__\
+                                 \/__\:\/:/  / \:\ \:\ \/__/ \/__\:\/:/  /
+                                      \::/  /   \:\ \:\__\        \::/  /
+                                      /:/  /     \:\/:/  /        /:/  /
+ Brief : I2C Request Queue           /:/  /       \::/  /        /:/  /
+                                     \/__/         \/__/         \/__/
+ _________________________________________________________________________________________*/
+#include "i2c_request_queue.h"
+
+/**
+ * @brief Appends a read request to the end of a device queue.
+ *
+ * The head and tail indices run freely and are masked on access, so the number
+ * of queued requests is always (head - tail) without a separate size counter.
+ *
+ * @param queue    The device queue, defined with I2C_REQUEST_QUEUE_DEFINE.
+ * @param address  The register / memory address inside the device.
+ * @param length   The number of bytes to read.
+ * @param dataPtr  Where the read data will be stored once it arrives.
+ *
+ * @return uint8_t Returns 1 if the request was queued, 0 if the queue is full.
+ */
+uint8_t i2c_QueueAdd(i2c_RequestQueue_t* queue, uint16_t address, uint8_t length, void* dataPtr) {
+    if ((uint8_t)(queue->head - queue->tail) > queue->mask) {
+        I2C_STATS(i2c_Stats.retries++);
+        return 0;  // Queue is full
+    }
+    i2c_Request_t* request = &queue->slots[queue->head & queue->mask];
+    request->address = address;
+    request->length  = length;
+    request->dataPtr = dataPtr;
+    queue->head++;
+    I2C_STATS(if (i2c_QueueCount(queue) > queue->highWater) { queue->highWater = i2c_QueueCount(queue); });
+    return 1;
+}
+
+/**
+ * @brief Returns the oldest request without removing it.
+ *
+ * Drivers keep the request in the queue while its transaction is on the bus and
+ * remove it once the data has been delivered, so no copy of it is needed.
+ *
+ * @param queue The device queue.
+ *
+ * @return i2c_Request_t* Pointer to the oldest request, or 0 if the queue is empty.
+ */
+i2c_Request_t* i2c_QueuePeek(i2c_RequestQueue_t* queue) {
+    if (queue->head == queue->tail) {
+        return 0;
+    }
+    return &queue->slots[queue->tail & queue->mask];
+}
+
+/**
+ * @brief Returns a queued request by its position, without removing it.
+ *
+ * @param queue The device queue.
+ * @param index 0 for the oldest request, 1 for the next one and so on.
+ *
+ * @return i2c_Request_t* Pointer to the request, or 0 if fewer are queued.
+ */
+i2c_Request_t* i2c_QueueAt(i2c_RequestQueue_t* queue, uint8_t index) {
+    if (index >= i2c_QueueCount(queue)) {
+        return 0;
+    }
+    return &queue->slots[(uint8_t)(queue->tail + index) & queue->mask];
+}
+
+/**
+ * @brief Removes the oldest request from the queue, if any.
+ *
+ * @param queue The device queue.
+ */
+void i2c_QueueRemove(i2c_RequestQueue_t* queue) {
+    if (queue->head != queue->tail) {
+        queue->tail++;
+    }
+}
+
+/**
+ * @brief Returns the number of requests currently in the queue.
+ *
+ * @param queue The device queue.
+ */
+uint8_t i2c_QueueCount(i2c_RequestQueue_t* queue) {
+    return (uint8_t)(queue->head - queue->tail);
+}
@@ -0,0 +1,57 @@
+#ifndef I2C_REQUEST_QUEUE_H
+#define I2C_REQUEST_QUEUE_H
+
+#include <stdint.h>
+#include "i2c_driver.h"
+
+// One pending read request of an I2C device driver
+typedef struct {
+    uint16_t address;     // Register / memory address inside the device
+    uint8_t  length;      // Number of bytes to read
+    void*    dataPtr;     // Destination of the read data
+} i2c_Request_t;
+
+// FIFO of requests, the size is a power of two so indices wrap with a mask
+typedef struct {
+    i2c_Request_t* slots;   // Storage, defined per device by I2C_REQUEST_QUEUE_DEFINE
+    uint8_t mask;           // Size - 1
+    uint8_t head;           // Free running index of the next slot to write
+    uint8_t tail;           // Free running index of the oldest request
+#ifdef I2C_STATS_ENABLE
+    uint8_t highWater;      // Most requests ever queued at once
+#endif
+} i2c_RequestQueue_t;
+
+// Compile time check of a queue size, a power of two up to 128
+#define I2C_REQUEST_QUEUE_SIZE_CHECK(name, size)                                          \
+    typedef char name##_size_must_be_power_of_two[                                        \
+        (((size) & ((size) - 1)) == 0 && (size) > 0 && (size) <= 128) ? 1 : -1]
+
+// Defines a static queue with its own storage, size must be a power of two up to 128
+#define I2C_REQUEST_QUEUE_DEFINE(name, size)                                              \
+    I2C_REQUEST_QUEUE_SIZE_CHECK(name, size);                                             \
+    static i2c_Request_t name##Slots[(size)];                                             \
+    static i2c_RequestQueue_t name = { .slots = name##Slots, .mask = (size) - 1 }
+
+// Defines count static queues of the same size, for a driver with several
+// devices of one kind. Each one is set up with I2C_REQUEST_QUEUE_ARRAY_INIT()
+// before it is used.
+#define I2C_REQUEST_QUEUE_ARRAY_DEFINE(name, count, size)                                 \
+    I2C_REQUEST_QUEUE_SIZE_CHECK(name, size);                                             \
+    static i2c_Request_t name##Slots[(count)][(size)];                                    \
+    static i2c_RequestQueue_t name[(count)]
+
+#define I2C_REQUEST_QUEUE_ARRAY_INIT(name, index)                                         \
+    do {                                                                                  \
+        name[(index)].slots = name##Slots[(index)];                                       \
+        name[(index)].mask  = (sizeof(name##Slots[0]) / sizeof(i2c_Request_t)) - 1;       \
+    } while (0)
+
+// Function prototypes
+uint8_t        i2c_QueueAdd(i2c_RequestQueue_t* queue, uint16_t address, uint8_t length, void* dataPtr); // Append a request
+i2c_Request_t* i2c_QueuePeek(i2c_RequestQueue_t* queue);       // Oldest request or 0 when empty
+i2c_Request_t* i2c_QueueAt(i2c_RequestQueue_t* queue, uint8_t index); // index-th oldest request or 0
+void           i2c_QueueRemove(i2c_RequestQueue_t* queue);     // Drop the oldest request
+uint8_t        i2c_QueueCount(i2c_RequestQueue_t* queue);      // Number of queued requests
+
+#endif // I2C_REQUEST_QUEUE_H
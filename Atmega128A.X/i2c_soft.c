@@ -0,0 +1,465 @@
+/*_____________________________{FILE_NAME}_____________________________________________________
+                                      ___           ___           ___
+ Author: Abdelrahman Selim           /\  \         /\  \         /\  \
+                                    /::\  \       /::\  \       /::\  \
+Created on: {DATE}                 /:/\:\  \     /:/\:\  \     /:/\:\  \
+                                  /::\ \:\  \   _\:\ \:\  \   /::\ \:\  \
+ Version: 01                     /:/\:\ \:\__\ /\ \:\ \:\__\ /:/\:\ \:\__\
+                                 \/__\:\/:/  / \:\ \:\ \/__/ \/__\:\/:/  /
+                                      \::/  /   \:\ \:\__\        \::/  /
+                                      /:/  /     \:\/:/  /        /:/  /
+ Brief : Software I2C Master         /:/  /       \::/  /        /:/  /
+                                     \/__/         \/__/         \/__/
+ _________________________________________________________________________________________*/
+#include "i2c_soft.h"
+#include "uart_trace.h"
+
+#ifdef I2C_SOFT_ENABLE
+
+/* Same ISR / main loop interface as the TWI driver (see i2c_driver.c): two
+ * single-producer/single-consumer rings whose indices are each written by
+ * one side only, frames published whole with one index store.
+ *
+ * The Timer2 compare interrupt does one step per tick: pull SCL low and put
+ * the next bit on SDA, or release SCL and sample SDA. A slave holding SCL low
+ * (clock stretching) simply makes the high step repeat. The interrupt is
+ * switched off while the write ring is empty.
+ */
+#define I2C_SOFT_BARRIER()  __asm__ __volatile__ ("" ::: "memory")
+
+// Line control, a released line is pulled high by the external resistor
+#define I2C_SOFT_SCL_LOW()      (I2C_SOFT_DDR |=  (1 << I2C_SOFT_SCL))
+#define I2C_SOFT_SCL_RELEASE()  (I2C_SOFT_DDR &= ~(1 << I2C_SOFT_SCL))
+#define I2C_SOFT_SDA_LOW()      (I2C_SOFT_DDR |=  (1 << I2C_SOFT_SDA))
+#define I2C_SOFT_SDA_RELEASE()  (I2C_SOFT_DDR &= ~(1 << I2C_SOFT_SDA))
+#define I2C_SOFT_SCL_READ()     ((I2C_SOFT_PIN >> I2C_SOFT_SCL) & 1)
+#define I2C_SOFT_SDA_READ()     ((I2C_SOFT_PIN >> I2C_SOFT_SDA) & 1)
+
+// Interrupt steps
+#define I2C_SOFT_IDLE       0   // Bus free, START of the next frame
+#define I2C_SOFT_LOW        1   // SCL low, next bit on SDA
+#define I2C_SOFT_HIGH       2   // SCL released, sample SDA
+#define I2C_SOFT_STOP       3   // SCL and SDA low
+#define I2C_SOFT_STOP_SCL   4   // SCL released
+#define I2C_SOFT_STOP_SDA   5   // SDA released: STOP, one tick of bus free time follows
+
+// Rings
+static uint8_t i2c_SoftWriteBuffer[I2C_SOFT_WRITE_BUFFER_SIZE];
+static volatile uint8_t i2c_SoftWriteHead;      // Main loop
+static volatile uint8_t i2c_SoftWriteTail;      // Interrupt
+static uint8_t i2c_SoftReadBuffer[I2C_SOFT_READ_BUFFER_SIZE];
+static volatile uint8_t i2c_SoftReadHead;       // Interrupt
+static volatile uint8_t i2c_SoftReadTail;       // Main loop
+
+// Handshake flags
+static volatile uint8_t i2c_SoftReadLength;     // Bytes of the pending read, set by i2c_SoftGetData() only while 0
+static volatile uint8_t i2c_SoftReadPending;    // Set by i2c_SoftGetData(), cleared on release or NACK
+
+// Probe answers, as i2c_ProbeResult() of the TWI driver
+static uint8_t i2c_SoftProbeHead;               // Main loop, probes queued
+static volatile uint8_t i2c_SoftProbeTail;      // Interrupt, probes answered
+static volatile uint8_t i2c_SoftProbeAcks;      // Bit (ticket % 8) set if acknowledged
+
+// Interrupt state
+static uint8_t i2c_SoftStep;
+static uint8_t i2c_SoftByte;        // Shift register, bits leave and enter at the top
+static uint8_t i2c_SoftBit;         // 0..7 data, 8 acknowledge
+static uint8_t i2c_SoftRemaining;   // Bytes of the frame after the current one (write) or including it (read)
+static uint8_t i2c_SoftAddressing;  // Current byte is the address
+static uint8_t i2c_SoftReading;     // Current frame is a read
+
+#ifdef I2C_STATS_ENABLE
+static i2c_SoftStats_t i2c_SoftStats;
+#endif
+
+static inline uint8_t i2c_SoftRingCount(uint8_t head, uint8_t tail, uint8_t size) {
+    return (head >= tail) ? (uint8_t)(head - tail) : (uint8_t)(size - tail + head);
+}
+
+static inline uint8_t i2c_SoftRingNext(uint8_t i, uint8_t size) {
+    return (++i == size) ? 0 : i;
+}
+
+// Takes one byte from the write ring, interrupt side
+static inline uint8_t i2c_SoftWritePop() {
+    uint8_t tail = i2c_SoftWriteTail;
+    uint8_t data = i2c_SoftWriteBuffer[tail];
+    i2c_SoftWriteTail = i2c_SoftRingNext(tail, I2C_SOFT_WRITE_BUFFER_SIZE);
+    return data;
+}
+
+// Records the answer to the oldest probe not answered yet, interrupt side
+static inline void i2c_SoftProbeAnswered(uint8_t ack) {
+    uint8_t ticket = i2c_SoftProbeTail + 1;
+    uint8_t bit = 1 << (ticket % I2C_PROBE_RESULTS);
+    i2c_SoftProbeAcks = ack ? (i2c_SoftProbeAcks | bit) : (i2c_SoftProbeAcks & ~bit);
+    I2C_SOFT_BARRIER();
+    i2c_SoftProbeTail = ticket;
+}
+
+/**
+ * @brief Returns the bytes queued in the write ring.
+ */
+uint8_t i2c_SoftWriteBufferUsed() {
+    return i2c_SoftRingCount(i2c_SoftWriteHead, i2c_SoftWriteTail, I2C_SOFT_WRITE_BUFFER_SIZE);
+}
+
+static uint8_t i2c_SoftReadBufferUsed() {
+    return i2c_SoftRingCount(i2c_SoftReadHead, i2c_SoftReadTail, I2C_SOFT_READ_BUFFER_SIZE);
+}
+
+/**
+ * @brief Appends a whole frame to the write ring, header bytes first.
+ *
+ * @return uint8_t Returns 1 if it fit, 0 if the ring is too full.
+ */
+static uint8_t i2c_SoftAddFrame(uint8_t address, uint8_t headerLength, const uint8_t* header,
+                                uint8_t length, const uint8_t* data) {
+    uint8_t head = i2c_SoftWriteHead;
+    uint8_t space = (I2C_SOFT_WRITE_BUFFER_SIZE - 1) - i2c_SoftWriteBufferUsed();
+    uint16_t total = (uint16_t) headerLength + length;
+
+    if (space < 2 || total > space - 2) {
+        return 0;
+    }
+    i2c_SoftWriteBuffer[head] = address;
+    head = i2c_SoftRingNext(head, I2C_SOFT_WRITE_BUFFER_SIZE);
+    i2c_SoftWriteBuffer[head] = (uint8_t) total;
+    head = i2c_SoftRingNext(head, I2C_SOFT_WRITE_BUFFER_SIZE);
+    for (uint8_t i = 0; i < headerLength; i++) {
+        i2c_SoftWriteBuffer[head] = header[i];
+        head = i2c_SoftRingNext(head, I2C_SOFT_WRITE_BUFFER_SIZE);
+    }
+    for (uint8_t i = 0; i < length; i++) {
+        i2c_SoftWriteBuffer[head] = data[i];
+        head = i2c_SoftRingNext(head, I2C_SOFT_WRITE_BUFFER_SIZE);
+    }
+    I2C_SOFT_BARRIER();
+    i2c_SoftWriteHead = head;
+    return 1;
+}
+
+/**
+ * @brief Sets up the pins and the Timer2 tick for an SCL frequency.
+ *
+ * The tick never gets shorter than I2C_SOFT_MIN_TICK_US, so a 100 kHz device
+ * runs at 25 kHz here; the TWI keeps the fast traffic.
+ *
+ * @param frequency The highest SCL frequency of the devices on this bus.
+ */
+void i2c_SoftInit(uint32_t frequency) {
+    uint16_t tickUs = (uint16_t)(500000UL / frequency);
+    if (tickUs < I2C_SOFT_MIN_TICK_US) {
+        tickUs = I2C_SOFT_MIN_TICK_US;
+    }
+
+    // Both lines released, the outputs stay at 0 so DDR alone drives them
+    I2C_SOFT_DDR  &= ~((1 << I2C_SOFT_SCL) | (1 << I2C_SOFT_SDA));
+    I2C_SOFT_PORT &= ~((1 << I2C_SOFT_SCL) | (1 << I2C_SOFT_SDA));
+
+    // Timer2 in CTC mode, the interrupt is enabled by i2c_SoftUpdate() when needed
+    TIMSK &= ~(1 << OCIE2);
+    OCR2  = (uint8_t)((tickUs * (F_CPU / 1000000UL)) / I2C_SOFT_TIMER_DIV - 1);
+    TCCR2 = (1 << WGM21) | I2C_SOFT_TIMER_CS;
+    i2c_SoftStep = I2C_SOFT_IDLE;
+    I2C_STATS(i2c_SoftStats.tickUs = (uint8_t) tickUs; i2c_SoftStatsReset());
+}
+
+/**
+ * @brief Queues a write transaction: address, then the data bytes.
+ *
+ * @return uint8_t Returns 1 if queued, 0 if the write ring is full.
+ */
+uint8_t i2c_SoftSendArray(uint8_t adr, uint8_t length, uint8_t* data) {
+    return i2c_SoftAddFrame(adr << 1, 0, 0, length, data);
+}
+
+/**
+ * @brief Queues a write transaction of a header followed by the data bytes.
+ */
+uint8_t i2c_SoftSendHeaderArray(uint8_t adr, uint8_t headerLength, const uint8_t* header, uint8_t length, const uint8_t* data) {
+    return i2c_SoftAddFrame(adr << 1, headerLength, header, length, data);
+}
+
+/**
+ * @brief Queues an address-only write, its outcome is read with the ticket of
+ * i2c_SoftProbeTicket() from i2c_SoftProbeResult().
+ */
+uint8_t i2c_SoftProbe(uint8_t adr) {
+    if (!i2c_SoftAddFrame(adr << 1, 0, 0, 0, 0)) {
+        return 0;
+    }
+    i2c_SoftProbeHead++;
+    return 1;
+}
+
+uint8_t i2c_SoftProbeTicket() {
+    return i2c_SoftProbeHead;
+}
+
+/**
+ * @brief Returns the I2C_PROBE_* outcome of the probe with the ticket, see
+ * i2c_ProbeResult().
+ */
+uint8_t i2c_SoftProbeResult(uint8_t ticket) {
+    if ((int8_t)(i2c_SoftProbeTail - ticket) < 0) {
+        return I2C_PROBE_PENDING;
+    }
+    uint8_t ack = i2c_SoftProbeAcks & (1 << (ticket % I2C_PROBE_RESULTS));
+    I2C_SOFT_BARRIER();
+    if ((uint8_t)(i2c_SoftProbeTail - ticket) >= I2C_PROBE_RESULTS) {
+        return I2C_PROBE_LOST;
+    }
+    return ack ? I2C_PROBE_ACK : I2C_PROBE_NACK;
+}
+
+/**
+ * @brief Queues a read; the bytes arrive in the read ring in order.
+ *
+ * Like i2c_GetData() only one read is pending at a time and the read ring
+ * must have been emptied by i2c_SoftReleaseRxBuffer().
+ *
+ * @return uint8_t Returns 1 if the read was queued.
+ */
+uint8_t i2c_SoftGetData(uint8_t adr, uint8_t length) {
+    if (i2c_SoftReadBufferUsed() != 0 || i2c_SoftReadLength != 0 || length == 0 || length >= I2C_SOFT_READ_BUFFER_SIZE) {
+        return 0;
+    }
+    i2c_SoftReadLength = length;
+    i2c_SoftReadPending = 1;
+    if (!i2c_SoftAddFrame((adr << 1) | 1, 0, 0, 0, 0)) {
+        i2c_SoftReadLength = 0;
+        i2c_SoftReadPending = 0;
+        return 0;
+    }
+    return 1;
+}
+
+uint8_t i2c_SoftReadBusy() {
+    return i2c_SoftReadPending;
+}
+
+/**
+ * @brief Copies received bytes without freeing them.
+ *
+ * @return uint8_t Returns length, or 0 if the bytes have not all arrived yet.
+ */
+uint8_t i2c_SoftCopyFromRxBuffer(uint8_t offset, uint8_t* data, uint8_t length) {
+    if ((uint16_t) offset + length > i2c_SoftReadBufferUsed()) {
+        return 0;
+    }
+    I2C_SOFT_BARRIER();
+    uint8_t tail = (uint8_t)(((uint16_t) i2c_SoftReadTail + offset) % I2C_SOFT_READ_BUFFER_SIZE);
+    for (uint8_t i = 0; i < length; i++) {
+        data[i] = i2c_SoftReadBuffer[tail];
+        tail = i2c_SoftRingNext(tail, I2C_SOFT_READ_BUFFER_SIZE);
+    }
+    return length;
+}
+
+/**
+ * @brief Frees the oldest received bytes and ends the read.
+ */
+void i2c_SoftReleaseRxBuffer(uint8_t length) {
+    uint8_t tail = (uint8_t)(((uint16_t) i2c_SoftReadTail + length) % I2C_SOFT_READ_BUFFER_SIZE);
+    I2C_SOFT_BARRIER();
+    i2c_SoftReadTail = tail;
+    i2c_SoftReadPending = 0;
+}
+
+/**
+ * @brief Starts the tick interrupt once a frame is queued.
+ *
+ * Called from the main loop through i2c_DeviceUpdate(); the interrupt turns
+ * itself off again when the ring is empty and the bus is free.
+ */
+void i2c_SoftUpdate() {
+    if (i2c_SoftWriteBufferUsed() != 0 && !(TIMSK & (1 << OCIE2))) {
+        TCNT2 = 0;
+        TIMSK |= (1 << OCIE2);
+    }
+}
+
+// Ends the frame: drops what is left of a refused write and goes to STOP
+static inline void i2c_SoftAbort() {
+    if (!i2c_SoftReading) {
+        while (i2c_SoftRemaining) {
+            i2c_SoftWritePop();
+            i2c_SoftRemaining--;
+        }
+    }
+    i2c_SoftStep = I2C_SOFT_STOP;
+}
+
+/**
+ * @brief One step of the bit engine per Timer2 compare match.
+ */
+ISR(TIMER2_COMP_vect) {
+    uint8_t addressed;
+
+#ifdef I2C_STATS_ENABLE
+    uint8_t latency = TCNT2;    // Counts since the compare match, interrupt latency
+    if (latency < i2c_SoftStats.latencyMin) {
+        i2c_SoftStats.latencyMin = latency;
+    }
+    if (latency > i2c_SoftStats.latencyMax) {
+        i2c_SoftStats.latencyMax = latency;
+    }
+    if (i2c_SoftStep != I2C_SOFT_IDLE) {
+        i2c_SoftStats.busyTicks++;
+    }
+#endif
+
+    switch (i2c_SoftStep) {
+        case I2C_SOFT_IDLE:
+            if (i2c_SoftWriteBufferUsed() < 2) {
+                TIMSK &= ~(1 << OCIE2);     // Nothing to do, sleep until i2c_SoftUpdate()
+                break;
+            }
+            I2C_SOFT_BARRIER();
+            i2c_SoftByte       = i2c_SoftWritePop();
+            i2c_SoftRemaining  = i2c_SoftWritePop();
+            i2c_SoftReading    = i2c_SoftByte & 1;
+            if (i2c_SoftReading) {
+                i2c_SoftRemaining = i2c_SoftReadLength;
+            }
+            i2c_SoftAddressing = 1;
+            i2c_SoftBit        = 0;
+            I2C_SOFT_SDA_LOW();         // START: SDA falls while SCL is high
+            I2C_STATS(i2c_SoftStats.transactions++);
+            i2c_SoftStep = I2C_SOFT_LOW;
+            break;
+
+        case I2C_SOFT_LOW:
+            I2C_SOFT_SCL_LOW();
+            if (i2c_SoftBit < 8) {
+                if ((i2c_SoftReading && !i2c_SoftAddressing) || (i2c_SoftByte & 0x80)) {
+                    I2C_SOFT_SDA_RELEASE();
+                } else {
+                    I2C_SOFT_SDA_LOW();
+                }
+            } else if (i2c_SoftReading && !i2c_SoftAddressing && i2c_SoftRemaining > 1) {
+                I2C_SOFT_SDA_LOW();         // ACK, more bytes wanted
+            } else {
+                I2C_SOFT_SDA_RELEASE();     // Slave acknowledges, or NACK after the last byte read
+            }
+            i2c_SoftStep = I2C_SOFT_HIGH;
+            break;
+
+        case I2C_SOFT_HIGH:
+            I2C_SOFT_SCL_RELEASE();
+            if (!I2C_SOFT_SCL_READ()) {
+                break;                      // Clock stretched, try again on the next tick
+            }
+            if (i2c_SoftBit < 8) {
+                i2c_SoftByte = (i2c_SoftByte << 1) | I2C_SOFT_SDA_READ();
+                i2c_SoftBit++;
+                i2c_SoftStep = I2C_SOFT_LOW;
+                break;
+            }
+
+            // Acknowledge bit
+            i2c_SoftBit  = 0;
+            i2c_SoftStep = I2C_SOFT_LOW;
+            if (i2c_SoftReading && !i2c_SoftAddressing) {
+                uint8_t head = i2c_SoftReadHead;
+                i2c_SoftReadBuffer[head] = i2c_SoftByte;
+                I2C_SOFT_BARRIER();
+                i2c_SoftReadHead = i2c_SoftRingNext(head, I2C_SOFT_READ_BUFFER_SIZE);
+                I2C_STATS(i2c_SoftStats.bytes++);
+                if (--i2c_SoftRemaining == 0) {
+                    i2c_SoftReadLength = 0;
+                    i2c_SoftStep = I2C_SOFT_STOP;
+                }
+                break;
+            }
+            if (I2C_SOFT_SDA_READ()) {
+                // Not acknowledged
+                I2C_STATS(i2c_SoftStats.nacks++);
+                if (i2c_SoftAddressing && !i2c_SoftReading && i2c_SoftRemaining == 0) {
+                    i2c_SoftProbeAnswered(0);
+                } else if (i2c_SoftReading) {
+                    i2c_SoftReadLength = 0;     // Abandon the read, the requester starts it again
+                    i2c_SoftReadPending = 0;
+                }
+                i2c_SoftAbort();
+                break;
+            }
+            addressed = i2c_SoftAddressing;
+            if (!addressed) {
+                I2C_STATS(i2c_SoftStats.bytes++);
+            }
+            i2c_SoftAddressing = 0;
+            if (i2c_SoftReading) {
+                break;                      // Address taken, the data bytes follow
+            }
+            if (i2c_SoftRemaining == 0) {
+                if (addressed) {
+                    i2c_SoftProbeAnswered(1);   // Address-only frame
+                }
+                i2c_SoftStep = I2C_SOFT_STOP;
+                break;
+            }
+            i2c_SoftByte = i2c_SoftWritePop();
+            i2c_SoftRemaining--;
+            break;
+
+        case I2C_SOFT_STOP:
+            I2C_SOFT_SCL_LOW();
+            I2C_SOFT_SDA_LOW();
+            i2c_SoftStep = I2C_SOFT_STOP_SCL;
+            break;
+
+        case I2C_SOFT_STOP_SCL:
+            I2C_SOFT_SCL_RELEASE();
+            if (I2C_SOFT_SCL_READ()) {
+                i2c_SoftStep = I2C_SOFT_STOP_SDA;
+            }
+            break;
+
+        case I2C_SOFT_STOP_SDA:
+        default:
+            I2C_SOFT_SDA_RELEASE();         // STOP: SDA rises while SCL is high
+            i2c_SoftStep = I2C_SOFT_IDLE;
+            break;
+    }
+}
+
+#ifdef I2C_STATS_ENABLE
+/**
+ * @brief Clears the statistics of the software bus.
+ */
+void i2c_SoftStatsReset() {
+    uint8_t sreg = SREG;
+    cli();
+    i2c_SoftStats.bytes        = 0;
+    i2c_SoftStats.transactions = 0;
+    i2c_SoftStats.nacks        = 0;
+    i2c_SoftStats.busyTicks    = 0;
+    i2c_SoftStats.latencyMin   = 0xFF;
+    i2c_SoftStats.latencyMax   = 0;
+    SREG = sreg;
+}
+
+/**
+ * @brief Consistent copy of the statistics of the software bus.
+ *
+ * Throughput is bytes / (busyTicks * tickUs), the SCL edge jitter
+ * latencyMax - latencyMin Timer2 counts (I2C_SOFT_TIMER_DIV CPU cycles each).
+ */
+void i2c_SoftStatsGet(i2c_SoftStats_t* stats) {
+    uint8_t sreg = SREG;
+    cli();
+    *stats = i2c_SoftStats;
+    SREG = sreg;
+}
+#endif
+
+// Operations for the device arbiter (i2c_device.h)
+const i2c_Bus_t i2c_SoftBus = {
+    i2c_SoftInit, i2c_SoftSendArray, i2c_SoftSendHeaderArray, i2c_SoftGetData, i2c_SoftCopyFromRxBuffer, i2c_SoftReleaseRxBuffer,
+    i2c_SoftReadBusy, i2c_SoftWriteBufferUsed, i2c_SoftProbe, i2c_SoftProbeTicket, i2c_SoftProbeResult, i2c_SoftUpdate,
+    I2C_SOFT_WRITE_BUFFER_SIZE, I2C_SOFT_READ_BUFFER_SIZE - 1
+};
+
+#endif // I2C_SOFT_ENABLE
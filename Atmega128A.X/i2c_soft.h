@@ -0,0 +1,66 @@
+#ifndef I2C_SOFT_H
+#define I2C_SOFT_H
+
+#include <avr/io.h>
+#include "i2c_driver.h"
+#include "i2c_device.h"
+
+// Second I2C master, bit-banged on two spare pins by the Timer2 compare
+// interrupt, so traffic of its devices runs in parallel with the TWI.
+// Uncomment or pass -DI2C_SOFT_ENABLE to the compiler; the DS1307 then moves
+// to it (see rtc_ds1307_low_level.c), other devices pick it with their bus field.
+//#define I2C_SOFT_ENABLE
+
+// Pins, open drain: driven low through DDR, released high by the external pull-ups
+#define I2C_SOFT_PORT           PORTE
+#define I2C_SOFT_DDR            DDRE
+#define I2C_SOFT_PIN            PINE
+#define I2C_SOFT_SCL            PE4
+#define I2C_SOFT_SDA            PE5
+
+// One interrupt per half SCL period, the SCL frequency is at most 1 / (2 * tick).
+// 20 us costs roughly a third of the CPU while a transaction runs at 8 MHz.
+#define I2C_SOFT_MIN_TICK_US    20
+#define I2C_SOFT_TIMER_DIV      8                       // Timer2 at clk/8, 1 count = 1 us at 8 MHz
+#define I2C_SOFT_TIMER_CS       (1 << CS21)
+
+#define I2C_SOFT_WRITE_BUFFER_SIZE  32                  // Frames [address][length][data ...]
+#define I2C_SOFT_READ_BUFFER_SIZE   32
+
+#ifdef I2C_SOFT_ENABLE
+
+#ifdef I2C_STATS_ENABLE
+typedef struct {
+    uint32_t bytes;             // Data bytes written and read
+    uint16_t transactions;      // STARTs sent
+    uint16_t nacks;             // Address or data bytes not acknowledged
+    uint32_t busyTicks;         // Interrupts while a transaction ran, x tickUs = busy time
+    uint8_t  tickUs;            // Interrupt period in microseconds
+    uint8_t  latencyMin;        // Timer2 counts from compare match to the interrupt, best case
+    uint8_t  latencyMax;        // and worst case, the difference is the SCL edge jitter
+} i2c_SoftStats_t;
+
+void    i2c_SoftStatsReset();
+void    i2c_SoftStatsGet(i2c_SoftStats_t* stats);
+#endif
+
+// The bus for i2c_Device_t.bus
+extern const i2c_Bus_t i2c_SoftBus;
+
+// Same transaction API as the TWI driver (i2c_driver.h)
+void    i2c_SoftInit(uint32_t frequency);                                   // Pins and tick for the SCL frequency
+uint8_t i2c_SoftSendArray(uint8_t adr, uint8_t length, uint8_t* data);      // Queue a write transaction
+uint8_t i2c_SoftSendHeaderArray(uint8_t adr, uint8_t headerLength, const uint8_t* header, uint8_t length, const uint8_t* data);
+uint8_t i2c_SoftGetData(uint8_t adr, uint8_t length);                       // Queue a read, one at a time
+uint8_t i2c_SoftCopyFromRxBuffer(uint8_t offset, uint8_t* data, uint8_t length); // Copy without freeing
+void    i2c_SoftReleaseRxBuffer(uint8_t length);                            // Free received bytes, ends the read
+uint8_t i2c_SoftReadBusy();                                                 // 1 from i2c_SoftGetData() until released or refused
+uint8_t i2c_SoftWriteBufferUsed();
+uint8_t i2c_SoftProbe(uint8_t adr);                                         // Address-only write
+uint8_t i2c_SoftProbeTicket();                                              // Ticket of the last probe queued
+uint8_t i2c_SoftProbeResult(uint8_t ticket);                                // I2C_PROBE_* of the probe with the ticket
+void    i2c_SoftUpdate();                                                   // Start the interrupt if work is queued
+
+#endif // I2C_SOFT_ENABLE
+
+#endif // I2C_SOFT_H
@@ -1,4 +1,6 @@
+#ifndef F_CPU
 #define F_CPU 8000000UL
+#endif
 #define _XTAL_FREQ 8000000  // 8 MHz clock frequency
 
 #include <avr/io.h>
@@ -7,6 +9,11 @@
 #include "EEPROM_24C32.h"
 #include "ProgramDataHandler.h"
 #include "rtc_ds1307.h"
+#include "uart_trace.h"
+#include "data_log.h"
+#include "profile_store.h"
+#include "boot.h"
+#include "power_fail.h"
 #define SUCCESS 1
 #define ERROR 0
 
@@ -28,17 +35,37 @@ void init_portb() {
 
 int main() {
 
-    _delay_ms(1000);
-    // Initialize I2C and EEPROM
-    i2c_Init(I2C_STANDARD_MODE);
-    eeprom_init(I2C_STANDARD_MODE);
     init_portb();
-    // Set the DS1307 to run and reset state
-    DS1307_init(init_data, CLOCK_RUN, NO_FORCE_RESET);
-    DS1307_read(TIME, time_data);
+    TRACE(trace_Init());
+    // Start the RTC, the default program, the data log and the profiles together
+    boot_Start(init_data);
+#ifdef CODEC_BENCH_ENABLE
+    codec_Bench_t bench;
+    codec_Benchmark(&bench);
+    TRACE(trace_Event(TRACE_EVT_CODEC_BENCH, &bench, sizeof(bench)));
+#endif
+#ifdef TRACE_ENABLE
+    uint8_t traceCountdown = 100;
+#endif
     while(1){
-    DS1307_update();
-    eeprom_Update();
+    i2c_DeviceUpdate();
+    datalog_Update();
+    EEPROM_prefetchUpdate();
+    profile_Update();
+    if (!boot_Ready()) {
+        boot_Update();
+        if (boot_Ready() && !(boot_Report()->failed & BOOT_TASK_RTC)) {
+            DS1307_read(TIME, time_data);
+        }
+        continue;                       // No fixed delay while booting
+    }
+#ifdef POWERFAIL_ENABLE
+    powerfail_Update();                 // Staged page follows the program switches
+#endif
+    TRACE(if (--traceCountdown == 0) { traceCountdown = 100; trace_Counters(); }); // Once a second
+#ifdef I2C_BUSTRACE_ENABLE
+    TRACE(trace_BusTrace());
+#endif
     _delay_ms(10);}
     return 0;
 }
@@ -51,17 +51,17 @@ OBJECTDIR=build/${CND_CONF}/${IMAGE_TYPE}
 DISTDIR=dist/${CND_CONF}/${IMAGE_TYPE}
 
 # Source Files Quoted if spaced
-SOURCEFILES_QUOTED_IF_SPACED=i2c_driver.c main.c ProgramDataHandler.c EEPROM_24C32.c rtc_ds1307.c rtc_ds1307_low_level.c
+SOURCEFILES_QUOTED_IF_SPACED=i2c_driver.c main.c ProgramDataHandler.c EEPROM_24C32.c rtc_ds1307.c rtc_ds1307_low_level.c i2c_request_queue.c i2c_device.c uart_trace.c data_log.c delta_codec.c profile_store.c i2c_soft.c stack_monitor.c boot.c power_fail.c
 
 # Object Files Quoted if spaced
-OBJECTFILES_QUOTED_IF_SPACED=${OBJECTDIR}/i2c_driver.o ${OBJECTDIR}/main.o ${OBJECTDIR}/ProgramDataHandler.o ${OBJECTDIR}/EEPROM_24C32.o ${OBJECTDIR}/rtc_ds1307.o ${OBJECTDIR}/rtc_ds1307_low_level.o
-POSSIBLE_DEPFILES=${OBJECTDIR}/i2c_driver.o.d ${OBJECTDIR}/main.o.d ${OBJECTDIR}/ProgramDataHandler.o.d ${OBJECTDIR}/EEPROM_24C32.o.d ${OBJECTDIR}/rtc_ds1307.o.d ${OBJECTDIR}/rtc_ds1307_low_level.o.d
+OBJECTFILES_QUOTED_IF_SPACED=${OBJECTDIR}/i2c_driver.o ${OBJECTDIR}/main.o ${OBJECTDIR}/ProgramDataHandler.o ${OBJECTDIR}/EEPROM_24C32.o ${OBJECTDIR}/rtc_ds1307.o ${OBJECTDIR}/rtc_ds1307_low_level.o ${OBJECTDIR}/i2c_request_queue.o ${OBJECTDIR}/i2c_device.o ${OBJECTDIR}/uart_trace.o ${OBJECTDIR}/data_log.o ${OBJECTDIR}/delta_codec.o ${OBJECTDIR}/profile_store.o ${OBJECTDIR}/i2c_soft.o ${OBJECTDIR}/stack_monitor.o ${OBJECTDIR}/boot.o ${OBJECTDIR}/power_fail.o
+POSSIBLE_DEPFILES=${OBJECTDIR}/i2c_driver.o.d ${OBJECTDIR}/main.o.d ${OBJECTDIR}/ProgramDataHandler.o.d ${OBJECTDIR}/EEPROM_24C32.o.d ${OBJECTDIR}/rtc_ds1307.o.d ${OBJECTDIR}/rtc_ds1307_low_level.o.d ${OBJECTDIR}/i2c_request_queue.o.d ${OBJECTDIR}/i2c_device.o.d ${OBJECTDIR}/uart_trace.o.d ${OBJECTDIR}/data_log.o.d ${OBJECTDIR}/delta_codec.o.d ${OBJECTDIR}/profile_store.o.d ${OBJECTDIR}/i2c_soft.o.d ${OBJECTDIR}/stack_monitor.o.d ${OBJECTDIR}/boot.o.d ${OBJECTDIR}/power_fail.o.d
 
 # Object Files
-OBJECTFILES=${OBJECTDIR}/i2c_driver.o ${OBJECTDIR}/main.o ${OBJECTDIR}/ProgramDataHandler.o ${OBJECTDIR}/EEPROM_24C32.o ${OBJECTDIR}/rtc_ds1307.o ${OBJECTDIR}/rtc_ds1307_low_level.o
+OBJECTFILES=${OBJECTDIR}/i2c_driver.o ${OBJECTDIR}/main.o ${OBJECTDIR}/ProgramDataHandler.o ${OBJECTDIR}/EEPROM_24C32.o ${OBJECTDIR}/rtc_ds1307.o ${OBJECTDIR}/rtc_ds1307_low_level.o ${OBJECTDIR}/i2c_request_queue.o ${OBJECTDIR}/i2c_device.o ${OBJECTDIR}/uart_trace.o ${OBJECTDIR}/data_log.o ${OBJECTDIR}/delta_codec.o ${OBJECTDIR}/profile_store.o ${OBJECTDIR}/i2c_soft.o ${OBJECTDIR}/stack_monitor.o ${OBJECTDIR}/boot.o ${OBJECTDIR}/power_fail.o
 
 # Source Files
-SOURCEFILES=i2c_driver.c main.c ProgramDataHandler.c EEPROM_24C32.c rtc_ds1307.c rtc_ds1307_low_level.c
+SOURCEFILES=i2c_driver.c main.c ProgramDataHandler.c EEPROM_24C32.c rtc_ds1307.c rtc_ds1307_low_level.c i2c_request_queue.c i2c_device.c uart_trace.c data_log.c delta_codec.c profile_store.c i2c_soft.c stack_monitor.c boot.c power_fail.c
 
 
 
@@ -124,6 +124,66 @@ ${OBJECTDIR}/rtc_ds1307_low_level.o: rtc_ds1307_low_level.c  nbproject/Makefile-
 	@${RM} ${OBJECTDIR}/rtc_ds1307_low_level.o 
 	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -D__DEBUG=1 -g -DDEBUG -D__MPLAB_DEBUGGER_SIMULATOR=1 -gdwarf-2  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -O1 -ffunction-sections -fdata-sections -fshort-enums -fno-common -funsigned-char -funsigned-bitfields -Wall -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mno-const-data-in-progmem     -MD -MP -MF "${OBJECTDIR}/rtc_ds1307_low_level.o.d" -MT "${OBJECTDIR}/rtc_ds1307_low_level.o.d" -MT ${OBJECTDIR}/rtc_ds1307_low_level.o -o ${OBJECTDIR}/rtc_ds1307_low_level.o rtc_ds1307_low_level.c 
 	
+${OBJECTDIR}/power_fail.o: power_fail.c  nbproject/Makefile-${CND_CONF}.mk 
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/power_fail.o.d 
+	@${RM} ${OBJECTDIR}/power_fail.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -D__DEBUG=1 -g -DDEBUG -D__MPLAB_DEBUGGER_SIMULATOR=1 -gdwarf-2  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -O1 -ffunction-sections -fdata-sections -fshort-enums -fno-common -funsigned-char -funsigned-bitfields -Wall -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mno-const-data-in-progmem     -MD -MP -MF "${OBJECTDIR}/power_fail.o.d" -MT "${OBJECTDIR}/power_fail.o.d" -MT ${OBJECTDIR}/power_fail.o -o ${OBJECTDIR}/power_fail.o power_fail.c 
+	
+${OBJECTDIR}/boot.o: boot.c  nbproject/Makefile-${CND_CONF}.mk 
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/boot.o.d 
+	@${RM} ${OBJECTDIR}/boot.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -D__DEBUG=1 -g -DDEBUG -D__MPLAB_DEBUGGER_SIMULATOR=1 -gdwarf-2  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -O1 -ffunction-sections -fdata-sections -fshort-enums -fno-common -funsigned-char -funsigned-bitfields -Wall -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mno-const-data-in-progmem     -MD -MP -MF "${OBJECTDIR}/boot.o.d" -MT "${OBJECTDIR}/boot.o.d" -MT ${OBJECTDIR}/boot.o -o ${OBJECTDIR}/boot.o boot.c 
+	
+${OBJECTDIR}/stack_monitor.o: stack_monitor.c  nbproject/Makefile-${CND_CONF}.mk 
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/stack_monitor.o.d 
+	@${RM} ${OBJECTDIR}/stack_monitor.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -D__DEBUG=1 -g -DDEBUG -D__MPLAB_DEBUGGER_SIMULATOR=1 -gdwarf-2  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -O1 -ffunction-sections -fdata-sections -fshort-enums -fno-common -funsigned-char -funsigned-bitfields -Wall -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mno-const-data-in-progmem     -MD -MP -MF "${OBJECTDIR}/stack_monitor.o.d" -MT "${OBJECTDIR}/stack_monitor.o.d" -MT ${OBJECTDIR}/stack_monitor.o -o ${OBJECTDIR}/stack_monitor.o stack_monitor.c 
+	
+${OBJECTDIR}/i2c_soft.o: i2c_soft.c  nbproject/Makefile-${CND_CONF}.mk 
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/i2c_soft.o.d 
+	@${RM} ${OBJECTDIR}/i2c_soft.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -D__DEBUG=1 -g -DDEBUG -D__MPLAB_DEBUGGER_SIMULATOR=1 -gdwarf-2  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -O1 -ffunction-sections -fdata-sections -fshort-enums -fno-common -funsigned-char -funsigned-bitfields -Wall -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mno-const-data-in-progmem     -MD -MP -MF "${OBJECTDIR}/i2c_soft.o.d" -MT "${OBJECTDIR}/i2c_soft.o.d" -MT ${OBJECTDIR}/i2c_soft.o -o ${OBJECTDIR}/i2c_soft.o i2c_soft.c 
+	
+${OBJECTDIR}/profile_store.o: profile_store.c  nbproject/Makefile-${CND_CONF}.mk 
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/profile_store.o.d 
+	@${RM} ${OBJECTDIR}/profile_store.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -D__DEBUG=1 -g -DDEBUG -D__MPLAB_DEBUGGER_SIMULATOR=1 -gdwarf-2  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -O1 -ffunction-sections -fdata-sections -fshort-enums -fno-common -funsigned-char -funsigned-bitfields -Wall -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mno-const-data-in-progmem     -MD -MP -MF "${OBJECTDIR}/profile_store.o.d" -MT "${OBJECTDIR}/profile_store.o.d" -MT ${OBJECTDIR}/profile_store.o -o ${OBJECTDIR}/profile_store.o profile_store.c 
+	
+${OBJECTDIR}/delta_codec.o: delta_codec.c  nbproject/Makefile-${CND_CONF}.mk 
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/delta_codec.o.d 
+	@${RM} ${OBJECTDIR}/delta_codec.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -D__DEBUG=1 -g -DDEBUG -D__MPLAB_DEBUGGER_SIMULATOR=1 -gdwarf-2  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -O1 -ffunction-sections -fdata-sections -fshort-enums -fno-common -funsigned-char -funsigned-bitfields -Wall -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mno-const-data-in-progmem     -MD -MP -MF "${OBJECTDIR}/delta_codec.o.d" -MT "${OBJECTDIR}/delta_codec.o.d" -MT ${OBJECTDIR}/delta_codec.o -o ${OBJECTDIR}/delta_codec.o delta_codec.c 
+	
+${OBJECTDIR}/data_log.o: data_log.c  nbproject/Makefile-${CND_CONF}.mk 
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/data_log.o.d 
+	@${RM} ${OBJECTDIR}/data_log.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -D__DEBUG=1 -g -DDEBUG -D__MPLAB_DEBUGGER_SIMULATOR=1 -gdwarf-2  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -O1 -ffunction-sections -fdata-sections -fshort-enums -fno-common -funsigned-char -funsigned-bitfields -Wall -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mno-const-data-in-progmem     -MD -MP -MF "${OBJECTDIR}/data_log.o.d" -MT "${OBJECTDIR}/data_log.o.d" -MT ${OBJECTDIR}/data_log.o -o ${OBJECTDIR}/data_log.o data_log.c 
+	
+${OBJECTDIR}/uart_trace.o: uart_trace.c  nbproject/Makefile-${CND_CONF}.mk 
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/uart_trace.o.d 
+	@${RM} ${OBJECTDIR}/uart_trace.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -D__DEBUG=1 -g -DDEBUG -D__MPLAB_DEBUGGER_SIMULATOR=1 -gdwarf-2  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -O1 -ffunction-sections -fdata-sections -fshort-enums -fno-common -funsigned-char -funsigned-bitfields -Wall -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mno-const-data-in-progmem     -MD -MP -MF "${OBJECTDIR}/uart_trace.o.d" -MT "${OBJECTDIR}/uart_trace.o.d" -MT ${OBJECTDIR}/uart_trace.o -o ${OBJECTDIR}/uart_trace.o uart_trace.c 
+	
+${OBJECTDIR}/i2c_device.o: i2c_device.c  nbproject/Makefile-${CND_CONF}.mk 
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/i2c_device.o.d 
+	@${RM} ${OBJECTDIR}/i2c_device.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -D__DEBUG=1 -g -DDEBUG -D__MPLAB_DEBUGGER_SIMULATOR=1 -gdwarf-2  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -O1 -ffunction-sections -fdata-sections -fshort-enums -fno-common -funsigned-char -funsigned-bitfields -Wall -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mno-const-data-in-progmem     -MD -MP -MF "${OBJECTDIR}/i2c_device.o.d" -MT "${OBJECTDIR}/i2c_device.o.d" -MT ${OBJECTDIR}/i2c_device.o -o ${OBJECTDIR}/i2c_device.o i2c_device.c 
+	
+${OBJECTDIR}/i2c_request_queue.o: i2c_request_queue.c  nbproject/Makefile-${CND_CONF}.mk 
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/i2c_request_queue.o.d 
+	@${RM} ${OBJECTDIR}/i2c_request_queue.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -D__DEBUG=1 -g -DDEBUG -D__MPLAB_DEBUGGER_SIMULATOR=1 -gdwarf-2  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -O1 -ffunction-sections -fdata-sections -fshort-enums -fno-common -funsigned-char -funsigned-bitfields -Wall -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mno-const-data-in-progmem     -MD -MP -MF "${OBJECTDIR}/i2c_request_queue.o.d" -MT "${OBJECTDIR}/i2c_request_queue.o.d" -MT ${OBJECTDIR}/i2c_request_queue.o -o ${OBJECTDIR}/i2c_request_queue.o i2c_request_queue.c 
+	
 else
 ${OBJECTDIR}/i2c_driver.o: i2c_driver.c  nbproject/Makefile-${CND_CONF}.mk 
 	@${MKDIR} "${OBJECTDIR}" 
@@ -161,6 +221,66 @@ ${OBJECTDIR}/rtc_ds1307_low_level.o: rtc_ds1307_low_level.c  nbproject/Makefile-
 	@${RM} ${OBJECTDIR}/rtc_ds1307_low_level.o 
 	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -O1 -ffunction-sections -fdata-sections -fshort-enums -fno-common -funsigned-char -funsigned-bitfields -Wall -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mno-const-data-in-progmem     -MD -MP -MF "${OBJECTDIR}/rtc_ds1307_low_level.o.d" -MT "${OBJECTDIR}/rtc_ds1307_low_level.o.d" -MT ${OBJECTDIR}/rtc_ds1307_low_level.o -o ${OBJECTDIR}/rtc_ds1307_low_level.o rtc_ds1307_low_level.c 
 	
+${OBJECTDIR}/power_fail.o: power_fail.c  nbproject/Makefile-${CND_CONF}.mk 
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/power_fail.o.d 
+	@${RM} ${OBJECTDIR}/power_fail.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -O1 -ffunction-sections -fdata-sections -fshort-enums -fno-common -funsigned-char -funsigned-bitfields -Wall -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mno-const-data-in-progmem     -MD -MP -MF "${OBJECTDIR}/power_fail.o.d" -MT "${OBJECTDIR}/power_fail.o.d" -MT ${OBJECTDIR}/power_fail.o -o ${OBJECTDIR}/power_fail.o power_fail.c 
+	
+${OBJECTDIR}/boot.o: boot.c  nbproject/Makefile-${CND_CONF}.mk 
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/boot.o.d 
+	@${RM} ${OBJECTDIR}/boot.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -O1 -ffunction-sections -fdata-sections -fshort-enums -fno-common -funsigned-char -funsigned-bitfields -Wall -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mno-const-data-in-progmem     -MD -MP -MF "${OBJECTDIR}/boot.o.d" -MT "${OBJECTDIR}/boot.o.d" -MT ${OBJECTDIR}/boot.o -o ${OBJECTDIR}/boot.o boot.c 
+	
+${OBJECTDIR}/stack_monitor.o: stack_monitor.c  nbproject/Makefile-${CND_CONF}.mk 
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/stack_monitor.o.d 
+	@${RM} ${OBJECTDIR}/stack_monitor.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -O1 -ffunction-sections -fdata-sections -fshort-enums -fno-common -funsigned-char -funsigned-bitfields -Wall -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mno-const-data-in-progmem     -MD -MP -MF "${OBJECTDIR}/stack_monitor.o.d" -MT "${OBJECTDIR}/stack_monitor.o.d" -MT ${OBJECTDIR}/stack_monitor.o -o ${OBJECTDIR}/stack_monitor.o stack_monitor.c 
+	
+${OBJECTDIR}/i2c_soft.o: i2c_soft.c  nbproject/Makefile-${CND_CONF}.mk 
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/i2c_soft.o.d 
+	@${RM} ${OBJECTDIR}/i2c_soft.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -O1 -ffunction-sections -fdata-sections -fshort-enums -fno-common -funsigned-char -funsigned-bitfields -Wall -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mno-const-data-in-progmem     -MD -MP -MF "${OBJECTDIR}/i2c_soft.o.d" -MT "${OBJECTDIR}/i2c_soft.o.d" -MT ${OBJECTDIR}/i2c_soft.o -o ${OBJECTDIR}/i2c_soft.o i2c_soft.c 
+	
+${OBJECTDIR}/profile_store.o: profile_store.c  nbproject/Makefile-${CND_CONF}.mk 
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/profile_store.o.d 
+	@${RM} ${OBJECTDIR}/profile_store.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -O1 -ffunction-sections -fdata-sections -fshort-enums -fno-common -funsigned-char -funsigned-bitfields -Wall -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mno-const-data-in-progmem     -MD -MP -MF "${OBJECTDIR}/profile_store.o.d" -MT "${OBJECTDIR}/profile_store.o.d" -MT ${OBJECTDIR}/profile_store.o -o ${OBJECTDIR}/profile_store.o profile_store.c 
+	
+${OBJECTDIR}/delta_codec.o: delta_codec.c  nbproject/Makefile-${CND_CONF}.mk 
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/delta_codec.o.d 
+	@${RM} ${OBJECTDIR}/delta_codec.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -O1 -ffunction-sections -fdata-sections -fshort-enums -fno-common -funsigned-char -funsigned-bitfields -Wall -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mno-const-data-in-progmem     -MD -MP -MF "${OBJECTDIR}/delta_codec.o.d" -MT "${OBJECTDIR}/delta_codec.o.d" -MT ${OBJECTDIR}/delta_codec.o -o ${OBJECTDIR}/delta_codec.o delta_codec.c 
+	
+${OBJECTDIR}/data_log.o: data_log.c  nbproject/Makefile-${CND_CONF}.mk 
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/data_log.o.d 
+	@${RM} ${OBJECTDIR}/data_log.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -O1 -ffunction-sections -fdata-sections -fshort-enums -fno-common -funsigned-char -funsigned-bitfields -Wall -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mno-const-data-in-progmem     -MD -MP -MF "${OBJECTDIR}/data_log.o.d" -MT "${OBJECTDIR}/data_log.o.d" -MT ${OBJECTDIR}/data_log.o -o ${OBJECTDIR}/data_log.o data_log.c 
+	
+${OBJECTDIR}/uart_trace.o: uart_trace.c  nbproject/Makefile-${CND_CONF}.mk 
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/uart_trace.o.d 
+	@${RM} ${OBJECTDIR}/uart_trace.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -O1 -ffunction-sections -fdata-sections -fshort-enums -fno-common -funsigned-char -funsigned-bitfields -Wall -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mno-const-data-in-progmem     -MD -MP -MF "${OBJECTDIR}/uart_trace.o.d" -MT "${OBJECTDIR}/uart_trace.o.d" -MT ${OBJECTDIR}/uart_trace.o -o ${OBJECTDIR}/uart_trace.o uart_trace.c 
+	
+${OBJECTDIR}/i2c_device.o: i2c_device.c  nbproject/Makefile-${CND_CONF}.mk 
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/i2c_device.o.d 
+	@${RM} ${OBJECTDIR}/i2c_device.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -O1 -ffunction-sections -fdata-sections -fshort-enums -fno-common -funsigned-char -funsigned-bitfields -Wall -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mno-const-data-in-progmem     -MD -MP -MF "${OBJECTDIR}/i2c_device.o.d" -MT "${OBJECTDIR}/i2c_device.o.d" -MT ${OBJECTDIR}/i2c_device.o -o ${OBJECTDIR}/i2c_device.o i2c_device.c 
+	
+${OBJECTDIR}/i2c_request_queue.o: i2c_request_queue.c  nbproject/Makefile-${CND_CONF}.mk 
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/i2c_request_queue.o.d 
+	@${RM} ${OBJECTDIR}/i2c_request_queue.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -O1 -ffunction-sections -fdata-sections -fshort-enums -fno-common -funsigned-char -funsigned-bitfields -Wall -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mno-const-data-in-progmem     -MD -MP -MF "${OBJECTDIR}/i2c_request_queue.o.d" -MT "${OBJECTDIR}/i2c_request_queue.o.d" -MT ${OBJECTDIR}/i2c_request_queue.o -o ${OBJECTDIR}/i2c_request_queue.o i2c_request_queue.c 
+	
 endif
 
 # ------------------------------------------------------------------------------------
@@ -0,0 +1,202 @@
+/*_____________________________{FILE_NAME}_____________________________________________________
+                                      ___           ___           ___
+ Author: Abdelrahman Selim           /\  \         /\  \         /\  \
+                                    /::\  \       /::\  \       /::\  \
+Created on: {DATE}                 /:/\:\  \     /:/\:\  \     /:/\:\  \
+                                  /::\ \:\  \   _\:\ \:\  \   /::\ \:\  \
+ Version: 01                     /:/\:\ \:\__\ /\ \:\ \:\__\ /:/\:\ \:\__\
+                                 \/__\:\/:/  / \:\ \:\ \/__/ \/__\:\/:/  /
+                                      \::/  /   \:\ \:\__\        \::/  /
+                                      /:/  /     \:\/:/  /        /:/  /
+ Brief : Power-Fail Save             /:/  /       \::/  /        /:/  /
+                                     \/__/         \/__/         \/__/
+ _________________________________________________________________________________________*/
+#include "power_fail.h"
+#include <avr/interrupt.h>
+#include <avr/wdt.h>
+#include <util/delay.h>
+
+#ifdef POWERFAIL_ENABLE
+
+typedef char powerfail_page_size_check[(sizeof(powerfail_Page_t) == POWERFAIL_PAGE_BYTES) ? 1 : -1];
+
+// Local Variables
+static powerfail_Page_t powerfail_Pages[2];         // Staged by the main loop, one of them complete at any time
+static volatile uint8_t powerfail_Staged;           // Index of the complete page, a single byte store
+static powerfail_Page_t powerfail_Saved;            // Page read back at boot
+static const Program_t* powerfail_StagedProgram;    // Active program when the page was staged
+static uint8_t powerfail_State = POWERFAIL_NONE;
+static uint8_t powerfail_ReadQueued;                // Read of powerfail_Saved taken by the queue
+
+// Complemented sum of the bytes after the checksum
+static uint8_t powerfail_Checksum(const powerfail_Page_t* page) {
+    const uint8_t* bytes = (const uint8_t*) page;
+    uint8_t sum = 0;
+    for (uint8_t i = 2; i < sizeof(powerfail_Page_t); i++) {
+        sum += bytes[i];
+    }
+    return ~sum;
+}
+
+// Queues the read of the saved page, 0 if the queue of the device is full
+static uint8_t powerfail_QueueRead() {
+#if POWERFAIL_TARGET == POWERFAIL_TARGET_EEPROM
+    return eeprom_readArray(POWERFAIL_EEPROM_ADDR, sizeof(powerfail_Saved), (uint8_t*) &powerfail_Saved);
+#else
+    return time_i2c_read_multi(DS1307_I2C_ADDRESS, POWERFAIL_NVRAM_START, (uint8_t*) &powerfail_Saved, sizeof(powerfail_Saved));
+#endif
+}
+
+/**
+ * @brief Reads back a page saved at the last power failure and arms the comparator.
+ *
+ * Nothing is staged yet, so a failure before the first powerfail_Stage()
+ * leaves the saved page alone.
+ */
+void powerfail_Init() {
+    powerfail_Pages[0].mark = 0;
+    powerfail_Pages[1].mark = 0;
+    powerfail_State = POWERFAIL_LOADING;        // A read the queue refuses is queued by powerfail_Status()
+    powerfail_ReadQueued = powerfail_QueueRead();
+
+    DDRE  &= ~(1 << PE3);                       // AIN1, high impedance input
+    PORTE &= ~(1 << PE3);
+    ACSR = (1 << ACBG) | (1 << ACIS1) | (1 << ACIS0);   // Bandgap on the positive input, rising output edge
+    _delay_us(100);                             // Bandgap start-up, no false trip
+    ACSR |= (1 << ACI);
+    ACSR |= (1 << ACIE);
+}
+
+/**
+ * @brief Returns POWERFAIL_LOADING, POWERFAIL_NONE or POWERFAIL_SAVED.
+ */
+uint8_t powerfail_Status() {
+    if (powerfail_State == POWERFAIL_LOADING && !powerfail_ReadQueued) {
+        powerfail_ReadQueued = powerfail_QueueRead();
+        return powerfail_State;
+    }
+#if POWERFAIL_TARGET == POWERFAIL_TARGET_EEPROM
+    uint8_t pending = eeprom_readPending();
+#else
+    uint8_t pending = DS1307_read_pending();
+#endif
+    if (powerfail_State == POWERFAIL_LOADING && !pending) {
+        powerfail_State = (powerfail_Saved.mark == POWERFAIL_MARK && powerfail_Saved.checksum == powerfail_Checksum(&powerfail_Saved))
+                          ? POWERFAIL_SAVED : POWERFAIL_NONE;
+    }
+    return powerfail_State;
+}
+
+/**
+ * @brief Hands over the saved page and queues its discard.
+ *
+ * The setpoints (EEPROM target only, the DS1307 RAM has no room for them)
+ * go into the shadow buffer of ProgramDataHandler.c and are published, so
+ * the control loop runs the saved program; setpoints that fail the program
+ * validation leave the active program in place. The progress goes to the
+ * caller, who resumes the program from it.
+ *
+ * @return uint8_t Returns 1 if a page was saved, 0 if there is none (yet),
+ *         a program load is still on its way or the discard could not be
+ *         queued; call it again then.
+ */
+uint8_t powerfail_Restore(powerfail_Progress_t* progress) {
+    uint8_t erased = 0;
+
+    if (powerfail_Status() != POWERFAIL_SAVED) {
+        return 0;
+    }
+#if POWERFAIL_TARGET == POWERFAIL_TARGET_EEPROM
+    uint8_t shadow = EEPROM_shadowProgram(&powerfail_Saved.setpoints);
+    if (shadow == PROGRAM_SHADOW_LOADING || !eeprom_writeByte(POWERFAIL_EEPROM_ADDR, erased)) {
+        return 0;
+    }
+    if (shadow == PROGRAM_SHADOW_READY) {
+        EEPROM_publishProgram();
+    }
+#else
+    if (!time_i2c_write_single(DS1307_I2C_ADDRESS, POWERFAIL_NVRAM_START, &erased)) {
+        return 0;
+    }
+#endif
+    *progress = powerfail_Saved.progress;
+    powerfail_State = POWERFAIL_NONE;
+    return 1;
+}
+
+/**
+ * @brief Serializes the page the power-fail interrupt will write.
+ *
+ * Call it whenever the progress changes, and with 0 once the program ended
+ * (a power failure then saves nothing). The setpoints are those of the
+ * program the control loop runs, EEPROM_activeProgram(). The page is built
+ * in the buffer the interrupt does not use and switched in with one byte
+ * store, so the interrupt always finds a complete page and spends no time
+ * on serializing.
+ */
+void powerfail_Stage(const powerfail_Progress_t* progress) {
+    powerfail_Page_t* page = &powerfail_Pages[powerfail_Staged ^ 1];
+
+    if (!progress) {
+        page->mark = 0;
+        powerfail_Staged ^= 1;
+        return;
+    }
+    page->mark     = POWERFAIL_MARK;
+    page->progress = *progress;
+    powerfail_StagedProgram = EEPROM_activeProgram();
+#if POWERFAIL_TARGET == POWERFAIL_TARGET_EEPROM
+    page->setpoints = *powerfail_StagedProgram;
+#endif
+    page->checksum = powerfail_Checksum(page);
+    powerfail_Staged ^= 1;
+}
+
+/**
+ * @brief Keeps the staged page in step with the program, call it from the main loop.
+ *
+ * A program published since the page was staged (EEPROM_publishProgram()
+ * switches the active buffer) is staged again with the same progress, so a
+ * power failure never saves the setpoints of a program that is no longer
+ * running.
+ */
+void powerfail_Update() {
+    const powerfail_Page_t* page = &powerfail_Pages[powerfail_Staged];
+
+    if (page->mark == POWERFAIL_MARK && powerfail_StagedProgram != EEPROM_activeProgram()) {
+        powerfail_Stage(&page->progress);
+    }
+}
+
+/**
+ * @brief Supply falling: saves the staged page and never returns.
+ *
+ * The TWI is taken from the queue (i2c_Preempt()), the frame in flight is
+ * dropped without its STOP and the page goes out in polled mode, all with
+ * interrupts off; worst case see POWERFAIL_WORST_CASE_US. Afterwards the
+ * controller waits for the supply to die. If it comes back instead (a dip),
+ * the watchdog restarts it, the queue is gone and the boot restores the page.
+ */
+ISR(ANA_COMP_vect) {
+    const powerfail_Page_t* page = &powerfail_Pages[powerfail_Staged];
+    uint16_t good = 0;
+
+    ACSR &= ~(1 << ACIE);
+    i2c_Preempt();
+    if (page->mark == POWERFAIL_MARK) {
+#if POWERFAIL_TARGET == POWERFAIL_TARGET_EEPROM
+        eeprom_writeNow(POWERFAIL_EEPROM_ADDR, sizeof(powerfail_Page_t), (const uint8_t*) page);
+#else
+        time_i2c_write_now(POWERFAIL_NVRAM_START, (const uint8_t*) page, sizeof(powerfail_Page_t));
+#endif
+    }
+    while (good < POWERFAIL_RECOVER_MS * 10) {
+        _delay_us(100);
+        good = (ACSR & (1 << ACO)) ? 0 : good + 1;
+    }
+    wdt_enable(WDTO_15MS);
+    for (;;) {
+    }
+}
+
+#endif // POWERFAIL_ENABLE
@@ -0,0 +1,101 @@
+#ifndef POWER_FAIL_H
+#define POWER_FAIL_H
+
+#include <avr/io.h>
+#include "EEPROM_24C32.h"
+#include "ProgramDataHandler.h"
+#include "profile_store.h"
+#include "rtc_ds1307.h"
+
+// Power-fail save, uncomment or pass -DPOWERFAIL_ENABLE to the compiler.
+// The unregulated supply, divided down onto AIN1 (PE3), is compared with the
+// internal bandgap (1.23 V); when it falls below, the analog comparator
+// interrupt takes the TWI from the queue and writes the page staged last by
+// powerfail_Stage(). PE2 (AIN0) stays free. The divider sets the trip point,
+// which must leave the hold-up time below (see POWERFAIL_WORST_CASE_US).
+//#define POWERFAIL_ENABLE
+
+// Where the page goes
+#define POWERFAIL_TARGET_EEPROM     0   // Reserved page between the program table and the profiles
+#define POWERFAIL_TARGET_NVRAM      1   // DS1307 RAM behind the snapshot ring, no write cycle but no setpoints
+#ifndef POWERFAIL_TARGET
+#define POWERFAIL_TARGET            POWERFAIL_TARGET_EEPROM
+#endif
+
+#define POWERFAIL_EEPROM_ADDR       0x07E0  // Free gap 0x07D0 - 0x07FF
+#define POWERFAIL_NVRAM_START       0x31    // 0x31 - 0x3F
+#define POWERFAIL_MARK              0xA5    // First byte of a saved page
+#define POWERFAIL_RECOVER_MS        100     // Supply back this long after a save: restart through the watchdog
+
+// Progress of the running program, kept up to date by the control loop
+typedef struct {
+    uint8_t  program;           // groupIndex * PROGRAMS_PER_GROUP + programIndex
+    uint8_t  segment;           // Firing segment in progress
+    uint16_t segmentElapsed;    // Seconds into the segment
+    uint16_t setpoint;          // Temperature the segment was heading for
+} powerfail_Progress_t;
+
+// The page as stored, written in one frame
+typedef struct {
+    uint8_t  mark;              // POWERFAIL_MARK, anything else means nothing was saved
+    uint8_t  checksum;          // Complemented sum of the bytes after it
+    powerfail_Progress_t progress;
+#if POWERFAIL_TARGET == POWERFAIL_TARGET_EEPROM
+    Program_t setpoints;        // EEPROM_activeProgram() when staged
+#endif
+} powerfail_Page_t;
+
+#if POWERFAIL_TARGET == POWERFAIL_TARGET_EEPROM
+#define POWERFAIL_PAGE_BYTES        28
+#define POWERFAIL_ADDRESS_BYTES     EEPROM_ADDRESS_WIDTH
+#define POWERFAIL_POLL_US           (EEPROM_WRITE_CYCLE_MS * 1000UL)  // Chip still programming an earlier page
+#define POWERFAIL_COMMIT_US         (EEPROM_WRITE_CYCLE_MS * 1000UL)  // Programming the saved page
+#if (POWERFAIL_EEPROM_ADDR < PROGRAM_TABLE_END) || (POWERFAIL_EEPROM_ADDR + POWERFAIL_PAGE_BYTES > PROFILE_DIR_START)
+#error "power-fail page overlaps the program table or the profiles"
+#endif
+#if (POWERFAIL_EEPROM_ADDR % EEPROM_PAGE_SIZE) + POWERFAIL_PAGE_BYTES > EEPROM_PAGE_SIZE
+#error "power-fail page must not cross an EEPROM page"
+#endif
+#else
+#define POWERFAIL_PAGE_BYTES        8
+#define POWERFAIL_ADDRESS_BYTES     1
+#define POWERFAIL_POLL_US           0
+#define POWERFAIL_COMMIT_US         0
+#if POWERFAIL_NVRAM_START < (DS1307_SNAP_RING_START + DS1307_SNAP_RING_SIZE) || (POWERFAIL_NVRAM_START + POWERFAIL_PAGE_BYTES - 1) > DS1307_RAM_END
+#error "power-fail page overlaps the snapshot ring or does not fit in ds1307 RAM"
+#endif
+#if defined(POWERFAIL_ENABLE) && defined(I2C_SOFT_ENABLE)
+#error "the save is polled on the TWI, the DS1307 is on the software bus"
+#endif
+#endif
+
+// Worst case from the comparator trip to the page being safe, at 100 kHz (the
+// slowest the TWI runs): entry behind the longest interrupt, the byte on the
+// wire plus one NACKed byte ending a read, ACK polling through a page write
+// in progress, the frame, and the chip's own write cycle. 24C32: 23.0 ms,
+// DS1307 RAM: 1.2 ms. The supply must stay in range of the memory that long:
+// hold-up capacitance >= load current * POWERFAIL_WORST_CASE_US / (trip voltage - minimum voltage).
+#define POWERFAIL_BIT_US            (1000000UL / I2C_STANDARD_MODE)
+#define POWERFAIL_ENTRY_US          50
+#define POWERFAIL_PREEMPT_US        (18 * POWERFAIL_BIT_US)
+#define POWERFAIL_FRAME_US          (((1 + POWERFAIL_ADDRESS_BYTES + POWERFAIL_PAGE_BYTES) * 9 + 2) * POWERFAIL_BIT_US)
+#define POWERFAIL_WORST_CASE_US     (POWERFAIL_ENTRY_US + POWERFAIL_PREEMPT_US + POWERFAIL_POLL_US + \
+                                     POWERFAIL_FRAME_US + POWERFAIL_COMMIT_US)
+
+// powerfail_Status() results
+#define POWERFAIL_LOADING           0   // Saved page on its way
+#define POWERFAIL_NONE              1   // Nothing saved, or already restored
+#define POWERFAIL_SAVED             2   // powerfail_Restore() will hand it over
+
+#ifdef POWERFAIL_ENABLE
+
+// Function prototypes
+void    powerfail_Init();                                       // Queue the read of a saved page, arm the comparator
+uint8_t powerfail_Status();                                     // POWERFAIL_*
+uint8_t powerfail_Restore(powerfail_Progress_t* progress);      // Progress and setpoints of the saved page, then discard it
+void    powerfail_Stage(const powerfail_Progress_t* progress);  // Serialize the page the interrupt will write, 0: nothing running
+void    powerfail_Update();                                     // Stage again after a program switch, call from the main loop
+
+#endif // POWERFAIL_ENABLE
+
+#endif // POWER_FAIL_H
@@ -0,0 +1,307 @@
+/*_____________________________{FILE_NAME}_____________________________________________________
+                                      ___           ___           ___
+ Author: Abdelrahman Selim           /\  \         /\  \         /\  \
+                                    /::\  \       /::\  \       /::\  \
+Created on: {DATE}                 /:/\:\  \     /:/\:\  \     /:/\:\  \
+                                  /::\ \:\  \   _\:\ \:\  \   /::\ \:\  \
+ Version: 01                     /:/\:\ \:\__\ /\ \:\ \:\__\ /:/\:\ \:\__\
+                                 \/__\:\/:/  / \:\ \:\ \/__/ \/__\:\/:/  /
+                                      \::/  /   \:\ \:\__\        \::/  /
+                                      /:/  /     \:\/:/  /        /:/  /
+ Brief : Ramp/Soak Profile Store     /:/  /       \::/  /        /:/  /
+                                     \/__/         \/__/         \/__/
+ _________________________________________________________________________________________*/
+#include "profile_store.h"
+
+// Store states, in the order a save passes through them
+#define PROFILE_STATE_OFF           0   // profile_Init() not called
+#define PROFILE_STATE_SCAN          1   // Reading the directory to build the heap map
+#define PROFILE_STATE_IDLE          2
+#define PROFILE_STATE_LOOKUP        3   // Reading the entry the save replaces
+#define PROFILE_STATE_WRITE         4   // Segments wait for the block writer
+#define PROFILE_STATE_WRITING       5   // Segments being written
+#define PROFILE_STATE_ENTRY         6   // New directory entry waits for the block writer
+#define PROFILE_STATE_ENTRY_WRITING 7   // Directory entry being written
+
+#define PROFILE_SCAN_ENTRIES        10  // Directory entries per read while scanning
+#define PROFILE_ENTRY_PENDING       0xFFFE  // Never a valid entry, the heap ends below 0x0FFE
+
+static uint8_t  profile_State;
+static uint8_t  profile_Busy;                       // A read of the current state is on its way
+static uint8_t  profile_HeapMap[(PROFILE_HEAP_BLOCKS + 7) / 8];    // One bit per used heap block
+static uint16_t profile_Scan[PROFILE_SCAN_ENTRIES];
+static uint8_t  profile_ScanIndex;                  // First directory entry of profile_Scan
+static uint16_t profile_OpenEntry;                  // Directory entry of the open profile
+
+// Save in progress
+static uint8_t  profile_SaveIndex;                  // Directory entry being replaced
+static uint16_t profile_OldEntry;
+static uint16_t profile_NewEntry;
+static const uint8_t* profile_SaveData;
+static uint16_t profile_SaveLength;
+static uint8_t  profile_SaveResult;
+
+/**
+ * @brief Address of the directory entry of a program.
+ */
+static uint16_t profile_EntryAddress(uint8_t index) {
+    return PROFILE_DIR_START + ((uint16_t) index * 2);
+}
+
+/**
+ * @brief Marks the heap blocks of a directory entry used or free.
+ */
+static void profile_MarkBlocks(uint16_t entry, uint8_t used) {
+    if (entry == PROFILE_ENTRY_EMPTY) {
+        return;
+    }
+    uint16_t first = (PROFILE_ENTRY_ADDRESS(entry) - PROFILE_HEAP_START) / PROFILE_BLOCK_SIZE;
+    uint16_t blocks = ((uint16_t) PROFILE_ENTRY_COUNT(entry) * PROFILE_SEGMENT_SIZE + PROFILE_BLOCK_SIZE - 1) / PROFILE_BLOCK_SIZE;
+    for (uint16_t b = first; b < first + blocks && b < PROFILE_HEAP_BLOCKS; b++) {
+        if (used) {
+            profile_HeapMap[b / 8] |= (1 << (b % 8));
+        } else {
+            profile_HeapMap[b / 8] &= ~(1 << (b % 8));
+        }
+    }
+}
+
+/**
+ * @brief First fit in the heap map.
+ *
+ * @return uint16_t The heap address, 0 if there is no gap of that many bytes.
+ */
+static uint16_t profile_Allocate(uint16_t length) {
+    uint16_t blocks = (length + PROFILE_BLOCK_SIZE - 1) / PROFILE_BLOCK_SIZE;
+    uint16_t run = 0;
+    for (uint16_t b = 0; b < PROFILE_HEAP_BLOCKS; b++) {
+        if (profile_HeapMap[b / 8] & (1 << (b % 8))) {
+            run = 0;
+        } else if (++run == blocks) {
+            return PROFILE_HEAP_START + (b + 1 - blocks) * PROFILE_BLOCK_SIZE;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Issues a read once and reports when it arrived, like datalog_ReadHeader().
+ */
+static uint8_t profile_Read(uint16_t addr, uint8_t length, void* data) {
+    if (!profile_Busy) {
+        profile_Busy = eeprom_readArray(addr, length, data);
+        return 0;
+    }
+    if (eeprom_readPending()) {
+        return 0;
+    }
+    profile_Busy = 0;
+    return 1;
+}
+
+/**
+ * @brief Starts the store.
+ *
+ * profile_Update() reads the directory once to learn which heap blocks are
+ * used; lookups work right away, saves once profile_Ready() returns 1.
+ */
+void profile_Init() {
+    for (uint8_t i = 0; i < sizeof(profile_HeapMap); i++) {
+        profile_HeapMap[i] = 0;
+    }
+    profile_ScanIndex = 0;
+    profile_Busy = 0;
+    profile_OpenEntry = PROFILE_ENTRY_EMPTY;
+    profile_SaveResult = PROFILE_OK;
+    profile_State = PROFILE_STATE_SCAN;
+}
+
+/**
+ * @brief Returns 1 once the heap map is built and no save is running.
+ */
+uint8_t profile_Ready() {
+    return profile_State == PROFILE_STATE_IDLE;
+}
+
+/**
+ * @brief Looks a profile up in the directory.
+ *
+ * The entry holds both the heap address and the segment count, so this is
+ * the only read needed before the segments can be streamed.
+ *
+ * @return uint8_t Returns 1 if the read was queued, see profile_Status().
+ */
+uint8_t profile_Open(uint8_t group, uint8_t program) {
+    if (group >= PROGRAM_GROUP_COUNT || program >= PROFILE_PROGRAMS) {
+        return 0;
+    }
+    profile_OpenEntry = PROFILE_ENTRY_PENDING;
+    if (!eeprom_read_uint16_t(profile_EntryAddress(group * PROFILE_PROGRAMS + program), &profile_OpenEntry)) {
+        profile_OpenEntry = PROFILE_ENTRY_EMPTY;
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Returns PROFILE_PENDING, PROFILE_OK or PROFILE_EMPTY for the last profile_Open().
+ */
+uint8_t profile_Status() {
+    if (profile_OpenEntry == PROFILE_ENTRY_PENDING) {
+        return PROFILE_PENDING;
+    }
+    return (profile_OpenEntry == PROFILE_ENTRY_EMPTY) ? PROFILE_EMPTY : PROFILE_OK;
+}
+
+/**
+ * @brief Returns the number of segments of the open profile, 0 if none is open.
+ */
+uint8_t profile_SegmentCount() {
+    return (profile_Status() == PROFILE_OK) ? PROFILE_ENTRY_COUNT(profile_OpenEntry) : 0;
+}
+
+/**
+ * @brief Queues the read of one segment of the open profile.
+ *
+ * Meant to be called as the controller reaches the segment, so only the
+ * running segment has to be in RAM. The segment is filled once
+ * profile_Pending() returns 0.
+ *
+ * @return uint8_t Returns 1 if the read was queued.
+ */
+uint8_t profile_LoadSegment(uint8_t index, profile_Segment_t* segment) {
+    if (index >= profile_SegmentCount()) {
+        return 0;
+    }
+    uint16_t addr = PROFILE_ENTRY_ADDRESS(profile_OpenEntry) + (uint16_t) index * PROFILE_SEGMENT_SIZE;
+    return eeprom_readArray(addr, PROFILE_SEGMENT_SIZE, (uint8_t*) segment);
+}
+
+/**
+ * @brief Returns 1 while EEPROM reads, e.g. of a segment, are not delivered yet.
+ */
+uint8_t profile_Pending() {
+    return eeprom_readPending();
+}
+
+/**
+ * @brief Stores a profile for a program, replacing the previous one.
+ *
+ * The segments go to a free part of the heap first and the directory entry
+ * is switched last with a single two-byte write, so a power loss leaves
+ * either the old or the new profile. The old segments are freed after that.
+ *
+ * @param segments Kept by reference until profile_SaveStatus() is not PROFILE_PENDING.
+ * @param count    1 to PROFILE_MAX_SEGMENTS.
+ *
+ * @return uint8_t Returns 1 if the save was started.
+ */
+uint8_t profile_Save(uint8_t group, uint8_t program, const profile_Segment_t* segments, uint8_t count) {
+    if (profile_State != PROFILE_STATE_IDLE || group >= PROGRAM_GROUP_COUNT || program >= PROFILE_PROGRAMS ||
+        count == 0 || count > PROFILE_MAX_SEGMENTS) {
+        return 0;
+    }
+    profile_SaveIndex = group * PROFILE_PROGRAMS + program;
+    profile_SaveData = (const uint8_t*) segments;
+    profile_SaveLength = (uint16_t) count * PROFILE_SEGMENT_SIZE;
+    profile_NewEntry = (uint16_t) count << 12;
+    profile_SaveResult = PROFILE_PENDING;
+    profile_State = PROFILE_STATE_LOOKUP;
+    return 1;
+}
+
+/**
+ * @brief Removes the profile of a program.
+ *
+ * @return uint8_t Returns 1 if the delete was started, see profile_SaveStatus().
+ */
+uint8_t profile_Delete(uint8_t group, uint8_t program) {
+    if (profile_State != PROFILE_STATE_IDLE || group >= PROGRAM_GROUP_COUNT || program >= PROFILE_PROGRAMS) {
+        return 0;
+    }
+    profile_SaveIndex = group * PROFILE_PROGRAMS + program;
+    profile_SaveLength = 0;
+    profile_NewEntry = PROFILE_ENTRY_EMPTY;
+    profile_SaveResult = PROFILE_PENDING;
+    profile_State = PROFILE_STATE_LOOKUP;
+    return 1;
+}
+
+/**
+ * @brief Returns PROFILE_PENDING while a save or delete runs, then its result.
+ */
+uint8_t profile_SaveStatus() {
+    return profile_SaveResult;
+}
+
+/**
+ * @brief Runs the store state machine, call it from the main loop.
+ *
+ * Each call does at most one step and never waits on the bus.
+ */
+void profile_Update() {
+    switch (profile_State) {
+        case PROFILE_STATE_SCAN:
+            if (!profile_Read(profile_EntryAddress(profile_ScanIndex), sizeof(profile_Scan), profile_Scan)) {
+                break;
+            }
+            for (uint8_t i = 0; i < PROFILE_SCAN_ENTRIES; i++) {
+                profile_MarkBlocks(profile_Scan[i], 1);
+            }
+            profile_ScanIndex += PROFILE_SCAN_ENTRIES;
+            if (profile_ScanIndex >= PROFILE_DIR_ENTRIES) {
+                profile_State = PROFILE_STATE_IDLE;
+            }
+            break;
+
+        case PROFILE_STATE_LOOKUP:
+            if (!profile_Read(profile_EntryAddress(profile_SaveIndex), 2, &profile_OldEntry)) {
+                break;
+            }
+            if (profile_SaveLength == 0) {
+                profile_State = PROFILE_STATE_ENTRY;
+                break;
+            }
+            // The old blocks stay used until the new entry is written
+            uint16_t addr = profile_Allocate(profile_SaveLength);
+            if (!addr) {
+                profile_SaveResult = PROFILE_NO_SPACE;
+                profile_State = PROFILE_STATE_IDLE;
+                break;
+            }
+            profile_NewEntry |= addr;
+            profile_MarkBlocks(profile_NewEntry, 1);
+            profile_State = PROFILE_STATE_WRITE;
+            break;
+
+        case PROFILE_STATE_WRITE:
+            // Split at the page boundaries and ACK polled by the block writer
+            if (eeprom_writeBlock(PROFILE_ENTRY_ADDRESS(profile_NewEntry), profile_SaveLength, profile_SaveData)) {
+                profile_State = PROFILE_STATE_WRITING;
+            }
+            break;
+
+        case PROFILE_STATE_WRITING:
+            if (!eeprom_blockBusy()) {
+                profile_State = PROFILE_STATE_ENTRY;
+            }
+            break;
+
+        case PROFILE_STATE_ENTRY:
+            if (eeprom_writeBlock(profile_EntryAddress(profile_SaveIndex), 2, (const uint8_t*) &profile_NewEntry)) {
+                profile_State = PROFILE_STATE_ENTRY_WRITING;
+            }
+            break;
+
+        case PROFILE_STATE_ENTRY_WRITING:
+            if (!eeprom_blockBusy()) {
+                profile_MarkBlocks(profile_OldEntry, 0);
+                profile_SaveResult = PROFILE_OK;
+                profile_State = PROFILE_STATE_IDLE;
+            }
+            break;
+
+        default:
+            break;
+    }
+}
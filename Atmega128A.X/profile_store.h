@@ -0,0 +1,62 @@
+#ifndef PROFILE_STORE_H
+#define PROFILE_STORE_H
+
+#include <stdint.h>
+#include "EEPROM_24C32.h"
+#include "ProgramDataHandler.h"
+#include "data_log.h"
+
+// Ramp/soak firing profiles with a variable number of segments.
+// A directory of one 16-bit entry per (group, program) points into a heap of segments:
+//   entry = (segment count << 12) | address, PROFILE_ENTRY_EMPTY if the program has no profile
+#define PROFILE_PROGRAMS        10                                          // Programs per group
+#define PROFILE_DIR_START       0x0800                                      // Directory, right after the program table
+#define PROFILE_DIR_ENTRIES     (PROGRAM_GROUP_COUNT * PROFILE_PROGRAMS)
+#define PROFILE_HEAP_START      (PROFILE_DIR_START + (PROFILE_DIR_ENTRIES * 2))
+#define PROFILE_HEAP_END        DATALOG_REGION_START                        // Up to the log, which takes the rest of a larger part
+#define PROFILE_BLOCK_SIZE      8                                           // Heap allocation unit
+#define PROFILE_HEAP_BLOCKS     ((PROFILE_HEAP_END - PROFILE_HEAP_START) / PROFILE_BLOCK_SIZE)
+#define PROFILE_MAX_SEGMENTS    15
+#define PROFILE_ENTRY_EMPTY     0xFFFF
+#define PROFILE_ENTRY_ADDRESS(e)    ((e) & 0x0FFF)
+#define PROFILE_ENTRY_COUNT(e)      ((uint8_t)((e) >> 12))
+
+#if (PROFILE_DIR_START < PROGRAM_TABLE_END) || (PROFILE_HEAP_START % PROFILE_BLOCK_SIZE)
+#error "profile directory overlaps the program table or the heap is not block aligned"
+#endif
+#if (PROFILE_HEAP_END > EEPROM_SIZE) || (PROFILE_HEAP_END - 1 > PROFILE_ENTRY_ADDRESS(0xFFFF))
+#error "profile heap must end inside the EEPROM and below the 12-bit address of a directory entry"
+#endif
+
+// One ramp/soak segment, stored as is (7 bytes, little endian). Packed so an
+// array of them has the stride of the heap on any target, not just the AVR
+typedef struct __attribute__((packed)) {
+    uint16_t targetTemp;    // Temperature to reach
+    uint16_t rate;          // Ramp in degrees per hour, 0 = as fast as possible
+    uint16_t holdTime;      // Soak at the target, minutes
+    uint8_t  vaccumPercent; // Vacuum during the segment
+} profile_Segment_t;
+
+#define PROFILE_SEGMENT_SIZE    7
+typedef char profile_segment_size_check[(sizeof(profile_Segment_t) == PROFILE_SEGMENT_SIZE) ? 1 : -1];
+
+// profile_Status() and profile_SaveStatus() results
+#define PROFILE_PENDING         0   // Directory read or save on its way
+#define PROFILE_OK              1   // Open profile found / save done
+#define PROFILE_EMPTY           2   // No profile stored for that program
+#define PROFILE_NO_SPACE        3   // Save failed, heap full
+
+// Function prototypes
+void    profile_Init();                                                     // Build the heap map from the directory
+void    profile_Update();                                                   // Advance loading and saving, call periodically
+uint8_t profile_Ready();                                                    // 1 once the heap map is built
+uint8_t profile_Open(uint8_t group, uint8_t program);                      // One directory read, see profile_Status()
+uint8_t profile_Status();                                                   // PROFILE_* of the last open or save
+uint8_t profile_SegmentCount();                                             // Segments of the open profile
+uint8_t profile_LoadSegment(uint8_t index, profile_Segment_t* segment);     // Queue the read of one segment
+uint8_t profile_Pending();                                                  // 1 while segment reads are on their way
+uint8_t profile_Save(uint8_t group, uint8_t program, const profile_Segment_t* segments, uint8_t count); // segments must stay valid until done
+uint8_t profile_Delete(uint8_t group, uint8_t program);
+uint8_t profile_SaveStatus();                                               // PROFILE_* of the last save or delete
+
+#endif // PROFILE_STORE_H
@@ -1,13 +1,50 @@
 /*ds1307 high level api - Reza Ebrahimi v1.0*/
 /*this is mcu independent code, no need to change the contents of this file. use low level api to adapt the driver to your mcu of choice*/
 #include "rtc_ds1307.h"
+#include "i2c_pt.h"
+#include "uart_trace.h"
 
 static void BCD_to_HEX(uint8_t *data_array, uint8_t array_length);        /*turns the bcd numbers from ds1307 into hex*/
 static void HEX_to_BCD(uint8_t *data_array, uint8_t array_length);        /*turns the hex numbers into bcd, to be written back into ds1307*/
+static void snapshot_pack(uint8_t *slot, uint8_t sequence, uint8_t *time_array);        /*packs 7 hex time bytes into one 5 byte slot*/
+static void snapshot_unpack(uint8_t *slot, uint8_t *time_array);        /*unpacks one 5 byte slot into 7 hex time bytes*/
+static uint8_t snapshot_next_sequence(uint8_t sequence);
+static void seconds_modify(uint8_t keep_mask, uint8_t set_bits);        /*read-modify-write of the SECONDS register*/
+static uint8_t seconds_write();
+static uint8_t seconds_sequence();
+static uint8_t init_sequence();
+static uint8_t init_ram_length();
 
 static uint8_t register_current_value;        /*used to read current values of ds1307 registers*/
 static uint8_t register_new_value;        /*used to write values to ds1307 registers*/
-static uint8_t snap0_vacancy;       /*if snap0_vacancy == OCCUPIED, then a snapshot has been saved on ds1307 RAM and is ready to be read*/
+static uint8_t snap_ring[DS1307_SNAP_RING_SIZE];        /*ram mirror of the snapshot ring, loaded once by DS1307_snapshot_load*/
+static uint8_t snap_time_raw[7];        /*raw bcd time registers captured for the next snapshot*/
+static uint8_t snap_head;       /*slot index of the newest snapshot*/
+static uint8_t snap_count;        /*number of occupied slots*/
+static uint8_t snap_pending;        /*SNAP_PENDING_* reads in flight and writes the queue has not taken yet*/
+
+#define SNAP_PENDING_LOAD                     0X01
+#define SNAP_PENDING_CAPTURE                  0X02
+#define SNAP_PENDING_WRITE                    0X04        /*captured time in snap_time_raw, slot write refused so far*/
+#define SNAP_PENDING_CLEAR                    0X08        /*ring write of the clear refused so far*/
+
+/*the operations that need the result of one transaction before the next are coroutines
+  (i2c_pt.h) resumed by DS1307_update on every arbiter pass*/
+static i2c_Pt_t init_pt;        /*DS1307_init_start*/
+static i2c_Pt_t seconds_pt;       /*seconds_modify*/
+static uint8_t seconds_value;       /*SECONDS register as read*/
+static uint8_t seconds_keep;        /*bits of SECONDS kept by the pending read-modify-write*/
+static uint8_t seconds_set;       /*bits set after masking*/
+static uint8_t seconds_pending;       /*1 from seconds_modify until the write is queued*/
+static uint8_t init_state;        /*DS1307_INIT_* reported by DS1307_init_state*/
+static uint8_t init_result;       /*DS1307_INIT_KEPT or DS1307_INIT_RESET, reported once the ring load is queued*/
+static uint8_t init_regs[DS1307_REGISTER_INIT_STATUS + 1];        /*registers 0x00 to the init status, read once*/
+static uint8_t *init_time;        /*hex time from the caller, converted to bcd in place*/
+static uint8_t init_run_state;
+static uint8_t init_reset_state;
+static uint8_t init_ram_address;        /*next RAM byte to clear*/
+static uint8_t init_ram_default[DS1307_INIT_CHUNK];        /*source of the RAM clear frames*/
+static uint8_t init_byte;       /*CH write when kept, DS1307_INITIALIZED when reset*/
 static uint8_t register_default_value[] = {       /*used in reset function, contains default zero values*/
   DS1307_REGISTER_SECONDS_DEFAULT,
   DS1307_REGISTER_MINUTES_DEFAULT,
@@ -22,24 +59,115 @@ static uint8_t register_default_value[] = {       /*used in reset function, cont
 /*ds1307_init function accepts 3 inputs, data_array[7] is the new time settings,
   run_state commands ds1307 to run or halt (CLOCK_RUN and CLOCK_HALT), and reset_state
   could force reset ds1307 (FORCE_RESET) or checks if ds1307 is reset beforehand
-  (NO_FORCE_RESET)*/
+  (NO_FORCE_RESET). returns OPERATION_DONE if ds1307 was reset and OPERATION_FAILED if
+  it was initialized already or did not answer. runs DS1307_init_start and drives the bus
+  arbiter until it finished, so it blocks for the whole sequence, but for no more than
+  DS1307_INIT_TIMEOUT_MS (counted in arbiter passes of at least DS1307_WAIT_STEP_US):
+  a missing or dead ds1307 is given up and DS1307_init_state reports DS1307_INIT_FAILED*/
 uint8_t DS1307_init(uint8_t *data_array, uint8_t run_state, uint8_t reset_state)
 {
-  if ((DS1307_init_status_report() == DS1307_NOT_INITIALIZED) || (reset_state == FORCE_RESET))
+  DS1307_init_start(data_array, run_state, reset_state);
+  for (uint16_t step = 0; DS1307_init_state() == DS1307_INIT_BUSY; step++)
   {
-    DS1307_run(CLOCK_HALT);
-    DS1307_reset(ALL);       /*everything but the 56 bytes general purpose ram inside ds1307*/
-    DS1307_reset(RAM);        /*fills ds1307 general purpose ram wiith default value*/
-    DS1307_set(TIME, data_array);
-    DS1307_run(run_state);
-    DS1307_init_status_update();        /*now the device is initialized (DS1307_INITIALIZED)*/
-    return OPERATION_DONE;
+    if (step >= (DS1307_INIT_TIMEOUT_MS * 1000UL) / DS1307_WAIT_STEP_US)
+    {
+      DS1307_init_abort();
+      break;
+    }
+    i2c_DeviceUpdate();
+    time_i2c_wait_step();
+  }
+  return (DS1307_init_state() == DS1307_INIT_RESET) ? OPERATION_DONE : OPERATION_FAILED;
+}
+
+/*non blocking version of DS1307_init for the boot sequence. the init status and the clock
+  registers are fetched with one read; the init coroutine (run by the bus arbiter through
+  DS1307_update) decides once they arrived and queues the writes as the bus write buffer
+  takes them, so other devices boot meanwhile. data_array[7] must stay valid until
+  DS1307_init_state stops returning DS1307_INIT_BUSY*/
+void DS1307_init_start(uint8_t *data_array, uint8_t run_state, uint8_t reset_state)
+{
+  time_i2c_init();
+  init_time = data_array;
+  init_run_state = run_state;
+  init_reset_state = reset_state;
+  init_state = DS1307_INIT_BUSY;
+  I2C_PT_INIT(&init_pt);
+}
+
+/*returns DS1307_INIT_IDLE, DS1307_INIT_BUSY, DS1307_INIT_KEPT, DS1307_INIT_RESET or DS1307_INIT_FAILED*/
+uint8_t DS1307_init_state()
+{
+  return init_state;
+}
+
+/*gives a busy init up, e.g. at a boot deadline: the coroutine stops and its status read is
+  dropped. reads other drivers queued stay, they wait on their own results (the data log on
+  its time base). writes already queued run out on the bus. DS1307_init_start starts over*/
+void DS1307_init_abort()
+{
+  if (init_state != DS1307_INIT_BUSY)
+    return;
+  for (uint8_t index = 0; index < i2c_QueueCount(DS1307Device.readQueue); index++)
+  {
+    i2c_Request_t *request = i2c_QueueAt(DS1307Device.readQueue, index);
+    if (request->dataPtr == init_regs)
+      request->length = 0;        /*removed by the arbiter without bus traffic, like i2c_DeviceReadCancel*/
+  }
+  init_state = DS1307_INIT_FAILED;
+}
+
+/*advances DS1307_init_start, called by DS1307_update*/
+void DS1307_init_update()
+{
+  if (init_state == DS1307_INIT_BUSY)
+    init_sequence();
+}
+
+/*the init as a coroutine, every write waits on the bus write buffer and is retried on the next pass*/
+static uint8_t init_sequence()
+{
+  I2C_PT_BEGIN(&init_pt);
+  I2C_PT_READ(&init_pt, &DS1307Device, DS1307_REGISTER_SECONDS, sizeof(init_regs), init_regs);
+  if ((init_regs[DS1307_REGISTER_INIT_STATUS] == DS1307_INITIALIZED) && (init_reset_state != FORCE_RESET))
+  {
+    /*kept, only the CH bit is written and only if it changes*/
+    init_byte = init_regs[DS1307_REGISTER_SECONDS] & (~(1 << DS1307_BIT_SETTING_CH));
+    if (init_run_state != CLOCK_RUN)
+      init_byte |= (1 << DS1307_BIT_SETTING_CH);
+    if (init_byte != init_regs[DS1307_REGISTER_SECONDS])
+      I2C_PT_WRITE(&init_pt, &DS1307Device, DS1307_REGISTER_SECONDS, 1, &init_byte);
+    init_result = DS1307_INIT_KEPT;
   }
   else
   {
-    DS1307_run(run_state);
-    return OPERATION_FAILED;
+    /*seconds with CH, minutes to year, control: one frame in place of halt, reset, set and run*/
+    HEX_to_BCD(init_time, 7);
+    init_regs[DS1307_REGISTER_SECONDS] = init_time[0] | ((init_run_state == CLOCK_RUN) ? 0 : (1 << DS1307_BIT_SETTING_CH));
+    for (uint8_t i = DS1307_REGISTER_MINUTES; i <= DS1307_REGISTER_YEAR; i++)
+      init_regs[i] = init_time[i];
+    init_regs[DS1307_REGISTER_HOURS] &= (~(1 << DS1307_BIT_SETTING_AMPM));
+    init_regs[DS1307_REGISTER_CONTROL] = DS1307_REGISTER_CONTROL_DEFAULT;
+    for (uint8_t i = 0; i < DS1307_INIT_CHUNK; i++)
+      init_ram_default[i] = DS1307_RAM_BLOCK_DEFAULT;
+    I2C_PT_WRITE(&init_pt, &DS1307Device, DS1307_REGISTER_SECONDS, DS1307_REGISTER_CONTROL + 1, init_regs);
+    for (init_ram_address = DS1307_REGISTER_INIT_STATUS + 1; init_ram_address <= DS1307_RAM_END; init_ram_address += init_ram_length())
+      I2C_PT_WRITE(&init_pt, &DS1307Device, init_ram_address, init_ram_length(), init_ram_default);
+    /*marked last, a reset cut short by a power loss is done again on the next boot*/
+    init_byte = DS1307_INITIALIZED;
+    I2C_PT_WRITE(&init_pt, &DS1307Device, DS1307_REGISTER_INIT_STATUS, 1, &init_byte);
+    init_result = DS1307_INIT_RESET;
   }
+  I2C_PT_WAIT_UNTIL(&init_pt, DS1307_snapshot_load());
+  init_state = init_result;
+  I2C_PT_END(&init_pt);
+}
+
+/*bytes of the next RAM clear frame, from init_ram_address to the end of the RAM*/
+static uint8_t init_ram_length()
+{
+  uint8_t length = DS1307_RAM_END + 1 - init_ram_address;
+  return (length > DS1307_INIT_CHUNK) ? DS1307_INIT_CHUNK : length;
 }
 
 /*we use 1 byte of ds1307 ram to preserve the initialization status. this function reads that 1 byte*/
@@ -60,25 +188,22 @@ void DS1307_init_status_update()
 }
 
 /*function to start or halt the operation of DS1307, using CH control bit in SECONDS register
-  also preserves the contents of SECONDS register*/
+  also preserves the contents of SECONDS register. the register is read and written back by
+  the seconds coroutine*/
 uint8_t DS1307_run(uint8_t run_state)
 {
-  /*preserving the contents of SECONDS register and changing CH bit*/
-  time_i2c_read_single(DS1307_I2C_ADDRESS, DS1307_REGISTER_SECONDS, &register_current_value);
   if (run_state == CLOCK_RUN)
   {
     /*CH=0 runs the clock*/
-    register_new_value = register_current_value & (~(1 << DS1307_BIT_SETTING_CH));
+    seconds_modify((uint8_t) ~(1 << DS1307_BIT_SETTING_CH), 0);
   }
   else if (run_state == CLOCK_HALT)
   {
     /*CH=1 halts the clock*/
-    register_new_value = register_current_value | (1 << DS1307_BIT_SETTING_CH);
+    seconds_modify((uint8_t) ~(1 << DS1307_BIT_SETTING_CH), (1 << DS1307_BIT_SETTING_CH));
   }
   else
     return OPERATION_FAILED;
-  /*write the new value back to SECONDS register*/
-  time_i2c_write_single(DS1307_I2C_ADDRESS, DS1307_REGISTER_SECONDS, &register_new_value);
   return OPERATION_DONE;
 }
 
@@ -92,16 +217,55 @@ uint8_t DS1307_run_state(void)
     return DS1307_IS_STOPPED;
 }
 
+/*queues a read-modify-write of the SECONDS register: the value read is masked with keep_mask and
+  set_bits are added. a call made before the write is queued folds into the pending one, so
+  halt, set and run issued back to back cost one read and one write and apply in call order*/
+static void seconds_modify(uint8_t keep_mask, uint8_t set_bits)
+{
+  if (seconds_pending)
+  {
+    seconds_set = (seconds_set & keep_mask) | set_bits;
+    seconds_keep &= keep_mask;
+  }
+  else
+  {
+    seconds_set = set_bits;
+    seconds_keep = keep_mask;
+    seconds_pending = 1;
+  }
+}
+
+/*called by DS1307_update. the read is queued after every write already on the bus, so it sees them*/
+void DS1307_seconds_update()
+{
+  if (seconds_pending)
+    seconds_sequence();
+}
+
+static uint8_t seconds_sequence()
+{
+  I2C_PT_BEGIN(&seconds_pt);
+  I2C_PT_READ(&seconds_pt, &DS1307Device, DS1307_REGISTER_SECONDS, 1, &seconds_value);
+  I2C_PT_WAIT_UNTIL(&seconds_pt, seconds_write());
+  seconds_pending = 0;
+  I2C_PT_END(&seconds_pt);
+}
+
+/*masks are applied on every try, so calls folded in while the bus write buffer was full count too*/
+static uint8_t seconds_write()
+{
+  uint8_t value = (seconds_value & seconds_keep) | seconds_set;
+  return time_i2c_write_single(DS1307_I2C_ADDRESS, DS1307_REGISTER_SECONDS, &value);
+}
+
 /*resets the desired register(s), without affecting run_state*/
 void DS1307_reset(uint8_t option)
 {
   switch (option)
   {
     case SECOND:
-      time_i2c_read_single(DS1307_I2C_ADDRESS, DS1307_REGISTER_SECONDS, &register_current_value);
       HEX_to_BCD(&register_default_value[0], 1);
-      register_new_value = (register_current_value & (1 << DS1307_BIT_SETTING_CH)) | register_default_value[0];
-      time_i2c_write_single(DS1307_I2C_ADDRESS, DS1307_REGISTER_SECONDS, &register_new_value);
+      seconds_modify((1 << DS1307_BIT_SETTING_CH), register_default_value[0]);
       break;
     case MINUTE:
       HEX_to_BCD(&register_default_value[1], 1);
@@ -138,19 +302,15 @@ void DS1307_reset(uint8_t option)
       time_i2c_write_single(DS1307_I2C_ADDRESS, DS1307_REGISTER_CONTROL, &register_new_value);
       break;
     case TIME:
-      time_i2c_read_single(DS1307_I2C_ADDRESS, DS1307_REGISTER_SECONDS, &register_current_value);
       HEX_to_BCD(&register_default_value[0], 1);
-      register_new_value = (register_current_value & (1 << DS1307_BIT_SETTING_CH)) | register_default_value[0];
-      time_i2c_write_single(DS1307_I2C_ADDRESS, DS1307_REGISTER_SECONDS, &register_new_value);
+      seconds_modify((1 << DS1307_BIT_SETTING_CH), register_default_value[0]);
       HEX_to_BCD(&register_default_value[2], 1);
       register_default_value[2] &= (~(1 << DS1307_BIT_SETTING_AMPM));
       time_i2c_write_multi(DS1307_I2C_ADDRESS, DS1307_REGISTER_MINUTES, &register_default_value[1], 6);
       break;
     case ALL:        /*everything is reset but the general purpose ram*/
-      time_i2c_read_single(DS1307_I2C_ADDRESS, DS1307_REGISTER_SECONDS, &register_current_value);
       HEX_to_BCD(&register_default_value[0], 1);
-      register_new_value = (register_current_value & (1 << DS1307_BIT_SETTING_CH)) | register_default_value[0];
-      time_i2c_write_single(DS1307_I2C_ADDRESS, DS1307_REGISTER_SECONDS, &register_new_value);
+      seconds_modify((1 << DS1307_BIT_SETTING_CH), register_default_value[0]);
       HEX_to_BCD(&register_default_value[2], 1);
       register_default_value[2] &= (~(1 << DS1307_BIT_SETTING_AMPM));
       time_i2c_write_multi(DS1307_I2C_ADDRESS, DS1307_REGISTER_MINUTES, &register_default_value[1], 7);
@@ -218,17 +378,9 @@ uint8_t DS1307_read(uint8_t option, uint8_t *data_array)
       BCD_to_HEX(data_array, 7);
       break;
     case SNAPSHOT:
-      /*high level function to load a previously saved snapshot from ds1307 RAM. If there is
-         no saved snapshots, returns nothing. needs an array of 7 bytes as input to function*/
-      time_i2c_read_single(DS1307_I2C_ADDRESS, DS1307_REGISTER_SNAP0_VACANCY, &snap0_vacancy);
-      if (snap0_vacancy == OCCUPIED)
-      {
-        time_i2c_read_multi(DS1307_I2C_ADDRESS, DS1307_SNAP0_ADDRESS, data_array, 7);
-        BCD_to_HEX(data_array, 7);
-        break;
-      }
-      else
-        return OPERATION_FAILED;
+      /*loads the newest saved snapshot. If there is no saved snapshots, returns nothing.
+         needs an array of 7 bytes as input to function*/
+      return DS1307_snapshot_get(0, data_array);
     case ALL:
       time_i2c_read_single(DS1307_I2C_ADDRESS, DS1307_REGISTER_SECONDS, &register_current_value);
       data_array[0] = register_current_value & (~(1 << DS1307_BIT_SETTING_CH));
@@ -248,9 +400,7 @@ uint8_t DS1307_set(uint8_t option, uint8_t *data_array)
   {
     case SECOND:
       HEX_to_BCD(data_array, 1);
-      time_i2c_read_single(DS1307_I2C_ADDRESS, DS1307_REGISTER_SECONDS, &register_current_value);
-      register_new_value = (register_current_value & (1 << DS1307_BIT_SETTING_CH)) | *data_array;
-      time_i2c_write_single(DS1307_I2C_ADDRESS, DS1307_REGISTER_SECONDS, &register_new_value);
+      seconds_modify((1 << DS1307_BIT_SETTING_CH), *data_array);
       break;
     case MINUTE:
       HEX_to_BCD(data_array, 1);
@@ -288,17 +438,13 @@ uint8_t DS1307_set(uint8_t option, uint8_t *data_array)
       break;
     case TIME:
       HEX_to_BCD(data_array, 7);
-      time_i2c_read_single(DS1307_I2C_ADDRESS, DS1307_REGISTER_SECONDS, &register_current_value);
-      register_new_value = (register_current_value & (1 << DS1307_BIT_SETTING_CH)) | data_array[0];
-      time_i2c_write_single(DS1307_I2C_ADDRESS, DS1307_REGISTER_SECONDS, &register_new_value);
+      seconds_modify((1 << DS1307_BIT_SETTING_CH), data_array[0]);
       data_array[2] &= (~(1 << DS1307_BIT_SETTING_AMPM));
       time_i2c_write_multi(DS1307_I2C_ADDRESS, DS1307_REGISTER_MINUTES, &data_array[1], 6);
       break;
     case ALL:
       HEX_to_BCD(data_array, 7);
-      time_i2c_read_single(DS1307_I2C_ADDRESS, DS1307_REGISTER_SECONDS, &register_current_value);
-      register_new_value = (register_current_value & (1 << DS1307_BIT_SETTING_CH)) | data_array[0];
-      time_i2c_write_single(DS1307_I2C_ADDRESS, DS1307_REGISTER_SECONDS, &register_new_value);
+      seconds_modify((1 << DS1307_BIT_SETTING_CH), data_array[0]);
       data_array[2] &= (~(1 << DS1307_BIT_SETTING_AMPM));
       time_i2c_write_multi(DS1307_I2C_ADDRESS, DS1307_REGISTER_MINUTES, &data_array[1], 7);
       break;
@@ -340,22 +486,174 @@ uint8_t DS1307_square_wave(uint8_t input)
 }
 
 
-/*high level function to save a snapshot of all the time and control registers to ds1307 RAM.
-  there is only one slot for time snapshot, and a new save clears the last snapshot.*/
-void DS1307_snapshot_save()
+/*high level function to save a snapshot of the time registers into the next slot of the ring
+  in ds1307 RAM, overwriting the oldest one when the ring is full. the time registers are read
+  through the queue and the slot is written by DS1307_snapshot_update once they arrive. saves
+  issued before that merge into one snapshot. returns OPERATION_FAILED if the read queue is full,
+  call it again then*/
+uint8_t DS1307_snapshot_save()
 {
-  uint8_t data_array_temporary[7];
-  time_i2c_read_multi(DS1307_I2C_ADDRESS, DS1307_REGISTER_SECONDS, data_array_temporary, 7);
-  time_i2c_write_multi(DS1307_I2C_ADDRESS, DS1307_SNAP0_ADDRESS, data_array_temporary, 7);
-  snap0_vacancy = OCCUPIED;
-  time_i2c_write_single(DS1307_I2C_ADDRESS, DS1307_REGISTER_SNAP0_VACANCY, &snap0_vacancy);
+  if (!(snap_pending & (SNAP_PENDING_CAPTURE | SNAP_PENDING_WRITE)))
+  {
+    if (!time_i2c_read_multi(DS1307_I2C_ADDRESS, DS1307_REGISTER_SECONDS, snap_time_raw, 7))
+      return OPERATION_FAILED;
+    snap_pending |= SNAP_PENDING_CAPTURE;
+  }
+  return OPERATION_DONE;
 }
 
-/*high level function to clear the sapshot slot on ds1307 RAM*/
+/*high level function to clear every slot of the snapshot ring on ds1307 RAM. a write the queue
+  refuses is queued again by DS1307_snapshot_update, a capture waits for it*/
 void DS1307_snapshot_clear()
 {
-  snap0_vacancy = NOT_OCCUPIED;
-  time_i2c_write_single(DS1307_I2C_ADDRESS, DS1307_REGISTER_SNAP0_VACANCY, &snap0_vacancy);
+  for (uint8_t index = 0; index < DS1307_SNAP_RING_SIZE; index++)
+    snap_ring[index] = DS1307_SNAP_EMPTY;
+  snap_head = 0;
+  snap_count = 0;
+  snap_pending |= SNAP_PENDING_CLEAR;
+  if (time_i2c_write_multi(DS1307_I2C_ADDRESS, DS1307_SNAP_RING_START, snap_ring, DS1307_SNAP_RING_SIZE))
+    snap_pending &= (~SNAP_PENDING_CLEAR);
+}
+
+/*reads the whole ring into the ram mirror with one burst read. head and count are rebuilt
+  from the sequence numbers by DS1307_snapshot_update once the read is done. returns
+  OPERATION_FAILED if the read queue is full, call it again then*/
+uint8_t DS1307_snapshot_load()
+{
+  if (!time_i2c_read_multi(DS1307_I2C_ADDRESS, DS1307_SNAP_RING_START, snap_ring, DS1307_SNAP_RING_SIZE))
+    return OPERATION_FAILED;
+  snap_pending |= SNAP_PENDING_LOAD;
+  return OPERATION_DONE;
+}
+
+/*number of snapshots saved in the ring, 0 to DS1307_SNAP_SLOTS*/
+uint8_t DS1307_snapshot_count()
+{
+  return snap_count;
+}
+
+/*copies a saved snapshot into data_array[7] in the same order as DS1307_read(TIME).
+  age 0 is the newest snapshot, age 1 the one before it and so on*/
+uint8_t DS1307_snapshot_get(uint8_t age, uint8_t *data_array)
+{
+  if (age >= snap_count)
+    return OPERATION_FAILED;
+  uint8_t slot = (snap_head + DS1307_SNAP_SLOTS - age) % DS1307_SNAP_SLOTS;
+  snapshot_unpack(&snap_ring[slot * DS1307_SNAP_SLOT_SIZE], data_array);
+  return OPERATION_DONE;
+}
+
+/*called from DS1307_update. finishes a pending load or capture once the ds1307 read queue
+  has drained, since the queue completes reads in the order they were requested. the slot of a
+  capture enters the ram mirror only once its write was taken, a refused write (or clear) stays
+  pending and is queued again on the next pass*/
+void DS1307_snapshot_update()
+{
+  if ((snap_pending == 0) || DS1307_read_pending())
+    return;
+  if (snap_pending & SNAP_PENDING_CLEAR)
+  {
+    /*a load read since the clear has refilled the mirror with what the chip still holds*/
+    for (uint8_t index = 0; index < DS1307_SNAP_RING_SIZE; index++)
+      snap_ring[index] = DS1307_SNAP_EMPTY;
+    snap_head = 0;
+    snap_count = 0;
+    snap_pending &= (~SNAP_PENDING_LOAD);
+    if (!time_i2c_write_multi(DS1307_I2C_ADDRESS, DS1307_SNAP_RING_START, snap_ring, DS1307_SNAP_RING_SIZE))
+      return;
+    snap_pending &= (~SNAP_PENDING_CLEAR);
+  }
+  if (snap_pending & SNAP_PENDING_LOAD)
+  {
+    /*the newest slot is the occupied one whose successor does not carry the next sequence*/
+    snap_head = 0;
+    snap_count = 0;
+    for (uint8_t slot = 0; slot < DS1307_SNAP_SLOTS; slot++)
+    {
+      uint8_t sequence = snap_ring[slot * DS1307_SNAP_SLOT_SIZE] >> 4;
+      if (sequence == DS1307_SNAP_EMPTY)
+        continue;
+      snap_count++;
+      uint8_t next_slot = (slot + 1) % DS1307_SNAP_SLOTS;
+      if ((snap_ring[next_slot * DS1307_SNAP_SLOT_SIZE] >> 4) != snapshot_next_sequence(sequence))
+        snap_head = slot;
+    }
+    snap_pending &= (~SNAP_PENDING_LOAD);
+  }
+  if (snap_pending & SNAP_PENDING_CAPTURE)
+  {
+    snap_time_raw[0] &= (~(1 << DS1307_BIT_SETTING_CH));
+    snap_time_raw[2] &= (~(1 << DS1307_BIT_SETTING_AMPM));
+    BCD_to_HEX(snap_time_raw, 7);
+    snap_pending = (snap_pending & (~SNAP_PENDING_CAPTURE)) | SNAP_PENDING_WRITE;
+  }
+  if (snap_pending & SNAP_PENDING_WRITE)
+  {
+    uint8_t packed[DS1307_SNAP_SLOT_SIZE];
+    uint8_t sequence = 1;
+    uint8_t slot = 0;
+    if (snap_count)
+    {
+      sequence = snapshot_next_sequence(snap_ring[snap_head * DS1307_SNAP_SLOT_SIZE] >> 4);
+      slot = (snap_head + 1) % DS1307_SNAP_SLOTS;
+    }
+    snapshot_pack(packed, sequence, snap_time_raw);
+    if (!time_i2c_write_multi(DS1307_I2C_ADDRESS, DS1307_SNAP_RING_START + (slot * DS1307_SNAP_SLOT_SIZE),
+                              packed, DS1307_SNAP_SLOT_SIZE))
+      return;
+    for (uint8_t index = 0; index < DS1307_SNAP_SLOT_SIZE; index++)
+      snap_ring[(slot * DS1307_SNAP_SLOT_SIZE) + index] = packed[index];
+    snap_head = slot;
+    TRACE(trace_Event(TRACE_EVT_RTC_SNAPSHOT, (uint8_t[]){slot, sequence}, 2));
+    if (snap_count < DS1307_SNAP_SLOTS)
+      snap_count++;
+    snap_pending &= (~SNAP_PENDING_WRITE);
+  }
+}
+
+/*turns the 7 timekeeper registers, as read from the chip, into seconds since 2000-01-01 00:00:00.
+  the registers are converted to hex in place. assumes 24 hour mode, like the rest of the driver*/
+uint32_t DS1307_raw_to_seconds(uint8_t *data_array)
+{
+  static const uint16_t days_before_month[12] = {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334};
+  uint16_t days;
+  data_array[0] &= (~(1 << DS1307_BIT_SETTING_CH));
+  data_array[2] &= (~(1 << DS1307_BIT_SETTING_AMPM));
+  BCD_to_HEX(data_array, 7);
+  if ((data_array[5] < 1) || (data_array[5] > 12) || (data_array[4] < 1))
+    return 0;
+  days = (data_array[6] * 365U) + ((data_array[6] + 3) / 4) + days_before_month[data_array[5] - 1] + (data_array[4] - 1);
+  if ((data_array[5] > 2) && ((data_array[6] & 0X03) == 0))
+    days++;
+  return (((((uint32_t)days * 24) + data_array[2]) * 60 + data_array[1]) * 60) + data_array[0];
+}
+
+/*slot layout, msb first, 40 bits:
+  sequence(4) day_of_week(3) year(7) month(4) date(5) hour(5) minute(6) second(6)*/
+static void snapshot_pack(uint8_t *slot, uint8_t sequence, uint8_t *time_array)
+{
+  slot[0] = (sequence << 4) | ((time_array[3] & 0X07) << 1) | (time_array[6] >> 6);
+  slot[1] = ((time_array[6] & 0X3F) << 2) | (time_array[5] >> 2);
+  slot[2] = ((time_array[5] & 0X03) << 6) | ((time_array[4] & 0X1F) << 1) | (time_array[2] >> 4);
+  slot[3] = ((time_array[2] & 0X0F) << 4) | (time_array[1] >> 2);
+  slot[4] = ((time_array[1] & 0X03) << 6) | (time_array[0] & 0X3F);
+}
+
+static void snapshot_unpack(uint8_t *slot, uint8_t *time_array)
+{
+  time_array[0] = slot[4] & 0X3F;
+  time_array[1] = ((slot[3] & 0X0F) << 2) | (slot[4] >> 6);
+  time_array[2] = ((slot[2] & 0X01) << 4) | (slot[3] >> 4);
+  time_array[3] = (slot[0] >> 1) & 0X07;
+  time_array[4] = (slot[2] >> 1) & 0X1F;
+  time_array[5] = ((slot[1] & 0X03) << 2) | (slot[2] >> 6);
+  time_array[6] = ((slot[0] & 0X01) << 6) | (slot[1] >> 2);
+}
+
+/*sequence numbers run 1 to DS1307_SNAP_SEQUENCE_MAX, 0 marks an empty slot*/
+static uint8_t snapshot_next_sequence(uint8_t sequence)
+{
+  return (sequence >= DS1307_SNAP_SEQUENCE_MAX) ? 1 : (sequence + 1);
 }
 
 /*internal function related to this file and not accessible from outside*/
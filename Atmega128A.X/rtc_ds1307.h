@@ -2,6 +2,7 @@
 #include <avr/io.h>
 #ifndef RTC_DS1307_H
 #define RTC_DS1307_H
+#include "i2c_device.h"
 
 enum options {SECOND, MINUTE, HOUR, DAY_OF_WEEK, DATE, MONTH, YEAR, CONTROL, RAM, TIME, SNAPSHOT, ALL};
 enum square_wave {WAVE_OFF, WAVE_1, WAVE_2, WAVE_3, WAVE_4};
@@ -16,7 +17,8 @@ enum ds1307_registers {
   DS1307_REGISTER_CONTROL};
   
 #define DS1307_I2C_ADDRESS                    0X68
-#define DS1307_READ_QUEUE_SIZE                10
+#define DS1307_READ_QUEUE_SIZE                8         /*must be a power of two, 5 bytes a slot. i2c_DeviceQueueHighWater
+                                                          peaked at 5 with DS1307_read(TIME) and (ALL) and a snapshot queued at once*/
 #define CLOCK_RUN                             0X01
 #define CLOCK_HALT                            0X00
 #define FORCE_RESET                           0X00
@@ -31,7 +33,6 @@ enum ds1307_registers {
 #define NOT_OCCUPIED                          0X00
 
 #define DS1307_REGISTER_INIT_STATUS           0X08
-#define DS1307_REGISTER_SNAP0_VACANCY         0X09
 #define DS1307_RAM_START                      0X08
 #define DS1307_RAM_END                        0X3F
 #define DS1307_BIT_SETTING_CH                 0X07
@@ -51,7 +52,35 @@ enum ds1307_registers {
 #define DS1307_REGISTER_YEAR_DEFAULT          0X00
 #define DS1307_REGISTER_CONTROL_DEFAULT       0X00
 #define DS1307_RAM_BLOCK_DEFAULT              0x00
-#define DS1307_SNAP0_ADDRESS                  0X39
+
+/*snapshot ring inside ds1307 RAM. every slot is 5 packed bytes (see rtc_ds1307.c) holding a
+  4 bit sequence number, so the newest slot is found from the slots themselves and a save is
+  one burst write. 0x31 to 0x3F stay free for other users of the RAM*/
+#define DS1307_SNAP_RING_START                0X09
+#define DS1307_SNAP_SLOTS                     8
+#define DS1307_SNAP_SLOT_SIZE                 5
+#define DS1307_SNAP_RING_SIZE                 (DS1307_SNAP_SLOTS * DS1307_SNAP_SLOT_SIZE)
+#define DS1307_SNAP_SEQUENCE_MAX              0X0F
+#define DS1307_SNAP_EMPTY                     0X00
+
+#if (DS1307_SNAP_RING_START + DS1307_SNAP_RING_SIZE - 1) > DS1307_RAM_END
+#error "snapshot ring does not fit inside ds1307 RAM"
+#endif
+#if DS1307_SNAP_SLOTS >= DS1307_SNAP_SEQUENCE_MAX
+#error "snapshot sequence numbers must outnumber the slots"
+#endif
+
+/*DS1307_init_state() results*/
+#define DS1307_INIT_IDLE                      0X00        /*DS1307_init_start not called yet*/
+#define DS1307_INIT_BUSY                      0X01        /*status read or register writes on their way*/
+#define DS1307_INIT_KEPT                      0X02        /*was initialized, time kept*/
+#define DS1307_INIT_RESET                     0X03        /*registers and RAM were reset*/
+#define DS1307_INIT_FAILED                    0X04        /*no answer in time, given up by DS1307_init_abort*/
+#define DS1307_INIT_CHUNK                     8           /*RAM bytes per write frame of the reset*/
+#ifndef DS1307_INIT_TIMEOUT_MS
+#define DS1307_INIT_TIMEOUT_MS                250         /*DS1307_init gives up after this long without an answer*/
+#endif
+#define DS1307_WAIT_STEP_US                   100         /*pause per arbiter pass of the blocking calls*/
 
 uint8_t DS1307_run(uint8_t run_state);
 uint8_t DS1307_run_state(void);
@@ -59,16 +88,31 @@ uint8_t DS1307_read(uint8_t registers, uint8_t *data_array);
 void DS1307_reset(uint8_t input);
 uint8_t DS1307_set(uint8_t registers, uint8_t *data_array);
 uint8_t DS1307_init(uint8_t *data_array, uint8_t run_state, uint8_t reset_state);
+void DS1307_init_start(uint8_t *data_array, uint8_t run_state, uint8_t reset_state);
+uint8_t DS1307_init_state();
+void DS1307_init_abort();
+void DS1307_init_update();
+void DS1307_seconds_update();
 uint8_t DS1307_init_status_report();
 void DS1307_init_status_update();
 uint8_t DS1307_square_wave(uint8_t input);
-void DS1307_snapshot_save();
+uint8_t DS1307_snapshot_save();
 void DS1307_snapshot_clear();
+uint8_t DS1307_snapshot_load();
+uint8_t DS1307_snapshot_count();
+uint8_t DS1307_snapshot_get(uint8_t age, uint8_t *data_array);
+void DS1307_snapshot_update();
+uint32_t DS1307_raw_to_seconds(uint8_t *data_array);
 
+extern i2c_Device_t DS1307Device;        /*bus descriptor, the coroutines of the high level api wait on its reads*/
 void DS1307_update();
-void time_i2c_write_single(uint8_t device_address, uint8_t register_address, uint8_t *data_byte);
-void time_i2c_write_multi(uint8_t device_address, uint8_t start_register_address, uint8_t *data_array, uint8_t data_length);
-void time_i2c_read_single(uint8_t device_address, uint8_t register_address, uint8_t *data_byte);
-void time_i2c_read_multi(uint8_t device_address, uint8_t start_register_address, uint8_t *data_array, uint8_t data_length);
+uint8_t DS1307_read_pending();
+void time_i2c_init();
+uint8_t time_i2c_write_single(uint8_t device_address, uint8_t register_address, uint8_t *data_byte);
+uint8_t time_i2c_write_multi(uint8_t device_address, uint8_t start_register_address, uint8_t *data_array, uint8_t data_length);
+uint8_t time_i2c_write_now(uint8_t start_register_address, const uint8_t *data_array, uint8_t data_length);
+uint8_t time_i2c_read_single(uint8_t device_address, uint8_t register_address, uint8_t *data_byte);
+uint8_t time_i2c_read_multi(uint8_t device_address, uint8_t start_register_address, uint8_t *data_array, uint8_t data_length);
+void time_i2c_wait_step();
 
 #endif
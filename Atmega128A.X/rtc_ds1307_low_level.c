@@ -1,99 +1,81 @@
 #include "rtc_ds1307.h"
 #include"i2c_driver.h"
+#include "i2c_device.h"
+#include "i2c_soft.h"
+#include <util/delay.h>
 
-// Local Variables
-static uint8_t DS1307ReadWaitingFlag;
-static uint8_t DS1307DataReadyFlag;
+// With the software master the RTC gets a bus of its own and never waits behind EEPROM page writes
+#ifndef DS1307_I2C_BUS
+#ifdef I2C_SOFT_ENABLE
+#define DS1307_I2C_BUS  (&i2c_SoftBus)
+#else
+#define DS1307_I2C_BUS  0
+#endif
+#endif
 
-static uint8_t  CurrentReadReg;
-static uint8_t  CurrentLength;
-static void*    CurrentDataPtr;
+// FIFO of pending read requests
+I2C_REQUEST_QUEUE_DEFINE(DS1307ReadQueue, DS1307_READ_QUEUE_SIZE);
 
-// Arrays to hold the read request details
-static uint16_t DS1307ReadRegisterQueue[DS1307_READ_QUEUE_SIZE];     // Array to hold DS1307 addresses
-static void*    DS1307ReadDataPtrQueue[DS1307_READ_QUEUE_SIZE];     // Array to hold pointers to data buffers
-static uint8_t  DS1307ReadLengthQueue [DS1307_READ_QUEUE_SIZE];      // Array to hold the lengths of data to be read
+// Bus descriptor, the DS1307 takes a 1-byte register address and runs at 100 kHz only
+i2c_Device_t DS1307Device = { DS1307_I2C_ADDRESS, I2C_STANDARD_MODE, 1, &DS1307ReadQueue, DS1307_update, 0, DS1307_I2C_BUS };
 
-// Pointers to the head and tail of the FIFO queue
-static uint8_t queueHead = 0;
-static uint8_t queueTail = 0;
-static uint8_t DS1307ReadQueueSize;
-static uint8_t DS1307QueueADD(uint16_t adr , uint8_t length,void* DataPtr){
-    if (DS1307ReadQueueSize<DS1307_READ_QUEUE_SIZE){
-        DS1307ReadRegisterQueue[queueHead]  =adr;
-        DS1307ReadDataPtrQueue[queueHead]  =DataPtr;
-        DS1307ReadLengthQueue [queueHead]  =length;
-        queueHead=(queueHead+1)%DS1307_READ_QUEUE_SIZE;
-        DS1307ReadQueueSize++;
-        return 1;
-    } else{
-    return 0;
-    }
+/*function to register DS1307 with the i2c bus arbiter, reads are served by i2c_DeviceUpdate*/
+void time_i2c_init()
+{
+    i2c_DeviceRegister(&DS1307Device);
 }
-static uint8_t DS1307QueueGet(){
-    if(DS1307ReadQueueSize>0){
-        CurrentReadReg  = DS1307ReadRegisterQueue[queueTail];
-        CurrentDataPtr  = DS1307ReadDataPtrQueue [queueTail];
-        CurrentLength   = DS1307ReadLengthQueue  [queueTail];
-        return 1;
-    } else {
-            return 0;
-        }
+
+/*function to transmit one byte of data to register_address on DS1307, returns 0 if the bus write buffer is full*/
+uint8_t time_i2c_write_single(uint8_t device_address, uint8_t register_address, uint8_t *data_byte)
+{
+   return i2c_DeviceWriteRegister(&DS1307Device, register_address, 1, data_byte);
 }
-/*function to transmit one byte of data to register_address on DS1307*/
-void time_i2c_write_single(uint8_t device_address, uint8_t register_address, uint8_t *data_byte)
+
+/*function to transmit an array of data to device_address, starting from start_register_address,
+  returns 0 if the bus write buffer is full*/
+uint8_t time_i2c_write_multi(uint8_t device_address, uint8_t start_register_address, uint8_t *data_array, uint8_t data_length)
 {
-   i2c_SendArray(device_address, 2, (uint8_t[]) {register_address , *data_byte});   
+    return i2c_DeviceWriteRegister(&DS1307Device, start_register_address, data_length, data_array);
 }
 
-/*function to transmit an array of data to device_address, starting from start_register_address*/
-void time_i2c_write_multi(uint8_t device_address, uint8_t start_register_address, uint8_t *data_array, uint8_t data_length)
+/*polled write for the power-fail save, after i2c_Preempt with interrupts off. the ds1307 has no
+  write cycle, it only refuses access below its power-fail voltage. returns 0 if it is not on the twi
+  or did not take the write*/
+uint8_t time_i2c_write_now(uint8_t start_register_address, const uint8_t *data_array, uint8_t data_length)
 {
-    uint8_t DataArr[data_length + 1];
-    DataArr[0] = start_register_address;
-    for(uint8_t i = 0 ; i < data_length ; i ++){
-        DataArr[i+1] = data_array[i];
-    }
-    i2c_SendArray(device_address, (data_length+1) ,DataArr);
+    if (DS1307Device.bus && DS1307Device.bus != &i2c_TwiBus)
+        return 0;
+    return i2c_PolledWrite(DS1307_I2C_ADDRESS, 1, &start_register_address, data_length, data_array, 1);
 }
 
-/*function to read one byte of data from register_address on DS1307*/
-void time_i2c_read_single(uint8_t device_address, uint8_t register_address, uint8_t *data_byte)
+/*function to read one byte of data from register_address on DS1307, returns 0 if the read queue is full*/
+uint8_t time_i2c_read_single(uint8_t device_address, uint8_t register_address, uint8_t *data_byte)
 {
-DS1307QueueADD(register_address ,1,data_byte);
+return i2c_DeviceRead(&DS1307Device, register_address, 1, data_byte);
 }
 
-/*function to read an array of data from device_address*/
-void time_i2c_read_multi(uint8_t device_address, uint8_t start_register_address, uint8_t *data_array, uint8_t data_length)
+/*function to read an array of data from device_address, returns 0 if the read queue is full*/
+uint8_t time_i2c_read_multi(uint8_t device_address, uint8_t start_register_address, uint8_t *data_array, uint8_t data_length)
 {
-    DS1307QueueADD(start_register_address ,data_length,data_array);
+    return i2c_DeviceRead(&DS1307Device, start_register_address, data_length, data_array);
 }
 
-/*function to initialize I2C peripheral in 100khz*/
+/*service hook called by the i2c bus arbiter on every pass*/
 void DS1307_update()
 {
-        // Check if data in the I2C read buffer is ready to be processed
-    if(DS1307ReadWaitingFlag){
-        if (i2cReadDataReadyFlag ) {
-            // Data is ready, set the flag (you can define a flag variable in your program)
-            DS1307DataReadyFlag = 1;
-            DS1307ReadWaitingFlag = 0;
-            i2c_ReadFromRxBuffer(CurrentDataPtr, CurrentLength);
-            DS1307DataReadyFlag = 0;
-        }
-    } else{
-        // make sure there is enough size for the request in the write buffer , also if the i2c has another read request then wait 
-        // and for the first condition is that , make sure that there is a request for data
-        if(DS1307ReadQueueSize>0 && i2cReadBusyFlag == 0 &&((i2c_WriteBufferCurrentSize + 6) < I2C_WRITE_BUFFER_SIZE) ){  
+    DS1307_init_update();
+    DS1307_seconds_update();
+    DS1307_snapshot_update();
+}
 
-        DS1307QueueGet();
-        i2c_SendArray(DS1307_I2C_ADDRESS, 1, &CurrentReadReg);
-        if(i2c_GetData(DS1307_I2C_ADDRESS, CurrentLength)){
-            queueTail=(queueTail+1)%DS1307_READ_QUEUE_SIZE;
-            DS1307ReadQueueSize--;
-            DS1307ReadWaitingFlag = 1;
-        } 
-        }
-    }
-    
+/*returns 1 while any queued ds1307 read has not been delivered to its destination yet*/
+uint8_t DS1307_read_pending()
+{
+    return i2c_DeviceReadPending(&DS1307Device);
+}
+
+/*pause between two arbiter passes of the blocking calls, DS1307_WAIT_STEP_US*/
+void time_i2c_wait_step()
+{
+    _delay_us(DS1307_WAIT_STEP_US);
 }
@@ -0,0 +1,63 @@
+/*_____________________________{FILE_NAME}_____________________________________________________
+                                      ___           ___           ___
+ Author: Abdelrahman Selim           /\  \         /\  \         /\  \
+                                    /::\  \       /::\  \       /::\  \
+Created on: {DATE}                 /:/\:\  \     /:/\:\  \     /:/\:\  \
+                                  /::\ \:\  \   _\:\ \:\  \   /::\ \:\  \
+ Version: 01                     /:/\:\ \:\__\ /\ \:\ \:\__\ /:/\:\ \:\__\
+                                 \/__\:\/:/  / \:\ \:\ \/__/ \/__\:\/:/  /
+                                      \::/  /   \:\ \:\__\        \::/  /
+                                      /:/  /     \:\/:/  /        /:/  /
+ Brief : Stack Monitor               /:/  /       \::/  /        /:/  /
+                                     \/__/         \/__/         \/__/
+ _________________________________________________________________________________________*/
+#include "stack_monitor.h"
+
+#ifdef STACK_MONITOR_ENABLE
+
+// Linker symbols: first byte after .bss / .noinit, and the initial stack pointer (RAMEND)
+extern uint8_t _end;
+extern uint8_t __stack;
+
+/**
+ * @brief Paints the free RAM before main() runs.
+ *
+ * Placed in .init3, after the stack pointer is set up (.init2) and before
+ * .data and .bss are initialized. Naked and without calls, so it uses no
+ * stack itself; the bytes at the top are overwritten again as soon as the
+ * stack grows into them.
+ */
+void stack_Paint(void) __attribute__((naked, used, section(".init3")));
+void stack_Paint(void) {
+    uint8_t* p = &_end;
+
+    while (p <= &__stack) {
+        *p++ = STACK_PAINT;
+    }
+}
+
+/**
+ * @brief Returns the bytes above .bss the stack never reached.
+ *
+ * Counts the paint from the bottom up; the stack grows down towards .bss,
+ * so the first byte that changed marks the deepest point so far. Takes about
+ * 6 cycles per free byte, call it from the main loop.
+ */
+uint16_t stack_Unused() {
+    const uint8_t* p = &_end;
+
+    while (p <= &__stack && *p == STACK_PAINT) {
+        p++;
+    }
+    return (uint16_t)(p - &_end);
+}
+
+/**
+ * @brief Returns the size of the stack area and its high-water mark.
+ */
+void stack_UsageGet(stack_Usage_t* usage) {
+    usage->size = (uint16_t)(&__stack - &_end + 1);
+    usage->used = usage->size - stack_Unused();
+}
+
+#endif // STACK_MONITOR_ENABLE
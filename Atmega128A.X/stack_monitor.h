@@ -0,0 +1,41 @@
+#ifndef STACK_MONITOR_H
+#define STACK_MONITOR_H
+
+#include <avr/io.h>
+
+// Stack high-water monitor, uncomment or pass -DSTACK_MONITOR_ENABLE to the compiler.
+// The RAM between the end of .bss and the top of the stack is painted with
+// STACK_PAINT before main(); bytes the stack ever used no longer hold it.
+// There is no heap (no malloc), so that whole area belongs to the stack.
+//
+// Local arrays on the bus and EEPROM paths are the 2-byte register headers.
+// With TRACE_ENABLE the event payloads add to that: compound literals of up to
+// 4 bytes there (1 byte in the TWI interrupt), and trace_Counters() and
+// trace_BusTrace() build payloads of up to TRACE_MAX_PAYLOAD bytes each, from
+// the main loop only.
+//
+// The deepest chain from the host call graph (test/host/stack_depth.py, all
+// options on) is a program save: main > EEPROM_prefetchUpdate >
+// program_SaveUpdate > eeprom_writeBlock > eeprom_blockWritePiece >
+// eeprom_Write > i2c_DeviceWriteRegister > a bus function, plus TWI_vect on
+// top (the interrupts do not nest): 328 bytes with host frames. The figure
+// for the AVR and a reading of the monitor under load are still open, take
+// them from an avr-gcc -fstack-usage build and the STACK trace frame.
+//#define STACK_MONITOR_ENABLE
+
+#define STACK_PAINT     0xC5
+
+#ifdef STACK_MONITOR_ENABLE
+
+typedef struct {
+    uint16_t size;              // Bytes between the end of .bss and RAMEND
+    uint16_t used;              // Most bytes the stack ever took
+} stack_Usage_t;
+
+// Function prototypes
+uint16_t stack_Unused();                        // Painted bytes never touched, the margin left
+void     stack_UsageGet(stack_Usage_t* usage);  // Size and high-water mark
+
+#endif // STACK_MONITOR_ENABLE
+
+#endif // STACK_MONITOR_H
@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+"""Decoder for the sample log in the 24C32 (data_log.c), writes CSV.
+
+Reads a binary dump of the whole EEPROM (e.g. from a programmer) and prints
+the logged samples oldest first. The log takes the EEPROM from 0x0C00 to its
+end (32 pages on a 24C32), so the dump must not be truncated.
+
+    datalog_decode.py eeprom.bin                 time, value
+    datalog_decode.py eeprom.bin -o firing.csv
+
+Layout, see data_log.h: pages of 32 bytes from 0x0C00, each starting with the
+mark 0x4D, a sequence number, the time of the first sample in ticks since
+2000-01-01, the sample period, the first value and the sample count,
+followed by the delta_codec tokens of the further samples.
+"""
+import argparse
+import csv
+import datetime
+import struct
+import sys
+
+from delta_codec import decode
+
+REGION_START = 0x0C00
+PAGE_SIZE = 32
+TICKS_PER_SECOND = 4
+PAGE_MARK = 0x4D
+HEADER = struct.Struct('<BBIBhB')
+EPOCH = datetime.datetime(2000, 1, 1)
+
+
+def pages_oldest_first(image):
+    # Same count as DATALOG_PAGES for the EEPROM the dump was taken from
+    count = (len(image) - REGION_START) // PAGE_SIZE
+    count -= count % 256 == 0
+    pages = [image[REGION_START + i * PAGE_SIZE:REGION_START + (i + 1) * PAGE_SIZE] for i in range(count)]
+    if pages[0][0] != PAGE_MARK:
+        return []
+    # Same test as datalog_PageIsCurrent(), the head is the first page that fails it
+    first = pages[0][1]
+    head = next((p for p in range(1, count)
+                 if pages[p][0] != PAGE_MARK or pages[p][1] != (first + p) & 0xFF), count) % count
+    order = list(range(head, count)) + list(range(head))
+    return [pages[p] for p in order if pages[p][0] == PAGE_MARK]
+
+
+def samples(page):
+    _, _, time, period, value, count = HEADER.unpack_from(page)
+    yield time, value
+    for value in decode(page[HEADER.size:], value, count):
+        time += period
+        yield time, value
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('dump', help='binary image of the EEPROM')
+    parser.add_argument('-o', '--output', default='-', help='CSV file, default stdout')
+    args = parser.parse_args()
+
+    with open(args.dump, 'rb') as f:
+        image = f.read()
+    if len(image) < REGION_START + 2 * PAGE_SIZE:
+        sys.exit('%s: dump too short (%d bytes)' % (args.dump, len(image)))
+
+    out = sys.stdout if args.output == '-' else open(args.output, 'w', newline='')
+    writer = csv.writer(out)
+    writer.writerow(['time', 'value'])
+    for page in pages_oldest_first(image):
+        for ticks, value in samples(page):
+            stamp = EPOCH + datetime.timedelta(seconds=ticks / TICKS_PER_SECOND)
+            writer.writerow([stamp.isoformat(timespec='milliseconds'), value])
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,145 @@
+#!/usr/bin/env python3
+"""Reference implementation and benchmark of the delta codec (delta_codec.c).
+
+Tokens are unsigned LEB128 varints: (zigzag(delta) << 1) for a new value,
+(run << 1) | 1 for run repeats of the last value (run 1..255).
+
+    delta_codec.py                       benchmark on a synthetic firing
+    delta_codec.py firing.csv ...        benchmark on recorded profiles
+
+A recorded profile is a CSV with the value in the last column, e.g. the
+output of datalog_decode.py. The benchmark reports the compression against
+raw 16-bit storage, and the samples per 32-byte log page for the old 034 page
+layout (two bytes per sample) and the codec page layout. Cycles per sample
+on the target come from codec_Benchmark() (CODEC_BENCH_ENABLE), which the
+trace channel reports as a CODEC_BENCH event.
+"""
+import argparse
+import csv
+import sys
+
+PAGE_SIZE = 32
+PAGE_HEADER = 10        # DATALOG_HEADER_SIZE
+OLD_PAGE_SAMPLES = 12   # 034 layout, (dt, dv) byte pairs
+
+
+def varint(token):
+    out = bytearray()
+    while token >= 0x80:
+        out.append((token & 0x7F) | 0x80)
+        token >>= 7
+    out.append(token)
+    return bytes(out)
+
+
+def zigzag(delta):
+    return (delta << 1) ^ (delta >> 31) if delta < 0 else delta << 1
+
+
+def encode(values, size=None):
+    """Encodes values[1:] against values[0], same decisions as codec_EncodePut.
+
+    Returns (encoded bytes, number of values consumed including the first).
+    """
+    out, run, last = bytearray(), 0, values[0]
+    limit = size if size is not None else 1 << 30
+    used = 1
+    for v in values[1:]:
+        if v == last:
+            if run == 0xFF:
+                out += varint((run << 1) | 1)
+                run = 0
+            if len(out) + len(varint(((run + 1) << 1) | 1)) > limit:
+                break
+            run += 1
+        else:
+            token = zigzag(v - last) << 1
+            pending = varint((run << 1) | 1) if run else b''
+            if len(out) + len(pending) + len(varint(token)) > limit:
+                break
+            out += pending + varint(token)
+            run, last = 0, v
+        used += 1
+    if run:
+        out += varint((run << 1) | 1)
+    return bytes(out), used
+
+
+def decode(data, first, count=None):
+    """Yields the values after first; stops after count - 1 values if given."""
+    last, pos, produced = first, 0, 0
+    limit = None if count is None else count - 1
+    while pos < len(data) and (limit is None or produced < limit):
+        token, shift = 0, 0
+        while True:
+            byte = data[pos]
+            pos += 1
+            token |= (byte & 0x7F) << shift
+            shift += 7
+            if not byte & 0x80:
+                break
+        if token & 1:
+            for _ in range(token >> 1):
+                if limit is not None and produced >= limit:
+                    return
+                produced += 1
+                yield last
+        else:
+            z = token >> 1
+            last = (last + ((z >> 1) ^ -(z & 1)) + 0x8000) % 0x10000 - 0x8000
+            produced += 1
+            yield last
+
+
+def synthetic():
+    """Same profile as codec_BenchSample()."""
+    for i in range(1024):
+        if i < 300:
+            yield 25 + i * 3 + ((i & 7) == 0)
+        elif i < 600:
+            yield 925 + ((i & 15) == 0)
+        else:
+            yield 925 - (i - 600) * 2
+
+
+def pages_needed(values):
+    pages, i = 0, 0
+    while i < len(values):
+        _, used = encode(values[i:], PAGE_SIZE - PAGE_HEADER)
+        used = min(used, 0xFF)
+        i += used
+        pages += 1
+    return pages
+
+
+def bench(name, values):
+    data, _ = encode(values)
+    assert [values[0]] + list(decode(data, values[0])) == values, 'round trip failed'
+    raw = 2 * len(values)
+    pages = pages_needed(values)
+    old_pages = -(-len(values) // OLD_PAGE_SAMPLES)
+    print('%-24s %6d samples  %6d -> %5d bytes  ratio %5.2f  pages %3d (was %3d, %.1fx history)'
+          % (name, len(values), raw, len(data) + 2, raw / (len(data) + 2.0), pages, old_pages,
+             old_pages / float(pages)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('profiles', nargs='*', help='CSV files, value in the last column')
+    args = parser.parse_args()
+
+    if not args.profiles:
+        bench('synthetic firing', list(synthetic()))
+    for path in args.profiles:
+        with open(path, newline='') as f:
+            rows = [r for r in csv.reader(f) if r]
+        values = [int(float(r[-1])) for r in rows if r[-1].lstrip('-').replace('.', '', 1).isdigit()]
+        if len(values) < 2:
+            print('%s: not enough samples' % path)
+            continue
+        bench(path, values)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,178 @@
+#!/usr/bin/env python3
+"""Flash/SRAM footprint report and regression gate.
+
+Reads the linker map of every built configuration of the project
+(dist/<conf>/production, rebuilt by make footprint), prints a per-symbol size
+table and compares it against a checked-in baseline. The code analyzer
+outputs under .ca/ are not built by make and are left out.
+
+    footprint.py                 report and compare against footprint_baseline.txt
+    footprint.py --update        rewrite the baseline from the current maps
+
+Exits with 1 when the text, data or bss total of a configuration grows, or
+when the estimated stack headroom shrinks below --min-stack bytes. Without a
+baseline (none is checked in until one is recorded from a real build) only
+the report and the stack headroom check run.
+"""
+import argparse
+import glob
+import os
+import re
+import sys
+
+MAP_NAME = 'Atmega128A.X.production.map'
+RAM_START = 0x100            # ATmega128A internal SRAM
+RAM_SIZE = 0x1000            # 4 KB
+VECTOR_NAMES = {'__vector_33': 'ISR(TWI_vect)', '__vector_19': 'ISR(USART0_UDRE_vect)',
+                '__vector_23': 'ISR(ANALOG_COMP_vect)', '__vector_12': 'ISR(TIMER1_COMPA_vect)',
+                '__vector_15': 'ISR(TIMER0_COMP_vect)'}
+
+# " .text.i2c_SendByte   0x... 0x18 build/..." possibly wrapped after the section name
+INPUT_RE = re.compile(r'^ (\.[\w.$]+)\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(\S.*)$')
+NAME_ONLY_RE = re.compile(r'^ (\.[\w.$]+)\s*$')
+ADDR_RE = re.compile(r'^\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(\S.*)$')
+
+
+def region_of(section):
+    if section.startswith(('.bss', '.noinit')):
+        return 'bss'
+    if section.startswith(('.data', '.rodata')):
+        return 'data'
+    if section.startswith(('.text', '.progmem', '.vectors', '.init', '.fini', '.dinit',
+                           '.jumptables', '.lowtext', '.trampolines')):
+        return 'text'
+    return None
+
+
+def symbol_of(section, obj):
+    for prefix in ('.text.', '.data.', '.bss.', '.noinit.', '.rodata.', '.progmem.gcc_sw_table.'):
+        if section.startswith(prefix):
+            name = section[len(prefix):]
+            name = VECTOR_NAMES.get(name, name)
+            return name + ' (switch table)' if prefix == '.progmem.gcc_sw_table.' else name
+    return '%s(%s)' % (os.path.basename(obj.replace('\\', '/')), section)
+
+
+def parse_map(path):
+    """Returns {(region, symbol): bytes} for everything linked into the image."""
+    sizes = {}
+    with open(path, errors='replace') as f:
+        lines = f.read().split('\n')
+    try:
+        start = lines.index('Linker script and memory map')
+    except ValueError:
+        start = 0
+    pending = None
+    for line in lines[start:]:
+        m = INPUT_RE.match(line)
+        if m:
+            section, size, obj = m.group(1), int(m.group(3), 16), m.group(4)
+        elif pending and ADDR_RE.match(line):
+            a = ADDR_RE.match(line)
+            section, size, obj = pending, int(a.group(2), 16), a.group(3)
+        else:
+            n = NAME_ONLY_RE.match(line)
+            pending = n.group(1) if n else None
+            continue
+        pending = None
+        region = region_of(section)
+        if region is None or size == 0 or 'load address' in obj:
+            continue
+        key = (region, symbol_of(section, obj))
+        sizes[key] = sizes.get(key, 0) + size
+    return sizes
+
+
+def find_maps(root):
+    maps = {}
+    for path in glob.glob(os.path.join(root, 'dist', '*', 'production', MAP_NAME)):
+        maps[path.split(os.sep)[-3]] = path
+    return maps
+
+
+def totals(sizes):
+    t = {'text': 0, 'data': 0, 'bss': 0}
+    for (region, _), size in sizes.items():
+        t[region] += size
+    t['stack'] = RAM_SIZE - t['data'] - t['bss']   # SRAM left for the stack
+    return t
+
+
+def load_baseline(path):
+    base = {}
+    if not os.path.exists(path):
+        return base
+    with open(path) as f:
+        for line in f:
+            line = line.rstrip('\n')
+            if not line or line.startswith('#'):
+                continue
+            conf, region, size, symbol = line.split('\t')
+            base.setdefault(conf, {})[(region, symbol)] = int(size)
+    return base
+
+
+def write_baseline(path, current):
+    with open(path, 'w') as f:
+        f.write('# Footprint baseline, regenerate with: make footprint-update\n')
+        f.write('# config\tregion\tbytes\tsymbol\n')
+        for conf in sorted(current):
+            for (region, symbol), size in sorted(current[conf].items()):
+                f.write('%s\t%s\t%d\t%s\n' % (conf, region, size, symbol))
+
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('--root', default=os.path.dirname(here), help='MPLAB project directory')
+    parser.add_argument('--baseline', default=None, help='baseline file')
+    parser.add_argument('--update', action='store_true', help='rewrite the baseline')
+    parser.add_argument('--min-stack', type=int, default=512, help='minimum SRAM left for the stack')
+    parser.add_argument('--top', type=int, default=15, help='symbols listed per region')
+    args = parser.parse_args()
+    baseline_path = args.baseline or os.path.join(args.root, 'footprint_baseline.txt')
+
+    current = {conf: parse_map(path) for conf, path in sorted(find_maps(args.root).items())}
+    if not current:
+        print('footprint: no %s found under %s' % (MAP_NAME, args.root))
+        return 1
+    if args.update:
+        write_baseline(baseline_path, current)
+        print('footprint: baseline written to %s' % baseline_path)
+        return 0
+
+    baseline = load_baseline(baseline_path)
+    if not baseline:
+        print('footprint: no baseline in %s, record one with make footprint-update' % baseline_path)
+    failed = False
+    for conf, sizes in current.items():
+        now = totals(sizes)
+        base = baseline.get(conf)
+        was = totals(base) if base is not None else None
+        print('== %s' % conf)
+        for region in ('text', 'data', 'bss', 'stack'):
+            delta = '' if was is None else ' (%+d)' % (now[region] - was[region])
+            print('   %-6s %6d%s' % (region, now[region], delta))
+        for region in ('text', 'data', 'bss'):
+            top = sorted(((s, n) for (r, n), s in sizes.items() if r == region), reverse=True)
+            for size, name in top[:args.top]:
+                print('      %-5s %6d  %s' % (region, size, name))
+        if now['stack'] < args.min_stack:
+            print('   FAIL: only %d bytes of SRAM left for the stack' % now['stack'])
+            failed = True
+        if base is None:
+            print('   no baseline for this configuration')
+            continue
+        for key in sorted(set(sizes) | set(base)):
+            diff = sizes.get(key, 0) - base.get(key, 0)
+            if diff:
+                print('   %+6d  %-5s %s' % (diff, key[0], key[1]))
+        for region in ('text', 'data', 'bss'):
+            if now[region] > was[region]:
+                print('   FAIL: %s grew by %d bytes' % (region, now[region] - was[region]))
+                failed = True
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
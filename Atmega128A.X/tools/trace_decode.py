@@ -0,0 +1,229 @@
+#!/usr/bin/env python3
+"""Decoder for the USART0 trace channel (uart_trace.c), writes CSV.
+
+Reads the binary frame stream from a serial port, a pty (e.g. the UART of
+simavr) or a captured file and prints one CSV row per frame.
+
+    trace_decode.py /dev/ttyUSB0             live, 38400 8N1
+    trace_decode.py /dev/pts/3 -o run.csv    simavr uart pty
+    trace_decode.py capture.bin              offline
+
+Frame: A5 type sequence length payload[length] checksum, where checksum is
+the 8-bit sum of type, sequence, length and payload. Frames with a bad
+checksum are skipped and the decoder resynchronizes on the next A5. Gaps in
+the sequence number are reported in the 'lost' column; they include frames
+the target dropped because its ring was full.
+
+A frozen I2C bus trace (I2C_BUSTRACE_ENABLE) arrives in I2C_BUSTRACE chunks.
+Once all chunks are in, it is replayed as one BUS row per transaction, e.g.
+"S 50W A 00 A 10 A Sr 50R A [AB] A [CD] N P", with its start and length in
+Timer3 ticks.
+"""
+import argparse
+import csv
+import os
+import struct
+import sys
+import time
+
+SYNC = 0xA5
+BAUD = 38400
+
+I2C_ERRORS = {1: 'ADDRESS_WRITE', 2: 'DATA_WRITE', 3: 'ADDRESS_READ'}
+
+
+def i2c_error(p):
+    (code,) = struct.unpack('<B', p)
+    return {'code': I2C_ERRORS.get(code, code)}
+
+
+def i2c_read(p):
+    device, reg, length = struct.unpack('<BHB', p)
+    return {'device': '0x%02X' % device, 'register': '0x%04X' % reg, 'length': length}
+
+
+def eeprom_write(p):
+    address, length = struct.unpack('<HB', p)
+    return {'address': '0x%04X' % address, 'length': length}
+
+
+def rtc_snapshot(p):
+    slot, sequence = struct.unpack('<BB', p)
+    return {'slot': slot, 'sequence': sequence}
+
+
+STATS_FIELDS = ('bytesWritten', 'bytesRead', 'transactions', 'nacks', 'retries',
+                'writeBufferHighWater', 'readBufferHighWater', 'isrCount', 'isrMinTicks',
+                'isrMaxTicks', 'isrTotalTicks', 'busBusyTicks', 'windowTicks', 'readsMerged')
+
+
+def i2c_stats(p):
+    return dict(zip(STATS_FIELDS, struct.unpack('<IIHHHBBHHHIIIH', p)))
+
+
+def i2c_soft_stats(p):
+    # Timer2 counts are 1 us at 8 MHz with the clk/8 prescaler (I2C_SOFT_TIMER_DIV)
+    nbytes, transactions, nacks, busy, tick_us, lat_min, lat_max = struct.unpack('<IHHIBBB', p)
+    busy_us = busy * tick_us
+    return {'bytes': nbytes, 'transactions': transactions, 'nacks': nacks, 'busyUs': busy_us,
+            'throughput': '%.0f B/s' % (nbytes * 1e6 / busy_us) if busy_us else '-',
+            'latencyUs': '%d-%d' % (lat_min, lat_max) if lat_min <= lat_max else '-',
+            'jitterUs': lat_max - lat_min if lat_min <= lat_max else 0}
+
+
+def stack(p):
+    size, used = struct.unpack('<HH', p)
+    return {'size': size, 'used': used, 'free': size - used}
+
+
+def boot(p):
+    ready, rtc, program, log, profile, done, rtc_state, program_status, failed = struct.unpack('<HHHHHBBBB', p)
+    return {'ready_ms': ready, 'rtc_ms': rtc, 'program_ms': program, 'log_ms': log,
+            'profile_ms': profile, 'done': done, 'failed': failed,
+            'rtc': {2: 'kept', 3: 'reset', 4: 'failed'}.get(rtc_state, rtc_state),
+            'program': {2: 'loaded', 3: 'defaults'}.get(program_status, program_status)}
+
+
+def codec_bench(p):
+    samples, encoded, enc_cycles, dec_cycles = struct.unpack('<HHHH', p)
+    return {'samples': samples, 'bytes': encoded, 'ratio': '%.2f' % (2.0 * samples / encoded),
+            'encodeCycles': enc_cycles, 'decodeCycles': dec_cycles}
+
+
+def drops(p):
+    (count,) = struct.unpack('<H', p)
+    return {'dropped': count}
+
+
+BUSTRACE_ENTRY = struct.Struct('<HBBB')     # i2c_BusTraceEntry_t
+ACT_STOP = 5                                # I2C_BUSTRACE_ACT_STOP
+
+
+def i2c_bustrace(p):
+    first, total = p[0], p[1]
+    entries = [BUSTRACE_ENTRY.unpack_from(p, off) for off in range(2, len(p), BUSTRACE_ENTRY.size)]
+    return {'first': first, 'total': total, 'entries': entries}
+
+
+def bus_transactions(entries):
+    """Rebuilds START/address/data/ACK/STOP sequences from the bus trace.
+
+    TWDR is sampled on interrupt entry, so it holds the byte the status
+    reports on: the address after an SLA status, the data byte after a data
+    status. Yields (start ticks, duration ticks, sequence).
+    """
+    tokens, start = [], None
+    for ts, status, data, action in entries:
+        if status == 0x08 and tokens:
+            yield start, 0, ' '.join(tokens + ['...'])
+            tokens = []
+        if not tokens:
+            start = ts
+        if status in (0x08, 0x10):
+            tokens.append('S' if status == 0x08 else 'Sr')
+        elif status in (0x18, 0x20, 0x40, 0x48):
+            tokens.append('%02X%s %s' % (data >> 1, 'R' if data & 1 else 'W',
+                                         'A' if status in (0x18, 0x40) else 'N'))
+        elif status in (0x28, 0x30):
+            tokens.append('%02X %s' % (data, 'A' if status == 0x28 else 'N'))
+        elif status in (0x50, 0x58):
+            tokens.append('[%02X] %s' % (data, 'A' if status == 0x50 else 'N'))
+        else:
+            tokens.append('?%02X' % status)
+        if action == ACT_STOP:
+            yield start, (ts - start) & 0xFFFF, ' '.join(tokens + ['P'])
+            tokens = []
+    if tokens:
+        yield start, 0, ' '.join(tokens + ['...'])
+
+
+# type: (name, payload decoder), see TRACE_EVT_* in uart_trace.h
+EVENTS = {0x01: ('I2C_ERROR', i2c_error), 0x02: ('I2C_READ', i2c_read),
+          0x03: ('EEPROM_WRITE', eeprom_write), 0x04: ('RTC_SNAPSHOT', rtc_snapshot),
+          0x05: ('I2C_STATS', i2c_stats), 0x06: ('DROPS', drops),
+          0x07: ('I2C_BUSTRACE', i2c_bustrace), 0x08: ('CODEC_BENCH', codec_bench),
+          0x09: ('I2C_SOFT_STATS', i2c_soft_stats), 0x0A: ('STACK', stack),
+          0x0B: ('BOOT', boot)}
+
+
+def frames(stream):
+    """Yields (type, sequence, payload) for every frame with a valid checksum."""
+    buf = bytearray()
+    while True:
+        chunk = stream.read(256)
+        if not chunk:
+            return
+        buf += chunk
+        while True:
+            start = buf.find(SYNC)
+            if start < 0:
+                buf.clear()
+                break
+            del buf[:start]
+            if len(buf) < 4:
+                break
+            ftype, seq, length = buf[1], buf[2], buf[3]
+            if len(buf) < length + 5:
+                break
+            payload = bytes(buf[4:4 + length])
+            if (ftype + seq + length + sum(payload)) & 0xFF != buf[4 + length]:
+                del buf[:1]     # false sync or corrupted frame
+                continue
+            del buf[:length + 5]
+            yield ftype, seq, payload
+
+
+def open_input(path):
+    fd = os.open(path, os.O_RDONLY | os.O_NOCTTY)
+    if os.isatty(fd):
+        import termios
+        import tty
+        tty.setraw(fd)
+        attrs = termios.tcgetattr(fd)
+        attrs[4] = attrs[5] = getattr(termios, 'B%d' % BAUD)
+        termios.tcsetattr(fd, termios.TCSANOW, attrs)
+    return os.fdopen(fd, 'rb', buffering=0)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('input', help='serial port, pty or capture file')
+    parser.add_argument('-o', '--output', default='-', help='CSV file, default stdout')
+    args = parser.parse_args()
+
+    out = sys.stdout if args.output == '-' else open(args.output, 'w', newline='')
+    writer = csv.writer(out)
+    writer.writerow(['time', 'seq', 'lost', 'event', 'fields'])
+    expected = None
+    bustrace = []
+    t0 = time.monotonic()
+    try:
+        for ftype, seq, payload in frames(open_input(args.input)):
+            lost = 0 if expected is None else (seq - expected) & 0xFF
+            expected = (seq + 1) & 0xFF
+            name, decode = EVENTS.get(ftype, ('0x%02X' % ftype, None))
+            try:
+                fields = decode(payload) if decode else {'raw': payload.hex()}
+            except struct.error:
+                fields = {'raw': payload.hex()}
+            now = '%.3f' % (time.monotonic() - t0)
+            if ftype == 0x07 and 'entries' in fields:
+                entries = fields.pop('entries')
+                if fields['first'] == 0:
+                    bustrace = []
+                if fields['first'] == len(bustrace):   # chunks arrive in order, a lost one discards the trace
+                    bustrace += entries
+                fields['count'] = len(entries)
+            writer.writerow([now, seq, lost, name, ' '.join('%s=%s' % kv for kv in fields.items())])
+            if ftype == 0x07 and bustrace and len(bustrace) == fields.get('total'):
+                for start, duration, sequence in bus_transactions(bustrace):
+                    writer.writerow([now, '', '', 'BUS', 'start=%d ticks=%d seq=%s' % (start, duration, sequence)])
+                bustrace = []
+            out.flush()
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,230 @@
+/*_____________________________{FILE_NAME}_____________________________________________________
+                                      ___           ___           ___
+ Author: Abdelrahman Selim           /\  \         /\  \         /\  \
+                                    /::\  \       /::\  \       /::\  \
+Created on: {DATE}                 /:/\:\  \     /:/\:\  \     /:/\:\  \
+                                  /::\ \:\  \   _\:\ \:\  \   /::\ \:\  \
+ Version: 01                     /:/\:\ \:\__\ /\ \:\ \:\__\ /:/\:\ \:\__\
+                                 \/__\:\/:/  / \:\ \:\ \/__/ \/__\:\/:/  /
+                                      \::/  /   \:\ \:\__\        \::/  /
+                                      /:/  /     \:\/:/  /        /:/  /
+ Brief : UART Trace Channel          /:/  /       \::/  /        /:/  /
+                                     \/__/         \/__/         \/__/
+ _________________________________________________________________________________________*/
+#include "uart_trace.h"
+
+#ifdef TRACE_ENABLE
+
+// Transmit ring, filled by trace_Event() and drained by the UDRE interrupt
+static uint8_t          trace_Buffer[TRACE_BUFFER_SIZE];
+static uint8_t          trace_Head;         // Next byte to write, owned by trace_Event()
+static volatile uint8_t trace_Tail;         // Next byte to send, owned by the UDRE interrupt
+static uint8_t          trace_Sequence;     // Sequence number of the next frame
+static uint16_t         trace_DropCount;    // Frames dropped since reset
+
+// Free bytes in the transmit ring
+static uint8_t trace_Free() {
+    return TRACE_BUFFER_SIZE - (uint8_t)(trace_Head - trace_Tail);
+}
+
+/**
+ * @brief Initializes USART0 as a transmit-only trace port.
+ *
+ * 8N1 at TRACE_BAUD with double speed, which keeps the baud error low on
+ * the 8 MHz clock. The data register empty interrupt is only enabled while
+ * the ring holds data.
+ */
+void trace_Init() {
+    uint16_t ubrr = (F_CPU / (8 * TRACE_BAUD)) - 1;
+    UBRR0H = ubrr >> 8;
+    UBRR0L = (uint8_t) ubrr;
+    UCSR0A = (1 << U2X0);
+    UCSR0C = (1 << UCSZ01) | (1 << UCSZ00);
+    UCSR0B = (1 << TXEN0);
+}
+
+/**
+ * @brief Queues one trace frame for transmission.
+ *
+ * The frame is copied into the ring as a whole or not at all, so a full
+ * ring only increments the drop counter and the caller never waits for the
+ * UART. Safe to call from interrupts: the copy runs with interrupts held off,
+ * which costs a few cycles per byte.
+ *
+ * @param type     One of TRACE_EVT_*.
+ * @param payload  Event payload, may be 0 when length is 0.
+ * @param length   Payload length, at most TRACE_MAX_PAYLOAD.
+ *
+ * @return uint8_t Returns 1 if the frame was queued, 0 if it was dropped.
+ */
+uint8_t trace_Event(uint8_t type, const void* payload, uint8_t length) {
+    const uint8_t* data = payload;
+    uint8_t sreg = SREG;
+    cli();
+    if (length > TRACE_MAX_PAYLOAD || (length + TRACE_FRAME_OVERHEAD) > trace_Free()) {
+        trace_DropCount++;
+        trace_Sequence++;   // The gap shows up in the decoder as well
+        SREG = sreg;
+        return 0;
+    }
+    uint8_t head = trace_Head;
+    uint8_t checksum = type + trace_Sequence + length;
+    trace_Buffer[head++ & (TRACE_BUFFER_SIZE - 1)] = TRACE_SYNC;
+    trace_Buffer[head++ & (TRACE_BUFFER_SIZE - 1)] = type;
+    trace_Buffer[head++ & (TRACE_BUFFER_SIZE - 1)] = trace_Sequence++;
+    trace_Buffer[head++ & (TRACE_BUFFER_SIZE - 1)] = length;
+    for (uint8_t i = 0; i < length; i++) {
+        trace_Buffer[head++ & (TRACE_BUFFER_SIZE - 1)] = data[i];
+        checksum += data[i];
+    }
+    trace_Buffer[head++ & (TRACE_BUFFER_SIZE - 1)] = checksum;
+    trace_Head = head;
+    UCSR0B |= (1 << UDRIE0);  // Start draining
+    SREG = sreg;
+    return 1;
+}
+
+// Counter frames of trace_Counters(), in the order they go out
+#define TRACE_COUNTER_DROPS     0
+#define TRACE_COUNTER_I2C       1
+#define TRACE_COUNTER_I2C_SOFT  2
+#define TRACE_COUNTER_STACK     3
+#define TRACE_COUNTERS          4
+
+// 1 if a frame with the payload length fits in the ring now
+static uint8_t trace_Fits(uint8_t length) {
+    return trace_Free() >= (uint8_t)(length + TRACE_FRAME_OVERHEAD);
+}
+
+/**
+ * @brief Queues one counter frame if it fits, a counter that is not built
+ * in counts as sent.
+ *
+ * @return uint8_t Returns 0 if the ring has no room for it yet.
+ */
+static uint8_t trace_CounterSend(uint8_t counter) {
+    switch (counter) {
+        case TRACE_COUNTER_DROPS:
+            if (!trace_Fits(sizeof(trace_DropCount))) {
+                return 0;
+            }
+            trace_Event(TRACE_EVT_DROPS, &trace_DropCount, sizeof(trace_DropCount));
+            break;
+#ifdef I2C_STATS_ENABLE
+        case TRACE_COUNTER_I2C: {
+            i2c_Stats_t stats;
+            if (!trace_Fits(sizeof(stats))) {
+                return 0;
+            }
+            i2c_StatsGet(&stats);
+            trace_Event(TRACE_EVT_I2C_STATS, &stats, sizeof(stats));
+            break;
+        }
+#ifdef I2C_SOFT_ENABLE
+        case TRACE_COUNTER_I2C_SOFT: {
+            i2c_SoftStats_t soft;
+            if (!trace_Fits(sizeof(soft))) {
+                return 0;
+            }
+            i2c_SoftStatsGet(&soft);
+            trace_Event(TRACE_EVT_I2C_SOFT_STATS, &soft, sizeof(soft));
+            break;
+        }
+#endif
+#endif
+#ifdef STACK_MONITOR_ENABLE
+        case TRACE_COUNTER_STACK: {
+            stack_Usage_t stack;
+            if (!trace_Fits(sizeof(stack))) {
+                return 0;
+            }
+            stack_UsageGet(&stack);
+            trace_Event(TRACE_EVT_STACK, &stack, sizeof(stack));
+            break;
+        }
+#endif
+        default:
+            break;
+    }
+    return 1;
+}
+
+/**
+ * @brief Emits the drop counter and, when enabled, the I2C bus statistics
+ * of the TWI and the software master and the stack high-water mark.
+ *
+ * Meant to be called periodically (e.g. once a second) from the main loop.
+ * All of them together are larger than the ring (drops 7, TWI 41, soft bus
+ * 20, stack 9 bytes with the frame overhead), so the frames go out in turn: a
+ * frame that does not fit waits for the next call instead of being dropped,
+ * and that call starts with it. With the ring drained between the calls each
+ * counter goes out at least every second call.
+ */
+void trace_Counters() {
+    static uint8_t next;    // Counter to send first
+
+    for (uint8_t i = 0; i < TRACE_COUNTERS; i++) {
+        if (!trace_CounterSend(next)) {
+            return;
+        }
+        next = (next + 1) % TRACE_COUNTERS;
+    }
+}
+
+/**
+ * @brief Returns the number of frames dropped because the ring was full.
+ */
+uint16_t trace_Dropped() {
+    return trace_DropCount;
+}
+
+#ifdef I2C_BUSTRACE_ENABLE
+/**
+ * @brief Sends the next chunk of a frozen I2C bus trace.
+ *
+ * Call it on every main loop pass; it returns at once while the tracer is
+ * still recording. A chunk that does not fit in the ring is retried on the
+ * next call instead of being dropped. Once the whole trace went out the
+ * tracer is re-armed, so the next fault is captured as well.
+ */
+void trace_BusTrace() {
+    static uint8_t next;    // First entry of the next chunk
+    uint8_t payload[2 + 7 * sizeof(i2c_BusTraceEntry_t)];
+    uint8_t count;
+
+    if (!i2c_BusTraceFrozen()) {
+        return;
+    }
+    if (trace_Free() < (uint8_t)(sizeof(payload) + TRACE_FRAME_OVERHEAD)) {
+        return;  // Wait for the ring to drain
+    }
+    payload[0] = next;
+    payload[1] = i2c_BusTraceCount();
+    for (count = 0; count < 7; count++) {
+        if (!i2c_BusTraceGet(next + count, (i2c_BusTraceEntry_t*) &payload[2 + count * sizeof(i2c_BusTraceEntry_t)])) {
+            break;
+        }
+    }
+    trace_Event(TRACE_EVT_I2C_BUSTRACE, payload, 2 + count * sizeof(i2c_BusTraceEntry_t));
+    next += count;
+    if (next >= payload[1]) {
+        next = 0;
+        i2c_BusTraceRestart();
+    }
+}
+#endif
+
+/**
+ * @brief USART0 data register empty interrupt, sends the next ring byte.
+ */
+ISR(USART0_UDRE_vect) {
+    uint8_t tail = trace_Tail;
+    if (tail == trace_Head) {
+        UCSR0B &= ~(1 << UDRIE0);  // Ring is empty
+        return;
+    }
+    UDR0 = trace_Buffer[tail & (TRACE_BUFFER_SIZE - 1)];
+    trace_Tail = tail + 1;
+}
+
+#endif // TRACE_ENABLE
@@ -0,0 +1,51 @@
+#ifndef UART_TRACE_H
+#define UART_TRACE_H
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "i2c_driver.h"
+#include "i2c_soft.h"
+#include "stack_monitor.h"
+
+// Serial trace channel on USART0, uncomment or pass -DTRACE_ENABLE to the compiler.
+// When disabled every TRACE() call compiles to nothing.
+//#define TRACE_ENABLE
+
+#define TRACE_BAUD            38400UL  // 0.2% error at 8 MHz with U2X
+#define TRACE_BUFFER_SIZE     64       // Transmit ring, must be a power of two
+#define TRACE_MAX_PAYLOAD     40       // Largest event payload
+
+// Frame: [TRACE_SYNC][type][sequence][length][payload ...][checksum]
+// checksum is the 8-bit sum of type, sequence, length and payload
+#define TRACE_SYNC            0xA5
+#define TRACE_FRAME_OVERHEAD  5
+
+// Event types, payloads are little endian
+#define TRACE_EVT_I2C_ERROR     0x01  // code(u8), one of I2C_ERROR_*
+#define TRACE_EVT_I2C_READ      0x02  // device(u8) register(u16) length(u8), a read was delivered
+#define TRACE_EVT_EEPROM_WRITE  0x03  // address(u16) length(u8)
+#define TRACE_EVT_RTC_SNAPSHOT  0x04  // slot(u8) sequence(u8)
+#define TRACE_EVT_I2C_STATS     0x05  // i2c_Stats_t
+#define TRACE_EVT_DROPS         0x06  // frames dropped since reset(u16)
+#define TRACE_EVT_I2C_BUSTRACE  0x07  // first(u8) total(u8) then i2c_BusTraceEntry_t[], one chunk of a frozen bus trace
+#define TRACE_EVT_CODEC_BENCH   0x08  // codec_Bench_t
+#define TRACE_EVT_I2C_SOFT_STATS 0x09 // i2c_SoftStats_t, software I2C master
+#define TRACE_EVT_STACK         0x0A  // stack_Usage_t
+#define TRACE_EVT_BOOT          0x0B  // boot_Report_t, once when the controller is ready
+
+#ifdef TRACE_ENABLE
+#define TRACE(statement)    do { statement; } while (0)
+#else
+#define TRACE(statement)    do { } while (0)
+#endif
+
+// Function prototypes
+void    trace_Init();                                               // Set up USART0 for TRACE_BAUD
+uint8_t trace_Event(uint8_t type, const void* payload, uint8_t length); // Queue a frame, never blocks
+void    trace_Counters();                                           // Emit drop counter, bus statistics and stack usage
+uint16_t trace_Dropped();                                           // Frames dropped because the ring was full
+#ifdef I2C_BUSTRACE_ENABLE
+void    trace_BusTrace();                                           // Send a frozen bus trace in chunks, then re-arm it
+#endif
+
+#endif // UART_TRACE_H
@@ -0,0 +1,11 @@
+/*_____________________________{ASYNC_WIRE_ENGINE_C}_____________________________________________________
+ Author: Abdelrahman Selim
+ Brief : The I2C engine of the ATmega128A firmware, built into the AsyncWire library
+
+ The driver sources are compiled here unchanged, so the PlatformIO build runs
+ exactly the code of the MPLAB project. Options such as I2C_STATS_ENABLE are
+ passed with build_flags in platformio.ini.
+ _________________________________________________________________________________________*/
+#include "../../../../Atmega128A.X/i2c_driver.c"
+#include "../../../../Atmega128A.X/i2c_device.c"
+#include "../../../../Atmega128A.X/i2c_request_queue.c"
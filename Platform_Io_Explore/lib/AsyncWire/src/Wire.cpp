@@ -0,0 +1,313 @@
+/*_____________________________{WIRE_CPP}_____________________________________________________
+ Author: Abdelrahman Selim
+ Brief : Arduino Wire API on the interrupt driven queue of Atmega128A.X/i2c_driver.c
+
+ Writes go straight into the write ring of the C driver. Reads are queued here
+ and handed one at a time to a device of the arbiter that is re-addressed for
+ each of them, so Wire reads take turns with the reads of the other drivers.
+ _________________________________________________________________________________________*/
+#include "Wire.h"
+
+extern "C" {
+#include "../../../../Atmega128A.X/i2c_device.h"
+}
+
+static_assert((WIRE_ASYNC_QUEUE_SIZE & (WIRE_ASYNC_QUEUE_SIZE - 1)) == 0 && WIRE_ASYNC_QUEUE_SIZE <= 128,
+              "WIRE_ASYNC_QUEUE_SIZE must be a power of two up to 128");
+static_assert(BUFFER_LENGTH < I2C_READ_BUFFER_SIZE, "a Wire read must fit the receive buffer of the driver");
+
+// The device queue holds the one read on its way, the others wait in TwoWire::requests
+I2C_REQUEST_QUEUE_DEFINE(wireReadQueue, 1);
+static i2c_Device_t wireDevice = { 0, I2C_STANDARD_MODE, 0, &wireReadQueue, TwoWire::service, 0, 0 };
+
+uint8_t           TwoWire::txAddress;
+uint8_t           TwoWire::txBuffer[BUFFER_LENGTH];
+uint8_t           TwoWire::txLength;
+bool              TwoWire::transmitting;
+bool              TwoWire::txOverflow;
+uint8_t           TwoWire::rxBuffer[BUFFER_LENGTH];
+uint8_t           TwoWire::rxIndex;
+uint8_t           TwoWire::rxLength;
+TwoWire::Request  TwoWire::requests[WIRE_ASYNC_QUEUE_SIZE];
+uint8_t           TwoWire::requestHead;
+uint8_t           TwoWire::requestTail;
+bool              TwoWire::submitted;
+uint8_t           TwoWire::ticket;
+uint32_t          TwoWire::submitTime;
+uint8_t           TwoWire::staging[BUFFER_LENGTH];
+uint32_t          TwoWire::timeoutUs = WIRE_DEFAULT_TIMEOUT_US;
+bool              TwoWire::timeoutFlag;
+bool              TwoWire::begun;
+
+TwoWire::TwoWire() {
+}
+
+// Registers the Wire device, which initializes the TWI at the slowest device speed
+void TwoWire::begin() {
+    rxIndex  = 0;
+    rxLength = 0;
+    txLength = 0;
+    if (!begun) {
+        begun = i2c_DeviceRegister(&wireDevice);
+    }
+}
+
+// Slave mode is not supported, the bus is started as a master
+void TwoWire::begin(uint8_t address) {
+    begin();
+}
+
+void TwoWire::begin(int address) {
+    begin();
+}
+
+// Drops the Wire reads, the bus keeps running for the other drivers
+void TwoWire::end() {
+    i2c_DeviceReadCancel(&wireDevice);
+    requestTail = requestHead;
+    submitted   = false;
+}
+
+// Bus speed of the Wire devices, the bus runs at the slowest registered device
+void TwoWire::setClock(uint32_t clock) {
+    if (begun) {
+        i2c_DeviceSetSpeed(&wireDevice, clock);
+    } else {
+        wireDevice.speed = clock;
+    }
+}
+
+// Longest wait of a blocking call and of every read, 0 waits forever. The
+// driver has no bus recovery, resetWithTimeout is ignored.
+void TwoWire::setWireTimeout(uint32_t timeout, bool resetWithTimeout) {
+    timeoutUs = timeout;
+}
+
+bool TwoWire::getWireTimeoutFlag() {
+    return timeoutFlag;
+}
+
+void TwoWire::clearWireTimeoutFlag() {
+    timeoutFlag = false;
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+    txAddress    = address;
+    txLength     = 0;
+    transmitting = true;
+    txOverflow   = false;
+}
+
+void TwoWire::beginTransmission(int address) {
+    beginTransmission((uint8_t)address);
+}
+
+uint8_t TwoWire::endTransmission() {
+    return endTransmission((uint8_t)true);
+}
+
+// 0 once queued, 1 if more than BUFFER_LENGTH bytes were written, 5 if the
+// write buffer stayed full for the timeout. Without data it probes the address
+// and waits: 0 on ACK, 2 on NACK.
+uint8_t TwoWire::endTransmission(uint8_t sendStop) {
+    uint32_t start = micros();
+
+    transmitting = false;
+    if (txOverflow) {
+        return 1;
+    }
+    if (txLength == 0) {
+        uint8_t probe;
+
+        do {
+            while (!i2c_Probe(txAddress)) {
+                if (timedOut(start)) {
+                    return 5;
+                }
+                update();
+            }
+            uint8_t probeTicket = i2c_ProbeTicket();     // ACK polls of the EEPROM run on the same bus
+            while ((probe = i2c_ProbeResult(probeTicket)) == I2C_PROBE_PENDING) {
+                if (timedOut(start)) {
+                    return 5;
+                }
+                update();
+            }
+        } while (probe == I2C_PROBE_LOST);
+        return (probe == I2C_PROBE_ACK) ? 0 : 2;
+    }
+    while (!i2c_SendArray(txAddress, txLength, txBuffer)) {
+        if (timedOut(start)) {
+            return 5;
+        }
+        update();
+    }
+    return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity) {
+    return requestFrom(address, quantity, (uint32_t)0, (uint8_t)0, (uint8_t)true);
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, uint8_t sendStop) {
+    return requestFrom(address, quantity, (uint32_t)0, (uint8_t)0, sendStop);
+}
+
+uint8_t TwoWire::requestFrom(int address, int quantity) {
+    return requestFrom((uint8_t)address, (uint8_t)quantity, (uint32_t)0, (uint8_t)0, (uint8_t)true);
+}
+
+uint8_t TwoWire::requestFrom(int address, int quantity, int sendStop) {
+    return requestFrom((uint8_t)address, (uint8_t)quantity, (uint32_t)0, (uint8_t)0, (uint8_t)sendStop);
+}
+
+// Queues the read behind the asynchronous ones and runs the arbiter until it
+// is delivered. Returns the bytes received, 0 if the device did not answer.
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, uint32_t iaddress, uint8_t isize, uint8_t sendStop) {
+    uint32_t start = micros();
+
+    while (!queueRead(address, quantity, iaddress, isize, 0)) {
+        if (isize > 2 || quantity == 0 || timedOut(start)) {
+            return 0;
+        }
+        update();
+    }
+    uint8_t mine = requestHead;
+    while ((int8_t)(requestTail - mine) < 0) {
+        update();
+    }
+    return rxLength;
+}
+
+uint8_t TwoWire::requestFromAsync(uint8_t address, uint8_t quantity, Callback callback) {
+    return queueRead(address, quantity, 0, 0, callback);
+}
+
+// Returns 1 if queued, 0 if WIRE_ASYNC_QUEUE_SIZE reads wait already or isize
+// is above 2. The callback runs from update() once the data arrived.
+uint8_t TwoWire::requestFromAsync(uint8_t address, uint8_t quantity, uint32_t iaddress, uint8_t isize, Callback callback) {
+    return queueRead(address, quantity, iaddress, isize, callback);
+}
+
+uint8_t TwoWire::pending() {
+    return (uint8_t)(requestHead - requestTail);
+}
+
+void TwoWire::update() {
+    i2c_DeviceUpdate();
+}
+
+uint8_t TwoWire::queueRead(uint8_t address, uint8_t quantity, uint32_t iaddress, uint8_t isize, Callback callback) {
+    if (isize > 2 || quantity == 0 || (uint8_t)(requestHead - requestTail) >= WIRE_ASYNC_QUEUE_SIZE) {
+        return 0;
+    }
+    Request& request = requests[requestHead & (WIRE_ASYNC_QUEUE_SIZE - 1)];
+    request.address  = address;
+    request.quantity = (quantity > BUFFER_LENGTH) ? BUFFER_LENGTH : quantity;
+    request.isize    = isize;
+    request.iaddress = (uint16_t)iaddress;
+    request.callback = callback;
+    requestHead++;
+    return 1;
+}
+
+bool TwoWire::timedOut(uint32_t start) {
+    if (timeoutUs != 0 && (micros() - start) > timeoutUs) {
+        timeoutFlag = true;
+        return true;
+    }
+    return false;
+}
+
+// Called by the arbiter on every pass: finishes the read on its way, either
+// delivered or timed out, then submits the next one once the device queue is
+// empty (a cancelled read leaves it only after the arbiter dropped it).
+void TwoWire::service() {
+    if (submitted) {
+        const Request& request = requests[requestTail & (WIRE_ASYNC_QUEUE_SIZE - 1)];
+        uint8_t count;
+
+        if (i2c_DeviceReadDone(&wireDevice, ticket)) {
+            count = request.quantity;
+        } else if (timedOut(submitTime)) {
+            i2c_DeviceReadCancel(&wireDevice);
+            count = 0;
+        } else {
+            return;
+        }
+        memcpy(rxBuffer, staging, count);
+        rxIndex  = 0;
+        rxLength = count;
+        submitted = false;
+
+        // The slot is free again once the tail moves, the callback may queue into it
+        uint8_t  address  = request.address;
+        Callback callback = request.callback;
+        requestTail++;
+        if (callback) {
+            callback(address, count);
+        }
+    }
+    if (!submitted && requestHead != requestTail && !i2c_DeviceReadPending(&wireDevice)) {
+        const Request& request = requests[requestTail & (WIRE_ASYNC_QUEUE_SIZE - 1)];
+
+        wireDevice.address       = request.address;
+        wireDevice.registerWidth = request.isize;
+        if (i2c_DeviceRead(&wireDevice, request.iaddress, request.quantity, staging)) {
+            ticket     = i2c_DeviceReadTicket(&wireDevice);
+            submitted  = true;
+            submitTime = micros();
+        }
+    }
+}
+
+// Bytes outside beginTransmission() / endTransmission() are refused, there is
+// no slave mode to send them in
+size_t TwoWire::write(uint8_t data) {
+    if (!transmitting) {
+        setWriteError();
+        return 0;
+    }
+    if (txLength >= BUFFER_LENGTH) {
+        txOverflow = true;
+        setWriteError();
+        return 0;
+    }
+    txBuffer[txLength++] = data;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t* data, size_t quantity) {
+    for (size_t i = 0; i < quantity; i++) {
+        if (!write(data[i])) {
+            return i;
+        }
+    }
+    return quantity;
+}
+
+int TwoWire::available() {
+    return rxLength - rxIndex;
+}
+
+int TwoWire::read() {
+    return (rxIndex < rxLength) ? rxBuffer[rxIndex++] : -1;
+}
+
+int TwoWire::peek() {
+    return (rxIndex < rxLength) ? rxBuffer[rxIndex] : -1;
+}
+
+void TwoWire::flush() {
+    while (i2c_WriteBufferUsed()) {
+        update();
+    }
+}
+
+void TwoWire::onReceive(void (*function)(int)) {
+}
+
+void TwoWire::onRequest(void (*function)(void)) {
+}
+
+TwoWire Wire;
@@ -0,0 +1,135 @@
+/*_____________________________{WIRE_H}_____________________________________________________
+ Author: Abdelrahman Selim
+ Brief : Arduino Wire API on the interrupt driven queue of Atmega128A.X/i2c_driver.c
+
+ Drop-in for the framework's Wire library (the project sets lib_ignore = Wire):
+ sketches and libraries that include <Wire.h> get this TwoWire. Transfers run
+ in the TWI interrupt from the write ring of the C driver, and reads are served
+ by its device arbiter (i2c_device.c), so the EEPROM and DS1307 drivers of the
+ firmware share the bus with Wire in the same program.
+
+ Differences to the blocking library:
+ - endTransmission() returns 0 once the frame is queued; only an address-only
+   transmission (bus scan) waits for the answer and reports 2 on a NACK.
+ - requestFrom() waits for its data, but the loop goes on in requestFromAsync():
+
+       void timeRead(uint8_t address, uint8_t count) {   // Runs from Wire.update()
+           while (Wire.available()) { ... Wire.read() ... }
+       }
+       Wire.requestFromAsync(0x68, 7, 0x00, 1, timeRead);
+       for (;;) { Wire.update(); ... }
+
+ - A read that is not acknowledged is tried again. If it is not delivered
+   within the timeout (setWireTimeout(), 25 ms from reaching the arbiter by
+   default, 0 waits forever) it ends with 0 bytes. An EEPROM in its write
+   cycle is waited for instead of failing.
+ - Repeated STARTs are not used: endTransmission(false) sends a STOP, which
+   every register-addressed device accepts.
+ - Slave mode (begin(address), onReceive(), onRequest()) is not supported.
+
+ Blocking calls drive the arbiter themselves. Do not call them from a callback;
+ asynchronous calls are fine there.
+ _________________________________________________________________________________________*/
+#ifndef WIRE_H
+#define WIRE_H
+
+#include <Arduino.h>
+#include <Stream.h>
+
+#define BUFFER_LENGTH               32
+#define WIRE_HAS_END                1
+#define WIRE_HAS_TIMEOUT            1
+
+#define WIRE_DEFAULT_TIMEOUT_US     25000UL
+#define WIRE_ASYNC_QUEUE_SIZE       4       // Reads waiting for the bus, power of two
+
+class TwoWire : public Stream {
+public:
+    // Completion of requestFromAsync(), count is 0 if the device never answered.
+    // The data is in the receive buffer (available(), read()) during the call.
+    typedef void (*Callback)(uint8_t address, uint8_t count);
+
+    TwoWire();
+
+    void begin();
+    void begin(uint8_t address);
+    void begin(int address);
+    void end();
+    void setClock(uint32_t clock);
+    void setWireTimeout(uint32_t timeout = WIRE_DEFAULT_TIMEOUT_US, bool resetWithTimeout = false);
+    bool getWireTimeoutFlag();
+    void clearWireTimeoutFlag();
+
+    void    beginTransmission(uint8_t address);
+    void    beginTransmission(int address);
+    uint8_t endTransmission();
+    uint8_t endTransmission(uint8_t sendStop);
+
+    uint8_t requestFrom(uint8_t address, uint8_t quantity);
+    uint8_t requestFrom(uint8_t address, uint8_t quantity, uint8_t sendStop);
+    uint8_t requestFrom(uint8_t address, uint8_t quantity, uint32_t iaddress, uint8_t isize, uint8_t sendStop);
+    uint8_t requestFrom(int address, int quantity);
+    uint8_t requestFrom(int address, int quantity, int sendStop);
+
+    // Asynchronous extensions
+    uint8_t requestFromAsync(uint8_t address, uint8_t quantity, Callback callback);
+    uint8_t requestFromAsync(uint8_t address, uint8_t quantity, uint32_t iaddress, uint8_t isize, Callback callback);
+    uint8_t pending();      // Reads queued or on the bus
+    void    update();       // Runs the bus arbiter and the callbacks, call from loop()
+
+    virtual size_t write(uint8_t data);
+    virtual size_t write(const uint8_t* data, size_t quantity);
+    virtual int    available();
+    virtual int    read();
+    virtual int    peek();
+    virtual void   flush();     // Waits until the queued writes have been sent
+
+    void onReceive(void (*function)(int));
+    void onRequest(void (*function)(void));
+
+    inline size_t write(unsigned long n) { return write((uint8_t)n); }
+    inline size_t write(long n) { return write((uint8_t)n); }
+    inline size_t write(unsigned int n) { return write((uint8_t)n); }
+    inline size_t write(int n) { return write((uint8_t)n); }
+    using Print::write;
+
+    static void service();  // Arbiter hook of the Wire device
+
+private:
+    struct Request {
+        uint8_t  address;
+        uint8_t  quantity;
+        uint8_t  isize;         // Register address bytes, 0 to 2
+        uint16_t iaddress;
+        Callback callback;
+    };
+
+    static uint8_t queueRead(uint8_t address, uint8_t quantity, uint32_t iaddress, uint8_t isize, Callback callback);
+    static bool    timedOut(uint32_t start);
+
+    static uint8_t  txAddress;
+    static uint8_t  txBuffer[BUFFER_LENGTH];
+    static uint8_t  txLength;
+    static bool     transmitting;
+    static bool     txOverflow;
+
+    static uint8_t  rxBuffer[BUFFER_LENGTH];
+    static uint8_t  rxIndex;
+    static uint8_t  rxLength;
+
+    static Request  requests[WIRE_ASYNC_QUEUE_SIZE];
+    static uint8_t  requestHead;        // Free running, next request queued
+    static uint8_t  requestTail;        // Free running, request on the bus or next to go
+    static bool     submitted;          // requests[requestTail] is in the device queue
+    static uint8_t  ticket;             // Its read ticket
+    static uint32_t submitTime;         // micros() when it was submitted
+    static uint8_t  staging[BUFFER_LENGTH];  // Where the arbiter delivers it
+
+    static uint32_t timeoutUs;
+    static bool     timeoutFlag;
+    static bool     begun;
+};
+
+extern TwoWire Wire;
+
+#endif // WIRE_H
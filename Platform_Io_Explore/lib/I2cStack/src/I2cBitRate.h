@@ -0,0 +1,45 @@
+/*_____________________________{I2C_BIT_RATE_H}_____________________________________________________
+ Author: Abdelrahman Selim
+ Brief : Compile time TWI bit rate for the C++ port of the Atmega128A.X I2C stack
+
+ SCL = F_CPU / (16 + 2 * TWBR * 4^TWPS)
+
+ The smallest prescaler that keeps TWBR within 8 bits is chosen, so the
+ configuration costs two constant register writes and no runtime division.
+ _________________________________________________________________________________________*/
+#ifndef I2C_BIT_RATE_H
+#define I2C_BIT_RATE_H
+
+#include <stdint.h>
+
+namespace i2c {
+
+static const uint32_t kStandardMode = 100000UL;   // 100 kHz
+static const uint32_t kFastMode     = 400000UL;   // 400 kHz
+
+template <uint32_t CpuHz, uint32_t SclHz>
+struct BitRate {
+    static_assert(SclHz > 0 && SclHz <= kFastMode, "SCL frequency must be between 1 Hz and 400 kHz");
+    static_assert(CpuHz >= 16UL * SclHz, "CPU clock must be at least 16 times the SCL frequency");
+
+    // 2 * TWBR * 4^TWPS
+    static constexpr uint32_t divider = CpuHz / SclHz - 16;
+
+    // TWPS bits, 0..3 for a prescaler of 1, 4, 16 or 64
+    static constexpr uint8_t prescalerBits = (divider / 2 <= 255)  ? 0
+                                           : (divider / 8 <= 255)  ? 1
+                                           : (divider / 32 <= 255) ? 2
+                                           : 3;
+
+    static constexpr uint32_t twbrWide = divider / (2UL << (2 * prescalerBits));
+    static_assert(twbrWide <= 255, "SCL frequency too low for this CPU clock");
+    // ATmega128 datasheet: TWBR should be 10 or higher in master mode
+    static_assert(twbrWide >= 10, "SCL frequency too high for this CPU clock (TWBR < 10)");
+
+    static constexpr uint8_t  twbr     = (uint8_t)twbrWide;
+    static constexpr uint32_t actualHz = CpuHz / (16 + (2UL << (2 * prescalerBits)) * twbr);
+};
+
+} // namespace i2c
+
+#endif // I2C_BIT_RATE_H
@@ -0,0 +1,250 @@
+/*_____________________________{I2C_BUS_H}_____________________________________________________
+ Author: Abdelrahman Selim
+ Brief : Interrupt driven TWI master, C++ port of Atmega128A.X/i2c_driver.c
+
+ Clock, bus speed and buffer sizes are template parameters. Every transaction is
+ stored in the write ring as [SLA+R/W][length][data...], exactly like the C driver,
+ and the TWI interrupt walks through the ring on its own, chaining transactions
+ with STOP+START. Only one read can be in flight because the read ring is shared.
+
+ The interrupt vector must be bound once in the program:
+     I2C_STACK_BIND_ISR(MyBus)
+ _________________________________________________________________________________________*/
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "I2cBitRate.h"
+
+namespace i2c {
+
+// TWI Status Register (TWSR) status codes
+enum Status : uint8_t {
+    kStart       = 0x08,
+    kRepStart    = 0x10,
+    kMtSlaAck    = 0x18,
+    kMtSlaNack   = 0x20,
+    kMtDataAck   = 0x28,
+    kMtDataNack  = 0x30,
+    kMrSlaAck    = 0x40,
+    kMrSlaNack   = 0x48,
+    kMrDataAck   = 0x50,
+    kMrDataNack  = 0x58
+};
+
+// State of the single read slot
+enum ReadState : uint8_t { kReadIdle, kReadBusy, kReadDone, kReadFailed };
+
+// Byte ring, power of two size so the free running indices wrap with a mask
+template <uint8_t Size>
+struct Ring {
+    static_assert(Size >= 4 && Size <= 128 && (Size & (Size - 1)) == 0,
+                  "ring size must be a power of two between 4 and 128");
+    uint8_t buffer[Size];
+    volatile uint8_t head;   // Written by the producer only
+    volatile uint8_t tail;   // Written by the consumer only
+
+    uint8_t count() const { return (uint8_t)(head - tail); }
+    uint8_t space() const { return Size - count(); }
+};
+
+template <uint32_t CpuHz, uint32_t SclHz, uint8_t WriteSize = 64, uint8_t ReadSize = 32>
+class Bus {
+public:
+    typedef BitRate<CpuHz, SclHz> Rate;
+
+    // Largest payload of one transaction (2 framing bytes are taken from the ring)
+    static const uint8_t kMaxTransfer = WriteSize - 2;
+    // Largest read of one transaction, the receive ring holds it whole
+    static const uint8_t kMaxRead = ReadSize;
+
+    static void init() {
+        TWBR = Rate::twbr;
+        TWSR = Rate::prescalerBits;
+        TWCR = (1 << TWEN) | (1 << TWIE);
+        sei();
+    }
+
+    // Queues a write of header[0..headerLength) followed by data[0..length)
+    static bool write(uint8_t address, const uint8_t* header, uint8_t headerLength,
+                      const uint8_t* data, uint8_t length) {
+        uint8_t total = headerLength + length;
+        if (total > kMaxTransfer || tx.space() < (uint8_t)(total + 2)) {
+            return false;
+        }
+        uint8_t head = tx.head;
+        tx.buffer[head++ & kWriteMask] = address << 1;
+        tx.buffer[head++ & kWriteMask] = total;
+        for (uint8_t i = 0; i < headerLength; i++) {
+            tx.buffer[head++ & kWriteMask] = header[i];
+        }
+        for (uint8_t i = 0; i < length; i++) {
+            tx.buffer[head++ & kWriteMask] = data[i];
+        }
+        tx.head = head;   // Publish the whole frame at once
+        return true;
+    }
+
+    // Queues a read of length bytes, fails while another read is not taken yet
+    static bool requestRead(uint8_t address, uint8_t length) {
+        if (readState != kReadIdle || length == 0 || length > ReadSize || tx.space() < 2) {
+            return false;
+        }
+        readLeft  = length;
+        readState = kReadBusy;
+        uint8_t head = tx.head;
+        tx.buffer[head++ & kWriteMask] = (address << 1) | 1;
+        tx.buffer[head++ & kWriteMask] = 0;
+        tx.head = head;
+        return true;
+    }
+
+    static ReadState readStatus() { return readState; }
+
+    // Copies a finished read out of the read ring and frees the read slot
+    static bool takeRead(uint8_t* data, uint8_t length) {
+        if (readState != kReadDone || rx.count() < length) {
+            return false;
+        }
+        for (uint8_t i = 0; i < length; i++) {
+            data[i] = rx.buffer[rx.tail & kReadMask];
+            rx.tail = rx.tail + 1;
+        }
+        readState = kReadIdle;
+        return true;
+    }
+
+    // Frees the read slot after kReadFailed
+    static void clearRead() {
+        rx.tail = rx.head;
+        readState = kReadIdle;
+    }
+
+    static uint8_t writeSpace() { return tx.space(); }
+
+    // Starts the bus if transactions are queued and the ISR is not already chaining them
+    static void update() {
+        if (!active && tx.count()) {
+            active = true;
+            TWCR = (1 << TWINT) | (1 << TWSTA) | (1 << TWEN) | (1 << TWIE);
+        }
+    }
+
+    // TWI state machine, called from I2C_STACK_BIND_ISR
+    static inline void isr() {
+        switch (TWSR & 0xF8) {
+            case kStart:
+            case kRepStart:
+                if (tx.count() >= 2) {
+                    address   = pop();
+                    writeLeft = pop();
+                    TWDR = address;
+                    TWCR = kRun;
+                } else {
+                    finish();
+                }
+                break;
+
+            case kMtSlaAck:
+            case kMtDataAck:
+                if (writeLeft) {
+                    TWDR = pop();
+                    writeLeft--;
+                    TWCR = kRun;
+                } else {
+                    finish();
+                }
+                break;
+
+            case kMtSlaNack:
+            case kMtDataNack:
+                tx.tail = tx.tail + writeLeft;   // Drop the rest of the frame
+                writeLeft = 0;
+                errors++;
+                finish();
+                break;
+
+            case kMrSlaAck:
+                TWCR = (readLeft > 1) ? (kRun | (1 << TWEA)) : kRun;
+                break;
+
+            case kMrDataAck:
+                push(TWDR);
+                TWCR = (readLeft > 1) ? (kRun | (1 << TWEA)) : kRun;
+                break;
+
+            case kMrDataNack:
+                push(TWDR);
+                readState = kReadDone;
+                finish();
+                break;
+
+            case kMrSlaNack:
+                readLeft  = 0;
+                readState = kReadFailed;
+                errors++;
+                finish();
+                break;
+
+            default:
+                finish();
+                break;
+        }
+    }
+
+    static volatile uint8_t errors;   // NACKed transactions since reset
+
+private:
+    static const uint8_t kWriteMask = WriteSize - 1;
+    static const uint8_t kReadMask  = ReadSize - 1;
+    static const uint8_t kRun       = (1 << TWINT) | (1 << TWEN) | (1 << TWIE);
+
+    static uint8_t pop() {
+        uint8_t tail = tx.tail;
+        uint8_t value = tx.buffer[tail & kWriteMask];
+        tx.tail = tail + 1;
+        return value;
+    }
+
+    static void push(uint8_t value) {
+        uint8_t head = rx.head;
+        rx.buffer[head & kReadMask] = value;
+        rx.head = head + 1;
+        readLeft--;
+    }
+
+    // STOP, followed directly by START when more transactions are queued
+    static void finish() {
+        if (tx.count()) {
+            TWCR = kRun | (1 << TWSTO) | (1 << TWSTA);
+        } else {
+            TWCR = kRun | (1 << TWSTO);
+            active = false;
+        }
+    }
+
+    static Ring<WriteSize>    tx;
+    static Ring<ReadSize>     rx;
+    static uint8_t            address;
+    static uint8_t            writeLeft;
+    static volatile uint8_t   readLeft;
+    static volatile ReadState readState;
+    static volatile bool      active;
+};
+
+template <uint32_t C, uint32_t S, uint8_t W, uint8_t R> Ring<W>                  Bus<C, S, W, R>::tx;
+template <uint32_t C, uint32_t S, uint8_t W, uint8_t R> Ring<R>                  Bus<C, S, W, R>::rx;
+template <uint32_t C, uint32_t S, uint8_t W, uint8_t R> uint8_t                  Bus<C, S, W, R>::address;
+template <uint32_t C, uint32_t S, uint8_t W, uint8_t R> uint8_t                  Bus<C, S, W, R>::writeLeft;
+template <uint32_t C, uint32_t S, uint8_t W, uint8_t R> volatile uint8_t         Bus<C, S, W, R>::readLeft;
+template <uint32_t C, uint32_t S, uint8_t W, uint8_t R> volatile ReadState       Bus<C, S, W, R>::readState;
+template <uint32_t C, uint32_t S, uint8_t W, uint8_t R> volatile bool            Bus<C, S, W, R>::active;
+template <uint32_t C, uint32_t S, uint8_t W, uint8_t R> volatile uint8_t         Bus<C, S, W, R>::errors;
+
+} // namespace i2c
+
+// Binds the TWI interrupt to a bus type, use in exactly one translation unit
+#define I2C_STACK_BIND_ISR(BusType) ISR(TWI_vect) { BusType::isr(); }
+
+#endif // I2C_BUS_H
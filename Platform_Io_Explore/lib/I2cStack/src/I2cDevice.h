@@ -0,0 +1,164 @@
+/*_____________________________{I2C_DEVICE_H}_____________________________________________________
+ Author: Abdelrahman Selim
+ Brief : Compile time device set, C++ port of Atmega128A.X/i2c_device.c
+
+ Every device is a type with its own read queue. The scheduler takes the device set
+ as template parameters and serves their reads round robin. Devices that are not
+ listed are never instantiated and cost no flash or SRAM.
+ _________________________________________________________________________________________*/
+#ifndef I2C_STACK_DEVICE_H
+#define I2C_STACK_DEVICE_H
+
+#include "I2cBus.h"
+
+namespace i2c {
+
+// One pending read request
+struct Request {
+    uint16_t reg;
+    uint8_t  length;
+    uint8_t* data;
+};
+
+template <typename BusT, uint8_t Address, uint8_t RegisterWidth, uint8_t QueueSize = 8>
+class Device {
+    static_assert(Address < 0x80, "I2C addresses are 7 bits");
+    static_assert(RegisterWidth == 1 || RegisterWidth == 2, "register address width must be 1 or 2 bytes");
+    static_assert(QueueSize >= 1 && QueueSize <= 128 && (QueueSize & (QueueSize - 1)) == 0,
+                  "queue size must be a power of two up to 128");
+
+public:
+    typedef BusT Bus;
+    static const uint8_t kAddress = Address;
+
+    // Queues a read of length bytes starting at register reg. A read longer than
+    // the receive ring of the bus is queued as several requests, either all of
+    // them or none, like i2c_DeviceRead()
+    static bool read(uint16_t reg, uint8_t length, uint8_t* data) {
+        uint8_t pieces = (length + BusT::kMaxRead - 1) / BusT::kMaxRead;
+        if (length == 0 || (uint8_t)(head - tail) + pieces > QueueSize) {
+            return false;
+        }
+        while (length) {
+            uint8_t piece = (length > BusT::kMaxRead) ? BusT::kMaxRead : length;
+            Request& request = queue[head & kMask];
+            request.reg    = reg;
+            request.length = piece;
+            request.data   = data;
+            head++;
+            reg    += piece;
+            data   += piece;
+            length -= piece;
+        }
+        return true;
+    }
+
+    // Queues a write of length bytes starting at register reg
+    static bool write(uint16_t reg, const uint8_t* data, uint8_t length) {
+        uint8_t header[RegisterWidth];
+        registerBytes(reg, header);
+        return BusT::write(Address, header, RegisterWidth, data, length);
+    }
+
+    static bool pending() { return head != tail; }
+
+    // Scheduler hooks
+    // The register address frame and the read request go into the write ring
+    // together or not at all, a header without its read would be sent again on
+    // every pass
+    static bool startRead() {
+        if (head == tail || BusT::writeSpace() < RegisterWidth + 4 || BusT::readStatus() != kReadIdle) {
+            return false;
+        }
+        const Request& request = queue[tail & kMask];
+        uint8_t header[RegisterWidth];
+        registerBytes(request.reg, header);
+        return BusT::write(Address, header, RegisterWidth, 0, 0) && BusT::requestRead(Address, request.length);
+    }
+
+    static bool finishRead() {
+        const Request& request = queue[tail & kMask];
+        if (BusT::readStatus() == kReadFailed) {
+            BusT::clearRead();   // Request is dropped, the bus error counter records it
+        } else if (!BusT::takeRead(request.data, request.length)) {
+            return false;
+        }
+        tail++;
+        return true;
+    }
+
+private:
+    static const uint8_t kMask = QueueSize - 1;
+
+    static void registerBytes(uint16_t reg, uint8_t* header) {
+        if (RegisterWidth == 2) {
+            header[0] = reg >> 8;
+            header[RegisterWidth - 1] = (uint8_t)reg;
+        } else {
+            header[0] = (uint8_t)reg;
+        }
+    }
+
+    static Request queue[QueueSize];
+    static uint8_t head;
+    static uint8_t tail;
+};
+
+template <typename B, uint8_t A, uint8_t W, uint8_t Q> Request Device<B, A, W, Q>::queue[Q];
+template <typename B, uint8_t A, uint8_t W, uint8_t Q> uint8_t Device<B, A, W, Q>::head;
+template <typename B, uint8_t A, uint8_t W, uint8_t Q> uint8_t Device<B, A, W, Q>::tail;
+
+// Runtime index -> device dispatch over the compile time device set
+template <typename... Devices> struct Dispatch;
+
+template <> struct Dispatch<> {
+    static bool startRead(uint8_t)  { return false; }
+    static bool finishRead(uint8_t) { return false; }
+};
+
+template <typename First, typename... Rest>
+struct Dispatch<First, Rest...> {
+    static bool startRead(uint8_t index) {
+        return index == 0 ? First::startRead() : Dispatch<Rest...>::startRead(index - 1);
+    }
+    static bool finishRead(uint8_t index) {
+        return index == 0 ? First::finishRead() : Dispatch<Rest...>::finishRead(index - 1);
+    }
+};
+
+template <typename BusT, typename... Devices>
+class Scheduler {
+    static const uint8_t kCount = sizeof...(Devices);
+    static const uint8_t kNone  = 0xFF;
+    static_assert(kCount > 0 && kCount < kNone, "scheduler needs at least one device");
+
+public:
+    // Call periodically from the main loop
+    static void update() {
+        if (active != kNone && Dispatch<Devices...>::finishRead(active)) {
+            active = kNone;
+        }
+        if (active == kNone && BusT::readStatus() == kReadIdle) {
+            for (uint8_t i = 0; i < kCount; i++) {
+                uint8_t index = next;
+                next = (next + 1 == kCount) ? 0 : next + 1;
+                if (Dispatch<Devices...>::startRead(index)) {
+                    active = index;
+                    break;
+                }
+            }
+        }
+        BusT::update();
+    }
+
+private:
+    static uint8_t next;
+    static uint8_t active;
+};
+
+template <typename B, typename... D> uint8_t Scheduler<B, D...>::next;
+template <typename B, typename... D> uint8_t Scheduler<B, D...>::active = Scheduler<B, D...>::kNone;
+
+} // namespace i2c
+
+#endif // I2C_STACK_DEVICE_H
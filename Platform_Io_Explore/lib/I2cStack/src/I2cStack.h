@@ -0,0 +1,27 @@
+/*_____________________________{I2C_STACK_H}_____________________________________________________
+ Author: Abdelrahman Selim
+ Brief : Compile time configured I2C stack for ATmega128 boards
+
+ Example board configuration (8 MHz, 100 kHz, 24C32 + DS1307):
+
+     typedef i2c::Bus<F_CPU, i2c::kStandardMode, 64, 32>   Bus;
+     typedef i2c::Device<Bus, 0x50, 2, 16>                 Eeprom24C32;
+     typedef i2c::Device<Bus, 0x68, 1, 8>                  Ds1307;
+     typedef i2c::Scheduler<Bus, Eeprom24C32, Ds1307>      Scheduler;
+     I2C_STACK_BIND_ISR(Bus)
+
+     Bus::init();
+     Ds1307::read(0x00, 7, timeBuffer);
+     for (;;) { Scheduler::update(); }
+
+ Impossible configurations (TWBR out of range, non power of two buffers, bad
+ register widths) fail the build with a static_assert.
+ _________________________________________________________________________________________*/
+#ifndef I2C_STACK_H
+#define I2C_STACK_H
+
+#include "I2cBitRate.h"
+#include "I2cBus.h"
+#include "I2cDevice.h"
+
+#endif // I2C_STACK_H
@@ -0,0 +1,21 @@
+/*_____________________________{HOST ARDUINO.H}_____________________________________________________
+ Brief : The part of the Arduino core AsyncWire uses, for the host tests
+
+ micros() is bus time: the test suite defines it on top of twi_model.c.
+ _________________________________________________________________________________________*/
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+unsigned long micros(void);
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_ARDUINO_H
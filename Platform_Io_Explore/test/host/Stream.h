@@ -0,0 +1,47 @@
+/*_____________________________{HOST STREAM.H}_____________________________________________________
+ Brief : Print and Stream of the Arduino core, as far as TwoWire uses them
+ _________________________________________________________________________________________*/
+#ifndef HOST_STREAM_H
+#define HOST_STREAM_H
+
+#include "Arduino.h"
+
+class Print {
+public:
+    virtual size_t write(uint8_t data) = 0;
+    virtual size_t write(const uint8_t* data, size_t quantity) {
+        size_t written = 0;
+        while (quantity--) {
+            written += write(*data++);
+        }
+        return written;
+    }
+    size_t write(const char* text) {
+        return write((const uint8_t*) text, strlen(text));
+    }
+    int getWriteError() {
+        return writeError;
+    }
+    void clearWriteError() {
+        writeError = 0;
+    }
+
+protected:
+    void setWriteError(int error = 1) {
+        writeError = error;
+    }
+
+private:
+    int writeError = 0;
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    virtual void flush() {
+    }
+};
+
+#endif // HOST_STREAM_H
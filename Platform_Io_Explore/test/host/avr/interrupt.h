@@ -0,0 +1,19 @@
+/*_____________________________{HOST AVR/INTERRUPT.H}_____________________________________________________
+ Brief : Interrupt vectors and the I flag for the host tests
+
+ A vector is a plain function the bus models call. cli() and sei() only move
+ the I bit of SREG; the models do not run an interrupt while it is clear.
+ _________________________________________________________________________________________*/
+#ifndef HOST_AVR_INTERRUPT_H
+#define HOST_AVR_INTERRUPT_H
+
+#include <avr/io.h>
+
+#define ISR(vector, ...)    void vector(void)
+#define ISR_NAKED
+#define ISR_NOBLOCK
+
+#define cli()   do { SREG &= (uint8_t) ~(1 << SREG_I); } while (0)
+#define sei()   do { SREG |= (1 << SREG_I); } while (0)
+
+#endif // HOST_AVR_INTERRUPT_H
@@ -0,0 +1,117 @@
+/*_____________________________{HOST AVR/IO.H}_____________________________________________________
+ Brief : ATmega128A registers for the host tests
+
+ Every register is a byte of host_regs[], at its data space address. TWCR and
+ PINE are read through the bus models (twi_model.c, the software bus test),
+ which run the hardware on each access.
+ _________________________________________________________________________________________*/
+#ifndef HOST_AVR_IO_H
+#define HOST_AVR_IO_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+extern volatile uint8_t host_regs[0x100];
+volatile uint8_t* host_twcr(void);
+uint8_t host_pine(void);
+#ifdef __cplusplus
+}
+#endif
+
+#define _SFR_MEM8(addr)     (host_regs[(addr)])
+#define _SFR_MEM16(addr)    (*(volatile uint16_t*) &host_regs[(addr)])
+#define RAMEND              0x10FF
+
+// TWI
+#define TWBR    _SFR_MEM8(0x70)
+#define TWSR    _SFR_MEM8(0x71)
+#define TWAR    _SFR_MEM8(0x72)
+#define TWDR    _SFR_MEM8(0x73)
+#define TWCR    (*host_twcr())
+#define TWINT   7
+#define TWEA    6
+#define TWSTA   5
+#define TWSTO   4
+#define TWWC    3
+#define TWEN    2
+#define TWIE    0
+#define TWPS1   1
+#define TWPS0   0
+
+// Status register, bit 7 is the global interrupt enable
+#define SREG    _SFR_MEM8(0x5F)
+#define SREG_I  7
+
+// Ports
+#define PORTB   _SFR_MEM8(0x38)
+#define DDRB    _SFR_MEM8(0x37)
+#define PINB    _SFR_MEM8(0x36)
+#define PORTE   _SFR_MEM8(0x23)
+#define DDRE    _SFR_MEM8(0x22)
+#define PINE    (host_pine())
+#define PE2     2
+#define PE3     3
+#define PE4     4
+#define PE5     5
+
+// Analog comparator
+#define ACSR    _SFR_MEM8(0x28)
+#define ACD     7
+#define ACBG    6
+#define ACO     5
+#define ACI     4
+#define ACIE    3
+#define ACIS1   1
+#define ACIS0   0
+
+// Timers
+#define TIMSK   _SFR_MEM8(0x57)
+#define TIFR    _SFR_MEM8(0x56)
+#define OCIE2   7
+#define TOIE1   2
+#define OCIE1A  4
+#define TCCR1A  _SFR_MEM8(0x4F)
+#define TCCR1B  _SFR_MEM8(0x4E)
+#define TCNT1   _SFR_MEM16(0x4C)
+#define OCR1A   _SFR_MEM16(0x4A)
+#define CS12    2
+#define CS11    1
+#define CS10    0
+#define WGM12   3
+#define TCCR2   _SFR_MEM8(0x45)
+#define TCNT2   _SFR_MEM8(0x44)
+#define OCR2    _SFR_MEM8(0x43)
+#define WGM21   3
+#define CS22    2
+#define CS21    1
+#define CS20    0
+#define TCCR3A  _SFR_MEM8(0x8B)
+#define TCCR3B  _SFR_MEM8(0x8A)
+#define TCNT3   _SFR_MEM16(0x88)
+#define CS32    2
+#define CS31    1
+#define CS30    0
+
+// USART0
+#define UDR0    _SFR_MEM8(0x2C)
+#define UCSR0A  _SFR_MEM8(0x2B)
+#define UCSR0B  _SFR_MEM8(0x2A)
+#define UCSR0C  _SFR_MEM8(0x95)
+#define UBRR0L  _SFR_MEM8(0x29)
+#define UBRR0H  _SFR_MEM8(0x90)
+#define U2X0    1
+#define UDRIE0  5
+#define TXEN0   3
+#define UCSZ01  2
+#define UCSZ00  1
+
+// Reset causes
+#define MCUCSR  _SFR_MEM8(0x54)
+#define WDRF    3
+#define BORF    2
+#define EXTRF   1
+#define PORF    0
+
+#endif // HOST_AVR_IO_H
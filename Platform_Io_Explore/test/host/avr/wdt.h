@@ -0,0 +1,14 @@
+/*_____________________________{HOST AVR/WDT.H}_____________________________________________________
+ Brief : Watchdog for the host tests, a reset ends the run in host_watchdogReset()
+ _________________________________________________________________________________________*/
+#ifndef HOST_AVR_WDT_H
+#define HOST_AVR_WDT_H
+
+#define WDTO_15MS   0
+
+void host_watchdogReset(void);
+
+#define wdt_enable(timeout) host_watchdogReset()
+#define wdt_reset()
+
+#endif // HOST_AVR_WDT_H
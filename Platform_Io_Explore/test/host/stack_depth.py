@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+"""Deepest stack of the firmware from the call graph of the host compiler.
+
+Builds every source of Atmega128A.X with gcc -Os -fcallgraph-info=su and the
+host headers of this directory, with the trace, the statistics, the soft bus
+and the stack monitor enabled, then walks the call graph from main() and from
+each ISR. Calls through an i2c_Bus_t go to every function of the bus tables.
+The interrupts do not nest (no ISR_NOBLOCK), so the worst case is the main
+chain plus the deepest ISR.
+
+The frames are those of the host (8-byte return addresses, 16-byte alignment),
+not of the AVR: the chain shows where the stack goes deep, the byte counts do
+not bound the target.
+
+    python3 test/host/stack_depth.py
+"""
+import glob
+import os
+import re
+import subprocess
+import tempfile
+HOST=os.path.dirname(os.path.abspath(__file__))
+DRIVER=os.path.join(HOST,'..','..','..','Atmega128A.X')
+FLAGS=['-Os','-std=gnu99','-c','-w','-funsigned-char','-DF_CPU=8000000UL','-DUNIT_TEST','-I'+HOST,'-I'+DRIVER,
+ '-DTRACE_ENABLE','-DI2C_STATS_ENABLE','-DI2C_SOFT_ENABLE','-DSTACK_MONITOR_ENABLE','-fcallgraph-info=su']
+size={};edges={}
+with tempfile.TemporaryDirectory() as out:
+    for src in sorted(glob.glob(os.path.join(DRIVER,'*.c'))):
+        obj=os.path.join(out,os.path.basename(src)[:-2]+'.o')
+        subprocess.run(['gcc']+FLAGS+[src,'-o',obj],check=True)
+    for ci in glob.glob(os.path.join(out,'*.ci')):
+        for l in open(ci):
+            m=re.match(r'node: \{ title: "([^"]+)" label: "[^"]*\\n(\d+) bytes \((\w+)',l)
+            if m:
+                assert m.group(3)=='static', m.group(1)+' has a dynamic frame'
+                size[m.group(1)]=int(m.group(2))
+            m=re.match(r'edge: \{ sourcename: "([^"]+)" targetname: "([^"]+)"',l)
+            if m: edges.setdefault(m.group(1),set()).add(m.group(2))
+# Bus tables: every function of i2c_TwiBus and i2c_SoftBus is a target of an indirect call
+bus=set()
+for src in ('i2c_device.c','i2c_soft.c'):
+    for table in re.findall(r'const i2c_Bus_t \w+ = \{(.*?)\};',open(os.path.join(DRIVER,src)).read(),re.S):
+        bus|={f for f in re.findall(r'\b(i2c_\w+)\b',table)}
+def node(f):
+    if f in size: return f
+    local=[k for k in size if k.endswith(':'+f)]
+    return local[0] if local else f
+edges['__indirect_call']={node(f) for f in bus}
+size['__indirect_call']=0
+memo={}
+def deep(f,path=()):
+    assert f not in path, 'recursion through '+f
+    if f not in memo:
+        best=(0,[])
+        for t in edges.get(f,()):
+            d=deep(t,path+(f,))
+            if d[0]>best[0]: best=d
+        memo[f]=(size.get(f,0)+best[0],[f]+best[1])
+    return memo[f]
+total,chain=deep('main')
+print('main %d bytes: %s'%(total,' > '.join(c.split(':')[-1] for c in chain if c!='__indirect_call')))
+isrs=sorted(f for f in size if f.endswith('_vect'))
+worst=0
+for isr in isrs:
+    d,c=deep(isr)
+    worst=max(worst,d)
+    print('%s %d bytes: %s'%(isr,d,' > '.join(x.split(':')[-1] for x in c)))
+print('worst case %d bytes (main + deepest ISR), host frames'%(total+worst))
@@ -0,0 +1,99 @@
+#!/usr/bin/env python3
+"""Cycle count of the naked TWI_vect fast path (Atmega128A.X/i2c_driver.c).
+
+Takes the inline assembly of ISR(TWI_vect, ISR_NAKED) from the driver source,
+runs it on a small AVR model and checks the MT data and MR data paths: the
+buffer byte moved, the tail/head wrap at the buffer size, the length counted
+down, TWEA cleared before the last byte read, and every register and SREG
+restored. Any other status must leave for the C handler. Prints the cycles
+of each path.
+
+    python3 test/host/twi_fast_isr.py
+"""
+import os
+import re
+DRIVER=os.path.join(os.path.dirname(os.path.abspath(__file__)),'..','..','..','Atmega128A.X')
+src=open(os.path.join(DRIVER,'i2c_driver.c')).read()
+hdr=open(os.path.join(DRIVER,'i2c_driver.h')).read()
+SIZE={k:int(re.search(r'#define '+k+r'\s+(\d+)',hdr).group(1)) for k in ('I2C_WRITE_BUFFER_SIZE','I2C_READ_BUFFER_SIZE')}
+body=src[src.index('ISR(TWI_vect, ISR_NAKED)'):]
+body=body[:body.index('    );\n}')]
+lines=re.findall(r'^\s*"([^"]*)\\n\\t"', body, re.M)
+# memory model
+SYM={'i2c_WriteBuffer':0x200,'i2c_ReadBuffer':0x300,'WriteDataLength':0x100,'i2c_WriteBufferTail':0x101,'i2c_ReadBufferHead':0x102,'i2c_ReadDataLength':0x103}
+TWINT,TWEA,TWEN=7,6,2
+OPS={'sreg':0x3F,'twsr':0x71,'twdr':0x73,'twcr':0x74,'mtData':0x28,'mrData':0x50,'twint':1<<TWINT,
+ 'twAck':(1<<TWINT)|(1<<TWEN)|(1<<TWEA),'twNack':(1<<TWINT)|(1<<TWEN),'twNoAck':0xff&~(1<<TWEA),
+ 'wlen':'WriteDataLength','wtail':'i2c_WriteBufferTail','wbuf':'i2c_WriteBuffer','wsize':SIZE['I2C_WRITE_BUFFER_SIZE'],
+ 'rhead':'i2c_ReadBufferHead','rlen':'i2c_ReadDataLength','rbuf':'i2c_ReadBuffer','rsize':SIZE['I2C_READ_BUFFER_SIZE']}
+prog=[];labels={}
+for l in lines:
+    l=l.split('//')[0].strip()
+    m=re.match(r'(\d+):\s*(.*)',l)
+    if m: labels.setdefault(m.group(1),[]).append(len(prog)); l=m.group(2)
+    if not l: continue
+    l=re.sub(r'%\[(\w+)\]',lambda m:str(OPS[m.group(1)]),l)
+    prog.append(l)
+def val(e):
+    e=e.strip()
+    m=re.match(r'lo8\(-\((\w+)\)\)',e)
+    if m: return (-SYM[m.group(1)])&0xff
+    m=re.match(r'hi8\(-\((\w+)\)\)',e)
+    if m: return ((-SYM[m.group(1)])>>8)&0xff
+    if e in SYM: return SYM[e]
+    return int(e,0)
+def run(mem):
+    r=[0]*32; sp=0x10ff; C=Z=0; pc=0; cyc=4+3; sreg0=mem[0x5F]=0xA5
+    r[24]=0x11;r[30]=0x22;r[31]=0x33
+    while True:
+        ins=prog[pc]; pc+=1
+        op,*a=ins.replace(',',' ').split(); a=[x for x in a]
+        def R(x): return int(x[1:])
+        def br(cond,lab):
+            nonlocal pc,cyc
+            if cond:
+                d,t=lab[-1],lab[:-1]; tg=[i for i in labels[t] if (i>=pc if d=='f' else i<pc)]
+                pc=min(tg) if d=='f' else max(tg); cyc+=2
+            else: cyc+=1
+        if op=='push': mem[sp]=r[R(a[0])]; sp-=1; cyc+=2
+        elif op=='pop': sp+=1; r[R(a[0])]=mem[sp]; cyc+=2
+        elif op=='in': r[R(a[0])]=mem[0x20+val(a[1])]; cyc+=1
+        elif op=='out': mem[0x20+val(a[0])]=r[R(a[1])]; cyc+=1
+        elif op=='lds': r[R(a[0])]=mem[val(a[1])]; cyc+=2
+        elif op=='sts': mem[val(a[0])]=r[R(a[1])]; cyc+=2
+        elif op in('andi','ori'):
+            x=r[R(a[0])]; v=val(a[1]); x = x&v if op=='andi' else x|v; r[R(a[0])]=x; Z=x==0; cyc+=1
+        elif op=='cpi': x=r[R(a[0])]; v=val(a[1]); Z=x==v; C=x<v; cyc+=1
+        elif op=='subi': x=r[R(a[0])]; v=val(a[1]); C=x<v; x=(x-v)&0xff; Z=x==0; r[R(a[0])]=x; cyc+=1
+        elif op=='sbci': x=r[R(a[0])]; v=val(a[1])+C; C=x<v; x=(x-v)&0xff; r[R(a[0])]=x; cyc+=1
+        elif op=='ldi': r[R(a[0])]=val(a[1]); cyc+=1
+        elif op=='ld': r[R(a[0])]=mem[r[30]|r[31]<<8]; cyc+=2
+        elif op=='st': mem[r[30]|r[31]<<8]=r[R(a[1])]; cyc+=2
+        elif op=='inc': r[R(a[0])]=(r[R(a[0])]+1)&0xff; Z=r[R(a[0])]==0; cyc+=1
+        elif op=='dec': r[R(a[0])]=(r[R(a[0])]-1)&0xff; Z=r[R(a[0])]==0; cyc+=1
+        elif op=='clr': r[R(a[0])]=0; Z=1; cyc+=1
+        elif op=='breq': br(Z,a[0])
+        elif op=='brne': br(not Z,a[0])
+        elif op in('brcs','brlo'): br(C,a[0])
+        elif op=='rjmp': br(True,a[0])
+        elif op=='reti': cyc+=4; res='reti'; break
+        elif op=='jmp': cyc+=3; res='slow'; break
+        else: raise Exception(ins)
+    assert sp==0x10ff and mem[0x5F]==sreg0 and r[24]==0x11 and (res=='slow' or (r[30],r[31])==(0x22,0x33)), 'regs not restored'
+    return res,cyc
+def fresh(): return bytearray(0x1100)
+# MT data with bytes left, with wrap
+WSIZE,RSIZE=SIZE['I2C_WRITE_BUFFER_SIZE'],SIZE['I2C_READ_BUFFER_SIZE']
+for tail in (5,WSIZE-1):
+    m=fresh(); m[0x71]=0x28|3; m[0x100]=3; m[0x101]=tail; m[0x200+tail]=0x5A; m[0x74]=0x85
+    res,c=run(m); assert res=='reti' and m[0x73]==0x5A and m[0x100]==2 and m[0x101]==(tail+1)%WSIZE and m[0x74]==0x85, (res,m[0x73],m[0x101])
+    print('MT tail',tail,'cycles',c)
+m=fresh(); m[0x71]=0x28; m[0x100]=0; res,c=run(m); assert res=='slow' and m[0x100]==0; print('MT end -> C, overhead',c-7)
+for head,rlen in ((7,5),(RSIZE-1,2),(3,1)):
+    m=fresh(); m[0x71]=0x50; m[0x73]=0xC3; m[0x102]=head; m[0x103]=rlen; m[0x74]=0x85|(1<<TWEA)
+    res,c=run(m); assert res=='reti' and m[0x300+head]==0xC3 and m[0x102]==(head+1)%RSIZE and m[0x103]==rlen-1
+    want = 0x85|(1<<TWEA)|0x84 if rlen-1>1 else ((0x85|(1<<TWEA))&~(1<<TWEA))|0x84
+    assert m[0x74]==want,(hex(m[0x74]),hex(want))
+    print('MR head',head,'left',rlen-1,'cycles',c)
+for st in (0x08,0x18,0x30,0x40,0x58,0x00):
+    m=fresh(); m[0x71]=st; res,c=run(m); assert res=='slow'; print('status %02x -> C, overhead'%st,c-7)
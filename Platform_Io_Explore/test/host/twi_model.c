@@ -0,0 +1,289 @@
+/*_____________________________{TWI_MODEL_C}_____________________________________________________
+ Brief : Host model of the ATmega128A TWI with the EEPROM chips and the DS1307 attached
+
+ TWCR is a byte of host_regs[] that the model watches. Bit 1 of TWCR is
+ reserved on the chip; the model sets it together with TWINT when it raises
+ the flag, so a TWINT without it is one the firmware wrote: the command that
+ clears the flag and starts the next operation. Writing TWINT as 0 leaves the
+ flag up, as on the chip.
+ _________________________________________________________________________________________*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <avr/io.h>
+#include "twi_model.h"
+
+#define MODEL_TWCR          host_regs[0x74]
+#define MODEL_FLAG          0x02        // Reserved TWCR bit, marks the TWINT raised by the model
+#define MODEL_NONE          0
+#define MODEL_EEPROM        1
+#define MODEL_RTC           2
+#define MODEL_ASYNC_STEPS   4           // Bus steps per timer signal
+
+void TWI_vect(void);
+
+volatile uint8_t  host_regs[0x100];
+uint8_t           model_Eeprom[EEPROM_CHIPS][EEPROM_CHIP_SIZE];
+uint8_t           model_Rtc[MODEL_RTC_SIZE];
+volatile uint32_t model_Now;
+volatile uint16_t model_Starts;
+volatile uint16_t model_Pages;
+volatile uint16_t model_Torn;
+uint8_t           model_Absent;
+
+static int16_t  busCommand = -1;        // Command written and not run yet, -1 none
+static uint8_t  busStatus  = 0xF8;      // Status of the last operation
+static uint8_t  busIdle    = 1;
+static uint8_t  busFlag;                // TWINT up, the firmware has not answered it
+static uint8_t  busStepping;            // The firmware runs from inside a step (TWI_vect)
+static uint8_t  busAsync;
+
+static uint8_t  slave;                  // MODEL_NONE, MODEL_EEPROM or MODEL_RTC
+static uint8_t  slaveReading;
+static uint8_t  frameBytes;             // Bytes of the frame after the address
+static uint8_t  chip;
+static uint32_t chipPointer[EEPROM_CHIPS];
+static uint32_t chipBusyUntil[EEPROM_CHIPS];
+static uint8_t  rtcPointer;
+
+static uint8_t  page[EEPROM_PAGE_SIZE]; // Page latch of the chip being written
+static uint32_t pageBase;
+static uint8_t  pageOffset;
+static uint8_t  pageBytes;              // Data bytes latched by the frame on the wire
+
+// Idle bus and chips, the memories keep their contents. Powering the bus down
+// in the middle of a frame is the same as a frame without STOP.
+void model_Reset() {
+    busCommand = -1;
+    busStatus  = 0xF8;
+    busIdle    = 1;
+    busFlag    = 0;
+    slave      = MODEL_NONE;
+    frameBytes = 0;
+    pageBytes  = 0;
+    for (uint8_t i = 0; i < EEPROM_CHIPS; i++) {
+        chipBusyUntil[i] = 0;
+    }
+    MODEL_TWCR = 0;
+    TWSR = 0xF8;
+}
+
+uint8_t model_PageBytes() {
+    return pageBytes;
+}
+
+uint8_t model_EepromBusy(uint8_t chipIndex) {
+    return (int32_t)(model_Now - chipBusyUntil[chipIndex]) < 0;
+}
+
+// The page latch is programmed by a STOP only, a repeated START drops it
+static void frameEnd(uint8_t stop) {
+    if (slave == MODEL_EEPROM && pageBytes) {
+        if (stop) {
+            memcpy(&model_Eeprom[chip][pageBase], page, EEPROM_PAGE_SIZE);
+            chipBusyUntil[chip] = model_Now + EEPROM_WRITE_CYCLE_MS * 1000UL;
+            model_Pages++;
+        } else {
+            model_Torn++;
+        }
+    }
+    pageBytes  = 0;
+    slave      = MODEL_NONE;
+    frameBytes = 0;
+}
+
+static uint8_t slaveAddress(uint8_t sla) {
+    uint8_t address = sla >> 1;
+
+    slaveReading = sla & 1;
+    frameBytes = 0;
+    if (address >= EEPROM_24C32_ADDR && address < EEPROM_24C32_ADDR + EEPROM_CHIPS
+        && !model_EepromBusy(address - EEPROM_24C32_ADDR) && !(model_Absent & MODEL_ABSENT_EEPROM)) {
+        slave = MODEL_EEPROM;
+        chip  = address - EEPROM_24C32_ADDR;
+    } else if (address == MODEL_RTC_ADDR && !(model_Absent & MODEL_ABSENT_RTC)) {
+        slave = MODEL_RTC;
+    } else {
+        slave = MODEL_NONE;
+        return slaveReading ? TWI_MR_SLA_NACK : TWI_MT_SLA_NACK;
+    }
+    return slaveReading ? TWI_MR_SLA_ACK : TWI_MT_SLA_ACK;
+}
+
+static void slaveWrite(uint8_t data) {
+    if (slave == MODEL_RTC) {
+        if (frameBytes == 0) {
+            rtcPointer = data & (MODEL_RTC_SIZE - 1);
+        } else {
+            model_Rtc[rtcPointer] = data;
+            rtcPointer = (rtcPointer + 1) & (MODEL_RTC_SIZE - 1);
+        }
+    } else if (frameBytes < EEPROM_ADDRESS_WIDTH) {
+        chipPointer[chip] = ((chipPointer[chip] << 8) | data) & (EEPROM_CHIP_SIZE - 1);
+        if (frameBytes == EEPROM_ADDRESS_WIDTH - 1) {
+            pageBase   = chipPointer[chip] & ~(uint32_t)(EEPROM_PAGE_SIZE - 1);
+            pageOffset = chipPointer[chip] & (EEPROM_PAGE_SIZE - 1);
+            memcpy(page, &model_Eeprom[chip][pageBase], EEPROM_PAGE_SIZE);
+        }
+    } else {
+        page[pageOffset] = data;                    // Rolls over inside the page
+        pageOffset = (pageOffset + 1) & (EEPROM_PAGE_SIZE - 1);
+        pageBytes++;
+        chipPointer[chip] = pageBase + pageOffset;
+    }
+    frameBytes++;
+}
+
+static uint8_t slaveRead() {
+    uint8_t data;
+
+    if (slave == MODEL_RTC) {
+        data = model_Rtc[rtcPointer];
+        rtcPointer = (rtcPointer + 1) & (MODEL_RTC_SIZE - 1);
+    } else {
+        data = model_Eeprom[chip][chipPointer[chip]];
+        chipPointer[chip] = (chipPointer[chip] + 1) & (EEPROM_CHIP_SIZE - 1);
+    }
+    frameBytes++;
+    return data;
+}
+
+// Runs a command on the bus. Returns the new status, 0 after a STOP.
+static uint8_t busRun(uint8_t command) {
+    if (command & (1 << TWSTO)) {
+        model_Now += MODEL_BIT_US;
+        frameEnd(1);
+        busIdle = 1;
+        return 0;
+    }
+    if (command & (1 << TWSTA)) {
+        uint8_t status = busIdle ? TWI_START : TWI_REP_START;
+
+        model_Now += MODEL_BIT_US;
+        frameEnd(0);
+        busIdle = 0;
+        model_Starts++;
+        return status;
+    }
+    model_Now += 9 * MODEL_BIT_US;
+    switch (busStatus) {
+        case TWI_START:
+        case TWI_REP_START:
+            return slaveAddress(TWDR);
+        case TWI_MT_SLA_ACK:
+        case TWI_MT_DATA_ACK:
+            slaveWrite(TWDR);
+            return TWI_MT_DATA_ACK;
+        case TWI_MR_SLA_ACK:
+        case TWI_MR_DATA_ACK:
+            TWDR = slaveRead();
+            return (command & (1 << TWEA)) ? TWI_MR_DATA_ACK : TWI_MR_DATA_NACK;
+        default:
+            fprintf(stderr, "twi_model: byte sent after status 0x%02X, TWCR 0x%02X\n", busStatus, command);
+            abort();
+    }
+}
+
+// TWI_vect with the I bit cleared, TWINT reads 0 in it so a TWINT written
+// back is the next command
+static void busInterrupt() {
+    uint8_t control;
+
+    MODEL_TWCR &= (uint8_t) ~((1 << TWINT) | MODEL_FLAG);
+    SREG &= (uint8_t) ~(1 << SREG_I);
+    TWI_vect();
+    SREG |= (1 << SREG_I);
+    control = MODEL_TWCR;
+    if (control & (1 << TWINT)) {
+        busCommand = control;
+        busFlag    = 0;
+        MODEL_TWCR = control & ~(1 << TWINT);
+    } else {
+        MODEL_TWCR = control | (1 << TWINT) | MODEL_FLAG;
+    }
+}
+
+static void busStep() {
+    uint8_t control = MODEL_TWCR;
+
+    if (busFlag) {
+        if ((control & ((1 << TWINT) | MODEL_FLAG)) == (1 << TWINT)) {
+            busCommand = control;                       // TWINT written as 1
+            busFlag    = 0;
+            MODEL_TWCR = control & ~(1 << TWINT);
+        } else if (!(control & (1 << TWINT))) {
+            MODEL_TWCR = control | (1 << TWINT) | MODEL_FLAG;   // Written as 0, the flag stays
+        }
+        if (busFlag && (control & (1 << TWIE)) && (SREG & (1 << SREG_I))) {
+            busInterrupt();
+        }
+    } else if (busCommand < 0) {
+        MODEL_TWCR = control & ~((1 << TWINT) | MODEL_FLAG);  // Nothing to clear, TWINT reads 0
+        if (busIdle && (control & (1 << TWSTA)) && (control & (1 << TWEN))) {
+            busCommand = control;                       // START once the bus is free
+        }
+    }
+    if (busCommand < 0) {
+        model_Now++;
+        return;
+    }
+
+    uint8_t status = busRun((uint8_t)busCommand);
+
+    busCommand = -1;
+    if (status == 0) {
+        MODEL_TWCR &= (uint8_t) ~(1 << TWSTO);
+        return;
+    }
+    busStatus  = status;
+    TWSR       = status;
+    busFlag    = 1;
+    MODEL_TWCR |= (1 << TWINT) | MODEL_FLAG;
+    if ((MODEL_TWCR & (1 << TWIE)) && (SREG & (1 << SREG_I))) {
+        busInterrupt();
+    }
+}
+
+void model_Step() {
+    if (!busStepping) {
+        busStepping = 1;
+        busStep();
+        busStepping = 0;
+    }
+}
+
+// Busy waits of the firmware, the bus runs on meanwhile unless the timer runs it
+void host_delayUs(uint32_t us) {
+    uint32_t until = model_Now + us;
+
+    while (!busAsync && (int32_t)(model_Now - until) < 0) {
+        model_Step();
+    }
+}
+
+// Every access runs the bus one step, unless the timer does
+volatile uint8_t* host_twcr(void) {
+    if (!busAsync) {
+        model_Step();
+    }
+    return &MODEL_TWCR;
+}
+
+static void asyncTick(int signal) {
+    (void)signal;
+    for (uint8_t i = 0; i < MODEL_ASYNC_STEPS; i++) {
+        model_Step();
+    }
+}
+
+void model_Async(uint16_t periodUs) {
+    struct itimerval timer = { { 0, periodUs }, { 0, periodUs } };
+
+    busAsync = periodUs != 0;
+    if (busAsync) {
+        signal(SIGALRM, asyncTick);
+    }
+    setitimer(ITIMER_REAL, &timer, 0);
+}
@@ -0,0 +1,49 @@
+/*_____________________________{TWI_MODEL_H}_____________________________________________________
+ Brief : Host model of the ATmega128A TWI with the EEPROM chips and the DS1307 attached
+
+ The model plays the TWI hardware for Atmega128A.X/i2c_driver.c: it takes the
+ command the driver writes to TWCR, puts it on a 100 kHz bus, sets TWSR and
+ TWINT and runs ISR(TWI_vect) while TWIE and the I bit are set. With the
+ interrupt off the flag stays up for the polled paths (i2c_Preempt(),
+ i2c_PolledWrite()).
+
+ Slaves:
+ - EEPROM_CHIPS chips of EEPROM_PART from EEPROM_24C32_ADDR: page writes wrap
+   inside the page, are programmed on STOP only and take EEPROM_WRITE_CYCLE_MS,
+   during which the chip does not acknowledge its address.
+ - DS1307 at 0x68: 64 bytes of registers and RAM, the pointer wraps at 0x3F.
+ Any other address is not acknowledged, nor are the slaves set in
+ model_Absent (a part missing or dead on the board).
+
+ By default the bus runs one operation on every TWCR access and on every
+ model_Step(), so a test is repeatable. model_Async() runs it from a timer
+ signal instead, which interrupts the main loop between any two instructions.
+ _________________________________________________________________________________________*/
+#ifndef TWI_MODEL_H
+#define TWI_MODEL_H
+
+#include <stdint.h>
+#include "EEPROM_24C32.h"
+
+#define MODEL_BIT_US        10          // 100 kHz
+#define MODEL_RTC_ADDR      0x68
+#define MODEL_RTC_SIZE      64
+#define MODEL_ABSENT_EEPROM 0x01        // model_Absent bits
+#define MODEL_ABSENT_RTC    0x02
+
+extern uint8_t           model_Eeprom[EEPROM_CHIPS][EEPROM_CHIP_SIZE];
+extern uint8_t           model_Rtc[MODEL_RTC_SIZE];
+extern volatile uint32_t model_Now;             // Bus time in us
+extern volatile uint16_t model_Starts;          // STARTs and repeated STARTs
+extern volatile uint16_t model_Pages;           // EEPROM page writes programmed
+extern volatile uint16_t model_Torn;            // EEPROM frames ended without STOP, not programmed
+extern uint8_t           model_Absent;          // MODEL_ABSENT_* slaves that do not answer
+
+// Function prototypes
+void     model_Reset();                     // Idle bus and chips, memories kept
+void     model_Step();                      // Runs one bus operation if one is due
+uint8_t  model_PageBytes();                 // Data bytes of the EEPROM page write on the wire, 0 if none
+uint8_t  model_EepromBusy(uint8_t chip);    // 1 while the chip is in its write cycle
+void     model_Async(uint16_t periodUs);    // Run the bus from a timer signal, 0 stops it
+
+#endif // TWI_MODEL_H
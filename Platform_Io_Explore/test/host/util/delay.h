@@ -0,0 +1,15 @@
+/*_____________________________{HOST UTIL/DELAY.H}_____________________________________________________
+ Brief : Busy waits run the bus model for the time waited (twi_model.c), as
+         the TWI goes on while the CPU spins
+ _________________________________________________________________________________________*/
+#ifndef HOST_UTIL_DELAY_H
+#define HOST_UTIL_DELAY_H
+
+#include <stdint.h>
+
+void host_delayUs(uint32_t us);
+
+#define _delay_ms(ms)   host_delayUs((ms) * 1000UL)
+#define _delay_us(us)   host_delayUs(us)
+
+#endif // HOST_UTIL_DELAY_H
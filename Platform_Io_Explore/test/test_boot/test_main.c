@@ -0,0 +1,154 @@
+/*_____________________________{TEST_BOOT}_____________________________________________________
+ Brief : Time to ready and the boot deadline (user-047)
+
+ The main loop of main.c runs on the host TWI model with Timer1 following
+ the bus time, so boot_Report() gives the time the bus needs; the loop
+ itself costs nothing here. A part missing from the board is modelled by
+ model_Absent: it never acknowledges and its reads are retried until the
+ deadline gives the task up.
+ _________________________________________________________________________________________*/
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#include "../../../Atmega128A.X/i2c_driver.c"
+#include "../../../Atmega128A.X/i2c_device.c"
+#include "../../../Atmega128A.X/i2c_request_queue.c"
+#include "../../../Atmega128A.X/EEPROM_24C32.c"
+#include "../../../Atmega128A.X/ProgramDataHandler.c"
+#include "../../../Atmega128A.X/rtc_ds1307.c"
+#include "../../../Atmega128A.X/rtc_ds1307_low_level.c"
+#include "../../../Atmega128A.X/data_log.c"
+#include "../../../Atmega128A.X/delta_codec.c"
+#include "../../../Atmega128A.X/profile_store.c"
+#include "../../../Atmega128A.X/boot.c"
+#include "../../../Atmega128A.X/uart_trace.c"
+#include "../host/twi_model.c"
+
+#define RUN_LIMIT       2000000UL
+#define READY_TARGET_MS 100
+
+static uint8_t bootTime[7] = { 0, 0, 0, 1, 1, 1, 0 };
+static uint32_t bootStart;
+
+// One pass of the main loop of main.c, then one bus operation
+static void run() {
+    TCNT1 = (uint16_t)(((model_Now - bootStart) * (F_CPU / 1000000UL)) / BOOT_TIMER_DIV);
+    i2c_DeviceUpdate();
+    datalog_Update();
+    EEPROM_prefetchUpdate();
+    profile_Update();
+    if (!boot_Ready()) {
+        boot_Update();
+    }
+    model_Step();
+}
+
+static const boot_Report_t* boot() {
+    char line[96];
+
+    memset(&boot_Status, 0, sizeof(boot_Status));
+    bootStart = model_Now;
+    boot_Start(bootTime);
+    for (uint32_t i = 0; i < RUN_LIMIT && !boot_Ready(); i++) {
+        run();
+    }
+    TEST_ASSERT_TRUE(boot_Ready());
+    snprintf(line, sizeof(line), "ready %u ms: rtc %u, program %u, log %u, profile %u, failed 0x%02X",
+             boot_Report()->readyMs, boot_Report()->rtcMs, boot_Report()->programMs,
+             boot_Report()->logMs, boot_Report()->profileMs, boot_Report()->failed);
+    TEST_MESSAGE(line);
+    return boot_Report();
+}
+
+static void saveDefaultProgram() {
+    TEST_ASSERT_TRUE(EEPROM_saveProgramData(BOOT_GROUP, BOOT_PROGRAM, 100, 200, 5, 333, 400, 500, 600, 50, 700, 800));
+    for (uint32_t i = 0; i < RUN_LIMIT && EEPROM_saveBusy(); i++) {
+        run();
+    }
+}
+
+void setUp(void) {
+    model_Absent = 0;
+}
+
+void tearDown(void) {
+}
+
+// First boot on blank parts, the slowest healthy one: the DS1307 is reset
+// (registers and 56 bytes of RAM written) and the program table is empty.
+// Then a boot on the initialized parts publishes the stored program.
+static void test_healthy_boot_is_under_target(void) {
+    const boot_Report_t* report;
+
+    memset(model_Eeprom, 0xFF, sizeof(model_Eeprom));
+    memset(model_Rtc, 0, sizeof(model_Rtc));
+    report = boot();
+    TEST_ASSERT_EQUAL_UINT(BOOT_TASK_ALL, report->done);
+    TEST_ASSERT_EQUAL_UINT(0, report->failed);
+    TEST_ASSERT_EQUAL_UINT(DS1307_INIT_RESET, report->rtcState);
+    TEST_ASSERT_EQUAL_UINT(PROGRAM_SHADOW_INVALID, report->programStatus);
+    TEST_ASSERT_LESS_OR_EQUAL(READY_TARGET_MS, report->readyMs);
+
+    saveDefaultProgram();
+    report = boot();
+    TEST_ASSERT_EQUAL_UINT(0, report->failed);
+    TEST_ASSERT_EQUAL_UINT(DS1307_INIT_KEPT, report->rtcState);
+    TEST_ASSERT_EQUAL_UINT(PROGRAM_SHADOW_READY, report->programStatus);
+    TEST_ASSERT_EQUAL_UINT(333, BurningTemp);
+    TEST_ASSERT_LESS_OR_EQUAL(READY_TARGET_MS, report->readyMs);
+}
+
+// Without the DS1307 the boot is ready at the deadline with the clock marked
+// failed, and the log too as it takes its time base from the clock; the
+// program and the profiles are there on time
+static void test_missing_rtc_fails_at_the_deadline(void) {
+    const boot_Report_t* report;
+
+    model_Absent = MODEL_ABSENT_RTC;
+    report = boot();
+    TEST_ASSERT_EQUAL_UINT(BOOT_TASK_RTC | BOOT_TASK_LOG, report->failed);
+    TEST_ASSERT_EQUAL_UINT(BOOT_TASK_PROGRAM | BOOT_TASK_PROFILE, report->done);
+    TEST_ASSERT_EQUAL_UINT(DS1307_INIT_FAILED, report->rtcState);
+    TEST_ASSERT_EQUAL_UINT(PROGRAM_SHADOW_READY, report->programStatus);
+    TEST_ASSERT_TRUE(report->readyMs >= BOOT_TASK_TIMEOUT_MS - 1 && report->readyMs <= BOOT_TASK_TIMEOUT_MS + 5);
+    TEST_ASSERT_LESS_OR_EQUAL(READY_TARGET_MS, report->profileMs);
+}
+
+// The blocking init gives up the same way instead of spinning forever
+static void test_blocking_init_gives_up(void) {
+    model_Absent = MODEL_ABSENT_RTC;
+    TEST_ASSERT_EQUAL_UINT(OPERATION_FAILED, DS1307_init(bootTime, CLOCK_RUN, NO_FORCE_RESET));
+    TEST_ASSERT_EQUAL_UINT(DS1307_INIT_FAILED, DS1307_init_state());
+
+    model_Absent = 0;
+    TEST_ASSERT_EQUAL_UINT(OPERATION_FAILED, DS1307_init(bootTime, CLOCK_RUN, NO_FORCE_RESET));
+    TEST_ASSERT_EQUAL_UINT(DS1307_INIT_KEPT, DS1307_init_state());
+}
+
+// Without the EEPROM the clock still comes up and the controller starts at
+// the deadline on its built-in program (left last: the EEPROM tasks keep
+// retrying in the background)
+static void test_missing_eeprom_fails_at_the_deadline(void) {
+    const boot_Report_t* report;
+    uint16_t burning = BurningTemp;
+
+    model_Absent = MODEL_ABSENT_EEPROM;
+    report = boot();
+    TEST_ASSERT_EQUAL_UINT(BOOT_TASK_PROGRAM | BOOT_TASK_LOG | BOOT_TASK_PROFILE, report->failed);
+    TEST_ASSERT_EQUAL_UINT(BOOT_TASK_RTC, report->done);
+    TEST_ASSERT_EQUAL_UINT(DS1307_INIT_KEPT, report->rtcState);
+    TEST_ASSERT_EQUAL_UINT(PROGRAM_SHADOW_LOADING, report->programStatus);
+    TEST_ASSERT_TRUE(report->readyMs >= BOOT_TASK_TIMEOUT_MS - 1 && report->readyMs <= BOOT_TASK_TIMEOUT_MS + 5);
+    TEST_ASSERT_EQUAL_UINT(burning, BurningTemp);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    model_Reset();
+    RUN_TEST(test_healthy_boot_is_under_target);
+    RUN_TEST(test_missing_rtc_fails_at_the_deadline);
+    RUN_TEST(test_blocking_init_gives_up);
+    RUN_TEST(test_missing_eeprom_fails_at_the_deadline);
+    return UNITY_END();
+}
@@ -0,0 +1,142 @@
+/*_____________________________{TEST_DATA_LOG}_____________________________________________________
+ Brief : Write head recovery of the data log on a 24C256 (user-043), page layout (user-035)
+
+ The log region runs from DATALOG_REGION_START to the end of the chip, more
+ than 256 pages, so the 8-bit sequence numbers wrap inside it. The pages are
+ filled as a log that wrapped around with its head at the page under test;
+ after recovery the next page must land there with the next sequence.
+ _________________________________________________________________________________________*/
+#define EEPROM_PART     EEPROM_PART_24C256
+
+#include <string.h>
+#include <unity.h>
+
+#include "../../../Atmega128A.X/i2c_driver.c"
+#include "../../../Atmega128A.X/i2c_device.c"
+#include "../../../Atmega128A.X/i2c_request_queue.c"
+#include "../../../Atmega128A.X/EEPROM_24C32.c"
+#include "../../../Atmega128A.X/rtc_ds1307.c"
+#include "../../../Atmega128A.X/rtc_ds1307_low_level.c"
+#include "../../../Atmega128A.X/delta_codec.c"
+#include "../../../Atmega128A.X/data_log.c"
+#include "../../../Atmega128A.X/uart_trace.c"
+#include "../host/twi_model.c"
+
+#define RUN_LIMIT       300000UL
+#define FIRST_SEQUENCE  200
+
+static void run() {
+    i2c_DeviceUpdate();
+    datalog_Update();
+    model_Step();
+}
+
+static void start() {
+    datalog_Init();
+    for (uint32_t i = 0; i < RUN_LIMIT && !datalog_Ready(); i++) {
+        run();
+    }
+    TEST_ASSERT_TRUE(datalog_Ready());
+}
+
+static void append(uint32_t elapsed, int16_t value) {
+    for (uint32_t i = 0; i < RUN_LIMIT && !datalog_Append(elapsed, value); i++) {
+        run();
+    }
+}
+
+static void flush() {
+    uint32_t i;
+
+    while (!datalog_Flush()) {
+        run();
+    }
+    for (i = 0; i < RUN_LIMIT && (eeprom_blockBusy() || eeprom_writeQueued()); i++) {
+        run();
+    }
+}
+
+static void checkHead(uint16_t head) {
+    uint8_t* page;
+
+    memset(model_Eeprom, 0xFF, sizeof(model_Eeprom));
+    for (uint16_t p = 0; p < DATALOG_PAGES; p++) {
+        page = &model_Eeprom[0][DATALOG_REGION_START + p * DATALOG_PAGE_SIZE];
+        page[DATALOG_HDR_MARK] = DATALOG_PAGE_MARK;
+        page[DATALOG_HDR_SEQUENCE] = (uint8_t)(FIRST_SEQUENCE + p - ((p < head) ? 0 : DATALOG_PAGES));
+        page[DATALOG_HDR_COUNT] = 0;
+    }
+    start();
+    append(10, 5);
+    flush();
+
+    page = &model_Eeprom[0][DATALOG_REGION_START + (head % DATALOG_PAGES) * DATALOG_PAGE_SIZE];
+    TEST_ASSERT_EQUAL_HEX8(DATALOG_PAGE_MARK, page[DATALOG_HDR_MARK]);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)(FIRST_SEQUENCE + head), page[DATALOG_HDR_SEQUENCE]);
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+static void test_region_fills_the_chip(void) {
+    TEST_ASSERT_EQUAL_UINT((32768UL - DATALOG_REGION_START) / DATALOG_PAGE_SIZE, DATALOG_PAGES);
+}
+
+static void test_head_at_the_start(void) {
+    checkHead(0);
+}
+
+static void test_head_past_the_sequence_wrap(void) {
+    checkHead(600);
+}
+
+static void test_head_at_the_last_page(void) {
+    checkHead(DATALOG_PAGES - 1);
+}
+
+// A second sample at the same time as the first one, while the page has no
+// period yet, must not be stored as if it came one period later: it opens a
+// page of its own at that time
+static void test_repeated_time_opens_a_page(void) {
+    const uint8_t* first = &model_Eeprom[0][DATALOG_REGION_START];
+    const uint8_t* second = first + DATALOG_PAGE_SIZE;
+    codec_Decoder_t dec;
+    int16_t value;
+
+    memset(model_Eeprom, 0xFF, sizeof(model_Eeprom));
+    start();
+    append(100, 10);
+    append(100, 11);
+    append(104, 12);
+    append(108, 13);
+    flush();
+
+    TEST_ASSERT_EQUAL_UINT(1, first[DATALOG_HDR_COUNT]);
+    TEST_ASSERT_EQUAL_INT(10, (int16_t)(first[DATALOG_HDR_VALUE] | (first[DATALOG_HDR_VALUE + 1] << 8)));
+    TEST_ASSERT_EQUAL_HEX8(DATALOG_PAGE_MARK, second[DATALOG_HDR_MARK]);
+    TEST_ASSERT_EQUAL_MEMORY(&first[DATALOG_HDR_TIME], &second[DATALOG_HDR_TIME], 4);
+    TEST_ASSERT_EQUAL_UINT(4, second[DATALOG_HDR_PERIOD]);
+    TEST_ASSERT_EQUAL_UINT(3, second[DATALOG_HDR_COUNT]);
+    TEST_ASSERT_EQUAL_INT(11, (int16_t)(second[DATALOG_HDR_VALUE] | (second[DATALOG_HDR_VALUE + 1] << 8)));
+    codec_DecodeInit(&dec, &second[DATALOG_HEADER_SIZE], DATALOG_PAGE_SIZE - DATALOG_HEADER_SIZE, 11);
+    TEST_ASSERT_TRUE(codec_DecodeNext(&dec, &value));
+    TEST_ASSERT_EQUAL_INT(12, value);
+    TEST_ASSERT_TRUE(codec_DecodeNext(&dec, &value));
+    TEST_ASSERT_EQUAL_INT(13, value);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    model_Reset();
+    eeprom_init(I2C_STANDARD_MODE);
+    time_i2c_init();
+    RUN_TEST(test_region_fills_the_chip);
+    RUN_TEST(test_head_at_the_start);
+    RUN_TEST(test_head_past_the_sequence_wrap);
+    RUN_TEST(test_head_at_the_last_page);
+    RUN_TEST(test_repeated_time_opens_a_page);
+    return UNITY_END();
+}
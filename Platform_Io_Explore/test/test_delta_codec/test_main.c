@@ -0,0 +1,97 @@
+/*_____________________________{TEST_DELTA_CODEC}_____________________________________________________
+ Brief : Round trip of the delta codec (user-035)
+
+ Series of ramps, soaks, steps and the int16_t extremes are encoded into
+ windows of every size from 1 to 40 bytes. Whatever the encoder accepted
+ must decode to the same values, and nothing more.
+ _________________________________________________________________________________________*/
+#include <stdlib.h>
+#include <string.h>
+#include <unity.h>
+
+#include "../../../Atmega128A.X/delta_codec.c"
+
+#define SERIES_LENGTH   600
+
+static int16_t series[SERIES_LENGTH];
+
+static void makeSeries(uint16_t seed) {
+    int16_t value = 20;
+
+    srand(seed);
+    for (uint16_t i = 0; i < SERIES_LENGTH; i++) {
+        switch ((i / 50 + seed) % 5) {
+            case 0:  value += 3; break;                                 // Ramp
+            case 1:  break;                                             // Soak, runs past 255
+            case 2:  value += (rand() % 61) - 30; break;                // Noise
+            case 3:  value = (i & 1) ? INT16_MAX : INT16_MIN; break;    // Largest deltas
+            default: value -= (rand() % 2000); break;                   // Fast cooling
+        }
+        series[i] = value;
+    }
+}
+
+// Encodes series[1..] after series[0] into a window of size bytes, decodes it
+// back and checks the values. Returns the number of values accepted.
+static uint16_t roundTrip(uint8_t size) {
+    uint8_t window[64];
+    codec_Encoder_t enc;
+    codec_Decoder_t dec;
+    uint16_t accepted = 1;
+    int16_t value;
+
+    memset(window, 0xA5, sizeof(window));
+    codec_EncodeInit(&enc, window, size, series[0]);
+    while (accepted < SERIES_LENGTH && codec_EncodePut(&enc, series[accepted])) {
+        accepted++;
+    }
+    uint8_t length = codec_EncodeFinish(&enc);
+    TEST_ASSERT_TRUE(length <= size);
+    TEST_ASSERT_EQUAL_HEX8(0xA5, window[size]);     // Nothing past the window
+
+    codec_DecodeInit(&dec, window, length, series[0]);
+    for (uint16_t i = 1; i < accepted; i++) {
+        TEST_ASSERT_TRUE(codec_DecodeNext(&dec, &value));
+        TEST_ASSERT_EQUAL_INT(series[i], value);
+    }
+    TEST_ASSERT_FALSE(codec_DecodeNext(&dec, &value));
+    return accepted;
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+static void test_round_trip_every_window(void) {
+    for (uint16_t seed = 0; seed < 5; seed++) {
+        makeSeries(seed);
+        for (uint16_t start = 0; start + 1 < SERIES_LENGTH; start += 37) {
+            memmove(series, &series[start], (SERIES_LENGTH - start) * sizeof(int16_t));
+            for (uint8_t size = 1; size <= 40; size++) {
+                roundTrip(size);
+            }
+            makeSeries(seed);
+        }
+    }
+}
+
+// A soak is one token per 255 repeats, a slow ramp one byte per sample
+static void test_token_sizes(void) {
+    for (uint16_t i = 0; i < SERIES_LENGTH; i++) {
+        series[i] = 100;
+    }
+    TEST_ASSERT_EQUAL_UINT(SERIES_LENGTH, roundTrip(6));
+    for (uint16_t i = 0; i < SERIES_LENGTH; i++) {
+        series[i] = 100 + i * 2;
+    }
+    TEST_ASSERT_EQUAL_UINT(23, roundTrip(22));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip_every_window);
+    RUN_TEST(test_token_sizes);
+    return UNITY_END();
+}
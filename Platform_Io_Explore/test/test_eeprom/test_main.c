@@ -0,0 +1,218 @@
+/*_____________________________{TEST_EEPROM}_____________________________________________________
+ Brief : Block writes and program saves on the 24C32 (user-040, user-042, user-037, user-038)
+
+ The bus runs one operation per pass of the main loop. A write only reaches
+ the chip memory on its STOP and the chip then refuses its address for the
+ write cycle, so a frame sent into the write cycle is lost and shows here.
+ _________________________________________________________________________________________*/
+#include <string.h>
+#include <unity.h>
+
+#include "../../../Atmega128A.X/i2c_driver.c"
+#include "../../../Atmega128A.X/i2c_device.c"
+#include "../../../Atmega128A.X/i2c_request_queue.c"
+#include "../../../Atmega128A.X/EEPROM_24C32.c"
+#include "../../../Atmega128A.X/ProgramDataHandler.c"
+#include "../../../Atmega128A.X/uart_trace.c"
+#include "../host/twi_model.c"
+
+#define RUN_LIMIT   200000UL
+
+static void run() {
+    i2c_DeviceUpdate();
+    EEPROM_prefetchUpdate();
+    model_Step();
+}
+
+static Program_t expectedRecord(uint16_t standby, uint16_t vaccumStop, uint8_t vaccumPercent) {
+    Program_t p = { standby, 200, 300, 400, 500, 600, 700, vaccumStop, 5, vaccumPercent, 0 };
+    const uint8_t* bytes = (const uint8_t*) &p;
+
+    for (uint8_t i = 0; i < CHECKSUM_OFFSET; i++) {
+        p.Checksum += bytes[i];
+    }
+    return p;
+}
+
+static uint8_t load(uint8_t group, uint8_t program) {
+    while (!EEPROM_prefetchProgram(group, program)) {
+        run();
+    }
+    for (uint32_t i = 0; i < RUN_LIMIT && EEPROM_shadowStatus() == PROGRAM_SHADOW_LOADING; i++) {
+        run();
+    }
+    return EEPROM_publishProgram();
+}
+
+void setUp(void) {
+    memset(model_Eeprom, 0xFF, sizeof(model_Eeprom));
+    model_Pages = 0;
+    memset(program_Cache, 0, sizeof(program_Cache));       // The chip was wiped under the cache
+    program_WantedCount = 0;
+}
+
+void tearDown(void) {
+}
+
+// A block write right behind a plain write to the same chip waits for the
+// chip to answer a poll instead of losing its first page (user-040)
+static void test_block_write_behind_a_plain_write(void) {
+    static uint8_t block[100];
+    uint8_t word[4] = { 1, 2, 3, 4 };
+    uint32_t i;
+
+    for (i = 0; i < sizeof(block); i++) {
+        block[i] = 0x80 + i;
+    }
+    TEST_ASSERT_TRUE(eeprom_writeArray(0x0100, sizeof(word), word));
+    for (i = 0; i < RUN_LIMIT && !eeprom_writeBlock(0x0104, sizeof(block), block); i++) {
+        run();
+    }
+    for (i = 0; i < RUN_LIMIT && (eeprom_blockBusy() || eeprom_writeQueued()); i++) {
+        run();
+    }
+    TEST_ASSERT_EQUAL_MEMORY(word, &model_Eeprom[0][0x0100], sizeof(word));
+    TEST_ASSERT_EQUAL_MEMORY(block, &model_Eeprom[0][0x0104], sizeof(block));
+    TEST_ASSERT_EQUAL_UINT(5, model_Pages);     // 4 bytes, then 28 + 32 + 32 + 8
+}
+
+// A save goes through the block writer: record 1 of group 0 spans the page
+// boundary at 32 and takes two write cycles, a second save waits (user-042)
+static void test_save_across_a_page(void) {
+    Program_t p = expectedRecord(100, 800, 50);
+    uint32_t i;
+
+    TEST_ASSERT_TRUE(EEPROM_saveProgramData(0, 1, 100, 200, 5, 300, 400, 500, 600, 50, 700, 800));
+    TEST_ASSERT_FALSE(EEPROM_saveProgramData(0, 2, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10));
+    for (i = 0; i < RUN_LIMIT && EEPROM_saveBusy(); i++) {
+        run();
+    }
+    TEST_ASSERT_FALSE(EEPROM_saveBusy());
+    TEST_ASSERT_EQUAL_MEMORY(&p, &model_Eeprom[0][1 * PROGRAM_DATA_SIZE], PROGRAM_DATA_SIZE);
+    TEST_ASSERT_EQUAL_UINT(2, model_Pages);
+    TEST_ASSERT_EQUAL_UINT(0, model_Torn);
+
+    // Saving it again writes nothing
+    TEST_ASSERT_TRUE(EEPROM_saveProgramData(0, 1, 100, 200, 5, 300, 400, 500, 600, 50, 700, 800));
+    for (i = 0; i < RUN_LIMIT && EEPROM_saveBusy(); i++) {
+        run();
+    }
+    TEST_ASSERT_EQUAL_UINT(2, model_Pages);
+}
+
+// A field edit rewrites the record with a new checksum, so the program still
+// validates and loads with the new value, from the EEPROM and from the cache (user-037)
+static void test_field_edit_keeps_the_record_valid(void) {
+    uint32_t i;
+
+    TEST_ASSERT_TRUE(EEPROM_saveProgramData(0, 1, 100, 200, 5, 300, 400, 500, 600, 50, 700, 800));
+    for (i = 0; i < RUN_LIMIT && EEPROM_saveBusy(); i++) {
+        run();
+    }
+    TEST_ASSERT_TRUE(EEPROM_writeProgramVariable(0, 1, STANDBY_TEMP_OFFSET, 111));
+    for (i = 0; i < RUN_LIMIT && EEPROM_saveBusy(); i++) {
+        run();
+    }
+    TEST_ASSERT_TRUE(load(0, 1));
+    TEST_ASSERT_EQUAL_UINT(111, StandbyTemp);
+    TEST_ASSERT_EQUAL_UINT(300, BurningTemp);
+
+    EEPROM_selectProgram(0, 1);
+    for (i = 0; i < 20000; i++) {
+        run();
+    }
+    TEST_ASSERT_TRUE(EEPROM_writeProgramVariable(0, 1, VACCUM_PERCENT_OFFSET, 77));
+    for (i = 0; i < RUN_LIMIT && EEPROM_saveBusy(); i++) {
+        run();
+    }
+    Program_t p = expectedRecord(111, 800, 77);
+    const Program_t* cached = EEPROM_cachedProgram(0, 1);
+    TEST_ASSERT_NOT_NULL(cached);
+    TEST_ASSERT_EQUAL_MEMORY(&p, cached, PROGRAM_DATA_SIZE);
+    TEST_ASSERT_EQUAL_MEMORY(&p, &model_Eeprom[0][1 * PROGRAM_DATA_SIZE], PROGRAM_DATA_SIZE);
+    TEST_ASSERT_TRUE(load(0, 1));
+    TEST_ASSERT_EQUAL_UINT(77, VaccumPercent);
+
+    TEST_ASSERT_FALSE(EEPROM_writeProgramVariable(0, 1, 3, 1));    // Not a field offset
+}
+
+// Reading a field goes through the record cache and leaves the program the
+// control loop runs alone (user-037)
+static void test_field_read_leaves_the_running_program(void) {
+    uint16_t value = 0;
+    uint32_t i;
+
+    TEST_ASSERT_TRUE(EEPROM_saveProgramData(0, 1, 100, 200, 5, 300, 400, 500, 600, 50, 700, 800));
+    for (i = 0; i < RUN_LIMIT && EEPROM_saveBusy(); i++) {
+        run();
+    }
+    TEST_ASSERT_TRUE(EEPROM_saveProgramData(2, 3, 150, 200, 5, 310, 400, 500, 600, 40, 700, 800));
+    for (i = 0; i < RUN_LIMIT && EEPROM_saveBusy(); i++) {
+        run();
+    }
+    TEST_ASSERT_TRUE(load(0, 1));
+    uint16_t standby = StandbyTemp;
+    uint16_t burning = BurningTemp;
+
+    EEPROM_selectProgram(0, 1);
+    for (i = 0; i < RUN_LIMIT && !EEPROM_readProgramVariable(2, 3, BURNING_TEMP_OFFSET, &value); i++) {
+        run();
+    }
+    TEST_ASSERT_EQUAL_UINT(310, value);
+    TEST_ASSERT_TRUE(EEPROM_readProgramVariable(2, 3, VACCUM_PERCENT_OFFSET, &value));
+    TEST_ASSERT_EQUAL_UINT(40, value);
+    TEST_ASSERT_FALSE(EEPROM_readProgramVariable(2, 3, CHECKSUM_OFFSET, &value));
+    TEST_ASSERT_EQUAL_UINT(standby, StandbyTemp);
+    TEST_ASSERT_EQUAL_UINT(burning, BurningTemp);
+}
+
+static void prefetch() {
+    for (uint32_t i = 0; i < 20000; i++) {
+        run();
+    }
+}
+
+// The selected program misses once, then the rest of its group and the
+// neighbour across the group boundary are there before they are selected;
+// a blank record is known too, it just has nothing to show (user-038)
+static void test_cache_prefetches_the_group(void) {
+    uint16_t hits = EEPROM_cacheHits();
+    uint16_t misses = EEPROM_cacheMisses();
+
+    TEST_ASSERT_TRUE(EEPROM_saveProgramData(1, 4, 100, 200, 5, 300, 400, 500, 600, 50, 700, 800));
+    for (uint32_t i = 0; i < RUN_LIMIT && EEPROM_saveBusy(); i++) {
+        run();
+    }
+    TEST_ASSERT_FALSE(EEPROM_selectProgram(1, 4));
+    TEST_ASSERT_NULL(EEPROM_cachedProgram(1, 4));
+    prefetch();
+    TEST_ASSERT_NOT_NULL(EEPROM_cachedProgram(1, 4));
+    TEST_ASSERT_EQUAL_UINT(300, EEPROM_cachedProgram(1, 4)->BurningTemp);
+
+    for (uint8_t p = 0; p < PROGRAMS_PER_GROUP; p++) {
+        TEST_ASSERT_TRUE(EEPROM_selectProgram(1, p));
+    }
+    TEST_ASSERT_NULL(EEPROM_cachedProgram(1, 9));              // Blank
+    prefetch();
+    TEST_ASSERT_TRUE(EEPROM_selectProgram(2, 0));
+    TEST_ASSERT_EQUAL_UINT(hits + 1 + PROGRAMS_PER_GROUP, EEPROM_cacheHits());
+    TEST_ASSERT_EQUAL_UINT(misses + 1, EEPROM_cacheMisses());
+
+    // Settled, the prefetcher leaves the bus alone
+    prefetch();
+    TEST_ASSERT_FALSE(eeprom_readPending());
+    TEST_ASSERT_NULL(program_CacheLoad);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    model_Reset();
+    i2c_Init(I2C_STANDARD_MODE);
+    eeprom_init(I2C_STANDARD_MODE);
+    RUN_TEST(test_block_write_behind_a_plain_write);
+    RUN_TEST(test_save_across_a_page);
+    RUN_TEST(test_field_edit_keeps_the_record_valid);
+    RUN_TEST(test_field_read_leaves_the_running_program);
+    RUN_TEST(test_cache_prefetches_the_group);
+    return UNITY_END();
+}
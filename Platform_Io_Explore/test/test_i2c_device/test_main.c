@@ -0,0 +1,192 @@
+/*_____________________________{TEST_I2C_DEVICE}_____________________________________________________
+ Brief : The device registry and bus arbiter (user-028), read coalescing (user-041)
+
+ Two test devices sit on the TWI of the host model: a memory at the EEPROM
+ address flagged I2C_DEVICE_COALESCE and the DS1307 registers without the
+ flag. Bus reads are counted in STARTs: a read is the register write and
+ the read frame, two STARTs.
+ _________________________________________________________________________________________*/
+#define I2C_STATS_ENABLE
+
+#include <string.h>
+#include <unity.h>
+
+#include "../../../Atmega128A.X/i2c_driver.c"
+#include "../../../Atmega128A.X/i2c_device.c"
+#include "../../../Atmega128A.X/i2c_request_queue.c"
+#include "../../../Atmega128A.X/uart_trace.c"
+#include "../host/twi_model.c"
+
+#define RUN_LIMIT       200000UL
+#define STARTS_PER_READ 2
+#define FIELDS          11          // Program_t read field by field
+
+I2C_REQUEST_QUEUE_DEFINE(memoryQueue, 16);
+I2C_REQUEST_QUEUE_DEFINE(rtcQueue, 4);
+
+static i2c_Device_t memory = { EEPROM_24C32_ADDR, I2C_STANDARD_MODE, 2, &memoryQueue, 0, I2C_DEVICE_COALESCE };
+static i2c_Device_t rtc = { MODEL_RTC_ADDR, I2C_STANDARD_MODE, 1, &rtcQueue };
+
+static const uint8_t fieldOffset[FIELDS] = { 0, 2, 4, 6, 8, 10, 12, 14, 16, 17, 18 };
+static const uint8_t fieldLength[FIELDS] = { 2, 2, 2, 2, 2, 2, 2, 2, 1, 1, 2 };
+
+static uint16_t starts;
+static uint16_t merged;
+
+static void settle() {
+    for (uint32_t i = 0; i < RUN_LIMIT && (i2c_DeviceReadPending(&memory) || i2c_DeviceReadPending(&rtc)
+                                           || i2c_WriteBufferUsed() || !busIdle); i++) {
+        i2c_DeviceUpdate();
+        model_Step();
+    }
+    TEST_ASSERT_FALSE(i2c_DeviceReadPending(&memory));
+}
+
+// Bus reads and merged requests since the last call
+static uint16_t reads() {
+    uint16_t n = (model_Starts - starts) / STARTS_PER_READ;
+    starts = model_Starts;
+    return n;
+}
+
+static uint16_t mergedSince() {
+    uint16_t n = i2c_Stats.readsMerged - merged;
+    merged = i2c_Stats.readsMerged;
+    return n;
+}
+
+void setUp(void) {
+    for (uint16_t i = 0; i < EEPROM_CHIP_SIZE; i++) {
+        model_Eeprom[0][i] = (uint8_t)(i * 13 + 1);
+    }
+    for (uint8_t i = 0; i < MODEL_RTC_SIZE; i++) {
+        model_Rtc[i] = 0x40 + i;
+    }
+    reads();
+    mergedSince();
+}
+
+void tearDown(void) {
+}
+
+// The fields of a record queued one by one take one bus read
+static void test_field_reads_merge(void) {
+    uint8_t record[20];
+
+    memset(record, 0, sizeof(record));
+    for (uint8_t i = 0; i < FIELDS; i++) {
+        TEST_ASSERT_TRUE(i2c_DeviceRead(&memory, 0x0014 + fieldOffset[i], fieldLength[i], &record[fieldOffset[i]]));
+    }
+    settle();
+    TEST_ASSERT_EQUAL_MEMORY(&model_Eeprom[0][0x0014], record, sizeof(record));
+    TEST_ASSERT_EQUAL_UINT(1, reads());
+    TEST_ASSERT_EQUAL_UINT(FIELDS - 1, mergedSince());
+}
+
+// A gap ends the span and the FIFO order is kept: the request behind the gap
+// is not pulled forward even though it continues the first read
+static void test_gap_keeps_the_order(void) {
+    uint8_t a[4], b[4], c[4];
+
+    TEST_ASSERT_TRUE(i2c_DeviceRead(&memory, 0x0100, 4, a));
+    TEST_ASSERT_TRUE(i2c_DeviceRead(&memory, 0x0200, 4, b));
+    TEST_ASSERT_TRUE(i2c_DeviceRead(&memory, 0x0104, 4, c));
+    settle();
+    TEST_ASSERT_EQUAL_MEMORY(&model_Eeprom[0][0x0100], a, 4);
+    TEST_ASSERT_EQUAL_MEMORY(&model_Eeprom[0][0x0200], b, 4);
+    TEST_ASSERT_EQUAL_MEMORY(&model_Eeprom[0][0x0104], c, 4);
+    TEST_ASSERT_EQUAL_UINT(3, reads());
+    TEST_ASSERT_EQUAL_UINT(0, mergedSince());
+}
+
+// A repeat of an address queued behind another read is served by the first
+// read and leaves the queue without bus traffic
+static void test_repeated_read_is_served_once(void) {
+    uint8_t a[4], b[4], c[2];
+
+    TEST_ASSERT_TRUE(i2c_DeviceRead(&memory, 0x0100, 4, a));
+    TEST_ASSERT_TRUE(i2c_DeviceRead(&memory, 0x0200, 4, b));
+    TEST_ASSERT_TRUE(i2c_DeviceRead(&memory, 0x0102, 2, c));
+    settle();
+    TEST_ASSERT_EQUAL_MEMORY(&model_Eeprom[0][0x0102], c, 2);
+    TEST_ASSERT_EQUAL_UINT(2, reads());
+    TEST_ASSERT_EQUAL_UINT(1, mergedSince());
+}
+
+// A repeat queued after the read started is read again, the memory may have
+// been written in between
+static void test_repeat_after_the_start_reads_again(void) {
+    uint8_t a[4], c[4];
+    uint32_t i;
+
+    TEST_ASSERT_TRUE(i2c_DeviceRead(&memory, 0x0100, 4, a));
+    for (i = 0; i < RUN_LIMIT && !i2c_Arbiters[0].active; i++) {
+        i2c_DeviceUpdate();
+        model_Step();
+    }
+    TEST_ASSERT_TRUE(i2c_DeviceRead(&memory, 0x0100, 4, c));
+    settle();
+    TEST_ASSERT_EQUAL_MEMORY(a, c, 4);
+    TEST_ASSERT_EQUAL_UINT(2, reads());
+    TEST_ASSERT_EQUAL_UINT(0, mergedSince());
+}
+
+// A span never grows past the receive buffer of the bus
+static void test_span_fits_the_read_buffer(void) {
+    static uint8_t data[4][16];
+
+    for (uint8_t i = 0; i < 4; i++) {
+        TEST_ASSERT_TRUE(i2c_DeviceRead(&memory, 0x0300 + i * 16, 16, data[i]));
+    }
+    settle();
+    TEST_ASSERT_EQUAL_MEMORY(&model_Eeprom[0][0x0300], data, sizeof(data));
+    TEST_ASSERT_EQUAL_UINT((sizeof(data) + i2c_TwiBus.maxRead - 1) / i2c_TwiBus.maxRead, reads());
+}
+
+// Registers without the flag are read one request at a time
+static void test_plain_device_is_not_merged(void) {
+    uint8_t a[2], b[2];
+
+    TEST_ASSERT_TRUE(i2c_DeviceRead(&rtc, 0x08, 2, a));
+    TEST_ASSERT_TRUE(i2c_DeviceRead(&rtc, 0x0A, 2, b));
+    settle();
+    TEST_ASSERT_EQUAL_MEMORY(&model_Rtc[0x08], a, 2);
+    TEST_ASSERT_EQUAL_MEMORY(&model_Rtc[0x0A], b, 2);
+    TEST_ASSERT_EQUAL_UINT(2, reads());
+    TEST_ASSERT_EQUAL_UINT(0, mergedSince());
+}
+
+// Devices take turns: a clock read queued behind a full memory queue is on
+// the bus after at most one memory read
+static void test_devices_take_turns(void) {
+    static uint8_t data[8][2];
+    uint8_t seconds = 0;
+    uint32_t i;
+
+    for (i = 0; i < 8; i++) {
+        TEST_ASSERT_TRUE(i2c_DeviceRead(&memory, 0x0400 + i * 0x10, 2, data[i]));
+    }
+    TEST_ASSERT_TRUE(i2c_DeviceRead(&rtc, 0x00, 1, &seconds));
+    for (i = 0; i < RUN_LIMIT && i2c_DeviceReadPending(&rtc); i++) {
+        i2c_DeviceUpdate();
+        model_Step();
+    }
+    TEST_ASSERT_EQUAL_UINT(model_Rtc[0], seconds);
+    TEST_ASSERT_TRUE(i2c_QueueCount(&memoryQueue) >= 6);
+    settle();
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    model_Reset();
+    TEST_ASSERT_TRUE(i2c_DeviceRegister(&memory));
+    TEST_ASSERT_TRUE(i2c_DeviceRegister(&rtc));
+    RUN_TEST(test_field_reads_merge);
+    RUN_TEST(test_gap_keeps_the_order);
+    RUN_TEST(test_repeated_read_is_served_once);
+    RUN_TEST(test_repeat_after_the_start_reads_again);
+    RUN_TEST(test_span_fits_the_read_buffer);
+    RUN_TEST(test_plain_device_is_not_merged);
+    RUN_TEST(test_devices_take_turns);
+    return UNITY_END();
+}
@@ -0,0 +1,7 @@
+/*_____________________________{TEST_I2C_STACK BUS}_____________________________________________________
+ Brief : Bus model for the C++ port, built as C next to the test
+
+ The bus runs one operation on every TWCR access and every model_Step(), the
+ interrupt of the port is bound to TWI_vect in test_main.cpp.
+ _________________________________________________________________________________________*/
+#include "../host/twi_model.c"
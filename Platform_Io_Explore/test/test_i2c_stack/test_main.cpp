@@ -0,0 +1,77 @@
+/*_____________________________{TEST_I2C_STACK}_____________________________________________________
+ Brief : Reads of the C++ port of the I2C stack (user-029)
+
+ One 24C32 on a bus with a 64 byte write ring and a 32 byte receive ring, as
+ in the example of I2cStack.h, against the host TWI model.
+ _________________________________________________________________________________________*/
+#include <string.h>
+#include <unity.h>
+#include <I2cStack.h>
+
+extern "C" {
+#include "twi_model.h"
+}
+
+#define RUN_LIMIT   200000UL
+
+typedef i2c::Bus<F_CPU, i2c::kStandardMode, 64, 32> TestBus;
+typedef i2c::Device<TestBus, EEPROM_24C32_ADDR, 2, 4> Eeprom;
+typedef i2c::Scheduler<TestBus, Eeprom>               Scheduler;
+
+extern "C" {
+I2C_STACK_BIND_ISR(TestBus)
+}
+
+static void run() {
+    for (uint32_t i = 0; i < RUN_LIMIT && (Eeprom::pending() || TestBus::writeSpace() < 64); i++) {
+        Scheduler::update();
+        model_Step();
+    }
+}
+
+void setUp(void) {
+    for (uint16_t i = 0; i < 256; i++) {
+        model_Eeprom[0][i] = (uint8_t)(i ^ 0x5A);
+    }
+}
+
+void tearDown(void) {
+}
+
+// A read longer than the receive ring is split and arrives whole, the write
+// ring is empty again afterwards
+static void test_long_read_is_split(void) {
+    uint8_t data[40];
+
+    memset(data, 0, sizeof(data));
+    TEST_ASSERT_TRUE(Eeprom::read(0x10, sizeof(data), data));
+    run();
+    TEST_ASSERT_FALSE(Eeprom::pending());
+    TEST_ASSERT_EQUAL_UINT(64, TestBus::writeSpace());
+    TEST_ASSERT_EQUAL_MEMORY(&model_Eeprom[0][0x10], data, sizeof(data));
+}
+
+// Reads the queue cannot take whole, and empty reads, are refused and leave
+// nothing behind
+static void test_refused_reads_leave_nothing(void) {
+    uint8_t data[200];
+
+    TEST_ASSERT_FALSE(Eeprom::read(0x00, 0, data));
+    TEST_ASSERT_FALSE(Eeprom::read(0x00, sizeof(data), data));    // 7 pieces, 4 slots
+    TEST_ASSERT_TRUE(Eeprom::read(0x00, 1, data));
+    TEST_ASSERT_FALSE(Eeprom::read(0x01, 97, data + 1));          // Needs 4 slots, 3 left
+    TEST_ASSERT_TRUE(Eeprom::read(0x01, 96, data + 1));
+    run();
+    TEST_ASSERT_FALSE(Eeprom::pending());
+    TEST_ASSERT_EQUAL_UINT(64, TestBus::writeSpace());
+    TEST_ASSERT_EQUAL_MEMORY(&model_Eeprom[0][0], data, 97);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    model_Reset();
+    TestBus::init();
+    RUN_TEST(test_long_read_is_split);
+    RUN_TEST(test_refused_reads_leave_nothing);
+    return UNITY_END();
+}
@@ -0,0 +1,246 @@
+/*_____________________________{TEST_POWER_FAIL}_____________________________________________________
+ Brief : Power-fail save and restore through a restart (user-048)
+
+ Each test lives twice. The first life runs in a child process: it boots,
+ stages the running program, then fails the supply by running
+ ISR(ANA_COMP_vect) with interrupts off, up to the watchdog reset. Only the
+ EEPROM and the DS1307 RAM survive, the parent boots on them with every
+ static of the firmware fresh and checks what boot_ResumePoint() gives back.
+ _________________________________________________________________________________________*/
+#define POWERFAIL_ENABLE
+
+#include <setjmp.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <unity.h>
+
+#include "../../../Atmega128A.X/i2c_driver.c"
+#include "../../../Atmega128A.X/i2c_device.c"
+#include "../../../Atmega128A.X/i2c_request_queue.c"
+#include "../../../Atmega128A.X/EEPROM_24C32.c"
+#include "../../../Atmega128A.X/ProgramDataHandler.c"
+#include "../../../Atmega128A.X/rtc_ds1307.c"
+#include "../../../Atmega128A.X/rtc_ds1307_low_level.c"
+#include "../../../Atmega128A.X/data_log.c"
+#include "../../../Atmega128A.X/delta_codec.c"
+#include "../../../Atmega128A.X/profile_store.c"
+#include "../../../Atmega128A.X/boot.c"
+#include "../../../Atmega128A.X/power_fail.c"
+#include "../../../Atmega128A.X/uart_trace.c"
+#include "../host/twi_model.c"
+
+#define RUN_LIMIT   300000UL
+
+static uint8_t bootTime[7] = { 0, 0, 0, 1, 1, 1, 0 };
+static jmp_buf watchdog;
+
+void host_watchdogReset(void) {
+    longjmp(watchdog, 1);
+}
+
+// One pass of the main loop of main.c, then one bus operation
+static void run() {
+    i2c_DeviceUpdate();
+    datalog_Update();
+    EEPROM_prefetchUpdate();
+    profile_Update();
+    if (!boot_Ready()) {
+        boot_Update();
+    } else {
+        powerfail_Update();
+    }
+    model_Step();
+}
+
+static uint8_t boot() {
+    model_Reset();
+    boot_Start(bootTime);
+    for (uint32_t i = 0; i < RUN_LIMIT && !boot_Ready(); i++) {
+        run();
+    }
+    return boot_Ready();
+}
+
+static uint8_t save(uint8_t program, uint16_t burningTemp) {
+    while (!EEPROM_saveProgramData(0, program, 100, 200, 5, burningTemp, 400, 500, 600, 50, 700, 800)) {
+        run();
+    }
+    for (uint32_t i = 0; i < RUN_LIMIT && EEPROM_saveBusy(); i++) {
+        run();
+    }
+    return !EEPROM_saveBusy();
+}
+
+static uint8_t publish(uint8_t program) {
+    while (!EEPROM_prefetchProgram(0, program)) {
+        run();
+    }
+    for (uint32_t i = 0; i < RUN_LIMIT && EEPROM_shadowStatus() == PROGRAM_SHADOW_LOADING; i++) {
+        run();
+    }
+    return EEPROM_publishProgram();
+}
+
+// Supply falls: the comparator interrupt with the I bit clear, up to the watchdog
+static void powerFail() {
+    cli();
+    if (!setjmp(watchdog)) {
+        ANA_COMP_vect();
+    }
+}
+
+// What the second life found after the restart
+typedef struct {
+    uint8_t  ready;
+    uint8_t  resumed;
+    powerfail_Progress_t progress;
+    uint16_t burningTemp;           // Global the control loop reads
+    uint16_t activeBurningTemp;     // EEPROM_activeProgram()
+} restart_t;
+
+// Runs a life in a child process, so every static of the firmware starts
+// fresh, and takes over the memories it leaves. The child gets the memories
+// as they are and sends back them and its result. Returns the exit code of
+// the life, 0 if it went as planned.
+static int live(int (*life)(void* result), void* result, size_t size) {
+    int channel[2];
+    int status = -1;
+
+    if (pipe(channel) != 0) {
+        return -1;
+    }
+    pid_t child = fork();
+    if (child == 0) {
+        int code = life(result);
+        if (write(channel[1], model_Eeprom, sizeof(model_Eeprom)) != sizeof(model_Eeprom) ||
+                write(channel[1], model_Rtc, sizeof(model_Rtc)) != sizeof(model_Rtc) ||
+                write(channel[1], result, size) != (ssize_t) size) {
+            code = 100;
+        }
+        _exit(code);
+    }
+    close(channel[1]);
+    if (read(channel[0], model_Eeprom, sizeof(model_Eeprom)) != sizeof(model_Eeprom) ||
+            read(channel[0], model_Rtc, sizeof(model_Rtc)) != sizeof(model_Rtc) ||
+            read(channel[0], result, size) != (ssize_t) size) {
+        waitpid(child, &status, 0);
+        return -1;
+    }
+    close(channel[0]);
+    waitpid(child, &status, 0);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+// Program 3 running in segment 2, then switched to program 4 (burning 999):
+// the staged page follows the switch, the globals are not its source
+static int lifeIdle(void* result) {
+    powerfail_Progress_t progress = { 3, 2, 77, 1234 };
+
+    if (!boot() || boot_ResumePoint()) {
+        return 1;
+    }
+    if (!save(3, 1234) || !publish(3)) {
+        return 2;
+    }
+    powerfail_Stage(&progress);
+    if (!save(4, 999) || !publish(4)) {
+        return 3;
+    }
+    run();
+    BurningTemp = 5;
+    powerFail();
+    return 0;
+}
+
+// As above, failing with a page of program 5 half way on the wire
+static int lifeMidFrame(void* result) {
+    powerfail_Progress_t progress = { 4, 2, 77, 999 };
+
+    if (!boot() || !save(4, 999) || !publish(4)) {
+        return 1;
+    }
+    powerfail_Stage(&progress);
+    run();
+    if (!EEPROM_saveProgramData(0, 5, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10)) {
+        return 2;
+    }
+    for (uint32_t i = 0; i < RUN_LIMIT && model_PageBytes() < 6; i++) {
+        run();
+    }
+    if (model_PageBytes() < 6) {
+        return 3;
+    }
+    powerFail();
+    return model_Torn == 1 ? 0 : 4;
+}
+
+// Boots on what the failure left, then lets the restored page be discarded
+static int lifeRestart(void* result) {
+    restart_t* restart = result;
+    const powerfail_Progress_t* resume;
+
+    restart->ready = boot();
+    resume = boot_ResumePoint();
+    restart->resumed = resume != 0;
+    if (resume) {
+        restart->progress = *resume;
+    }
+    restart->burningTemp = BurningTemp;
+    restart->activeBurningTemp = EEPROM_activeProgram()->BurningTemp;
+    for (uint32_t i = 0; i < 20000; i++) {
+        run();
+    }
+    model_Now += EEPROM_WRITE_CYCLE_MS * 1000UL;
+    for (uint32_t i = 0; i < 100; i++) {
+        run();
+    }
+    return 0;
+}
+
+static void checkRestart(void) {
+    restart_t restart;
+
+    TEST_ASSERT_EQUAL_INT(0, live(lifeRestart, &restart, sizeof(restart)));
+    TEST_ASSERT_TRUE(restart.ready);
+    TEST_ASSERT_TRUE(restart.resumed);
+    TEST_ASSERT_EQUAL_UINT(2, restart.progress.segment);
+    TEST_ASSERT_EQUAL_UINT(77, restart.progress.segmentElapsed);
+    TEST_ASSERT_EQUAL_UINT(999, restart.burningTemp);
+    TEST_ASSERT_EQUAL_UINT(999, restart.activeBurningTemp);
+    TEST_ASSERT_NOT_EQUAL(POWERFAIL_MARK, model_Eeprom[0][POWERFAIL_EEPROM_ADDR]);   // Restored once only
+}
+
+void setUp(void) {
+    memset(model_Eeprom, 0xFF, sizeof(model_Eeprom));
+    memset(model_Rtc, 0, sizeof(model_Rtc));
+}
+
+void tearDown(void) {
+}
+
+static void test_failure_while_idle(void) {
+    uint8_t none;
+
+    TEST_ASSERT_EQUAL_INT(0, live(lifeIdle, &none, sizeof(none)));
+    checkRestart();
+}
+
+// The frame cut by i2c_Preempt() never gets its STOP, its page keeps the old contents
+static void test_failure_during_a_page_write(void) {
+    static const uint8_t blank[PROGRAM_DATA_SIZE] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+                                                      0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+
+    uint8_t none;
+
+    TEST_ASSERT_EQUAL_INT(0, live(lifeMidFrame, &none, sizeof(none)));
+    TEST_ASSERT_EQUAL_MEMORY(blank, &model_Eeprom[0][5 * PROGRAM_DATA_SIZE], PROGRAM_DATA_SIZE);
+    checkRestart();
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_failure_while_idle);
+    RUN_TEST(test_failure_during_a_page_write);
+    return UNITY_END();
+}
@@ -0,0 +1,154 @@
+/*_____________________________{TEST_PROFILE_STORE}_____________________________________________________
+ Brief : Ramp/soak profiles in the directory and heap of the 24C32 (user-036)
+
+ The heap holds 103 blocks of 8 bytes, a profile of 15 segments takes 14 of
+ them, so seven fit and the eighth is refused until one is deleted. The heap
+ map is rebuilt from the directory after a restart.
+ _________________________________________________________________________________________*/
+#include <string.h>
+#include <unity.h>
+
+#include "../../../Atmega128A.X/i2c_driver.c"
+#include "../../../Atmega128A.X/i2c_device.c"
+#include "../../../Atmega128A.X/i2c_request_queue.c"
+#include "../../../Atmega128A.X/EEPROM_24C32.c"
+#include "../../../Atmega128A.X/profile_store.c"
+#include "../../../Atmega128A.X/uart_trace.c"
+#include "../host/twi_model.c"
+
+#define RUN_LIMIT       200000UL
+#define FULL_PROFILES   (PROFILE_HEAP_BLOCKS / 14)
+
+static profile_Segment_t segments[PROFILE_MAX_SEGMENTS];
+
+static void run() {
+    i2c_DeviceUpdate();
+    profile_Update();
+    model_Step();
+}
+
+static void start() {
+    profile_Init();
+    for (uint32_t i = 0; i < RUN_LIMIT && !profile_Ready(); i++) {
+        run();
+    }
+    TEST_ASSERT_TRUE(profile_Ready());
+}
+
+static uint8_t save(uint8_t group, uint8_t program, uint8_t count) {
+    TEST_ASSERT_TRUE(profile_Save(group, program, segments, count));
+    for (uint32_t i = 0; i < RUN_LIMIT && profile_SaveStatus() == PROFILE_PENDING; i++) {
+        run();
+    }
+    return profile_SaveStatus();
+}
+
+static uint8_t open(uint8_t group, uint8_t program) {
+    TEST_ASSERT_TRUE(profile_Open(group, program));
+    for (uint32_t i = 0; i < RUN_LIMIT && profile_Status() == PROFILE_PENDING; i++) {
+        run();
+    }
+    return profile_Status();
+}
+
+static uint16_t entry(uint8_t group, uint8_t program) {
+    const uint8_t* e = &model_Eeprom[0][PROFILE_DIR_START + (group * PROFILE_PROGRAMS + program) * 2];
+    return e[0] | ((uint16_t) e[1] << 8);
+}
+
+static void fillSegments(uint16_t seed) {
+    for (uint8_t i = 0; i < PROFILE_MAX_SEGMENTS; i++) {
+        segments[i].targetTemp = seed + i * 50;
+        segments[i].rate = 100 + i;
+        segments[i].holdTime = i;
+        segments[i].vaccumPercent = (uint8_t)(seed + i);
+    }
+}
+
+void setUp(void) {
+    memset(model_Eeprom, 0xFF, sizeof(model_Eeprom));
+    start();
+}
+
+void tearDown(void) {
+}
+
+// A saved profile opens with one directory read and its segments stream in
+// one by one; a program without one is empty
+static void test_save_open_and_load(void) {
+    profile_Segment_t segment;
+
+    fillSegments(600);
+    TEST_ASSERT_EQUAL_UINT(PROFILE_OK, save(2, 5, 3));
+    TEST_ASSERT_EQUAL_UINT(PROFILE_OK, open(2, 5));
+    TEST_ASSERT_EQUAL_UINT(3, profile_SegmentCount());
+    for (uint8_t i = 0; i < 3; i++) {
+        TEST_ASSERT_TRUE(profile_LoadSegment(i, &segment));
+        for (uint32_t n = 0; n < RUN_LIMIT && profile_Pending(); n++) {
+            run();
+        }
+        TEST_ASSERT_EQUAL_MEMORY(&segments[i], &segment, PROFILE_SEGMENT_SIZE);
+    }
+    TEST_ASSERT_FALSE(profile_LoadSegment(3, &segment));
+
+    TEST_ASSERT_EQUAL_UINT(PROFILE_EMPTY, open(2, 6));
+    TEST_ASSERT_EQUAL_UINT(0, profile_SegmentCount());
+    TEST_ASSERT_FALSE(profile_Save(0, 0, segments, 0));
+    TEST_ASSERT_FALSE(profile_Save(0, 0, segments, PROFILE_MAX_SEGMENTS + 1));
+}
+
+// A replacement goes next to the old segments and the directory entry
+// switches last; the old blocks are free afterwards and stay free after a
+// restart rebuilt the heap map
+static void test_replace_frees_the_old_segments(void) {
+    fillSegments(100);
+    TEST_ASSERT_EQUAL_UINT(PROFILE_OK, save(0, 0, PROFILE_MAX_SEGMENTS));
+    uint16_t first = entry(0, 0);
+    TEST_ASSERT_EQUAL_UINT(PROFILE_HEAP_START, PROFILE_ENTRY_ADDRESS(first));
+
+    fillSegments(200);
+    TEST_ASSERT_EQUAL_UINT(PROFILE_OK, save(0, 0, 2));
+    uint16_t second = entry(0, 0);
+    TEST_ASSERT_EQUAL_UINT(2, PROFILE_ENTRY_COUNT(second));
+    TEST_ASSERT_TRUE(PROFILE_ENTRY_ADDRESS(second) >= PROFILE_HEAP_START + 14 * PROFILE_BLOCK_SIZE);
+    TEST_ASSERT_EQUAL_MEMORY(segments, &model_Eeprom[0][PROFILE_ENTRY_ADDRESS(second)], 2 * PROFILE_SEGMENT_SIZE);
+
+    start();
+    TEST_ASSERT_EQUAL_UINT(PROFILE_OK, save(0, 1, PROFILE_MAX_SEGMENTS));
+    TEST_ASSERT_EQUAL_UINT(PROFILE_HEAP_START, PROFILE_ENTRY_ADDRESS(entry(0, 1)));
+    TEST_ASSERT_EQUAL_UINT(second, entry(0, 0));
+}
+
+// A full heap refuses a save and leaves the directory alone, a delete makes
+// room again
+static void test_full_heap_and_delete(void) {
+    uint8_t p;
+
+    fillSegments(300);
+    for (p = 0; p < FULL_PROFILES; p++) {
+        TEST_ASSERT_EQUAL_UINT(PROFILE_OK, save(1, p, PROFILE_MAX_SEGMENTS));
+    }
+    TEST_ASSERT_EQUAL_UINT(PROFILE_NO_SPACE, save(1, p, PROFILE_MAX_SEGMENTS));
+    TEST_ASSERT_EQUAL_UINT(PROFILE_ENTRY_EMPTY, entry(1, p));
+    TEST_ASSERT_TRUE(profile_Ready());
+
+    TEST_ASSERT_TRUE(profile_Delete(1, 3));
+    for (uint32_t i = 0; i < RUN_LIMIT && profile_SaveStatus() == PROFILE_PENDING; i++) {
+        run();
+    }
+    TEST_ASSERT_EQUAL_UINT(PROFILE_OK, profile_SaveStatus());
+    TEST_ASSERT_EQUAL_UINT(PROFILE_EMPTY, open(1, 3));
+    TEST_ASSERT_EQUAL_UINT(PROFILE_OK, save(1, p, PROFILE_MAX_SEGMENTS));
+    TEST_ASSERT_EQUAL_UINT(PROFILE_OK, open(1, p));
+    TEST_ASSERT_EQUAL_UINT(PROFILE_MAX_SEGMENTS, profile_SegmentCount());
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    model_Reset();
+    eeprom_init(I2C_STANDARD_MODE);
+    RUN_TEST(test_save_open_and_load);
+    RUN_TEST(test_replace_frees_the_old_segments);
+    RUN_TEST(test_full_heap_and_delete);
+    return UNITY_END();
+}
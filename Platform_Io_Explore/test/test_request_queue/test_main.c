@@ -0,0 +1,94 @@
+/*_____________________________{TEST_REQUEST_QUEUE}_____________________________________________________
+ Brief : The shared read request queue and the EEPROM queue size (user-027)
+
+ The FIFO is tested on its own first, then through the EEPROM driver on the
+ host TWI model: the burst of a whole profile, the peak the queue is sized
+ from, fits and is delivered in order.
+ _________________________________________________________________________________________*/
+#define I2C_STATS_ENABLE
+
+#include <string.h>
+#include <unity.h>
+
+#include "../../../Atmega128A.X/i2c_driver.c"
+#include "../../../Atmega128A.X/i2c_device.c"
+#include "../../../Atmega128A.X/i2c_request_queue.c"
+#include "../../../Atmega128A.X/EEPROM_24C32.c"
+#include "../../../Atmega128A.X/uart_trace.c"
+#include "../host/twi_model.c"
+
+#define RUN_LIMIT       200000UL
+#define BURST           15          // PROFILE_MAX_SEGMENTS
+#define SEGMENT_SIZE    7           // PROFILE_SEGMENT_SIZE
+#define BURST_START     0x0820      // Inside the profile heap
+
+I2C_REQUEST_QUEUE_DEFINE(testQueue, 8);
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+// Requests come out in the order they went in across many wraps of the free
+// running indices, and a full queue refuses without losing the others
+static void test_fifo_order_and_wrap(void) {
+    uint16_t next = 0;
+    uint16_t expect = 0;
+
+    for (uint16_t round = 0; round < 300; round++) {
+        while (i2c_QueueAdd(&testQueue, next, (uint8_t) next, 0)) {
+            next++;
+        }
+        TEST_ASSERT_EQUAL_UINT(8, i2c_QueueCount(&testQueue));
+        TEST_ASSERT_EQUAL_UINT(next - 1, i2c_QueueAt(&testQueue, 7)->address);
+        TEST_ASSERT_NULL(i2c_QueueAt(&testQueue, 8));
+        for (uint8_t i = 0; i < 1 + (round % 8); i++) {
+            TEST_ASSERT_EQUAL_UINT(expect, i2c_QueuePeek(&testQueue)->address);
+            TEST_ASSERT_EQUAL_UINT((uint8_t) expect, i2c_QueuePeek(&testQueue)->length);
+            i2c_QueueRemove(&testQueue);
+            expect++;
+        }
+    }
+    while (i2c_QueuePeek(&testQueue)) {
+        TEST_ASSERT_EQUAL_UINT(expect++, i2c_QueuePeek(&testQueue)->address);
+        i2c_QueueRemove(&testQueue);
+    }
+    TEST_ASSERT_EQUAL_UINT(next, expect);
+    i2c_QueueRemove(&testQueue);                // Empty, no effect
+    TEST_ASSERT_EQUAL_UINT(0, i2c_QueueCount(&testQueue));
+    TEST_ASSERT_EQUAL_UINT(8, testQueue.highWater);
+}
+
+// The 15 segment reads of a profile fit the 16 slots of one chip and arrive in
+// order; one read more than the queue holds is refused
+static void test_profile_burst_fits(void) {
+    static uint8_t segments[BURST + 1][SEGMENT_SIZE];
+    uint32_t i;
+
+    for (i = 0; i < (BURST + 1) * SEGMENT_SIZE; i++) {
+        model_Eeprom[0][BURST_START + i] = (uint8_t)(i * 7 + 3);
+    }
+    for (i = 0; i < BURST; i++) {
+        TEST_ASSERT_TRUE(eeprom_readArray(BURST_START + i * SEGMENT_SIZE, SEGMENT_SIZE, segments[i]));
+    }
+    TEST_ASSERT_TRUE(eeprom_readArray(BURST_START + BURST * SEGMENT_SIZE, SEGMENT_SIZE, segments[BURST]));
+    TEST_ASSERT_FALSE(eeprom_readArray(0, 1, segments[0]));
+    TEST_ASSERT_EQUAL_UINT(EEPROM_READ_QUEUE_SIZE, i2c_DeviceQueueHighWater(EEPROM_24C32_ADDR));
+
+    for (i = 0; i < RUN_LIMIT && eeprom_readPending(); i++) {
+        i2c_DeviceUpdate();
+        model_Step();
+    }
+    TEST_ASSERT_FALSE(eeprom_readPending());
+    TEST_ASSERT_EQUAL_MEMORY(&model_Eeprom[0][BURST_START], segments, sizeof(segments));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    model_Reset();
+    eeprom_init(I2C_STANDARD_MODE);
+    RUN_TEST(test_fifo_order_and_wrap);
+    RUN_TEST(test_profile_burst_fits);
+    return UNITY_END();
+}
@@ -0,0 +1,152 @@
+/*_____________________________{TEST_RTC_SNAPSHOT}_____________________________________________________
+ Brief : The snapshot ring in the DS1307 RAM (user-026)
+
+ The DS1307 sits on the TWI of the host model, one bus operation per pass.
+ To make the queue refuse a write the test keeps the write buffer full with
+ one-byte frames to an address nobody acknowledges.
+ _________________________________________________________________________________________*/
+#include <string.h>
+#include <unity.h>
+
+#include "../../../Atmega128A.X/i2c_driver.c"
+#include "../../../Atmega128A.X/i2c_device.c"
+#include "../../../Atmega128A.X/i2c_request_queue.c"
+#include "../../../Atmega128A.X/rtc_ds1307.c"
+#include "../../../Atmega128A.X/rtc_ds1307_low_level.c"
+#include "../../../Atmega128A.X/uart_trace.c"
+#include "../host/twi_model.c"
+
+#define RUN_LIMIT       200000UL
+#define ABSENT_ADDR     0x20
+
+static const uint8_t startTime[7] = { 0x30, 0x15, 0x10, 0x03, 0x14, 0x05, 0x24 };    // BCD, 2024-05-14 10:15:30
+
+static uint8_t busBlocked;              // Keep the write buffer full once the DS1307 read is on the bus
+
+static void fill() {
+    uint8_t filler = 0;
+
+    while (i2c_SendArray(ABSENT_ADDR, 1, &filler)) {
+    }
+}
+
+static void run() {
+    if (busBlocked && (i2c_Arbiters[0].active == &DS1307Device || !DS1307_read_pending())) {
+        fill();
+    }
+    i2c_DeviceUpdate();
+    model_Step();
+}
+
+static void settle() {
+    for (uint32_t i = 0; i < RUN_LIMIT && (snap_pending || DS1307_read_pending() || i2c_WriteBufferUsed() || !busIdle); i++) {
+        run();
+    }
+    TEST_ASSERT_EQUAL_UINT(0, snap_pending);
+}
+
+static void save(uint8_t second) {
+    model_Rtc[DS1307_REGISTER_SECONDS] = second;
+    TEST_ASSERT_EQUAL_UINT(OPERATION_DONE, DS1307_snapshot_save());
+    settle();
+}
+
+static void reload() {
+    TEST_ASSERT_EQUAL_UINT(OPERATION_DONE, DS1307_snapshot_load());
+    settle();
+}
+
+void setUp(void) {
+    memset(model_Rtc, 0, sizeof(model_Rtc));
+    memcpy(model_Rtc, startTime, sizeof(startTime));
+    busBlocked = 0;
+    reload();
+}
+
+void tearDown(void) {
+}
+
+// Ten saves wrap the eight slots; the ring read back from the chip gives the
+// same newest and oldest snapshots as the RAM mirror
+static void test_ring_wraps_and_reloads(void) {
+    uint8_t time[7];
+
+    TEST_ASSERT_EQUAL_UINT(0, DS1307_snapshot_count());
+    for (uint8_t i = 0; i < 10; i++) {
+        save(0x10 + i);
+    }
+    TEST_ASSERT_EQUAL_UINT(DS1307_SNAP_SLOTS, DS1307_snapshot_count());
+    TEST_ASSERT_EQUAL_UINT(OPERATION_DONE, DS1307_snapshot_get(0, time));
+    TEST_ASSERT_EQUAL_UINT(19, time[0]);
+    TEST_ASSERT_EQUAL_UINT(15, time[1]);
+    TEST_ASSERT_EQUAL_UINT(24, time[6]);
+
+    memset(snap_ring, 0, sizeof(snap_ring));
+    reload();
+    TEST_ASSERT_EQUAL_UINT(DS1307_SNAP_SLOTS, DS1307_snapshot_count());
+    TEST_ASSERT_EQUAL_UINT(OPERATION_DONE, DS1307_snapshot_get(0, time));
+    TEST_ASSERT_EQUAL_UINT(19, time[0]);
+    TEST_ASSERT_EQUAL_UINT(OPERATION_DONE, DS1307_snapshot_get(DS1307_SNAP_SLOTS - 1, time));
+    TEST_ASSERT_EQUAL_UINT(12, time[0]);
+    TEST_ASSERT_EQUAL_UINT(OPERATION_FAILED, DS1307_snapshot_get(DS1307_SNAP_SLOTS, time));
+}
+
+// A slot write the queue refuses stays pending: the mirror does not count a
+// snapshot the chip has not stored, and it is written once there is room
+static void test_refused_capture_is_retried(void) {
+    uint8_t chip[DS1307_SNAP_RING_SIZE];
+    uint8_t time[7];
+    uint32_t i;
+
+    save(0x01);
+    memcpy(chip, &model_Rtc[DS1307_SNAP_RING_START], sizeof(chip));
+
+    busBlocked = 1;
+    model_Rtc[DS1307_REGISTER_SECONDS] = 0x02;
+    TEST_ASSERT_EQUAL_UINT(OPERATION_DONE, DS1307_snapshot_save());
+    for (i = 0; i < RUN_LIMIT && (DS1307_read_pending() || (snap_pending & SNAP_PENDING_CAPTURE)); i++) {
+        run();
+    }
+    for (i = 0; i < 2000; i++) {
+        run();
+    }
+    TEST_ASSERT_EQUAL_UINT(SNAP_PENDING_WRITE, snap_pending);
+    TEST_ASSERT_EQUAL_UINT(1, DS1307_snapshot_count());
+    TEST_ASSERT_EQUAL_MEMORY(chip, &model_Rtc[DS1307_SNAP_RING_START], sizeof(chip));
+
+    // A save while the write waits merges into it
+    TEST_ASSERT_EQUAL_UINT(OPERATION_DONE, DS1307_snapshot_save());
+    TEST_ASSERT_EQUAL_UINT(SNAP_PENDING_WRITE, snap_pending);
+
+    busBlocked = 0;
+    settle();
+    TEST_ASSERT_EQUAL_UINT(2, DS1307_snapshot_count());
+    TEST_ASSERT_EQUAL_UINT(OPERATION_DONE, DS1307_snapshot_get(0, time));
+    TEST_ASSERT_EQUAL_UINT(2, time[0]);
+    TEST_ASSERT_EQUAL_MEMORY(snap_ring, &model_Rtc[DS1307_SNAP_RING_START], sizeof(snap_ring));
+}
+
+// A clear refused by the queue is queued again until the chip is empty
+static void test_refused_clear_is_retried(void) {
+    static const uint8_t empty[DS1307_SNAP_RING_SIZE];
+
+    save(0x01);
+    save(0x02);
+    fill();
+    DS1307_snapshot_clear();
+    TEST_ASSERT_EQUAL_UINT(SNAP_PENDING_CLEAR, snap_pending);
+    settle();
+    TEST_ASSERT_EQUAL_MEMORY(empty, &model_Rtc[DS1307_SNAP_RING_START], sizeof(empty));
+    reload();
+    TEST_ASSERT_EQUAL_UINT(0, DS1307_snapshot_count());
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    model_Reset();
+    time_i2c_init();
+    RUN_TEST(test_ring_wraps_and_reloads);
+    RUN_TEST(test_refused_capture_is_retried);
+    RUN_TEST(test_refused_clear_is_retried);
+    return UNITY_END();
+}
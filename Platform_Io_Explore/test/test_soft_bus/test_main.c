@@ -0,0 +1,369 @@
+/*_____________________________{TEST_SOFT_BUS}_____________________________________________________
+ Brief : The bit-banged bus on PE4/PE5 with a DS1307 at its pins (user-044, user-049)
+
+ The slave below watches SCL and SDA the way the DS1307 does: it samples on
+ the rising edge, drives SDA after the falling edge, can hold SCL low for a
+ few ticks after each ACK (clock stretching) and answers at 0x68 only. A line
+ is high unless the master drives it (DDRE bit set, PORTE low) or the slave
+ pulls it down. One pass runs ISR(TIMER2_COMP_vect) once, then the slave.
+ _________________________________________________________________________________________*/
+#define I2C_SOFT_ENABLE
+#define I2C_STATS_ENABLE
+#define TRACE_ENABLE
+
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#include "../../../Atmega128A.X/i2c_driver.c"
+#include "../../../Atmega128A.X/i2c_device.c"
+#include "../../../Atmega128A.X/i2c_request_queue.c"
+#include "../../../Atmega128A.X/i2c_soft.c"
+#include "../../../Atmega128A.X/rtc_ds1307.c"
+#include "../../../Atmega128A.X/rtc_ds1307_low_level.c"
+#include "../../../Atmega128A.X/uart_trace.c"
+#include "../host/twi_model.c"
+
+#define RUN_LIMIT       2000000UL
+
+#define SLAVE_IDLE      0
+#define SLAVE_ADDRESS   1
+#define SLAVE_WRITE     2
+#define SLAVE_READ      3
+#define SLAVE_IGNORE    4       // Not addressed, or the master ended the read
+
+static uint8_t  slaveMemory[MODEL_RTC_SIZE];
+static uint8_t  slavePointer;
+static uint8_t  slaveState;
+static uint8_t  slaveBit;
+static uint8_t  slaveFirst;             // Next byte written is the register pointer
+static uint8_t  slaveAckPhase;
+static uint8_t  slaveMasterAck;
+static uint8_t  slaveShift;
+static uint8_t  slaveOut;
+static uint8_t  slaveSdaLow;
+static uint8_t  slaveSclHold;
+static uint8_t  slaveStretch;           // Ticks SCL is held low after each ACK
+static uint8_t  slaveAbsent;
+static uint8_t  lastScl = 1;
+static uint8_t  lastSda = 1;
+static uint16_t slaveStarts;
+
+static uint8_t line(uint8_t pin, uint8_t pulled) {
+    return !(DDRE & (1 << pin)) && !pulled;
+}
+
+uint8_t host_pine(void) {
+    return (line(PE4, slaveSclHold) << PE4) | (line(PE5, slaveSdaLow) << PE5);
+}
+
+static void slaveFalling() {
+    if (slaveAckPhase) {
+        slaveAckPhase = 0;
+        slaveSdaLow   = 0;
+        slaveBit      = 0;
+        slaveSclHold  = slaveStretch;
+        if (slaveState == SLAVE_READ) {
+            if (!slaveMasterAck) {
+                slaveState = SLAVE_IGNORE;
+            } else {
+                slaveOut    = slaveMemory[slavePointer++ & (MODEL_RTC_SIZE - 1)];
+                slaveSdaLow = !(slaveOut & 0x80);
+            }
+        }
+    } else if (slaveBit == 8 && slaveState == SLAVE_ADDRESS) {
+        if ((slaveShift >> 1) != MODEL_RTC_ADDR || slaveAbsent) {
+            slaveState = SLAVE_IGNORE;
+        } else {
+            slaveState     = (slaveShift & 1) ? SLAVE_READ : SLAVE_WRITE;
+            slaveFirst     = 1;
+            slaveSdaLow    = 1;
+            slaveAckPhase  = 1;
+            slaveMasterAck = 1;
+        }
+        slaveBit   = 0;
+        slaveShift = 0;
+    } else if (slaveBit == 8 && slaveState == SLAVE_WRITE) {
+        if (slaveFirst) {
+            slavePointer = slaveShift;
+            slaveFirst   = 0;
+        } else {
+            slaveMemory[slavePointer++ & (MODEL_RTC_SIZE - 1)] = slaveShift;
+        }
+        slaveSdaLow   = 1;
+        slaveAckPhase = 1;
+        slaveBit      = 0;
+        slaveShift    = 0;
+    } else if (slaveState == SLAVE_READ) {
+        if (slaveBit == 8) {
+            slaveSdaLow   = 0;                      // Master ACKs or NACKs
+            slaveAckPhase = 1;
+        } else {
+            slaveSdaLow = !((slaveOut << slaveBit) & 0x80);
+        }
+    }
+}
+
+static void slaveTick() {
+    uint8_t scl, sda;
+
+    if (slaveSclHold) {
+        slaveSclHold--;
+    }
+    scl = line(PE4, slaveSclHold);
+    sda = line(PE5, slaveSdaLow);
+    if (scl && lastScl) {
+        if (lastSda && !sda) {                      // START or repeated START
+            slaveState    = SLAVE_ADDRESS;
+            slaveBit      = 0;
+            slaveShift    = 0;
+            slaveAckPhase = 0;
+            slaveSdaLow   = 0;
+            slaveStarts++;
+        } else if (!lastSda && sda) {               // STOP
+            slaveState  = SLAVE_IDLE;
+            slaveSdaLow = 0;
+        }
+    } else if (scl && !lastScl) {
+        if (slaveAckPhase) {
+            if (slaveState == SLAVE_READ) {
+                slaveMasterAck = !sda;
+            }
+        } else if (slaveState == SLAVE_ADDRESS || slaveState == SLAVE_WRITE) {
+            slaveShift = (slaveShift << 1) | sda;
+            slaveBit++;
+        } else if (slaveState == SLAVE_READ) {
+            slaveBit++;
+        }
+    } else if (!scl && lastScl) {
+        slaveFalling();
+    }
+    lastScl = scl;
+    lastSda = line(PE5, slaveSdaLow);
+}
+
+static uint32_t ticks;                  // Timer2 interrupts run
+static uint32_t lastRise;               // Tick of the last SCL rising edge
+static uint16_t periodMin, periodMax;   // SCL period in ticks, rising edge to rising edge
+
+static void run() {
+    i2c_SoftUpdate();
+    if (TIMSK & (1 << OCIE2)) {
+        uint8_t scl = lastScl;
+
+        TIMER2_COMP_vect();
+        slaveTick();
+        ticks++;
+        if (!scl && lastScl) {
+            uint32_t period = ticks - lastRise;
+            if (lastRise && period < 100) {     // Not across the idle time between frames
+                periodMin = (period < periodMin) ? period : periodMin;
+                periodMax = (period > periodMax) ? period : periodMax;
+            }
+            lastRise = ticks;
+        }
+    }
+}
+
+static void drain() {
+    for (uint32_t i = 0; i < RUN_LIMIT && (i2c_SoftWriteBufferUsed() || (TIMSK & (1 << OCIE2))); i++) {
+        run();
+    }
+}
+
+static void runDevices(uint32_t passes) {
+    for (uint32_t i = 0; i < passes; i++) {
+        i2c_DeviceUpdate();
+        DS1307_update();
+        run();
+    }
+    drain();
+}
+
+static uint8_t probe(uint8_t address) {
+    uint8_t ticket;
+    uint8_t result;
+
+    TEST_ASSERT_TRUE(i2c_SoftProbe(address));
+    ticket = i2c_SoftProbeTicket();
+    for (uint32_t i = 0; i < RUN_LIMIT && (result = i2c_SoftProbeResult(ticket)) == I2C_PROBE_PENDING; i++) {
+        run();
+    }
+    return result;
+}
+
+void setUp(void) {
+    slaveStretch = 0;
+    slaveAbsent  = 0;
+}
+
+void tearDown(void) {
+}
+
+static void test_write_then_read_with_clock_stretching(void) {
+    uint8_t frame[4] = { 10, 0xAA, 0x55, 0x81 };
+    uint8_t pointer = 8;
+    uint8_t data[8];
+
+    for (uint8_t i = 0; i < MODEL_RTC_SIZE; i++) {
+        slaveMemory[i] = i * 7 + 3;
+    }
+    TEST_ASSERT_TRUE(i2c_SoftSendArray(MODEL_RTC_ADDR, sizeof(frame), frame));
+    drain();
+    TEST_ASSERT_EQUAL_MEMORY(&frame[1], &slaveMemory[10], 3);
+
+    for (slaveStretch = 0; slaveStretch < 3; slaveStretch++) {
+        TEST_ASSERT_TRUE(i2c_SoftSendArray(MODEL_RTC_ADDR, 1, &pointer));
+        TEST_ASSERT_TRUE(i2c_SoftGetData(MODEL_RTC_ADDR, sizeof(data)));
+        drain();
+        TEST_ASSERT_TRUE(i2c_SoftCopyFromRxBuffer(0, data, sizeof(data)));
+        TEST_ASSERT_EQUAL_MEMORY(&slaveMemory[8], data, sizeof(data));
+        i2c_SoftReleaseRxBuffer(sizeof(data));
+        TEST_ASSERT_FALSE(i2c_SoftReadBusy());
+    }
+}
+
+// An ACK counts for a probe only if its frame is address-only, the ACKed
+// bytes of the write queued before it are not its answer (user-044)
+static void test_probe_after_a_write(void) {
+    uint8_t frame[2] = { 1, 2 };
+
+    TEST_ASSERT_TRUE(i2c_SoftSendArray(MODEL_RTC_ADDR, sizeof(frame), frame));
+    TEST_ASSERT_EQUAL_UINT(I2C_PROBE_NACK, probe(EEPROM_24C32_ADDR));
+    TEST_ASSERT_EQUAL_UINT(I2C_PROBE_ACK, probe(MODEL_RTC_ADDR));
+
+    slaveAbsent = 1;
+    TEST_ASSERT_EQUAL_UINT(I2C_PROBE_NACK, probe(MODEL_RTC_ADDR));
+}
+
+// Init of a blank chip resets it, a warm chip is kept and only restarted
+static void test_rtc_init(void) {
+    uint8_t time[7] = { 0x30, 0x15, 0x10, 3, 0x19, 0x10, 0x26 };
+    uint32_t passes;
+
+    memset(slaveMemory, 0xFF, sizeof(slaveMemory));
+    DS1307_init_start(time, CLOCK_RUN, NO_FORCE_RESET);
+    for (passes = 0; passes < RUN_LIMIT && DS1307_init_state() == DS1307_INIT_BUSY; passes++) {
+        runDevices(1);
+    }
+    TEST_ASSERT_EQUAL_UINT(DS1307_INIT_RESET, DS1307_init_state());
+    TEST_ASSERT_EQUAL_HEX8(DS1307_INITIALIZED, slaveMemory[DS1307_REGISTER_INIT_STATUS]);
+    TEST_ASSERT_EQUAL_HEX8(0x00, slaveMemory[DS1307_REGISTER_INIT_STATUS + 1]);          // RAM cleared
+
+    runDevices(20000);
+    slaveMemory[0] |= 0x80;                         // Clock halted
+    slaveMemory[20] = 0x5A;
+    DS1307_init_start(time, CLOCK_RUN, NO_FORCE_RESET);
+    for (passes = 0; passes < RUN_LIMIT && DS1307_init_state() == DS1307_INIT_BUSY; passes++) {
+        runDevices(1);
+    }
+    TEST_ASSERT_EQUAL_UINT(DS1307_INIT_KEPT, DS1307_init_state());
+    TEST_ASSERT_FALSE(slaveMemory[0] & 0x80);
+    TEST_ASSERT_EQUAL_HEX8(0x5A, slaveMemory[20]);
+}
+
+// Halt, set the seconds, run and halt again, queued back to back: the
+// coroutines read SECONDS once and keep each other's bits (user-049)
+static void test_rtc_read_modify_write(void) {
+    uint8_t seconds = 12;
+    uint16_t starts;
+
+    runDevices(20000);
+    slaveMemory[0] = 0x45;
+    starts = slaveStarts;
+    DS1307_run(CLOCK_HALT);
+    DS1307_set(SECOND, &seconds);
+    DS1307_run(CLOCK_RUN);
+    DS1307_run(CLOCK_HALT);
+    runDevices(20000);
+    TEST_ASSERT_EQUAL_HEX8(0x92, slaveMemory[0]);    // CH set, 12 in BCD
+    TEST_ASSERT_LESS_OR_EQUAL(3, slaveStarts - starts);
+
+    slaveMemory[0] = 0x97;
+    DS1307_run(CLOCK_RUN);
+    runDevices(20000);
+    TEST_ASSERT_EQUAL_HEX8(0x17, slaveMemory[0]);
+}
+
+// Pointer write and 16-byte read, 8 times over: throughput from the bus
+// statistics and the spread of the SCL period, without and with the slave
+// stretching the clock for 2 ticks after every ACK
+static void test_throughput_and_jitter(void) {
+    uint8_t pointer = 0;
+    uint8_t data[16];
+    i2c_SoftStats_t stats;
+    char line[120];
+
+    for (slaveStretch = 0; slaveStretch <= 2; slaveStretch += 2) {
+        i2c_SoftStatsReset();
+        lastRise  = 0;
+        periodMin = 0xFFFF;
+        periodMax = 0;
+        for (uint8_t i = 0; i < 8; i++) {
+            TEST_ASSERT_TRUE(i2c_SoftSendArray(MODEL_RTC_ADDR, 1, &pointer));
+            TEST_ASSERT_TRUE(i2c_SoftGetData(MODEL_RTC_ADDR, sizeof(data)));
+            drain();
+            TEST_ASSERT_TRUE(i2c_SoftCopyFromRxBuffer(0, data, sizeof(data)));
+            i2c_SoftReleaseRxBuffer(sizeof(data));
+        }
+        i2c_SoftStatsGet(&stats);
+        uint32_t busyUs = stats.busyTicks * stats.tickUs;
+        uint32_t bytesPerSecond = (stats.bytes * 1000000UL) / busyUs;
+        snprintf(line, sizeof(line), "stretch %u: %lu bytes in %lu us, %lu B/s, SCL period %u-%u ticks of %u us",
+                 slaveStretch, (unsigned long) stats.bytes, (unsigned long) busyUs, (unsigned long) bytesPerSecond,
+                 periodMin, periodMax, stats.tickUs);
+        TEST_MESSAGE(line);
+
+        TEST_ASSERT_EQUAL_UINT(8 * (1 + sizeof(data)), stats.bytes);
+        TEST_ASSERT_EQUAL_UINT(16, stats.transactions);
+        TEST_ASSERT_EQUAL_UINT(2, periodMin);                       // 25 kHz, one tick low, one high
+        TEST_ASSERT_EQUAL_UINT(slaveStretch ? 6 : 5, periodMax);    // First clock after a (repeated) START
+        TEST_ASSERT_TRUE(bytesPerSecond >= (slaveStretch ? 2150 : 2400));
+    }
+    slaveStretch = 0;
+}
+
+// All counters together are larger than the trace ring; they go out in turn,
+// each at least every second call, and none is dropped (user-044)
+static void test_counters_take_turns(void) {
+    uint8_t seen[3];
+    uint8_t last[3] = { 1, 1, 1 };
+    uint16_t dropped = trace_Dropped();
+
+    for (uint8_t call = 0; call < 6; call++) {
+        trace_Tail = trace_Head;                    // The UART sent everything
+        memset(seen, 0, sizeof(seen));
+        trace_Counters();
+        for (uint8_t at = trace_Tail; at != trace_Head; ) {
+            uint8_t type = trace_Buffer[(uint8_t)(at + 1) & (TRACE_BUFFER_SIZE - 1)];
+            uint8_t length = trace_Buffer[(uint8_t)(at + 3) & (TRACE_BUFFER_SIZE - 1)];
+            TEST_ASSERT_EQUAL_HEX8(TRACE_SYNC, trace_Buffer[at & (TRACE_BUFFER_SIZE - 1)]);
+            if (type == TRACE_EVT_DROPS) {
+                seen[0] = 1;
+            } else if (type == TRACE_EVT_I2C_STATS) {
+                seen[1] = 1;
+            } else if (type == TRACE_EVT_I2C_SOFT_STATS) {
+                seen[2] = 1;
+            }
+            at += length + TRACE_FRAME_OVERHEAD;
+        }
+        for (uint8_t i = 0; i < sizeof(seen); i++) {
+            TEST_ASSERT_TRUE(seen[i] || last[i]);
+            last[i] = seen[i];
+        }
+        TEST_ASSERT_EQUAL_UINT(dropped, trace_Dropped());
+    }
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    model_Reset();
+    i2c_SoftInit(I2C_STANDARD_MODE);
+    RUN_TEST(test_write_then_read_with_clock_stretching);
+    RUN_TEST(test_probe_after_a_write);
+    RUN_TEST(test_rtc_init);
+    RUN_TEST(test_rtc_read_modify_write);
+    RUN_TEST(test_throughput_and_jitter);
+    RUN_TEST(test_counters_take_turns);
+    return UNITY_END();
+}
@@ -0,0 +1,81 @@
+/*_____________________________{TEST_TWI_RING}_____________________________________________________
+ Brief : The write and read rings between TWI_vect and the main loop (user-039)
+
+ The bus runs from a timer signal, so TWI_vect interrupts the producers of
+ the rings at any instruction, as it does on the chip. Random writes of 1 to
+ 4 bytes go into the 24C32 with the chip ACK polled between them, every
+ other one is read back at once; at the end the whole chip is compared.
+ _________________________________________________________________________________________*/
+#include <stdlib.h>
+#include <string.h>
+#include <unity.h>
+
+#include "../../../Atmega128A.X/i2c_driver.c"
+#include "../../../Atmega128A.X/i2c_device.c"
+#include "../../../Atmega128A.X/i2c_request_queue.c"
+#include "../../../Atmega128A.X/EEPROM_24C32.c"
+#include "../../../Atmega128A.X/uart_trace.c"
+#include "../host/twi_model.c"
+
+#define RING_WRITES     1000
+
+static uint8_t expected[EEPROM_CHIP_SIZE];
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+static void test_writes_and_reads_under_the_interrupt(void) {
+    uint16_t verified = 0;
+
+    memset(model_Eeprom, 0xFF, sizeof(model_Eeprom));
+    memset(expected, 0xFF, sizeof(expected));
+    model_Reset();
+    i2c_Init(I2C_STANDARD_MODE);
+    eeprom_init(I2C_STANDARD_MODE);
+    model_Async(50);
+
+    srand(7);
+    for (uint16_t k = 0; k < RING_WRITES; k++) {
+        uint16_t addr = (rand() % (EEPROM_CHIP_SIZE / 4)) * 4;  // 1 to 4 bytes never cross a page
+        uint8_t length = 1 + rand() % 4;
+        uint8_t data[4];
+
+        for (uint8_t i = 0; i < length; i++) {
+            data[i] = rand();
+        }
+        while (!eeprom_writeArray(addr, length, data)) {        // Refused until the last write was ACK polled
+            i2c_DeviceUpdate();
+        }
+        memcpy(&expected[addr], data, length);
+        if (rand() % 2) {
+            uint8_t back[4];
+
+            while (!eeprom_readArray(addr, 4, back)) {
+                i2c_DeviceUpdate();
+            }
+            while (eeprom_readPending()) {
+                i2c_DeviceUpdate();
+            }
+            TEST_ASSERT_EQUAL_MEMORY(&expected[addr], back, 4);
+            verified++;
+        }
+    }
+    while (eeprom_blockBusy() || eeprom_writeQueued()) {
+        i2c_DeviceUpdate();
+    }
+    model_Async(0);
+
+    TEST_ASSERT_GREATER_THAN(RING_WRITES / 3, verified);
+    TEST_ASSERT_EQUAL_MEMORY(expected, model_Eeprom[0], EEPROM_CHIP_SIZE);
+    TEST_ASSERT_EQUAL_UINT(RING_WRITES, model_Pages);
+    TEST_ASSERT_EQUAL_UINT(0, model_Torn);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_writes_and_reads_under_the_interrupt);
+    return UNITY_END();
+}
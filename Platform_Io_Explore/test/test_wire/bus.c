@@ -0,0 +1,15 @@
+/*_____________________________{TEST_WIRE BUS}_____________________________________________________
+ Brief : EEPROM driver and bus model next to the AsyncWire library
+
+ The library brings the driver, the arbiter and the queues (AsyncWireEngine.c),
+ the EEPROM driver shares them as in the firmware. The bus runs from the
+ timer signal (model_Async()), as the interrupt does on the chip: flush() and
+ the other waiting loops of Wire only call update(). micros() is bus time.
+ _________________________________________________________________________________________*/
+#include "../../../Atmega128A.X/EEPROM_24C32.c"
+#include "../../../Atmega128A.X/uart_trace.c"
+#include "../host/twi_model.c"
+
+unsigned long micros(void) {
+    return model_Now;
+}
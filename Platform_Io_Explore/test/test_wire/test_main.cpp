@@ -0,0 +1,138 @@
+/*_____________________________{TEST_WIRE}_____________________________________________________
+ Brief : AsyncWire next to the firmware drivers on one bus (user-050)
+
+ Wire scans, writes and reads the 24C32 and the DS1307 of twi_model.c while
+ the EEPROM driver runs its own transfers on the same queue.
+ _________________________________________________________________________________________*/
+#include <unity.h>
+#include <Wire.h>
+
+extern "C" {
+#include "twi_model.h"
+}
+
+#define RUN_LIMIT   200000UL
+
+static uint8_t  callbacks;
+static uint8_t  callbackCount;
+static uint8_t  callbackData[BUFFER_LENGTH];
+
+static void received(uint8_t address, uint8_t count) {
+    callbacks++;
+    callbackCount = count;
+    for (uint8_t i = 0; i < count; i++) {
+        callbackData[i] = Wire.read();
+    }
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+static void test_scan(void) {
+    Wire.beginTransmission(EEPROM_24C32_ADDR);
+    TEST_ASSERT_EQUAL_UINT(0, Wire.endTransmission());
+    Wire.beginTransmission(EEPROM_24C32_ADDR + 1);
+    TEST_ASSERT_EQUAL_UINT(2, Wire.endTransmission());
+    Wire.beginTransmission(MODEL_RTC_ADDR);
+    TEST_ASSERT_EQUAL_UINT(0, Wire.endTransmission());
+}
+
+static void test_write_then_read_back(void) {
+    char text[4] = { 0 };
+
+    Wire.beginTransmission(EEPROM_24C32_ADDR);
+    Wire.write((uint8_t) 0x01);
+    Wire.write((uint8_t) 0x00);
+    Wire.write((const uint8_t*) "ABC", 3);
+    TEST_ASSERT_EQUAL_UINT(0, Wire.endTransmission());
+    Wire.flush();
+
+    // The chip is in its write cycle, the read is retried until it answers
+    TEST_ASSERT_EQUAL_UINT(3, Wire.requestFrom((uint8_t) EEPROM_24C32_ADDR, (uint8_t) 3, (uint32_t) 0x0100, (uint8_t) 2, (uint8_t) 1));
+    for (uint8_t i = 0; i < 3; i++) {
+        text[i] = Wire.read();
+    }
+    TEST_ASSERT_EQUAL_MEMORY("ABC", text, 3);
+    TEST_ASSERT_EQUAL_MEMORY("ABC", &model_Eeprom[0][0x0100], 3);
+}
+
+static void test_async_reads(void) {
+    uint32_t i;
+
+    Wire.beginTransmission(MODEL_RTC_ADDR);
+    Wire.write((uint8_t) 0x10);
+    Wire.write((uint8_t) 7);
+    Wire.write((uint8_t) 8);
+    Wire.write((uint8_t) 9);
+    TEST_ASSERT_EQUAL_UINT(0, Wire.endTransmission());
+
+    TEST_ASSERT_TRUE(Wire.requestFromAsync(MODEL_RTC_ADDR, 3, 0x10, 1, received));
+    TEST_ASSERT_TRUE(Wire.requestFromAsync(MODEL_RTC_ADDR, 2, 0x11, 1, received));
+    TEST_ASSERT_EQUAL_UINT(2, Wire.pending());
+    for (i = 0; i < RUN_LIMIT && callbacks < 1; i++) {
+        Wire.update();
+    }
+    TEST_ASSERT_EQUAL_UINT(3, callbackCount);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(((const uint8_t[]) { 7, 8, 9 }), callbackData, 3);
+    for (i = 0; i < RUN_LIMIT && callbacks < 2; i++) {
+        Wire.update();
+    }
+    TEST_ASSERT_EQUAL_UINT(2, callbackCount);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(((const uint8_t[]) { 8, 9 }), callbackData, 2);
+    TEST_ASSERT_EQUAL_UINT(0, Wire.pending());
+}
+
+// An absent device times out, the next read is not disturbed
+static void test_absent_device(void) {
+    Wire.clearWireTimeoutFlag();
+    TEST_ASSERT_EQUAL_UINT(0, Wire.requestFrom(0x33, 2));
+    TEST_ASSERT_TRUE(Wire.getWireTimeoutFlag());
+    TEST_ASSERT_EQUAL_UINT(1, Wire.requestFrom((uint8_t) MODEL_RTC_ADDR, (uint8_t) 1, (uint32_t) 0x12, (uint8_t) 1, (uint8_t) 1));
+    TEST_ASSERT_EQUAL_INT(9, Wire.read());
+}
+
+// A scan while the block writer ACK polls the 24C32 between its pages: each
+// probe has its own ticket, so neither takes the other's answer
+static void test_scan_during_block_write(void) {
+    static uint8_t block[100];
+    uint16_t scans = 0;
+    uint32_t i;
+
+    for (i = 0; i < sizeof(block); i++) {
+        block[i] = i + 1;
+    }
+    for (i = 0; i < RUN_LIMIT && !eeprom_writeBlock(0x0010, sizeof(block), block); i++) {
+        Wire.update();
+    }
+    while (eeprom_blockBusy() && scans < 200) {
+        Wire.beginTransmission(EEPROM_24C32_ADDR + 1);
+        TEST_ASSERT_EQUAL_UINT(2, Wire.endTransmission());
+        Wire.beginTransmission(MODEL_RTC_ADDR);
+        TEST_ASSERT_EQUAL_UINT(0, Wire.endTransmission());
+        scans++;
+    }
+    for (i = 0; i < RUN_LIMIT && eeprom_blockBusy(); i++) {
+        Wire.update();
+    }
+    TEST_ASSERT_GREATER_THAN(0, scans);
+    TEST_ASSERT_FALSE(eeprom_blockBusy());
+    TEST_ASSERT_EQUAL_MEMORY(block, &model_Eeprom[0][0x0010], sizeof(block));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    model_Reset();
+    eeprom_init(I2C_STANDARD_MODE);
+    Wire.begin();
+    model_Async(50);
+    RUN_TEST(test_scan);
+    RUN_TEST(test_write_then_read_back);
+    RUN_TEST(test_async_reads);
+    RUN_TEST(test_absent_device);
+    RUN_TEST(test_scan_during_block_write);
+    model_Async(0);
+    return UNITY_END();
+}